@@ -46,6 +46,28 @@ bool IsLastRegstInPieceWithOrder(const Regst* regst, ColIdOrder order) {
          || (order == ColIdOrder::kDescending && regst->col_id() == 0);
 }
 
+void Actor::BindBlobs4ExecKernel(ExecKernel* ek) const {
+  HashMap<int64_t, int32_t> regst_desc_id2regst_idx;
+  for (const std::string& bn_in_op : ek->kernel->bn_in_op_vec()) {
+    const auto& regst_desc_id_it = ek->bn_in_op2regst_desc_id.find(bn_in_op);
+    if (regst_desc_id_it == ek->bn_in_op2regst_desc_id.end()) {
+      ek->bn_slot2regst_idx_and_blob_ordinal.emplace_back(-1, -1);
+      continue;
+    }
+    const int64_t regst_desc_id = regst_desc_id_it->second;
+    if (regst_desc_id2regst_idx.find(regst_desc_id) == regst_desc_id2regst_idx.end()) {
+      regst_desc_id2regst_idx[regst_desc_id] = ek->regst_desc_ids.size();
+      ek->regst_desc_ids.push_back(regst_desc_id);
+    }
+    const RtRegstDesc& regst_desc = Global<RegstMgr>::Get()->RegstDesc4RegstDescId(regst_desc_id);
+    ek->bn_slot2regst_idx_and_blob_ordinal.emplace_back(
+        regst_desc_id2regst_idx.at(regst_desc_id),
+        regst_desc.GetBlobOrdinal4Lbi(ek->kernel->BnInOp2Lbi(bn_in_op)));
+  }
+  ek->cur_regsts.resize(ek->regst_desc_ids.size());
+  ek->bn_slot2blob.resize(ek->bn_slot2regst_idx_and_blob_ordinal.size());
+}
+
 void Actor::Init(const JobDesc* job_desc, const TaskProto& task_proto,
                  const ThreadCtx& thread_ctx) {
   job_desc_ = job_desc;
@@ -59,6 +81,7 @@ void Actor::Init(const JobDesc* job_desc, const TaskProto& task_proto,
     ExecKernel ek;
     ek.kernel = ConstructKernel(job_desc_, node.kernel_conf(), device_ctx_.get());
     ek.bn_in_op2regst_desc_id = PbMap2HashMap(node.bn_in_op2regst_desc_id());
+    BindBlobs4ExecKernel(&ek);
     exec_kernel_vec_.push_back(std::move(ek));
   }
 
@@ -85,6 +108,18 @@ void Actor::Init(const JobDesc* job_desc, const TaskProto& task_proto,
   for (const auto& pair : produced_regsts_) {
     for (const auto& regst : pair.second) { produced_regst2reading_cnt_[regst.get()] = 0; }
   }
+  metrics_ = nullptr;
+  RuntimeMetrics* runtime_metrics = Global<RuntimeMetrics>::Get();
+  if (runtime_metrics != nullptr) {
+    metrics_ = runtime_metrics->NewActorMetrics(actor_id_, thrd_id());
+    for (const auto& pair : produced_regsts_) {
+      metrics_->regst_desc_id2metrics.emplace(
+          pair.first, runtime_metrics->NewRegstMetrics(pair.first, actor_id_, pair.second.size()));
+    }
+  }
+  const ProfilerConf* profiler_conf = Global<const ProfilerConf>::Get();
+  collect_perf_counters_ = GetDeviceType() == DeviceType::kCPU && profiler_conf->collect_act_event()
+                           && profiler_conf->collect_perf_counters();
 
   for (const auto& pair : task_proto.consumed_regst_desc_id()) {
     CHECK(name2regst_desc_id_.find(pair.first) == name2regst_desc_id_.end());
@@ -202,7 +237,17 @@ int64_t Actor::ReadingCnt4ProducedRegst(Regst* regst) const {
 }
 
 void Actor::IncreaseReadingCnt4ProducedRegst(Regst* regst, int64_t val) {
-  produced_regst2reading_cnt_.at(regst) += val;
+  int64_t& reading_cnt = produced_regst2reading_cnt_.at(regst);
+  if (metrics_ != nullptr) { UpdtRegstInUseMetrics(regst, reading_cnt, reading_cnt + val); }
+  reading_cnt += val;
+}
+
+void Actor::UpdtRegstInUseMetrics(const Regst* regst, int64_t reading_cnt,
+                                  int64_t new_reading_cnt) const {
+  const int64_t delta = (new_reading_cnt > 0) - (reading_cnt > 0);
+  if (delta != 0) {
+    metrics_->regst_desc_id2metrics.at(regst->regst_desc_id())->in_use.Add(delta);
+  }
 }
 
 int64_t Actor::GetPieceId4NaiveCurReadableDataRegst() const {
@@ -373,6 +418,23 @@ void Actor::TryLogActEvent(const std::function<void()>& DoAct) const {
 
     DoAct();
 
+    if (collect_perf_counters_) {
+      PerfCounters* perf_counters = act_event->mutable_perf_counters();
+      const PerfCounterValues& values = act_perf_counters_;
+      if (values.at(kCyclesPerfCounter) >= 0) {
+        perf_counters->set_cycles(values.at(kCyclesPerfCounter));
+      }
+      if (values.at(kInstructionsPerfCounter) >= 0) {
+        perf_counters->set_instructions(values.at(kInstructionsPerfCounter));
+      }
+      if (values.at(kLlcMissesPerfCounter) >= 0) {
+        perf_counters->set_llc_misses(values.at(kLlcMissesPerfCounter));
+      }
+      if (values.at(kBranchMissesPerfCounter) >= 0) {
+        perf_counters->set_branch_misses(values.at(kBranchMissesPerfCounter));
+      }
+    }
+
     device_ctx_->AddCallBack([act_event]() {
       act_event->set_stop_time(GetCurTime());
       // The stream poller thread is not allowed to perform blocking RPC call. Hence, the
@@ -388,7 +450,15 @@ void Actor::TryLogActEvent(const std::function<void()>& DoAct) const {
 void Actor::ActUntilFail() {
   while (IsReadReady() && IsWriteReady()) {
     act_id_ += 1;
-    TryLogActEvent([&] { Act(); });
+    if (collect_perf_counters_) { act_perf_counters_.fill(-1); }
+    if (metrics_ != nullptr) {
+      const double start_time = GetCurTime();
+      TryLogActEvent([&] { Act(); });
+      metrics_->act_cnt.Add(1);
+      metrics_->busy_ns.Add(GetCurTime() - start_time);
+    } else {
+      TryLogActEvent([&] { Act(); });
+    }
 
     AsyncSendCustomizedProducedRegstMsgToConsumer();
     AsyncSendNaiveProducedRegstMsgToConsumer();
@@ -497,6 +567,7 @@ int64_t Actor::HandleRegstToConsumer(Regst* regst, std::function<bool(int64_t)>
     real_consumer_cnt += 1;
   }
   total_reading_cnt_ += real_consumer_cnt;
+  if (metrics_ != nullptr) { UpdtRegstInUseMetrics(regst, 0, real_consumer_cnt); }
   regst_reading_cnt_it->second += real_consumer_cnt;
   return real_consumer_cnt;
 }
@@ -513,25 +584,46 @@ bool Actor::IsWriteReady() const {
 
 void Actor::AsyncLaunchKernel(const KernelCtx& kernel_ctx,
                               std::function<Regst*(int64_t)> Regst4RegstDescId) {
-  for (const ExecKernel& ek : exec_kernel_vec_) {
-    ek.kernel->Launch(kernel_ctx, [&](const std::string& bn_in_op) -> Blob* {
-      auto regst_desc_id_it = ek.bn_in_op2regst_desc_id.find(bn_in_op);
-      if (regst_desc_id_it == ek.bn_in_op2regst_desc_id.end()) { return nullptr; }
-      Regst* regst = GetNaiveOrInplaceCurWriteable(regst_desc_id_it->second);
-      if (regst == nullptr) { regst = GetNaiveOrInplaceCurReadable(regst_desc_id_it->second); }
-      if (regst == nullptr) { regst = Regst4RegstDescId(regst_desc_id_it->second); }
-      if (regst == nullptr) { return nullptr; }
-      const LogicalBlobId& lbi = ek.kernel->BnInOp2Lbi(bn_in_op);
-      return regst->GetBlobByLbi(lbi);
-    });
+  // opened lazily on the thread the actor acts on, null if the counters are not available
+  ThreadPerfCounters* perf_counters =
+      collect_perf_counters_ ? ThreadPerfCounters::Get() : nullptr;
+  for (ExecKernel& ek : exec_kernel_vec_) {
+    FOR_RANGE(size_t, i, 0, ek.regst_desc_ids.size()) {
+      const int64_t regst_desc_id = ek.regst_desc_ids.at(i);
+      Regst* regst = GetNaiveOrInplaceCurWriteable(regst_desc_id);
+      if (regst == nullptr) { regst = GetNaiveOrInplaceCurReadable(regst_desc_id); }
+      if (regst == nullptr) { regst = Regst4RegstDescId(regst_desc_id); }
+      ek.cur_regsts.at(i) = regst;
+    }
+    FOR_RANGE(size_t, bn_slot, 0, ek.bn_slot2blob.size()) {
+      const auto& regst_idx_and_blob_ordinal = ek.bn_slot2regst_idx_and_blob_ordinal.at(bn_slot);
+      Regst* regst = nullptr;
+      if (regst_idx_and_blob_ordinal.first != -1) {
+        regst = ek.cur_regsts.at(regst_idx_and_blob_ordinal.first);
+      }
+      ek.bn_slot2blob.at(bn_slot) =
+          regst == nullptr ? nullptr : regst->GetBlobByOrdinal(regst_idx_and_blob_ordinal.second);
+    }
+    if (perf_counters != nullptr) {
+      PerfCounterValues before;
+      perf_counters->Read(&before);
+      ek.kernel->Launch(kernel_ctx, ek.bn_slot2blob);
+      PerfCounterValues after;
+      perf_counters->Read(&after);
+      FOR_RANGE(int, i, 0, kPerfCounterTypeNum) {
+        if (before.at(i) < 0 || after.at(i) < 0) { continue; }
+        act_perf_counters_.at(i) = std::max<int64_t>(act_perf_counters_.at(i), 0)
+                                   + after.at(i) - before.at(i);
+      }
+    } else {
+      ek.kernel->Launch(kernel_ctx, ek.bn_slot2blob);
+    }
   }
 }
 
 void Actor::AsyncLaunchKernel(const KernelCtx& kernel_ctx) {
-  AsyncLaunchKernel(kernel_ctx, [](int64_t) -> Regst* {
-    UNIMPLEMENTED();
-    return nullptr;
-  });
+  // the blobs are bound before the launch, a kernel gets nullptr for a regst the actor lacks
+  AsyncLaunchKernel(kernel_ctx, [](int64_t) -> Regst* { return nullptr; });
 }
 
 void Actor::HandleProducedNaiveDataRegstToConsumer(std::function<bool(Regst*)> RegstPreProcess,
@@ -607,6 +699,8 @@ void Actor::HandleConsumedNaiveDataRegstToProducer(std::function<bool(Regst*)> I
 }
 
 void Actor::AsyncSendEORDMsgForAllProducedRegstDesc() {
+  // the consumers must get the last regsts before the eord
+  SendBatchedMsgs();
   for (auto& pair : produced_regsts_) {
     CHECK(!pair.second.empty());
     const RtRegstDesc* regst_desc = pair.second.front()->regst_desc();
@@ -645,6 +739,7 @@ int Actor::TryUpdtStateAsProducedRegst(Regst* regst) {
   reading_cnt_it->second -= 1;
   total_reading_cnt_ -= 1;
   if (reading_cnt_it->second != 0) { return 0; }
+  if (metrics_ != nullptr) { UpdtRegstInUseMetrics(regst, 1, 0); }
 
   if (inplace_produced_rs_.TryPushBackRegst(regst) == 0) {
     int64_t in_regst_desc_id = inplace_regst_desc_id_out2in_.at(regst->regst_desc_id());
@@ -668,7 +763,7 @@ void Actor::EnqueueAsyncMsg(const ActorMsg& msg) {
   if (is_kernel_launch_synchronized_
       && GetGlobalWorkStreamId()
              == Global<IDMgr>::Get()->GlobalWorkStreamId4ActorId(msg.dst_actor_id())) {
-    Global<ActorMsgBus>::Get()->SendMsg(msg);
+    batched_msgs_.push_back(msg);
   } else {
     async_msg_queue_.push_back(msg);
   }
@@ -711,12 +806,18 @@ std::unique_ptr<Actor> NewActor(const TaskProto& task_proto, const ThreadCtx& th
 
 void Actor::AsyncSendQueuedMsg() {
   if (!async_msg_queue_.empty()) {
-    std::deque<ActorMsg> msgs;
-    msgs.swap(async_msg_queue_);
-    device_ctx_->AddCallBack([msgs]() {
-      for (const ActorMsg& msg : msgs) { Global<ActorMsgBus>::Get()->SendMsg(msg); }
-    });
+    // a cpu device ctx runs the callback right away, after the msgs batched before
+    SendBatchedMsgs();
+    std::vector<ActorMsg> msgs(async_msg_queue_.begin(), async_msg_queue_.end());
+    async_msg_queue_.clear();
+    device_ctx_->AddCallBack([msgs]() { Global<ActorMsgBus>::Get()->SendMsgs(msgs); });
   }
 }
 
+void Actor::SendBatchedMsgs() {
+  if (batched_msgs_.empty()) { return; }
+  Global<ActorMsgBus>::Get()->SendMsgs(batched_msgs_);
+  batched_msgs_.clear();
+}
+
 }  // namespace oneflow
@@ -18,9 +18,11 @@ limitations under the License.
 
 #include "oneflow/core/actor/act_event.pb.h"
 #include "oneflow/core/actor/actor_message_bus.h"
+#include "oneflow/core/common/perf_counters.h"
 #include "oneflow/core/device/cpu_device_context.h"
 #include "oneflow/core/device/cuda_device_context.h"
 #include "oneflow/core/device/cuda_stream_handle.h"
+#include "oneflow/core/job/runtime_metrics.h"
 #include "oneflow/core/job/task.pb.h"
 #include "oneflow/core/kernel/kernel.h"
 #include "oneflow/core/kernel/kernel_context.h"
@@ -46,7 +48,11 @@ class Actor {
 
   // 1: success, and actor finish
   // 0: success, and actor not finish
-  int ProcessMsg(const ActorMsg& msg) { return (this->*msg_handler_)(msg); }
+  int ProcessMsg(const ActorMsg& msg) {
+    const int ret = (this->*msg_handler_)(msg);
+    SendBatchedMsgs();
+    return ret;
+  }
 
   int64_t machine_id() const { return Global<IDMgr>::Get()->MachineId4ActorId(actor_id_); }
   int64_t thrd_id() const { return Global<IDMgr>::Get()->ThrdId4ActorId(actor_id_); }
@@ -56,6 +62,12 @@ class Actor {
   struct ExecKernel {
     std::unique_ptr<const Kernel> kernel;
     HashMap<std::string, int64_t> bn_in_op2regst_desc_id;
+    // the regsts the kernel reads and writes, and for each bn slot of the kernel the index of its
+    // regst in regst_desc_ids (-1 if unbound) and its blob ordinal in the regst
+    std::vector<int64_t> regst_desc_ids;
+    std::vector<std::pair<int32_t, int64_t>> bn_slot2regst_idx_and_blob_ordinal;
+    std::vector<Regst*> cur_regsts;
+    std::vector<Blob*> bn_slot2blob;
   };
   using MsgHandler = int (Actor::*)(const ActorMsg&);
   enum class RegstNameType { kNaive = 0, kCustomized };
@@ -67,6 +79,7 @@ class Actor {
   bool ReceiveEordMsg(int64_t regst_desc_id) const;
   DeviceType GetDeviceType() const;
   virtual void VirtualActorInit(const TaskProto&) {}
+  void BindBlobs4ExecKernel(ExecKernel* ek) const;
   int64_t Name2SoleRegstDescId(const std::string& name) const;
   const std::vector<int64_t>& Name2RegstDescIds(const std::string& name) const;
   virtual void InitDeviceCtx(const ThreadCtx&);
@@ -123,6 +136,7 @@ class Actor {
   void AsyncSendRegstMsgToProducer(Regst*, int64_t producer);
   void AsyncSendEORDMsgForAllProducedRegstDesc();
   void AsyncSendQueuedMsg();
+  void SendBatchedMsgs();
 
   // Get Regst
   Regst* GetNaiveCurReadable(int64_t regst_desc_id) const;
@@ -172,6 +186,8 @@ class Actor {
                   // area
   }
   void TryLogActEvent(const std::function<void()>& Callback) const;
+  void UpdtRegstInUseMetrics(const Regst* regst, int64_t reading_cnt,
+                             int64_t new_reading_cnt) const;
 
   // Ready
   bool IsReadReady() const;
@@ -246,8 +262,15 @@ class Actor {
   HashMap<int64_t, int64_t> inplace_regst_desc_id_out2in_;
 
   std::deque<ActorMsg> async_msg_queue_;
+  // the msgs sent right after the acts of one msg, delivered together when it is handled
+  std::vector<ActorMsg> batched_msgs_;
   bool is_kernel_launch_synchronized_;
   std::vector<int64_t> tmp_regst_desc_id_vec_;
+  // null unless the runtime metrics are enabled
+  ActorMetrics* metrics_;
+  bool collect_perf_counters_;
+  // the perf counters of the kernel launches of the current act
+  PerfCounterValues act_perf_counters_;
 };
 
 std::unique_ptr<Actor> NewActor(const TaskProto&, const ThreadCtx&);
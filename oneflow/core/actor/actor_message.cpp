@@ -87,6 +87,21 @@ ActorMsg ActorMsg::BuildCommandMsg(int64_t dst_actor_id, ActorCmd cmd) {
   return msg;
 }
 
+ActorMsg ActorMsg::BuildRegstAcksMsg(const ActorMsg& first, const ActorMsg& second) {
+  CHECK(first.msg_type_ == ActorMsgType::kRegstMsg);
+  CHECK(second.msg_type_ == ActorMsgType::kRegstMsg);
+  CHECK_EQ(first.src_actor_id_, second.src_actor_id_);
+  CHECK_EQ(first.dst_actor_id_, second.dst_actor_id_);
+  ActorMsg msg;
+  msg.src_actor_id_ = first.src_actor_id_;
+  msg.dst_actor_id_ = first.dst_actor_id_;
+  msg.msg_type_ = ActorMsgType::kRegstAcksMsg;
+  msg.regst_acks_.regst_num = 2;
+  msg.regst_acks_.regsts[0] = first.regst_wrapper_.regst;
+  msg.regst_acks_.regsts[1] = second.regst_wrapper_.regst;
+  return msg;
+}
+
 int64_t ActorMsg::SrcMachineId() const {
   return Global<IDMgr>::Get()->MachineId4ActorId(src_actor_id_);
 }
@@ -136,4 +151,32 @@ int64_t ActorMsg::eord_regst_desc_id() const {
   return eord_regst_desc_id_;
 }
 
+bool ActorMsg::IsLocalRegstAck() const {
+  if (msg_type_ != ActorMsgType::kRegstMsg) { return false; }
+  const int64_t this_machine_id = Global<MachineCtx>::Get()->this_machine_id();
+  if (Global<IDMgr>::Get()->MachineId4ActorId(src_actor_id_) != this_machine_id
+      || Global<IDMgr>::Get()->MachineId4ActorId(dst_actor_id_) != this_machine_id) {
+    return false;
+  }
+  return regst_wrapper_.regst->producer_actor_id() == dst_actor_id_;
+}
+
+int64_t ActorMsg::acked_regst_num() const {
+  CHECK_EQ(msg_type_, ActorMsgType::kRegstAcksMsg);
+  return regst_acks_.regst_num;
+}
+
+Regst* ActorMsg::acked_regst(int64_t i) const {
+  CHECK_LT(i, acked_regst_num());
+  return regst_acks_.regsts[i];
+}
+
+bool ActorMsg::TryAddAckedRegst(Regst* regst) {
+  CHECK_EQ(msg_type_, ActorMsgType::kRegstAcksMsg);
+  if (regst_acks_.regst_num == kMaxAckedRegstNumInMsg) { return false; }
+  regst_acks_.regsts[regst_acks_.regst_num] = regst;
+  regst_acks_.regst_num += 1;
+  return true;
+}
+
 }  // namespace oneflow
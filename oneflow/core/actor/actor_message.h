@@ -29,7 +29,10 @@ enum class ActorCmd {
   kConstructActor
 };
 
-enum class ActorMsgType { kRegstMsg = 0, kEordMsg, kCmdMsg };
+enum class ActorMsgType { kRegstMsg = 0, kEordMsg, kCmdMsg, kRegstAcksMsg };
+
+// as many regst ptrs as fit into the space of a regst msg
+constexpr int64_t kMaxAckedRegstNumInMsg = 6;
 
 class ActorMsg final {
  public:
@@ -42,6 +45,8 @@ class ActorMsg final {
   static ActorMsg BuildRegstMsgToProducer(int64_t consumer, int64_t producer, Regst*);
   static ActorMsg BuildEordMsg(int64_t consumer, int64_t regst_desc_id);
   static ActorMsg BuildCommandMsg(int64_t dst_actor_id, ActorCmd cmd);
+  // the regsts of two regst msgs from one consumer to one local producer in one msg
+  static ActorMsg BuildRegstAcksMsg(const ActorMsg& first, const ActorMsg& second);
 
   // Getters
   int64_t SrcMachineId() const;
@@ -56,6 +61,12 @@ class ActorMsg final {
   void* comm_net_token() const;
   bool has_sole_empty_tensor_in_sole_tensor_list() const;
   int64_t eord_regst_desc_id() const;
+  // true for a regst msg returning a regst to its producer on this machine
+  bool IsLocalRegstAck() const;
+  int64_t acked_regst_num() const;
+  Regst* acked_regst(int64_t i) const;
+  // false if the regst acks msg is full
+  bool TryAddAckedRegst(Regst* regst);
 
   // Serialize
   template<typename StreamT>
@@ -74,6 +85,11 @@ class ActorMsg final {
     RegstStatus regst_status;
     bool has_sole_empty_tensor_in_sole_tensor_list;
   };
+  struct RegstAcks {
+    int64_t regst_num;
+    Regst* regsts[kMaxAckedRegstNumInMsg];
+  };
+  static_assert(sizeof(RegstAcks) <= sizeof(RegstWrapper), "regst acks enlarge ActorMsg");
 
   int64_t src_actor_id_;
   int64_t dst_actor_id_;
@@ -81,6 +97,7 @@ class ActorMsg final {
   union {
     ActorCmd actor_cmd_;
     RegstWrapper regst_wrapper_;
+    RegstAcks regst_acks_;
     int64_t eord_regst_desc_id_;
   };
 };
@@ -18,23 +18,107 @@ limitations under the License.
 #include "oneflow/core/job/machine_context.h"
 #include "oneflow/core/thread/thread_manager.h"
 #include "oneflow/core/comm_network/comm_network.h"
+#include "oneflow/core/job/runtime_metrics.h"
 
 namespace oneflow {
 
+void GroupActorMsgsByThrd(const std::vector<ActorMsg>& msgs,
+                          const std::function<int64_t(int64_t)>& ThrdId4ActorId,
+                          const std::function<bool(const ActorMsg&)>& IsRegstAck,
+                          std::vector<std::pair<int64_t, std::vector<ActorMsg>>>* thrd_id7msgs) {
+  HashMap<int64_t, size_t> thrd_id2idx;
+  // the regst acks msg each dst actor may still get more regsts in
+  HashMap<int64_t, size_t> dst_actor_id2acks_msg_idx;
+  for (const ActorMsg& msg : msgs) {
+    const int64_t thrd_id = ThrdId4ActorId(msg.dst_actor_id());
+    auto thrd_idx_it = thrd_id2idx.find(thrd_id);
+    if (thrd_idx_it == thrd_id2idx.end()) {
+      thrd_idx_it = thrd_id2idx.emplace(thrd_id, thrd_id7msgs->size()).first;
+      thrd_id7msgs->emplace_back(thrd_id, std::vector<ActorMsg>());
+    }
+    std::vector<ActorMsg>* thrd_msgs = &thrd_id7msgs->at(thrd_idx_it->second).second;
+    if (!IsRegstAck(msg)) {
+      dst_actor_id2acks_msg_idx.erase(msg.dst_actor_id());
+      thrd_msgs->push_back(msg);
+      continue;
+    }
+    const auto& acks_msg_idx_it = dst_actor_id2acks_msg_idx.find(msg.dst_actor_id());
+    if (acks_msg_idx_it != dst_actor_id2acks_msg_idx.end()) {
+      ActorMsg* acks_msg = &thrd_msgs->at(acks_msg_idx_it->second);
+      if (acks_msg->src_actor_id() == msg.src_actor_id()) {
+        if (acks_msg->msg_type() == ActorMsgType::kRegstMsg) {
+          *acks_msg = ActorMsg::BuildRegstAcksMsg(*acks_msg, msg);
+          continue;
+        } else if (acks_msg->TryAddAckedRegst(msg.regst())) {
+          continue;
+        }
+      }
+    }
+    dst_actor_id2acks_msg_idx[msg.dst_actor_id()] = thrd_msgs->size();
+    thrd_msgs->push_back(msg);
+  }
+}
+
+ActorMsgBus::ActorMsgBus()
+    : sent_msg_cnt_(0), enqueue_cnt_(0), coalesced_ack_cnt_(0), create_time_(GetCurTime()) {}
+
+ActorMsgBus::~ActorMsgBus() {
+  const double sec = (GetCurTime() - create_time_) / 1e9;
+  LOG(INFO) << "actor msg bus sent " << sent_msg_cnt_ << " msgs (" << sent_msg_cnt_ / sec
+            << " per sec) in " << enqueue_cnt_ << " enqueues, " << coalesced_ack_cnt_
+            << " regst acks coalesced";
+}
+
 void ActorMsgBus::SendMsg(const ActorMsg& msg) {
+  sent_msg_cnt_ += 1;
   int64_t dst_machine_id = Global<IDMgr>::Get()->MachineId4ActorId(msg.dst_actor_id());
   if (dst_machine_id == Global<MachineCtx>::Get()->this_machine_id()) {
     SendMsgWithoutCommNet(msg);
   } else {
-    Global<CommNet>::Get()->SendActorMsg(dst_machine_id, msg);
+    SendMsgWithCommNet(dst_machine_id, msg);
   }
 }
 
+void ActorMsgBus::SendMsgs(const std::vector<ActorMsg>& msgs) {
+  sent_msg_cnt_ += msgs.size();
+  const int64_t this_machine_id = Global<MachineCtx>::Get()->this_machine_id();
+  std::vector<ActorMsg> local_msgs;
+  local_msgs.reserve(msgs.size());
+  for (const ActorMsg& msg : msgs) {
+    const int64_t dst_machine_id = Global<IDMgr>::Get()->MachineId4ActorId(msg.dst_actor_id());
+    if (dst_machine_id == this_machine_id) {
+      local_msgs.push_back(msg);
+    } else {
+      SendMsgWithCommNet(dst_machine_id, msg);
+    }
+  }
+  std::vector<std::pair<int64_t, std::vector<ActorMsg>>> thrd_id7msgs;
+  GroupActorMsgsByThrd(
+      local_msgs,
+      [](int64_t actor_id) { return Global<IDMgr>::Get()->ThrdId4ActorId(actor_id); },
+      [](const ActorMsg& msg) { return msg.IsLocalRegstAck(); }, &thrd_id7msgs);
+  size_t grouped_msg_cnt = 0;
+  for (const auto& pair : thrd_id7msgs) {
+    Global<ThreadMgr>::Get()->GetThrd(pair.first)->EnqueueActorMsgs(pair.second);
+    enqueue_cnt_ += 1;
+    grouped_msg_cnt += pair.second.size();
+  }
+  coalesced_ack_cnt_ += local_msgs.size() - grouped_msg_cnt;
+}
+
 void ActorMsgBus::SendMsgWithoutCommNet(const ActorMsg& msg) {
   CHECK_EQ(Global<IDMgr>::Get()->MachineId4ActorId(msg.dst_actor_id()),
            Global<MachineCtx>::Get()->this_machine_id());
+  enqueue_cnt_ += 1;
   int64_t thrd_id = Global<IDMgr>::Get()->ThrdId4ActorId(msg.dst_actor_id());
   Global<ThreadMgr>::Get()->GetThrd(thrd_id)->EnqueueActorMsg(msg);
 }
 
+void ActorMsgBus::SendMsgWithCommNet(int64_t dst_machine_id, const ActorMsg& msg) {
+  if (Global<RuntimeMetrics>::Get() != nullptr) {
+    Global<RuntimeMetrics>::Get()->ThreadLocalPeerMetrics(dst_machine_id)->sent_msg_cnt.Add(1);
+  }
+  Global<CommNet>::Get()->SendActorMsg(dst_machine_id, msg);
+}
+
 }  // namespace oneflow
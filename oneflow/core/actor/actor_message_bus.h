@@ -21,17 +21,41 @@ limitations under the License.
 
 namespace oneflow {
 
+// Groups msgs by the thread of their dst actor, in the order the threads are first met. A run of
+// regst acks from one consumer to one producer, with no other msg to the producer in between,
+// becomes one regst acks msg, so that every actor still gets its msgs in the order they were sent.
+void GroupActorMsgsByThrd(const std::vector<ActorMsg>& msgs,
+                          const std::function<int64_t(int64_t)>& ThrdId4ActorId,
+                          const std::function<bool(const ActorMsg&)>& IsRegstAck,
+                          std::vector<std::pair<int64_t, std::vector<ActorMsg>>>* thrd_id7msgs);
+
 class ActorMsgBus final {
  public:
   OF_DISALLOW_COPY_AND_MOVE(ActorMsgBus);
-  ~ActorMsgBus() = default;
+  ~ActorMsgBus();
 
   void SendMsg(const ActorMsg& msg);
+  // One enqueue for the msgs to each thread of this machine, and the regst msgs one consumer
+  // returns to one producer are coalesced
+  void SendMsgs(const std::vector<ActorMsg>& msgs);
   void SendMsgWithoutCommNet(const ActorMsg& msg);
 
+  // msgs sent by the actors of this machine, to compare runs with and without actor fusion
+  int64_t sent_msg_cnt() const { return sent_msg_cnt_; }
+  // enqueues into the mailboxes of the threads, a batch of msgs is one
+  int64_t enqueue_cnt() const { return enqueue_cnt_; }
+  int64_t coalesced_ack_cnt() const { return coalesced_ack_cnt_; }
+
  private:
   friend class Global<ActorMsgBus>;
-  ActorMsgBus() = default;
+  ActorMsgBus();
+
+  void SendMsgWithCommNet(int64_t dst_machine_id, const ActorMsg& msg);
+
+  std::atomic<int64_t> sent_msg_cnt_;
+  std::atomic<int64_t> enqueue_cnt_;
+  std::atomic<int64_t> coalesced_ack_cnt_;
+  double create_time_;
 };
 
 }  // namespace oneflow
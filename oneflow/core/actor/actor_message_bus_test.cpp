@@ -0,0 +1,95 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/actor/actor_message_bus.h"
+
+namespace oneflow {
+
+namespace {
+
+// actors 0-9 are on thread 0, 10-19 on thread 1, and an actor acks the regsts of lower actors
+Regst* FakeRegst(int64_t i) { return reinterpret_cast<Regst*>(0x1000 + i * 0x100); }
+
+ActorMsg Ack(int64_t consumer, int64_t producer, int64_t i) {
+  return ActorMsg::BuildRegstMsgToProducer(consumer, producer, FakeRegst(i));
+}
+
+std::vector<std::pair<int64_t, std::vector<ActorMsg>>> Group(const std::vector<ActorMsg>& msgs) {
+  std::vector<std::pair<int64_t, std::vector<ActorMsg>>> thrd_id7msgs;
+  GroupActorMsgsByThrd(
+      msgs, [](int64_t actor_id) { return actor_id / 10; },
+      [](const ActorMsg& msg) {
+        return msg.msg_type() == ActorMsgType::kRegstMsg && msg.src_actor_id() > msg.dst_actor_id();
+      },
+      &thrd_id7msgs);
+  return thrd_id7msgs;
+}
+
+}  // namespace
+
+TEST(ActorMsgBus, group_by_thrd) {
+  const auto thrd_id7msgs =
+      Group({ActorMsg::BuildEordMsg(12, 0), ActorMsg::BuildEordMsg(3, 0), Ack(13, 11, 0)});
+  ASSERT_EQ(thrd_id7msgs.size(), 2);
+  ASSERT_EQ(thrd_id7msgs.at(0).first, 1);
+  ASSERT_EQ(thrd_id7msgs.at(0).second.size(), 2);
+  ASSERT_EQ(thrd_id7msgs.at(0).second.at(0).dst_actor_id(), 12);
+  ASSERT_EQ(thrd_id7msgs.at(0).second.at(1).dst_actor_id(), 11);
+  ASSERT_EQ(thrd_id7msgs.at(1).first, 0);
+  ASSERT_EQ(thrd_id7msgs.at(1).second.size(), 1);
+}
+
+TEST(ActorMsgBus, coalesce_regst_acks) {
+  std::vector<ActorMsg> msgs;
+  FOR_RANGE(int64_t, i, 0, kMaxAckedRegstNumInMsg + 2) { msgs.push_back(Ack(5, 1, i)); }
+  const auto thrd_id7msgs = Group(msgs);
+  ASSERT_EQ(thrd_id7msgs.size(), 1);
+  const std::vector<ActorMsg>& grouped = thrd_id7msgs.at(0).second;
+  ASSERT_EQ(grouped.size(), 2);
+  ASSERT_EQ(grouped.at(0).msg_type(), ActorMsgType::kRegstAcksMsg);
+  ASSERT_EQ(grouped.at(0).acked_regst_num(), kMaxAckedRegstNumInMsg);
+  FOR_RANGE(int64_t, i, 0, kMaxAckedRegstNumInMsg) {
+    ASSERT_EQ(grouped.at(0).acked_regst(i), FakeRegst(i));
+  }
+  ASSERT_EQ(grouped.at(1).msg_type(), ActorMsgType::kRegstAcksMsg);
+  ASSERT_EQ(grouped.at(1).acked_regst_num(), 2);
+  ASSERT_EQ(grouped.at(1).acked_regst(1), FakeRegst(kMaxAckedRegstNumInMsg + 1));
+}
+
+TEST(ActorMsgBus, keep_order_of_acks_and_other_msgs) {
+  // the eord to actor 1 ends the run of acks to it, the acks to actor 2 go on around it
+  const auto thrd_id7msgs =
+      Group({Ack(5, 1, 0), Ack(5, 2, 1), Ack(5, 1, 2), ActorMsg::BuildEordMsg(1, 0),
+             Ack(5, 1, 3), Ack(5, 2, 4), Ack(6, 2, 5)});
+  ASSERT_EQ(thrd_id7msgs.size(), 1);
+  const std::vector<ActorMsg>& grouped = thrd_id7msgs.at(0).second;
+  ASSERT_EQ(grouped.size(), 5);
+  ASSERT_EQ(grouped.at(0).msg_type(), ActorMsgType::kRegstAcksMsg);
+  ASSERT_EQ(grouped.at(0).dst_actor_id(), 1);
+  ASSERT_EQ(grouped.at(0).acked_regst_num(), 2);
+  ASSERT_EQ(grouped.at(0).acked_regst(1), FakeRegst(2));
+  ASSERT_EQ(grouped.at(1).msg_type(), ActorMsgType::kRegstAcksMsg);
+  ASSERT_EQ(grouped.at(1).dst_actor_id(), 2);
+  ASSERT_EQ(grouped.at(1).acked_regst_num(), 2);
+  ASSERT_EQ(grouped.at(1).acked_regst(1), FakeRegst(4));
+  ASSERT_EQ(grouped.at(2).msg_type(), ActorMsgType::kEordMsg);
+  ASSERT_EQ(grouped.at(3).msg_type(), ActorMsgType::kRegstMsg);
+  ASSERT_EQ(grouped.at(3).regst(), FakeRegst(3));
+  // an ack from another consumer is not merged into the run of actor 5
+  ASSERT_EQ(grouped.at(4).msg_type(), ActorMsgType::kRegstMsg);
+  ASSERT_EQ(grouped.at(4).src_actor_id(), 6);
+}
+
+}  // namespace oneflow
@@ -97,6 +97,10 @@ void CopyCommNetActor::Act() {
     void* writeable_token = writeable_regst->comm_net_token();
     // Async
     Global<CommNet>::Get()->Read(actor_read_id_, src_machine_id, readable_token, writeable_token);
+    if (Global<RuntimeMetrics>::Get() != nullptr) {
+      Global<RuntimeMetrics>::Get()->ThreadLocalPeerMetrics(src_machine_id)->read_byte_size.Add(
+          writeable_regst->regst_desc()->MainByteSize4OneRegst());
+    }
   }
 }
 
@@ -97,6 +97,9 @@ IBVerbsCommNet::IBVerbsCommNet(const Plan& plan)
   CHECK_EQ(ibv_query_gid(context_, 1, 0, &gid), 0);
   int64_t this_machine_id = Global<MachineCtx>::Get()->this_machine_id();
   qp_vec_.assign(Global<ResourceDesc, ForSession>::Get()->TotalMachineNum(), nullptr);
+  // the conn infos of all peers are pushed and pulled with one rpc per ctrl server
+  HashMap<std::string, std::string> key2conn_info;
+  std::vector<std::string> peer_keys;
   for (int64_t peer_id : peer_machine_id()) {
     IBVerbsQP* cur_qp = new IBVerbsQP(context_, pd_, cq_, cq_);
     qp_vec_.at(peer_id) = cur_qp;
@@ -105,12 +108,18 @@ IBVerbsCommNet::IBVerbsCommNet(const Plan& plan)
     conn_info.set_qp_num(cur_qp->qp_num());
     conn_info.set_subnet_prefix(gid.global.subnet_prefix);
     conn_info.set_interface_id(gid.global.interface_id);
-    Global<CtrlClient>::Get()->PushKV(GenConnInfoKey(this_machine_id, peer_id), conn_info);
+    conn_info.SerializeToString(&key2conn_info[GenConnInfoKey(this_machine_id, peer_id)]);
+    peer_keys.push_back(GenConnInfoKey(peer_id, this_machine_id));
   }
+  Global<CtrlClient>::Get()->PushKVs(key2conn_info);
+  std::vector<std::string> peer_conn_infos;
+  Global<CtrlClient>::Get()->PullKVs(peer_keys, &peer_conn_infos);
+  int64_t peer_idx = 0;
   for (int64_t peer_id : peer_machine_id()) {
     IBVerbsConnectionInfo conn_info;
-    Global<CtrlClient>::Get()->PullKV(GenConnInfoKey(peer_id, this_machine_id), &conn_info);
+    conn_info.ParseFromString(peer_conn_infos.at(peer_idx));
     qp_vec_.at(peer_id)->Connect(conn_info);
+    peer_idx += 1;
   }
   // TODO(chengcheng): change to OF_ENV_BARRIER
   OF_SESSION_BARRIER();
@@ -30,6 +30,7 @@ class Channel final {
   ~Channel() = default;
 
   ChannelStatus Send(const T& item);
+  ChannelStatus SendMany(const std::vector<T>& items);
   ChannelStatus Receive(T* item);
   ChannelStatus ReceiveMany(std::queue<T>* items);
   void Close();
@@ -50,6 +51,15 @@ ChannelStatus Channel<T>::Send(const T& item) {
   return kChannelStatusSuccess;
 }
 
+template<typename T>
+ChannelStatus Channel<T>::SendMany(const std::vector<T>& items) {
+  std::unique_lock<std::mutex> lock(mutex_);
+  if (is_closed_) { return kChannelStatusErrorClosed; }
+  for (const T& item : items) { queue_.push(item); }
+  cond_.notify_one();
+  return kChannelStatusSuccess;
+}
+
 template<typename T>
 ChannelStatus Channel<T>::Receive(T* item) {
   std::unique_lock<std::mutex> lock(mutex_);
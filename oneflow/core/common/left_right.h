@@ -0,0 +1,123 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifndef ONEFLOW_CORE_COMMON_LEFT_RIGHT_H_
+#define ONEFLOW_CORE_COMMON_LEFT_RIGHT_H_
+
+#include <array>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include "oneflow/core/common/util.h"
+
+namespace oneflow {
+
+// Counts the readers in flight. Each thread arrives and departs on its own padded slot, so that
+// concurrent readers do not write the same cache line.
+class ReadIndicator final {
+ public:
+  OF_DISALLOW_COPY_AND_MOVE(ReadIndicator);
+  ReadIndicator() {
+    for (Slot& slot : slots_) { slot.count.store(0); }
+  }
+  ~ReadIndicator() = default;
+
+  void Arrive() { slots_.at(ThreadSlotId()).count.fetch_add(1); }
+  void Depart() { slots_.at(ThreadSlotId()).count.fetch_sub(1); }
+  bool IsEmpty() const {
+    for (const Slot& slot : slots_) {
+      if (slot.count.load() != 0) { return false; }
+    }
+    return true;
+  }
+
+ private:
+  static const size_t kNumSlots = 32;
+  static const size_t kCacheLineSize = 64;
+
+  struct Slot {
+    std::atomic<int64_t> count;
+    char padding[kCacheLineSize - sizeof(std::atomic<int64_t>)];
+  };
+
+  static size_t ThreadSlotId() {
+    static std::atomic<size_t> next_slot_id(0);
+    static thread_local const size_t slot_id = next_slot_id.fetch_add(1) % kNumSlots;
+    return slot_id;
+  }
+
+  std::array<Slot, kNumSlots> slots_;
+};
+
+// A read-mostly container after the Left-Right algorithm (Ramalhete and Correia). Two instances
+// of T are kept, readers never block and run on the instance which is not being written, while
+// writers are serialized and apply each modification to both instances in turn. A read costs
+// two uncontended atomic increments instead of a lock.
+//
+// The writer passed to Write() is applied twice, it must modify both instances in the same way.
+template<typename T>
+class LeftRight final {
+ public:
+  OF_DISALLOW_COPY_AND_MOVE(LeftRight);
+  LeftRight() : left_right_(0), version_index_(0) {}
+  ~LeftRight() = default;
+
+  template<typename ReaderT>
+  auto Read(const ReaderT& Reader) const -> decltype(Reader(std::declval<const T&>())) {
+    ReadGuard guard(this);
+    return Reader(instances_.at(left_right_.load()));
+  }
+
+  template<typename WriterT>
+  void Write(const WriterT& Writer) {
+    std::unique_lock<std::mutex> lock(writer_mutex_);
+    const int left_right = left_right_.load();
+    Writer(&instances_.at(1 - left_right));
+    left_right_.store(1 - left_right);
+    const int version_index = version_index_.load();
+    WaitUntilEmpty(1 - version_index);
+    version_index_.store(1 - version_index);
+    WaitUntilEmpty(version_index);
+    // no reader is left on the previous instance
+    Writer(&instances_.at(left_right));
+  }
+
+ private:
+  class ReadGuard final {
+   public:
+    explicit ReadGuard(const LeftRight* left_right)
+        : read_indicator_(&left_right->read_indicators_.at(left_right->version_index_.load())) {
+      read_indicator_->Arrive();
+    }
+    ~ReadGuard() { read_indicator_->Depart(); }
+
+   private:
+    ReadIndicator* read_indicator_;
+  };
+
+  void WaitUntilEmpty(int version_index) const {
+    while (!read_indicators_.at(version_index).IsEmpty()) { std::this_thread::yield(); }
+  }
+
+  std::array<T, 2> instances_;
+  std::atomic<int> left_right_;
+  std::atomic<int> version_index_;
+  mutable std::array<ReadIndicator, 2> read_indicators_;
+  std::mutex writer_mutex_;
+};
+
+}  // namespace oneflow
+
+#endif  // ONEFLOW_CORE_COMMON_LEFT_RIGHT_H_
@@ -0,0 +1,133 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include <chrono>
+#include "oneflow/core/common/left_right.h"
+
+namespace oneflow {
+
+namespace test {
+
+namespace {
+
+using Id2Value = HashMap<int64_t, std::shared_ptr<int64_t>>;
+
+// Each reader looks up `num_lookups` ids in [0, num_ids) with `Lookup` and returns the
+// nanoseconds per lookup of the slowest reader
+double MeasureNsPerLookup(int num_readers, int64_t num_ids, int64_t num_lookups,
+                          const std::function<int64_t(int64_t)>& Lookup) {
+  std::atomic<int64_t> max_nanos(0);
+  std::vector<std::thread> readers;
+  FOR_RANGE(int, i, 0, num_readers) {
+    readers.emplace_back([&, i]() {
+      int64_t sum = 0;
+      const auto start = std::chrono::steady_clock::now();
+      FOR_RANGE(int64_t, j, 0, num_lookups) { sum += Lookup((i + j) % num_ids); }
+      const int64_t nanos = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                std::chrono::steady_clock::now() - start)
+                                .count();
+      CHECK_GT(sum, 0);
+      int64_t prev = max_nanos.load();
+      while (prev < nanos && !max_nanos.compare_exchange_weak(prev, nanos)) {}
+    });
+  }
+  for (std::thread& reader : readers) { reader.join(); }
+  return static_cast<double>(max_nanos.load()) / num_lookups;
+}
+
+}  // namespace
+
+TEST(LeftRight, read_write) {
+  LeftRight<Id2Value> id2value;
+  FOR_RANGE(int64_t, i, 0, 10) {
+    id2value.Write([&](Id2Value* map) { map->emplace(i, std::make_shared<int64_t>(i)); });
+  }
+  id2value.Write([](Id2Value* map) { map->erase(3); });
+  FOR_RANGE(int64_t, i, 0, 10) {
+    const int64_t* value = id2value.Read([&](const Id2Value& map) -> const int64_t* {
+      const auto& it = map.find(i);
+      return it == map.end() ? nullptr : it->second.get();
+    });
+    if (i == 3) {
+      ASSERT_TRUE(value == nullptr);
+    } else {
+      ASSERT_EQ(*value, i);
+    }
+  }
+}
+
+TEST(LeftRight, concurrent_read_write) {
+  // the writer keeps first == second in each write, readers must never see a half written pair
+  LeftRight<std::pair<int64_t, int64_t>> pair;
+  const int num_readers = 8;
+  const int64_t num_writes = 10000;
+  std::atomic<bool> done(false);
+  std::vector<std::thread> readers;
+  FOR_RANGE(int, i, 0, num_readers) {
+    readers.emplace_back([&]() {
+      int64_t last = 0;
+      while (!done.load()) {
+        const std::pair<int64_t, int64_t> value =
+            pair.Read([](const std::pair<int64_t, int64_t>& p) { return p; });
+        ASSERT_EQ(value.first, value.second);
+        ASSERT_GE(value.first, last);
+        last = value.first;
+      }
+    });
+  }
+  FOR_RANGE(int64_t, i, 1, num_writes + 1) {
+    pair.Write([&](std::pair<int64_t, int64_t>* p) {
+      p->first = i;
+      p->second = i;
+    });
+  }
+  done.store(true);
+  for (std::thread& reader : readers) { reader.join(); }
+  ASSERT_EQ(pair.Read([](const std::pair<int64_t, int64_t>& p) { return p.first; }), num_writes);
+}
+
+// Lookups of a read-mostly map guarded by a mutex against the LeftRight one, such as the symbol
+// lookups of eager instructions and the executable lookups of xrt launches
+// Run with --gtest_also_run_disabled_tests
+TEST(LeftRight, DISABLED_benchmark_contention) {
+  const int64_t num_ids = 1024;
+  const int64_t num_lookups = 1 << 20;
+  std::mutex mutex;
+  Id2Value locked_id2value;
+  LeftRight<Id2Value> id2value;
+  FOR_RANGE(int64_t, i, 0, num_ids) {
+    const auto& value = std::make_shared<int64_t>(i + 1);
+    locked_id2value.emplace(i, value);
+    id2value.Write([&](Id2Value* map) { map->emplace(i, value); });
+  }
+  const int max_num_readers = std::max<int>(std::thread::hardware_concurrency(), 2);
+  for (int num_readers = 1; num_readers <= max_num_readers; num_readers *= 2) {
+    const double mutex_ns =
+        MeasureNsPerLookup(num_readers, num_ids, num_lookups, [&](int64_t id) -> int64_t {
+          std::unique_lock<std::mutex> lock(mutex);
+          return *locked_id2value.at(id);
+        });
+    const double left_right_ns =
+        MeasureNsPerLookup(num_readers, num_ids, num_lookups, [&](int64_t id) -> int64_t {
+          return id2value.Read([&](const Id2Value& map) { return *map.at(id); });
+        });
+    LOG(INFO) << num_readers << " readers: mutex " << mutex_ns << " ns/lookup, left-right "
+              << left_right_ns << " ns/lookup";
+  }
+}
+
+}  // namespace test
+
+}  // namespace oneflow
@@ -0,0 +1,120 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/common/perf_counters.h"
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif  // __linux__
+
+namespace oneflow {
+
+namespace {
+
+#ifdef __linux__
+
+uint64_t PerfEventConfig(PerfCounterType type) {
+  switch (type) {
+    case kCyclesPerfCounter: return PERF_COUNT_HW_CPU_CYCLES;
+    case kInstructionsPerfCounter: return PERF_COUNT_HW_INSTRUCTIONS;
+    case kLlcMissesPerfCounter: return PERF_COUNT_HW_CACHE_MISSES;
+    case kBranchMissesPerfCounter: return PERF_COUNT_HW_BRANCH_MISSES;
+    default: UNIMPLEMENTED();
+  }
+  return 0;
+}
+
+int OpenPerfEvent(PerfCounterType type, int group_fd) {
+  perf_event_attr attr;
+  memset(&attr, 0, sizeof(attr));
+  attr.size = sizeof(attr);
+  attr.type = PERF_TYPE_HARDWARE;
+  attr.config = PerfEventConfig(type);
+  attr.read_format = PERF_FORMAT_GROUP;
+  attr.exclude_kernel = 1;
+  attr.exclude_hv = 1;
+  // the group starts as a whole once the leader is enabled
+  attr.disabled = group_fd == -1 ? 1 : 0;
+  return static_cast<int>(syscall(__NR_perf_event_open, &attr, 0, -1, group_fd, 0));
+}
+
+#endif  // __linux__
+
+}  // namespace
+
+ThreadPerfCounters::~ThreadPerfCounters() {
+#ifdef __linux__
+  for (int fd : fds_) { close(fd); }
+#endif  // __linux__
+}
+
+ThreadPerfCounters* ThreadPerfCounters::Get() {
+  static thread_local std::unique_ptr<ThreadPerfCounters> counters;
+  static thread_local bool opened = false;
+  if (!opened) {
+    opened = true;
+    counters.reset(new ThreadPerfCounters());
+    if (!counters->Open()) { counters.reset(); }
+  }
+  return counters.get();
+}
+
+bool ThreadPerfCounters::Open() {
+#ifdef __linux__
+  FOR_RANGE(int, i, 0, kPerfCounterTypeNum) {
+    const PerfCounterType type = static_cast<PerfCounterType>(i);
+    const int fd = OpenPerfEvent(type, group_fd_);
+    if (fd == -1) {
+      // a missing member leaves its value -1, without a leader there is no group
+      if (group_fd_ != -1) { continue; }
+      static std::once_flag warned;
+      std::call_once(warned, [] {
+        PLOG(WARNING) << "hardware perf counters are not collected, they need a linux "
+                         "perf_event_paranoid not above 2 or CAP_PERFMON";
+      });
+      return false;
+    }
+    if (group_fd_ == -1) { group_fd_ = fd; }
+    fds_.push_back(fd);
+    types_.push_back(type);
+  }
+  PCHECK(ioctl(group_fd_, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP) == 0);
+  PCHECK(ioctl(group_fd_, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP) == 0);
+  return true;
+#else
+  static std::once_flag warned;
+  std::call_once(warned, [] {
+    LOG(WARNING) << "hardware perf counters are only collected on linux";
+  });
+  return false;
+#endif  // __linux__
+}
+
+void ThreadPerfCounters::Read(PerfCounterValues* values) const {
+  values->fill(-1);
+#ifdef __linux__
+  // the number of counters followed by their values
+  uint64_t buffer[kPerfCounterTypeNum + 1];
+  const ssize_t size = read(group_fd_, buffer, sizeof(buffer));
+  if (size < static_cast<ssize_t>(sizeof(uint64_t))) { return; }
+  CHECK_EQ(buffer[0], types_.size());
+  FOR_RANGE(size_t, i, 0, types_.size()) { values->at(types_.at(i)) = buffer[i + 1]; }
+#endif  // __linux__
+}
+
+}  // namespace oneflow
@@ -0,0 +1,61 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifndef ONEFLOW_CORE_COMMON_PERF_COUNTERS_H_
+#define ONEFLOW_CORE_COMMON_PERF_COUNTERS_H_
+
+#include <array>
+#include "oneflow/core/common/util.h"
+
+namespace oneflow {
+
+enum PerfCounterType {
+  kCyclesPerfCounter = 0,
+  kInstructionsPerfCounter,
+  kLlcMissesPerfCounter,
+  kBranchMissesPerfCounter,
+  kPerfCounterTypeNum
+};
+
+// -1 for the counters the cpu does not have
+using PerfCounterValues = std::array<int64_t, kPerfCounterTypeNum>;
+
+// The hardware counters of the calling thread, opened with perf_event_open as one group so that
+// they are read together with one syscall. Only user space is counted, which needs no more than
+// perf_event_paranoid 2.
+class ThreadPerfCounters final {
+ public:
+  OF_DISALLOW_COPY_AND_MOVE(ThreadPerfCounters);
+  ~ThreadPerfCounters();
+
+  // The counters of the calling thread, nullptr if the platform or the permissions do not allow
+  // them, which is logged once per process
+  static ThreadPerfCounters* Get();
+
+  void Read(PerfCounterValues* values) const;
+
+ private:
+  ThreadPerfCounters() = default;
+  bool Open();
+
+  int group_fd_ = -1;
+  std::vector<int> fds_;
+  // the types of the opened counters in the order of the group
+  std::vector<PerfCounterType> types_;
+};
+
+}  // namespace oneflow
+
+#endif  // ONEFLOW_CORE_COMMON_PERF_COUNTERS_H_
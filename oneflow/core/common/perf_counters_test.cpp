@@ -0,0 +1,64 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/common/perf_counters.h"
+
+namespace oneflow {
+
+namespace {
+
+int64_t Spin(int64_t n) {
+  volatile int64_t sum = 0;
+  FOR_RANGE(int64_t, i, 0, n) { sum += i * i; }
+  return sum;
+}
+
+}  // namespace
+
+// nullptr where the platform or the permissions deny perf_event, monotonic counters otherwise
+TEST(ThreadPerfCounters, get_and_read) {
+  ThreadPerfCounters* counters = ThreadPerfCounters::Get();
+  ASSERT_EQ(ThreadPerfCounters::Get(), counters);
+  if (counters == nullptr) { return; }
+  PerfCounterValues first;
+  PerfCounterValues second;
+  counters->Read(&first);
+  Spin(1 << 20);
+  counters->Read(&second);
+  FOR_RANGE(int, i, 0, kPerfCounterTypeNum) {
+    ASSERT_GE(first.at(i), -1);
+    if (first.at(i) == -1) {
+      ASSERT_EQ(second.at(i), -1);
+    } else {
+      ASSERT_GE(second.at(i), first.at(i));
+    }
+  }
+}
+
+TEST(ThreadPerfCounters, one_group_per_thread) {
+  ThreadPerfCounters* counters = ThreadPerfCounters::Get();
+  ThreadPerfCounters* other_counters = nullptr;
+  std::thread([&]() {
+    other_counters = ThreadPerfCounters::Get();
+    if (other_counters != nullptr) {
+      PerfCounterValues values;
+      other_counters->Read(&values);
+      for (int64_t value : values) { ASSERT_GE(value, -1); }
+    }
+  }).join();
+  if (counters != nullptr && other_counters != nullptr) { ASSERT_NE(counters, other_counters); }
+}
+
+}  // namespace oneflow
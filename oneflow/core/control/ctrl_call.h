@@ -66,8 +66,9 @@ class CtrlCall final : public CtrlCallIf {
   }
 
   void SendResponse() override {
-    responder_.Finish(response_, grpc::Status::OK, this);
+    // the completion may be processed by another thread as soon as Finish is called
     status_ = Status::kBeforeDelete;
+    responder_.Finish(response_, grpc::Status::OK, this);
   }
 
  private:
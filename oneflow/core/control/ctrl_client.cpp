@@ -23,6 +23,8 @@ namespace {
 
 const int32_t max_retry_num = 60;
 const int64_t sleep_seconds = 10;
+// the flat barrier takes a single round trip but all the machines wait on the master
+const int64_t max_flat_barrier_machine_num = 32;
 
 #define GRPC_CHECK(x) CHECK_EQ(x.error_code(), grpc::StatusCode::OK)
 
@@ -56,7 +58,7 @@ CtrlClient::~CtrlClient() {
 }
 
 void CtrlClient::Barrier(const std::string& barrier_name) {
-  Barrier(barrier_name, Global<EnvDesc>::Get()->TotalMachineNum());
+  MachineBarrier(barrier_name, Global<EnvDesc>::Get()->TotalMachineNum());
 }
 
 void CtrlClient::Barrier(const std::string& barrier_name, int32_t barrier_num) {
@@ -66,6 +68,39 @@ void CtrlClient::Barrier(const std::string& barrier_name, int32_t barrier_num) {
   call(GetMasterStub());
 }
 
+void CtrlClient::MachineBarrier(const std::string& barrier_name, int64_t machine_num) {
+  if (machine_num <= max_flat_barrier_machine_num) {
+    Barrier(barrier_name, machine_num);
+  } else {
+    TreeBarrier(barrier_name, machine_num);
+  }
+}
+
+// The machines form a binary tree. A machine arrives at the barrier on its parent's ctrl server
+// once its whole subtree has arrived at its own, the release goes down the tree the same way.
+void CtrlClient::TreeBarrier(const std::string& barrier_name, int64_t machine_num) {
+  const int64_t machine_id = Global<MachineCtx>::Get()->this_machine_id();
+  CHECK_LT(machine_id, machine_num);
+  auto ChildNum = [&](int64_t id) {
+    return std::max<int64_t>(std::min<int64_t>(machine_num - (2 * id + 1), 2), 0);
+  };
+  auto BarrierOn = [&](int64_t id, const std::string& name) {
+    ClientCall<CtrlMethod::kBarrier> call;
+    call.mut_request()->set_name(name);
+    call.mut_request()->set_num(1 + ChildNum(id));
+    call(stubs_.at(id).get());
+  };
+  const std::string arrive_name = barrier_name + "_arrive";
+  const std::string release_name = barrier_name + "_release";
+  const int64_t parent_id = (machine_id - 1) / 2;
+  if (ChildNum(machine_id) > 0) { BarrierOn(machine_id, arrive_name); }
+  if (machine_id != 0) {
+    BarrierOn(parent_id, arrive_name);
+    BarrierOn(parent_id, release_name);
+  }
+  if (ChildNum(machine_id) > 0) { BarrierOn(machine_id, release_name); }
+}
+
 TryLockResult CtrlClient::TryLock(const std::string& name) {
   {
     std::unique_lock<std::mutex> lck(done_names_mtx_);
@@ -119,6 +154,24 @@ void CtrlClient::PushMasterKV(const std::string& k, const PbMessage& msg) {
   PushMasterKV(k, [&](std::string* o) { msg.SerializeToString(o); });
 }
 
+void CtrlClient::PushMachineKV(int64_t machine_id, const std::string& k, const std::string& v) {
+  ClientCall<CtrlMethod::kPushKV> call;
+  call.mut_request()->set_key(k);
+  *call.mut_request()->mutable_val() = v;
+  call(stubs_.at(machine_id).get());
+}
+
+void CtrlClient::PushKVs(const HashMap<std::string, std::string>& k2v) {
+  HashMap<int64_t, ClientCall<CtrlMethod::kPushKVs>> machine_id2call;
+  for (const auto& pair : k2v) {
+    const int64_t machine_id = GetResponsibleMachineId(pair.first);
+    PushKVRequest* kv = machine_id2call[machine_id].mut_request()->add_kv();
+    kv->set_key(pair.first);
+    kv->set_val(pair.second);
+  }
+  for (auto& pair : machine_id2call) { pair.second(stubs_.at(pair.first).get()); }
+}
+
 void CtrlClient::ClearKV(const std::string& k) {
   ClientCall<CtrlMethod::kClearKV> call;
   call.mut_request()->set_key(k);
@@ -158,6 +211,31 @@ void CtrlClient::PullMasterKV(const std::string& k, PbMessage* msg) {
   PullMasterKV(k, [&](const std::string& i) { msg->ParseFromString(i); });
 }
 
+void CtrlClient::PullMachineKV(int64_t machine_id, const std::string& k, std::string* v) {
+  ClientCall<CtrlMethod::kPullKV> call;
+  call.mut_request()->set_key(k);
+  call(stubs_.at(machine_id).get());
+  *v = call.response().val();
+}
+
+void CtrlClient::PullKVs(const std::vector<std::string>& keys, std::vector<std::string>* vals) {
+  HashMap<int64_t, std::pair<ClientCall<CtrlMethod::kPullKVs>, std::vector<int64_t>>>
+      machine_id2call7indices;
+  FOR_RANGE(int64_t, i, 0, keys.size()) {
+    auto* call7indices = &machine_id2call7indices[GetResponsibleMachineId(keys.at(i))];
+    call7indices->first.mut_request()->add_key(keys.at(i));
+    call7indices->second.push_back(i);
+  }
+  vals->resize(keys.size());
+  for (auto& pair : machine_id2call7indices) {
+    ClientCall<CtrlMethod::kPullKVs>* call = &pair.second.first;
+    (*call)(stubs_.at(pair.first).get());
+    const std::vector<int64_t>& indices = pair.second.second;
+    CHECK_EQ(call->response().val_size(), indices.size());
+    FOR_RANGE(int64_t, i, 0, indices.size()) { vals->at(indices.at(i)) = call->response().val(i); }
+  }
+}
+
 void CtrlClient::PushActEvent(const ActEvent& act_event) {
   ClientCall<CtrlMethod::kPushActEvent> call;
   *(call.mut_request()->mutable_act_event()) = act_event;
@@ -246,8 +324,11 @@ CtrlService::Stub* CtrlClient::GetThisStub() {
 }
 
 CtrlService::Stub* CtrlClient::GetResponsibleStub(const std::string& key) {
-  int64_t machine_id = (std::hash<std::string>{}(key)) % Global<EnvDesc>::Get()->TotalMachineNum();
-  return stubs_[machine_id].get();
+  return stubs_[GetResponsibleMachineId(key)].get();
+}
+
+int64_t CtrlClient::GetResponsibleMachineId(const std::string& key) const {
+  return (std::hash<std::string>{}(key)) % Global<EnvDesc>::Get()->TotalMachineNum();
 }
 
 }  // namespace oneflow
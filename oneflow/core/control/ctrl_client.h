@@ -30,6 +30,9 @@ class CtrlClient final {
 
   void Barrier(const std::string& barrier_name);
   void Barrier(const std::string& barrier_name, int32_t barrier_num);
+  // Barrier of the machines [0, machine_num), each of them calls it once
+  void MachineBarrier(const std::string& barrier_name, int64_t machine_num);
+  void TreeBarrier(const std::string& barrier_name, int64_t machine_num);
 
   TryLockResult TryLock(const std::string& name);
   void NotifyDone(const std::string& name);
@@ -39,6 +42,9 @@ class CtrlClient final {
   void PushKV(const std::string& k, const std::string& v);
   void PushKV(const std::string& k, const PbMessage& msg);
   void PushMasterKV(const std::string& k, const PbMessage& msg);
+  void PushMachineKV(int64_t machine_id, const std::string& k, const std::string& v);
+  // one rpc for the keys of each responsible machine
+  void PushKVs(const HashMap<std::string, std::string>& k2v);
   template<typename T>
   typename std::enable_if<std::is_arithmetic<T>::value>::type PushKVT(const std::string& k, T v) {
     PushKV(k, std::to_string(v));
@@ -51,6 +57,8 @@ class CtrlClient final {
   void PullKV(const std::string& k, std::string* v);
   void PullKV(const std::string& k, PbMessage* msg);
   void PullMasterKV(const std::string& k, PbMessage* msg);
+  void PullMachineKV(int64_t machine_id, const std::string& k, std::string* v);
+  void PullKVs(const std::vector<std::string>& keys, std::vector<std::string>* vals);
   template<typename T>
   typename std::enable_if<std::is_arithmetic<T>::value>::type PullKVT(const std::string& k, T* v) {
     std::string v_str;
@@ -74,6 +82,7 @@ class CtrlClient final {
   CtrlService::Stub* GetMasterStub() { return stubs_[0].get(); }
   CtrlService::Stub* GetThisStub();
   CtrlService::Stub* GetResponsibleStub(const std::string& key);
+  int64_t GetResponsibleMachineId(const std::string& key) const;
 
   std::vector<std::unique_ptr<CtrlService::Stub>> stubs_;
   std::mutex done_names_mtx_;
@@ -87,9 +96,9 @@ class CtrlClient final {
 #define FILE_LINE_STR __FILE__ ":" OF_PP_STRINGIZE(__LINE__)
 
 #define OF_ENV_BARRIER() Global<CtrlClient>::Get()->Barrier(FILE_LINE_STR)
-#define OF_SESSION_BARRIER()                        \
-  Global<CtrlClient>::Get()->Barrier(FILE_LINE_STR, \
-                                     Global<ResourceDesc, ForSession>::Get()->TotalMachineNum())
+#define OF_SESSION_BARRIER()          \
+  Global<CtrlClient>::Get()->MachineBarrier( \
+      FILE_LINE_STR, Global<ResourceDesc, ForSession>::Get()->TotalMachineNum())
 
 static void OfCallOnce(const std::string& name, std::function<void()> f) {
   TryLockResult lock_ret = Global<CtrlClient>::Get()->TryLock(name);
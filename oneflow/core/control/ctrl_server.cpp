@@ -31,13 +31,18 @@ int ExtractPortFromAddr(const std::string& addr) {
 }  // namespace
 
 CtrlServer::~CtrlServer() {
+  is_shutdown_ = true;
+  grpc_server_->Shutdown();
   // NOTE(chengcheng): This enqueues a special event (with a null tag) that causes
-  // the completion queue to be shut down on the polling thread.
-  grpc::Alarm alarm(cq_.get(), gpr_now(GPR_CLOCK_MONOTONIC), nullptr);
-  loop_thread_.join();
+  // the completion queue to be shut down on its polling thread.
+  std::vector<std::unique_ptr<grpc::Alarm>> alarms;
+  for (const auto& cq : cqs_) {
+    alarms.emplace_back(new grpc::Alarm(cq.get(), gpr_now(GPR_CLOCK_MONOTONIC), nullptr));
+  }
+  for (std::thread& loop_thread : loop_threads_) { loop_thread.join(); }
 }
 
-CtrlServer::CtrlServer() : is_first_connect_(true), this_machine_addr_("") {
+CtrlServer::CtrlServer() : is_shutdown_(false), is_first_connect_(true), this_machine_addr_("") {
   Init();
   int port = Global<EnvDesc>::Get()->ctrl_port();
   grpc::ServerBuilder server_builder;
@@ -47,30 +52,33 @@ CtrlServer::CtrlServer() : is_first_connect_(true), this_machine_addr_("") {
                                   grpc::InsecureServerCredentials(), &bound_port);
   grpc_service_.reset(new CtrlService::AsyncService);
   server_builder.RegisterService(grpc_service_.get());
-  cq_ = server_builder.AddCompletionQueue();
+  const int32_t thread_num = std::max(Global<EnvDesc>::Get()->ctrl_server_thread_num(), 1);
+  FOR_RANGE(int32_t, i, 0, thread_num) { cqs_.push_back(server_builder.AddCompletionQueue()); }
   grpc_server_ = server_builder.BuildAndStart();
   CHECK_EQ(port, bound_port) << "Port " << port << " is unavailable";
   LOG(INFO) << "CtrlServer listening on "
-            << "0.0.0.0:" + std::to_string(port);
-  loop_thread_ = std::thread(&CtrlServer::HandleRpcs, this);
+            << "0.0.0.0:" + std::to_string(port) << " with " << thread_num << " threads";
+  for (const auto& cq : cqs_) {
+    loop_threads_.emplace_back(&CtrlServer::HandleRpcs, this, cq.get());
+  }
 }
 
-void CtrlServer::HandleRpcs() {
-  EnqueueRequests();
+void CtrlServer::HandleRpcs(grpc::ServerCompletionQueue* cq) {
+  EnqueueRequests(cq);
 
   void* tag = nullptr;
   bool ok = false;
-  // NOTE(chengcheng): The is_shutdown bool flag make sure that 'ok = false' occurs ONLY after
-  // cq_->Shutdown() for security check.
-  bool is_shutdown = false;
-  // NOTE(chengcheng): The final end is that cq_->Next() get false and cq_ is empty with no item.
-  while (cq_->Next(&tag, &ok)) {
+  // NOTE(chengcheng): The is_shutdown_ flag make sure that 'ok = false' occurs ONLY after
+  // grpc_server_->Shutdown() for security check.
+  bool is_cq_shutdown = false;
+  // NOTE(chengcheng): The final end is that cq->Next() get false and cq is empty with no item.
+  while (cq->Next(&tag, &ok)) {
     auto call = static_cast<CtrlCallIf*>(tag);
     if (!ok) {
-      // NOTE(chengcheng): After call grpc_server_->Shutdown() and cq_->Shutdown(),
-      // there will trigger some cancel tag items on each RPC. And cq_->Next() can get these tag
+      // NOTE(chengcheng): After call grpc_server_->Shutdown() and cq->Shutdown(),
+      // there will trigger some cancel tag items on each RPC. And cq->Next() can get these tag
       // with ok = false. Then delete the tag with CtrlCallIf pointer for recovery.
-      CHECK(is_shutdown);
+      CHECK(is_shutdown_);
       CHECK(call);
       delete call;
       continue;
@@ -79,158 +87,209 @@ void CtrlServer::HandleRpcs() {
       call->Process();
     } else {
       // NOTE(chengcheng): A null `call` indicates that this is the shutdown alarm.
-      CHECK(!is_shutdown);
-      is_shutdown = true;
-      grpc_server_->Shutdown();
-      cq_->Shutdown();
+      CHECK(is_shutdown_);
+      CHECK(!is_cq_shutdown);
+      is_cq_shutdown = true;
+      cq->Shutdown();
 
       // NOTE(chengcheng): You CANNOT use code 'break;' in this block because that
-      // there still be items in the cq_.
+      // there still be items in the cq.
       // 'break;'
     }
   }
 }
 
+void CtrlServer::PushKV(const std::string& k, const std::string& v) {
+  KVShard* shard = MutKVShard(k);
+  std::list<std::function<void(const std::string&)>> pending_pulls;
+  {
+    std::unique_lock<std::mutex> lock(shard->mutex);
+    CHECK(shard->kv.emplace(k, v).second);
+    auto pending_pulls_it = shard->pending_pulls.find(k);
+    if (pending_pulls_it != shard->pending_pulls.end()) {
+      pending_pulls.swap(pending_pulls_it->second);
+      shard->pending_pulls.erase(pending_pulls_it);
+    }
+  }
+  for (const auto& VGetter : pending_pulls) { VGetter(v); }
+}
+
+void CtrlServer::PullKV(const std::string& k, std::function<void(const std::string&)> VGetter) {
+  KVShard* shard = MutKVShard(k);
+  std::unique_lock<std::mutex> lock(shard->mutex);
+  auto kv_it = shard->kv.find(k);
+  if (kv_it != shard->kv.end()) {
+    VGetter(kv_it->second);
+  } else {
+    shard->pending_pulls[k].push_back(std::move(VGetter));
+  }
+}
+
 void CtrlServer::Init() {
   Add([this](CtrlCall<CtrlMethod::kLoadServer>* call) {
-    if (this->is_first_connect_) {
-      this->this_machine_addr_ = call->request().addr();
-      this->is_first_connect_ = false;
-    } else {
-      CHECK_EQ(call->request().addr(), this->this_machine_addr_);
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      if (this->is_first_connect_) {
+        this->this_machine_addr_ = call->request().addr();
+        this->is_first_connect_ = false;
+      } else {
+        CHECK_EQ(call->request().addr(), this->this_machine_addr_);
+      }
     }
     call->SendResponse();
-    EnqueueRequest<CtrlMethod::kLoadServer>();
   });
 
   Add([this](CtrlCall<CtrlMethod::kBarrier>* call) {
     const std::string& barrier_name = call->request().name();
     int32_t barrier_num = call->request().num();
-    auto barrier_call_it = barrier_calls_.find(barrier_name);
-    if (barrier_call_it == barrier_calls_.end()) {
-      barrier_call_it =
-          barrier_calls_
-              .emplace(barrier_name, std::make_pair(std::list<CtrlCallIf*>{}, barrier_num))
-              .first;
-    }
-    CHECK_EQ(barrier_num, barrier_call_it->second.second);
-    barrier_call_it->second.first.push_back(call);
-    if (barrier_call_it->second.first.size() == barrier_call_it->second.second) {
-      for (CtrlCallIf* pending_call : barrier_call_it->second.first) {
-        pending_call->SendResponse();
+    std::list<CtrlCallIf*> done_calls;
+    {
+      std::unique_lock<std::mutex> lock(barrier_mutex_);
+      auto barrier_call_it = barrier_calls_.find(barrier_name);
+      if (barrier_call_it == barrier_calls_.end()) {
+        barrier_call_it =
+            barrier_calls_
+                .emplace(barrier_name, std::make_pair(std::list<CtrlCallIf*>{}, barrier_num))
+                .first;
+      }
+      CHECK_EQ(barrier_num, barrier_call_it->second.second);
+      barrier_call_it->second.first.push_back(call);
+      if (barrier_call_it->second.first.size() == barrier_call_it->second.second) {
+        done_calls.swap(barrier_call_it->second.first);
+        barrier_calls_.erase(barrier_call_it);
       }
-      barrier_calls_.erase(barrier_call_it);
     }
-
-    EnqueueRequest<CtrlMethod::kBarrier>();
+    for (CtrlCallIf* pending_call : done_calls) { pending_call->SendResponse(); }
   });
 
   Add([this](CtrlCall<CtrlMethod::kTryLock>* call) {
     const std::string& lock_name = call->request().name();
-    auto name2lock_status_it = name2lock_status_.find(lock_name);
-    if (name2lock_status_it == name2lock_status_.end()) {
-      call->mut_response()->set_result(TryLockResult::kLocked);
-      auto waiting_until_done_calls = new std::list<CtrlCallIf*>;
-      CHECK(name2lock_status_.emplace(lock_name, waiting_until_done_calls).second);
-    } else {
-      if (name2lock_status_it->second) {
-        call->mut_response()->set_result(TryLockResult::kDoing);
+    {
+      std::unique_lock<std::mutex> lock(lock_status_mutex_);
+      auto name2lock_status_it = name2lock_status_.find(lock_name);
+      if (name2lock_status_it == name2lock_status_.end()) {
+        call->mut_response()->set_result(TryLockResult::kLocked);
+        auto waiting_until_done_calls = new std::list<CtrlCallIf*>;
+        CHECK(name2lock_status_.emplace(lock_name, waiting_until_done_calls).second);
       } else {
-        call->mut_response()->set_result(TryLockResult::kDone);
+        if (name2lock_status_it->second) {
+          call->mut_response()->set_result(TryLockResult::kDoing);
+        } else {
+          call->mut_response()->set_result(TryLockResult::kDone);
+        }
       }
     }
     call->SendResponse();
-    EnqueueRequest<CtrlMethod::kTryLock>();
   });
 
   Add([this](CtrlCall<CtrlMethod::kNotifyDone>* call) {
     const std::string& lock_name = call->request().name();
-    auto name2lock_status_it = name2lock_status_.find(lock_name);
-    auto waiting_calls = static_cast<std::list<CtrlCallIf*>*>(name2lock_status_it->second);
+    std::unique_ptr<std::list<CtrlCallIf*>> waiting_calls;
+    {
+      std::unique_lock<std::mutex> lock(lock_status_mutex_);
+      auto name2lock_status_it = name2lock_status_.find(lock_name);
+      waiting_calls.reset(static_cast<std::list<CtrlCallIf*>*>(name2lock_status_it->second));
+      name2lock_status_it->second = nullptr;
+    }
     for (CtrlCallIf* waiting_call : *waiting_calls) { waiting_call->SendResponse(); }
-    delete waiting_calls;
-    name2lock_status_it->second = nullptr;
     call->SendResponse();
-    EnqueueRequest<CtrlMethod::kNotifyDone>();
   });
 
   Add([this](CtrlCall<CtrlMethod::kWaitUntilDone>* call) {
     const std::string& lock_name = call->request().name();
-    void* lock_status = name2lock_status_.at(lock_name);
-    if (lock_status) {
-      auto waiting_calls = static_cast<std::list<CtrlCallIf*>*>(lock_status);
-      waiting_calls->push_back(call);
-    } else {
-      call->SendResponse();
+    {
+      std::unique_lock<std::mutex> lock(lock_status_mutex_);
+      void* lock_status = name2lock_status_.at(lock_name);
+      if (lock_status) {
+        auto waiting_calls = static_cast<std::list<CtrlCallIf*>*>(lock_status);
+        waiting_calls->push_back(call);
+        return;
+      }
     }
-    EnqueueRequest<CtrlMethod::kWaitUntilDone>();
+    call->SendResponse();
   });
 
   Add([this](CtrlCall<CtrlMethod::kPushKV>* call) {
-    const std::string& k = call->request().key();
-    const std::string& v = call->request().val();
-    CHECK(kv_.emplace(k, v).second);
-
-    auto pending_kv_calls_it = pending_kv_calls_.find(k);
-    if (pending_kv_calls_it != pending_kv_calls_.end()) {
-      for (auto pending_call : pending_kv_calls_it->second) {
-        pending_call->mut_response()->set_val(v);
-        pending_call->SendResponse();
-      }
-      pending_kv_calls_.erase(pending_kv_calls_it);
-    }
+    PushKV(call->request().key(), call->request().val());
     call->SendResponse();
-    EnqueueRequest<CtrlMethod::kPushKV>();
   });
 
   Add([this](CtrlCall<CtrlMethod::kClearKV>* call) {
     const std::string& k = call->request().key();
-    CHECK_EQ(kv_.erase(k), 1);
-    CHECK(pending_kv_calls_.find(k) == pending_kv_calls_.end());
+    {
+      KVShard* shard = MutKVShard(k);
+      std::unique_lock<std::mutex> lock(shard->mutex);
+      CHECK_EQ(shard->kv.erase(k), 1);
+      CHECK(shard->pending_pulls.find(k) == shard->pending_pulls.end());
+    }
     call->SendResponse();
-    EnqueueRequest<CtrlMethod::kClearKV>();
   });
 
   Add([this](CtrlCall<CtrlMethod::kPullKV>* call) {
-    const std::string& k = call->request().key();
-    auto kv_it = kv_.find(k);
-    if (kv_it != kv_.end()) {
-      call->mut_response()->set_val(kv_it->second);
+    PullKV(call->request().key(), [call](const std::string& v) {
+      call->mut_response()->set_val(v);
       call->SendResponse();
-    } else {
-      pending_kv_calls_[k].push_back(call);
-    }
-    EnqueueRequest<CtrlMethod::kPullKV>();
+    });
   });
 
   Add([this](CtrlCall<CtrlMethod::kPushActEvent>* call) {
     ActEvent act_event = call->request().act_event();
     call->SendResponse();
+    std::unique_lock<std::mutex> lock(mutex_);
     Global<ActEventLogger>::Get()->PrintActEventToLogDir(act_event);
-    EnqueueRequest<CtrlMethod::kPushActEvent>();
   });
 
   Add([this](CtrlCall<CtrlMethod::kClear>* call) {
-    name2lock_status_.clear();
-    kv_.clear();
-    CHECK(pending_kv_calls_.empty()) << "size(): " << pending_kv_calls_.size()
-                                     << ", begin()->key: " << pending_kv_calls_.begin()->first;
+    {
+      std::unique_lock<std::mutex> lock(lock_status_mutex_);
+      name2lock_status_.clear();
+    }
+    for (KVShard& shard : kv_shards_) {
+      std::unique_lock<std::mutex> lock(shard.mutex);
+      shard.kv.clear();
+      CHECK(shard.pending_pulls.empty())
+          << "size(): " << shard.pending_pulls.size()
+          << ", begin()->key: " << shard.pending_pulls.begin()->first;
+    }
     call->SendResponse();
-    EnqueueRequest<CtrlMethod::kClear>();
   });
 
   Add([this](CtrlCall<CtrlMethod::kIncreaseCount>* call) {
-    int32_t& count = count_[call->request().key()];
-    count += call->request().val();
-    call->mut_response()->set_val(count);
+    {
+      std::unique_lock<std::mutex> lock(count_mutex_);
+      int32_t& count = count_[call->request().key()];
+      count += call->request().val();
+      call->mut_response()->set_val(count);
+    }
     call->SendResponse();
-    EnqueueRequest<CtrlMethod::kIncreaseCount>();
   });
 
   Add([this](CtrlCall<CtrlMethod::kEraseCount>* call) {
-    CHECK_EQ(count_.erase(call->request().key()), 1);
+    {
+      std::unique_lock<std::mutex> lock(count_mutex_);
+      CHECK_EQ(count_.erase(call->request().key()), 1);
+    }
     call->SendResponse();
-    EnqueueRequest<CtrlMethod::kEraseCount>();
+  });
+
+  Add([this](CtrlCall<CtrlMethod::kPushKVs>* call) {
+    for (const PushKVRequest& kv : call->request().kv()) { PushKV(kv.key(), kv.val()); }
+    call->SendResponse();
+  });
+
+  Add([this](CtrlCall<CtrlMethod::kPullKVs>* call) {
+    const int64_t key_num = call->request().key_size();
+    FOR_RANGE(int64_t, i, 0, key_num) { call->mut_response()->add_val(); }
+    // one for each key and one for this handler, whoever counts down to zero responds
+    auto remaining = std::make_shared<std::atomic<int64_t>>(key_num + 1);
+    FOR_RANGE(int64_t, i, 0, key_num) {
+      std::string* val = call->mut_response()->mutable_val(i);
+      PullKV(call->request().key(i), [call, val, remaining](const std::string& v) {
+        *val = v;
+        if (--*remaining == 0) { call->SendResponse(); }
+      });
+    }
+    if (--*remaining == 0) { call->SendResponse(); }
   });
 }
 
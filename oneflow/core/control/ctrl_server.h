@@ -41,21 +41,25 @@ class CtrlServer final {
   const std::string& this_machine_addr() { return this_machine_addr_; }
 
  private:
-  void HandleRpcs();
+  void HandleRpcs(grpc::ServerCompletionQueue* cq);
   void Init();
 
-  void EnqueueRequests() {
-    for_each_i(handlers_, helper{this}, std::make_index_sequence<kCtrlMethodNum>{});
+  void EnqueueRequests(grpc::ServerCompletionQueue* cq) {
+    for_each_i(handlers_, helper{this, cq}, std::make_index_sequence<kCtrlMethodNum>{});
   }
 
   template<CtrlMethod kMethod>
-  void EnqueueRequest() {
+  void EnqueueRequest(grpc::ServerCompletionQueue* cq) {
     constexpr const size_t I = (size_t)kMethod;
-    auto handler = std::get<I>(handlers_);
     auto call = new CtrlCall<(CtrlMethod)I>();
-    call->set_request_handler(std::bind(handler, call));
+    // the next request is enqueued before this one is handled, so that the other threads may take
+    // it meanwhile
+    call->set_request_handler([this, call, cq]() {
+      EnqueueRequest<kMethod>(cq);
+      std::get<I>(handlers_)(call);
+    });
     grpc_service_->RequestAsyncUnary(I, call->mut_server_ctx(), call->mut_request(),
-                                     call->mut_responder(), cq_.get(), cq_.get(), call);
+                                     call->mut_responder(), cq, cq, call);
   }
 
   template<typename F>
@@ -68,31 +72,49 @@ class CtrlServer final {
   }
 
   struct helper {
-    helper(CtrlServer* s) : s_(s) {}
+    helper(CtrlServer* s, grpc::ServerCompletionQueue* cq) : s_(s), cq_(cq) {}
     template<typename T, typename V>
     void operator()(const T& t, V) {
-      s_->EnqueueRequest<(CtrlMethod)V::value>();
+      s_->EnqueueRequest<(CtrlMethod)V::value>(cq_);
     }
 
     CtrlServer* s_;
+    grpc::ServerCompletionQueue* cq_;
   };
 
+  struct KVShard {
+    std::mutex mutex;
+    HashMap<std::string, std::string> kv;
+    HashMap<std::string, std::list<std::function<void(const std::string&)>>> pending_pulls;
+  };
+  static const size_t kKVShardNum = 64;
+  KVShard* MutKVShard(const std::string& k) {
+    return &kv_shards_.at(std::hash<std::string>{}(k) % kKVShardNum);
+  }
+  void PushKV(const std::string& k, const std::string& v);
+  void PullKV(const std::string& k, std::function<void(const std::string&)> VGetter);
+
   using HandlerTuple = decltype(GetHandlerTuple(std::make_index_sequence<kCtrlMethodNum>{}));
 
   HandlerTuple handlers_;
   std::unique_ptr<CtrlService::AsyncService> grpc_service_;
-  std::unique_ptr<grpc::ServerCompletionQueue> cq_;
+  std::vector<std::unique_ptr<grpc::ServerCompletionQueue>> cqs_;
   std::unique_ptr<grpc::Server> grpc_server_;
-  std::thread loop_thread_;
+  std::vector<std::thread> loop_threads_;
+  std::atomic<bool> is_shutdown_;
   // Barrier
+  std::mutex barrier_mutex_;
   HashMap<std::string, std::pair<std::list<CtrlCallIf*>, int32_t>> barrier_calls_;
   // TryLock, NotifyDone, WaitUntilDone
+  std::mutex lock_status_mutex_;
   HashMap<std::string, void*> name2lock_status_;
-  // PushKV, ClearKV, PullKV
-  HashMap<std::string, std::string> kv_;
-  HashMap<std::string, std::list<CtrlCall<CtrlMethod::kPullKV>*>> pending_kv_calls_;
+  // PushKV, ClearKV, PullKV, PushKVs, PullKVs
+  std::array<KVShard, kKVShardNum> kv_shards_;
   // IncreaseCount, EraseCount
+  std::mutex count_mutex_;
   HashMap<std::string, int32_t> count_;
+  // LoadServer, PushActEvent
+  std::mutex mutex_;
 
   bool is_first_connect_;
   std::string this_machine_addr_;
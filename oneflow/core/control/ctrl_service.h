@@ -44,7 +44,9 @@ namespace oneflow {
   OF_PP_MAKE_TUPLE_SEQ(PushActEvent)  \
   OF_PP_MAKE_TUPLE_SEQ(Clear)         \
   OF_PP_MAKE_TUPLE_SEQ(IncreaseCount) \
-  OF_PP_MAKE_TUPLE_SEQ(EraseCount)
+  OF_PP_MAKE_TUPLE_SEQ(EraseCount)    \
+  OF_PP_MAKE_TUPLE_SEQ(PushKVs)       \
+  OF_PP_MAKE_TUPLE_SEQ(PullKVs)
 
 #define CatRequest(method) method##Request,
 #define CatReqponse(method) method##Response,
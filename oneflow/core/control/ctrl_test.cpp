@@ -19,6 +19,8 @@ limitations under the License.
 #include "oneflow/core/control/ctrl_server.h"
 #include "oneflow/core/job/resource_desc.h"
 #include "oneflow/core/job/global_for.h"
+#include "oneflow/core/job/env_desc.h"
+#include "oneflow/core/common/str_util.h"
 
 #ifdef OF_PLATFORM_POSIX
 
@@ -27,6 +29,13 @@ limitations under the License.
 #include <sys/socket.h>
 #include <sys/types.h>
 #include <arpa/inet.h>
+#include <fcntl.h>
+#include <spawn.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+extern char** environ;
 
 namespace oneflow {
 
@@ -74,8 +83,154 @@ Resource GetResource() {
   return ret;
 }
 
+// ports picked by the kernel, all of them bound at the same time so they differ
+std::vector<int> FindAvailablePorts(int num) {
+  std::vector<int> socks;
+  std::vector<int> ports;
+  FOR_RANGE(int, i, 0, num) {
+    int sock = socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in sa = GetSockAddr("0.0.0.0", 0);
+    PCHECK(bind(sock, reinterpret_cast<sockaddr*>(&sa), sizeof(sa)) == 0);
+    socklen_t len = sizeof(sa);
+    PCHECK(getsockname(sock, reinterpret_cast<sockaddr*>(&sa), &len) == 0);
+    socks.push_back(sock);
+    ports.push_back(ntohs(sa.sin_port));
+  }
+  for (int sock : socks) { close(sock); }
+  return ports;
+}
+
+const char* kBarrierRankEnv = "ONEFLOW_CTRL_TEST_BARRIER_RANK";
+const char* kBarrierPortsEnv = "ONEFLOW_CTRL_TEST_BARRIER_PORTS";
+const char* kBarrierItersEnv = "ONEFLOW_CTRL_TEST_BARRIER_ITERS";
+const char* kBarrierArrivalsEnv = "ONEFLOW_CTRL_TEST_BARRIER_ARRIVALS";
+
+size_t ArrivalsByteSize(int num_iters) { return 2 * num_iters * sizeof(std::atomic<int64_t>); }
+
+// Every local process plays one machine with its own CtrlServer. Each rank counts its arrival at
+// each barrier in a file all processes map, and checks that all ranks have arrived when it leaves.
+// Returns the mean latency of the flat and the tree barrier in us.
+std::pair<double, double> RunBarriers(int64_t rank, const std::vector<int>& ports, int num_iters,
+                                      const std::string& arrivals_path) {
+  const int64_t machine_num = ports.size();
+  const int fd = open(arrivals_path.c_str(), O_RDWR);
+  PCHECK(fd != -1);
+  void* arrivals_ptr =
+      mmap(nullptr, ArrivalsByteSize(num_iters), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  PCHECK(arrivals_ptr != MAP_FAILED);
+  close(fd);
+  std::atomic<int64_t>* arrivals = reinterpret_cast<std::atomic<int64_t>*>(arrivals_ptr);
+
+  EnvProto env_proto;
+  FOR_RANGE(int64_t, i, 0, machine_num) {
+    Machine* machine = env_proto.add_machine();
+    machine->set_id(i);
+    machine->set_addr("127.0.0.1");
+    machine->set_ctrl_port_agent(ports.at(i));
+  }
+  env_proto.set_ctrl_port(ports.at(rank));
+  Global<EnvDesc>::New(env_proto);
+  Global<CtrlServer>::New();
+  Global<CtrlClient>::New();
+  Global<MachineCtx>::New(rank);
+  CtrlClient* ctrl_client = Global<CtrlClient>::Get();
+  ctrl_client->Barrier("warm_up", machine_num);
+  auto CheckArrivals = [&](int64_t barrier_idx) {
+    CHECK_EQ(arrivals[barrier_idx].load(), machine_num)
+        << "rank " << rank << " left barrier " << barrier_idx << " before all ranks arrived";
+  };
+  double start = GetCurTime();
+  FOR_RANGE(int, i, 0, num_iters) {
+    arrivals[i].fetch_add(1);
+    ctrl_client->Barrier("flat", machine_num);
+    CheckArrivals(i);
+  }
+  const double flat_us = (GetCurTime() - start) / num_iters / 1e3;
+  start = GetCurTime();
+  FOR_RANGE(int, i, num_iters, 2 * num_iters) {
+    arrivals[i].fetch_add(1);
+    ctrl_client->TreeBarrier("tree", machine_num);
+    CheckArrivals(i);
+  }
+  const double tree_us = (GetCurTime() - start) / num_iters / 1e3;
+  // no server may go away while the others still use it
+  ctrl_client->Barrier("done", machine_num);
+  Global<MachineCtx>::Delete();
+  Global<CtrlClient>::Delete();
+  Global<CtrlServer>::Delete();
+  Global<EnvDesc>::Delete();
+  PCHECK(munmap(arrivals_ptr, ArrivalsByteSize(num_iters)) == 0);
+  return std::make_pair(flat_us, tree_us);
+}
+
+// Spawns the processes of ranks [1, machine_num) and runs rank 0 in this one
+void RunBarriersInProcesses(int machine_num, int num_iters, std::pair<double, double>* latency) {
+  const std::vector<int>& ports = FindAvailablePorts(machine_num);
+  std::string ports_str;
+  for (int port : ports) { ports_str += (ports_str.empty() ? "" : ",") + std::to_string(port); }
+  const std::string arrivals_path = JoinPath(
+      ::testing::TempDir(), "ctrl_test_barrier_arrivals_" + std::to_string(getpid()));
+  const int fd = open(arrivals_path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0600);
+  ASSERT_NE(fd, -1);
+  ASSERT_EQ(ftruncate(fd, ArrivalsByteSize(num_iters)), 0);
+  close(fd);
+  std::vector<pid_t> pids;
+  FOR_RANGE(int, rank, 1, machine_num) {
+    std::vector<std::string> envs{std::string(kBarrierRankEnv) + "=" + std::to_string(rank),
+                                  std::string(kBarrierPortsEnv) + "=" + ports_str,
+                                  std::string(kBarrierItersEnv) + "=" + std::to_string(num_iters),
+                                  std::string(kBarrierArrivalsEnv) + "=" + arrivals_path};
+    std::vector<char*> envp;
+    for (std::string& env : envs) { envp.push_back(&env[0]); }
+    for (char** env = environ; *env != nullptr; ++env) { envp.push_back(*env); }
+    envp.push_back(nullptr);
+    std::string exe = "/proc/self/exe";
+    std::string filter = "--gtest_filter=CtrlServer.barrier_worker";
+    char* argv[] = {&exe[0], &filter[0], nullptr};
+    pid_t pid;
+    ASSERT_EQ(posix_spawn(&pid, exe.c_str(), nullptr, nullptr, argv, envp.data()), 0);
+    pids.push_back(pid);
+  }
+  *latency = RunBarriers(0, ports, num_iters, arrivals_path);
+  for (pid_t pid : pids) {
+    int status = 0;
+    ASSERT_EQ(waitpid(pid, &status, 0), pid);
+    ASSERT_TRUE(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+  }
+  unlink(arrivals_path.c_str());
+}
+
 }  // namespace
 
+// Only does something in the processes spawned by RunBarriersInProcesses
+TEST(CtrlServer, barrier_worker) {
+  const char* rank = std::getenv(kBarrierRankEnv);
+  const char* ports = std::getenv(kBarrierPortsEnv);
+  if (rank == nullptr || ports == nullptr) { return; }
+  std::vector<int> port_vec;
+  SplitAndParseAs<int>(ports, ",", [&](int&& port) { port_vec.push_back(port); });
+  RunBarriers(oneflow_cast<int64_t>(std::string(rank)), port_vec,
+              oneflow_cast<int>(std::string(std::getenv(kBarrierItersEnv))),
+              std::getenv(kBarrierArrivalsEnv));
+}
+
+TEST(CtrlServer, barrier_waits_for_all_machines) {
+  if (std::getenv(kBarrierRankEnv) != nullptr) { return; }
+  std::pair<double, double> latency;
+  ASSERT_NO_FATAL_FAILURE(RunBarriersInProcesses(5, 20, &latency));
+}
+
+// Run with --gtest_also_run_disabled_tests
+TEST(CtrlServer, DISABLED_benchmark_barrier) {
+  if (std::getenv(kBarrierRankEnv) != nullptr) { return; }
+  for (int machine_num : {2, 4, 8, 16, 32}) {
+    std::pair<double, double> latency;
+    ASSERT_NO_FATAL_FAILURE(RunBarriersInProcesses(machine_num, 200, &latency));
+    LOG(INFO) << "barrier latency of " << machine_num << " local processes, flat: "
+              << latency.first << " us, tree: " << latency.second << " us";
+  }
+}
+
 TEST(CtrlServer, new_delete) {
   int port = FindAvailablePort();
   if (port == -1) { return; }
@@ -25,6 +25,8 @@ class CpuDeviceCtx final : public DeviceCtx {
  public:
   OF_DISALLOW_COPY_AND_MOVE(CpuDeviceCtx);
   CpuDeviceCtx() = default;
+  explicit CpuDeviceCtx(std::unique_ptr<vm::Allocator>&& allocator)
+      : allocator_(std::move(allocator)) {}
   ~CpuDeviceCtx() = default;
 
   std::unique_ptr<DeviceCtx> Copy() const { return std::unique_ptr<DeviceCtx>(new CpuDeviceCtx()); }
@@ -32,9 +34,13 @@ class CpuDeviceCtx final : public DeviceCtx {
   void SyncDevice() override {}
   void AddCallBack(std::function<void()> callback) const override { callback(); }
 
-  vm::Allocator* mut_allocator() override { return Global<vm::CpuAllocator>::Get(); }
+  vm::Allocator* mut_allocator() override {
+    if (allocator_) { return allocator_.get(); }
+    return Global<vm::CpuAllocator>::Get();
+  }
 
  private:
+  std::unique_ptr<vm::Allocator> allocator_;
 };  // namespace oneflow
 
 }  // namespace oneflow
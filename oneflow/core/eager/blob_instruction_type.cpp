@@ -21,6 +21,7 @@ limitations under the License.
 #include "oneflow/core/vm/string_object.h"
 #include "oneflow/core/eager/blob_instruction_type.h"
 #include "oneflow/core/eager/blob_object.h"
+#include "oneflow/core/eager/blob_rematerializer.h"
 #include "oneflow/core/vm/device_helper_stream_type.h"
 #include "oneflow/core/device/cuda_util.h"
 #include "oneflow/core/register/register_manager.h"
@@ -53,7 +54,11 @@ class CudaHostRegisterBlobInstructionType final : public vm::InstructionType {
   }
   void Compute(vm::Instruction* instruction) const override {
     FlatMsgView<PinBlobInstruction> args(instruction->instr_msg().operand());
-    auto* blob = instruction->mut_operand_type(args->blob())->Mut<BlobObject>()->mut_blob();
+    auto* blob_object = instruction->mut_operand_type(args->blob())->Mut<BlobObject>();
+    // accessed from the device helper stream, so the body gets pinned
+    RematInstructionCtx remat_ctx(instruction->stream().device_ctx().get(), false);
+    CHECK_JUST(remat_ctx.AccessInput("blob", *blob_object, false));
+    auto* blob = blob_object->mut_blob();
     CHECK(blob->mem_case().has_host_mem());
     if (blob->mem_case().host_mem().has_cuda_pinned_mem()) { return; }
     void* dptr = blob->mut_dptr();
@@ -78,7 +83,11 @@ class CudaHostUnregisterBlobInstructionType final : public vm::InstructionType {
   }
   void Compute(vm::Instruction* instruction) const override {
     FlatMsgView<PinBlobInstruction> args(instruction->instr_msg().operand());
-    auto* blob = instruction->mut_operand_type(args->blob())->Mut<BlobObject>()->mut_blob();
+    auto* blob_object = instruction->mut_operand_type(args->blob())->Mut<BlobObject>();
+    // accessed from the device helper stream, so the body gets pinned
+    RematInstructionCtx remat_ctx(instruction->stream().device_ctx().get(), false);
+    CHECK_JUST(remat_ctx.AccessInput("blob", *blob_object, false));
+    auto* blob = blob_object->mut_blob();
     CHECK(blob->mem_case().has_host_mem());
     if (blob->mem_case().host_mem().has_cuda_pinned_mem()) { return; }
     void* dptr = blob->mut_dptr();
@@ -0,0 +1,439 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include <algorithm>
+#include <limits>
+#include "oneflow/core/eager/blob_rematerializer.h"
+#include "oneflow/core/eager/eager_blob_object.h"
+#include "oneflow/core/device/device_context.h"
+#include "oneflow/core/vm/allocator.h"
+
+namespace oneflow {
+namespace eager {
+
+namespace {
+
+int64_t MemZoneId4MemCase(const MemoryCase& mem_case) {
+  if (mem_case.has_host_mem()) { return -1; }
+  CHECK(mem_case.has_device_cuda_mem());
+  return mem_case.device_cuda_mem().device_id();
+}
+
+std::shared_ptr<RematBlob> GetRematBlob(const BlobObject& blob_object) {
+  const auto* eager_blob_object = dynamic_cast<const EagerBlobObject*>(&blob_object);
+  if (eager_blob_object == nullptr) { return std::shared_ptr<RematBlob>(); }
+  return eager_blob_object->remat_blob();
+}
+
+}  // namespace
+
+COMMAND(Global<BlobRematerializer>::SetAllocated(new BlobRematerializer()));
+
+RematBlob::RematBlob(BlobRematerializer* rematerializer, const MemoryCase& mem_case,
+                     const std::shared_ptr<const RtBlobDesc>& rt_blob_desc)
+    : rematerializer_(rematerializer),
+      mem_case_(mem_case),
+      mem_zone_id_(MemZoneId4MemCase(mem_case)),
+      rt_blob_desc_(rt_blob_desc),
+      body_bytes_(rt_blob_desc->AlignedByteSizeOfBlobBody()),
+      state_(kNotComputed),
+      owner_device_ctx_(nullptr),
+      pinned_(false),
+      lock_cnt_(0),
+      last_access_tick_(0),
+      indexed_tick_(-1) {
+  int64_t header_byte_size = rt_blob_desc_->ByteSizeOfBlobHeader();
+  const auto& FreeHeader = [header_byte_size](char* dptr) { std::free(dptr); };
+  char* ptr = reinterpret_cast<char*>(std::malloc(header_byte_size));
+  header_buffer_ = std::unique_ptr<char, std::function<void(char*)>>(ptr, FreeHeader);
+  blob_.reset(new Blob(mem_case_, rt_blob_desc_.get(), header_buffer_.get(), nullptr));
+}
+
+RematBlob::~RematBlob() { rematerializer_->OnRematBlobDestroyed(this); }
+
+BlobRematerializer::BlobRematerializer()
+    : budget_bytes_(0),
+      access_tick_(0),
+      evict_cnt_(0),
+      evict_bytes_(0),
+      remat_cnt_(0),
+      remat_bytes_(0),
+      pin_cnt_(0) {}
+
+std::shared_ptr<RematBlob> BlobRematerializer::NewRematBlob(
+    const MemoryCase& mem_case, const std::shared_ptr<const RtBlobDesc>& rt_blob_desc) {
+  return std::make_shared<RematBlob>(this, mem_case, rt_blob_desc);
+}
+
+void BlobRematerializer::OnRematBlobDestroyed(RematBlob* blob) {
+  std::unique_lock<std::recursive_mutex> lock(mutex_);
+  UnindexLocked(blob);
+  if (blob->state_ == RematBlob::kResident && blob->body_bytes_ > 0) {
+    CHECK_EQ(resident_blobs_.erase(blob), 1);
+    mem_zone_id2resident_bytes_[blob->mem_zone_id_] -= blob->body_bytes_;
+  }
+}
+
+Maybe<void> BlobRematerializer::MakeResidentLocked(RematBlob* blob, DeviceCtx* device_ctx) {
+  Touch(blob);
+  const bool is_foreign = blob->owner_device_ctx_ != device_ctx;
+  if (blob->state_ == RematBlob::kEvicted) {
+    if (is_foreign) {
+      // Host bodies are recomputed on the owner ctx, which may be used from any thread. Device
+      // bodies are recomputed on the accessing stream once the owner stream drained, because cuda
+      // library handles of the owner stream must not be shared across threads.
+      DeviceCtx* compute_ctx =
+          blob->mem_case_.has_host_mem() ? blob->owner_device_ctx_ : device_ctx;
+      CHECK_NOTNULL_OR_RETURN(compute_ctx) << "evicted device blob accessed without device ctx";
+      blob->owner_device_ctx_->SyncDevice();
+      JUST(RematerializeLocked(blob, compute_ctx, true));
+    } else {
+      JUST(RematerializeLocked(blob, device_ctx, false));
+    }
+  }
+  if (is_foreign) { PinLocked(blob); }
+  return Maybe<void>::Ok();
+}
+
+Maybe<void> BlobRematerializer::RematerializeLocked(RematBlob* blob, DeviceCtx* compute_ctx,
+                                                    bool is_foreign) {
+  const std::shared_ptr<RematOp> op = blob->producer_;
+  CHECK_OR_RETURN(static_cast<bool>(op)) << "evicted blob has no producer";
+  DeviceCtx* evicting_ctx = is_foreign ? nullptr : compute_ctx;
+  std::vector<std::shared_ptr<RematBlob>> locked_blobs;
+  HashMap<std::string, Blob*> bn_in_op2blob;
+  for (const auto& pair : op->ibn_and_inputs) {
+    RematBlob* input = pair.second.get();
+    Touch(input);
+    if (input->state_ == RematBlob::kEvicted) {
+      JUST(RematerializeLocked(input, compute_ctx, is_foreign));
+    }
+    CHECK_EQ_OR_RETURN(input->state_, RematBlob::kResident);
+    if (is_foreign) { PinLocked(input); }
+    ++input->lock_cnt_;
+    locked_blobs.push_back(pair.second);
+    bn_in_op2blob[pair.first] = input->mut_blob();
+  }
+  // Outputs still resident or already released by the frontend are written to scratch blobs so
+  // that readers of the resident ones never observe a rewrite.
+  vm::Allocator* allocator = blob->owner_device_ctx_->mut_allocator();
+  std::vector<std::string> scratch_headers;
+  scratch_headers.reserve(op->obns.size());
+  std::vector<std::unique_ptr<Blob>> scratch_blobs;
+  std::vector<std::pair<char*, size_t>> scratch_bodies;
+  FOR_RANGE(int64_t, i, 0, op->obns.size()) {
+    const std::shared_ptr<RematBlob> output = op->outputs.at(i).lock();
+    if (output && output->state_ == RematBlob::kEvicted) {
+      JUST(AllocateBodyLocked(output.get(), evicting_ctx));
+      if (is_foreign) { PinLocked(output.get()); }
+      ++output->lock_cnt_;
+      locked_blobs.push_back(output);
+      bn_in_op2blob[op->obns.at(i)] = output->mut_blob();
+      ++remat_cnt_;
+      remat_bytes_ += output->body_bytes_;
+    } else {
+      const RtBlobDesc* rt_blob_desc = op->output_rt_blob_descs.at(i).get();
+      scratch_headers.push_back(op->output_headers.at(i));
+      char* dptr = nullptr;
+      size_t body_bytes = rt_blob_desc->AlignedByteSizeOfBlobBody();
+      if (body_bytes > 0) { allocator->Allocate(&dptr, body_bytes); }
+      scratch_bodies.emplace_back(dptr, body_bytes);
+      scratch_blobs.emplace_back(new Blob(op->output_mem_cases.at(i), rt_blob_desc,
+                                          &scratch_headers.back()[0], dptr));
+      bn_in_op2blob[op->obns.at(i)] = scratch_blobs.back().get();
+    }
+  }
+  const auto& Blob4BnInOp = [&](const std::string& bn_in_op) -> Blob* {
+    const auto& iter = bn_in_op2blob.find(bn_in_op);
+    if (iter == bn_in_op2blob.end()) { return nullptr; }
+    return iter->second;
+  };
+  JUST(op->forward(compute_ctx, Blob4BnInOp));
+  // scratch bodies released by another thread may be reused by the owner stream right away
+  if (is_foreign) { compute_ctx->SyncDevice(); }
+  for (const auto& pair : scratch_bodies) {
+    if (pair.first != nullptr) { allocator->Deallocate(pair.first, pair.second); }
+  }
+  for (const auto& locked_blob : locked_blobs) { --locked_blob->lock_cnt_; }
+  return Maybe<void>::Ok();
+}
+
+Maybe<void> BlobRematerializer::AllocateBodyLocked(RematBlob* blob, DeviceCtx* evicting_ctx) {
+  CHECK_NOTNULL_OR_RETURN(blob->owner_device_ctx_);
+  if (blob->body_bytes_ == 0) {
+    blob->state_ = RematBlob::kResident;
+    return Maybe<void>::Ok();
+  }
+  EvictUntilFitsLocked(blob->mem_zone_id_, evicting_ctx, blob->body_bytes_);
+  vm::Allocator* allocator = blob->owner_device_ctx_->mut_allocator();
+  CHECK_NOTNULL_OR_RETURN(allocator);
+  const size_t body_bytes = blob->body_bytes_;
+  const auto& Free = [allocator, body_bytes](char* dptr) {
+    allocator->Deallocate(dptr, body_bytes);
+  };
+  char* dptr = nullptr;
+  allocator->Allocate(&dptr, body_bytes);
+  blob->body_ = std::unique_ptr<char, std::function<void(char*)>>(dptr, Free);
+  blob->blob_->reset_dptr(dptr);
+  blob->state_ = RematBlob::kResident;
+  CHECK_OR_RETURN(resident_blobs_.insert(blob).second);
+  ReindexLocked(blob);
+  int64_t resident_bytes = (mem_zone_id2resident_bytes_[blob->mem_zone_id_] += body_bytes);
+  int64_t* peak_resident_bytes = &mem_zone_id2peak_resident_bytes_[blob->mem_zone_id_];
+  *peak_resident_bytes = std::max(*peak_resident_bytes, resident_bytes);
+  return Maybe<void>::Ok();
+}
+
+Maybe<void> BlobRematerializer::PrepareMutationLocked(RematBlob* blob, DeviceCtx* device_ctx) {
+  JUST(MakeResidentLocked(blob, device_ctx));
+  // bodies derived from the old content would be replayed from the new one, so they are
+  // restored now and never evicted again
+  for (const auto& weak_consumer : blob->consumers_) {
+    const std::shared_ptr<RematOp> consumer = weak_consumer.lock();
+    if (!consumer) { continue; }
+    for (const auto& weak_output : consumer->outputs) {
+      const std::shared_ptr<RematBlob> output = weak_output.lock();
+      if (!output) { continue; }
+      JUST(MakeResidentLocked(output.get(), device_ctx));
+      PinLocked(output.get());
+    }
+  }
+  blob->consumers_.clear();
+  PinLocked(blob);
+  return Maybe<void>::Ok();
+}
+
+void BlobRematerializer::PinLocked(RematBlob* blob) {
+  if (blob->pinned_) { return; }
+  CHECK_EQ(blob->state_, RematBlob::kResident);
+  blob->pinned_ = true;
+  // a pinned body is never replayed, so its lineage can be released
+  blob->producer_.reset();
+  UnindexLocked(blob);
+  ++pin_cnt_;
+}
+
+void BlobRematerializer::EvictUntilFitsLocked(int64_t mem_zone_id, DeviceCtx* evicting_ctx,
+                                              int64_t bytes) {
+  const int64_t budget_bytes = budget_bytes_;
+  if (budget_bytes <= 0 || evicting_ctx == nullptr) { return; }
+  const auto& evictable_iter = evictable_blobs_.find(std::make_pair(mem_zone_id, evicting_ctx));
+  if (evictable_iter == evictable_blobs_.end()) { return; }
+  const std::set<std::pair<int64_t, RematBlob*>>& evictable_blobs = evictable_iter->second;
+  const int64_t* resident_bytes = &mem_zone_id2resident_bytes_[mem_zone_id];
+  while (*resident_bytes + bytes > budget_bytes) {
+    RematBlob* victim = nullptr;
+    double min_score = std::numeric_limits<double>::max();
+    for (const auto& pair : evictable_blobs) {
+      RematBlob* blob = pair.second;
+      // the producer of a body also writes it, so its replay cost is at least its size and its
+      // score at least 1 / staleness. Fresher bodies can not beat min_score from here on.
+      if (1 / StalenessLocked(*blob) >= min_score) { break; }
+      if (blob->lock_cnt_ > 0) { continue; }
+      double score = EvictionScoreLocked(*blob);
+      if (score < min_score) {
+        min_score = score;
+        victim = blob;
+      }
+    }
+    // over budget with nothing evictable, the allocation goes ahead anyway
+    if (victim == nullptr) { break; }
+    EvictLocked(victim);
+  }
+}
+
+void BlobRematerializer::EvictLocked(RematBlob* blob) {
+  CHECK_EQ(blob->state_, RematBlob::kResident);
+  CHECK_EQ(resident_blobs_.erase(blob), 1);
+  UnindexLocked(blob);
+  mem_zone_id2resident_bytes_[blob->mem_zone_id_] -= blob->body_bytes_;
+  blob->blob_->reset_dptr(nullptr);
+  blob->body_.reset();
+  blob->state_ = RematBlob::kEvicted;
+  ++evict_cnt_;
+  evict_bytes_ += blob->body_bytes_;
+}
+
+double BlobRematerializer::EvictionScoreLocked(const RematBlob& blob) const {
+  // replaying also has to recompute the evicted inputs of the producer
+  double cost = blob.producer_->compute_cost;
+  for (const auto& pair : blob.producer_->ibn_and_inputs) {
+    const RematBlob& input = *pair.second;
+    if (input.state_ == RematBlob::kEvicted && input.producer_) {
+      cost += input.producer_->compute_cost;
+    }
+  }
+  return cost / (static_cast<double>(blob.body_bytes_) * StalenessLocked(blob));
+}
+
+void BlobRematerializer::Touch(RematBlob* blob) {
+  blob->last_access_tick_ = ++access_tick_;
+  ReindexLocked(blob);
+}
+
+void BlobRematerializer::ReindexLocked(RematBlob* blob) {
+  UnindexLocked(blob);
+  if (blob->state_ != RematBlob::kResident || blob->body_bytes_ == 0 || blob->pinned_
+      || !blob->producer_) {
+    return;
+  }
+  evictable_blobs_[std::make_pair(blob->mem_zone_id_, blob->owner_device_ctx_)].emplace(
+      blob->last_access_tick_, blob);
+  blob->indexed_tick_ = blob->last_access_tick_;
+}
+
+void BlobRematerializer::UnindexLocked(RematBlob* blob) {
+  if (blob->indexed_tick_ == -1) { return; }
+  auto* evictable_blobs =
+      &evictable_blobs_.at(std::make_pair(blob->mem_zone_id_, blob->owner_device_ctx_));
+  CHECK_EQ(evictable_blobs->erase(std::make_pair(blob->indexed_tick_, blob)), 1);
+  blob->indexed_tick_ = -1;
+}
+
+std::string BlobRematerializer::StatisticsDebugString() const {
+  std::unique_lock<std::recursive_mutex> lock(mutex_);
+  std::stringstream ss;
+  ss << "budget_bytes: " << budget_bytes() << ", evict_cnt: " << evict_cnt_
+     << ", evict_bytes: " << evict_bytes_ << ", remat_cnt: " << remat_cnt_
+     << ", remat_bytes: " << remat_bytes_ << ", pin_cnt: " << pin_cnt_;
+  for (const auto& pair : mem_zone_id2resident_bytes_) {
+    const auto& peak_iter = mem_zone_id2peak_resident_bytes_.find(pair.first);
+    int64_t peak = peak_iter == mem_zone_id2peak_resident_bytes_.end() ? 0 : peak_iter->second;
+    ss << ", mem_zone " << pair.first << " resident_bytes: " << pair.second
+       << " peak_resident_bytes: " << peak;
+  }
+  return ss.str();
+}
+
+RematInstructionCtx::RematInstructionCtx(DeviceCtx* device_ctx, bool is_replayable)
+    : rematerializer_(Global<BlobRematerializer>::Get()),
+      device_ctx_(device_ctx),
+      is_replayable_(is_replayable) {}
+
+RematInstructionCtx::~RematInstructionCtx() {
+  if (locked_blobs_.empty()) { return; }
+  std::unique_lock<std::recursive_mutex> lock(rematerializer_->mutex_);
+  for (const auto& blob : locked_blobs_) { --blob->lock_cnt_; }
+}
+
+void RematInstructionCtx::Lock(const std::shared_ptr<RematBlob>& blob) {
+  ++blob->lock_cnt_;
+  locked_blobs_.push_back(blob);
+}
+
+Maybe<void> RematInstructionCtx::AccessInput(const std::string& ibn, const BlobObject& blob_object,
+                                             bool is_mut) {
+  const std::shared_ptr<RematBlob> blob = GetRematBlob(blob_object);
+  if (!blob) {
+    is_replayable_ = false;
+    return Maybe<void>::Ok();
+  }
+  if (is_mut) { is_replayable_ = false; }
+  std::unique_lock<std::recursive_mutex> lock(rematerializer_->mutex_);
+  if (blob->state_ == RematBlob::kNotComputed) {
+    is_replayable_ = false;
+    return Maybe<void>::Ok();
+  }
+  if (is_mut) {
+    JUST(rematerializer_->PrepareMutationLocked(blob.get(), device_ctx_));
+  } else {
+    JUST(rematerializer_->MakeResidentLocked(blob.get(), device_ctx_));
+  }
+  Lock(blob);
+  ibn_and_inputs_.emplace_back(ibn, blob);
+  return Maybe<void>::Ok();
+}
+
+Maybe<void> RematInstructionCtx::AccessOutput(const std::string& obn, BlobObject* blob_object,
+                                              bool is_visible_to_kernel) {
+  const std::shared_ptr<RematBlob> blob = GetRematBlob(*blob_object);
+  if (!blob) {
+    is_replayable_ = false;
+    blob_object->TryAllocateBlobBodyMemory(device_ctx_);
+    return Maybe<void>::Ok();
+  }
+  std::unique_lock<std::recursive_mutex> lock(rematerializer_->mutex_);
+  if (blob->state_ == RematBlob::kNotComputed) {
+    CHECK_NOTNULL_OR_RETURN(device_ctx_);
+    blob->owner_device_ctx_ = device_ctx_;
+    JUST(rematerializer_->AllocateBodyLocked(blob.get(), device_ctx_));
+    rematerializer_->Touch(blob.get());
+  } else {
+    // the instruction writes to a blob computed before
+    is_replayable_ = false;
+    JUST(rematerializer_->PrepareMutationLocked(blob.get(), device_ctx_));
+  }
+  Lock(blob);
+  if (is_visible_to_kernel) { obn_and_outputs_.emplace_back(obn, blob); }
+  return Maybe<void>::Ok();
+}
+
+Maybe<void> RematInstructionCtx::TryRecordProducer(
+    const std::shared_ptr<const EagerKernel>& kernel,
+    const std::shared_ptr<const JobDesc>& job_desc,
+    const std::shared_ptr<user_op::OpKernelState>& opkernel_state) {
+  if (opkernel_state) { return Maybe<void>::Ok(); }
+  // the job desc outlives the kernel replays
+  return TryRecordProducer(
+      [kernel, job_desc](DeviceCtx* device_ctx,
+                         const std::function<Blob*(const std::string&)>& Blob4BnInOp)
+          -> Maybe<void> {
+        const auto& opkernel_state = kernel->EagerForward(
+            std::shared_ptr<user_op::OpKernelState>(), device_ctx, Blob4BnInOp);
+        CHECK_OR_RETURN(!opkernel_state) << "only stateless kernels are replayed";
+        return Maybe<void>::Ok();
+      });
+}
+
+Maybe<void> RematInstructionCtx::TryRecordProducer(const RematForward& forward) {
+  if (!is_replayable_ || obn_and_outputs_.empty()) { return Maybe<void>::Ok(); }
+  const auto& op = std::make_shared<RematOp>();
+  op->forward = forward;
+  op->ibn_and_inputs = ibn_and_inputs_;
+  op->compute_cost = 0;
+  for (const auto& pair : ibn_and_inputs_) { op->compute_cost += pair.second->body_bytes_; }
+  for (const auto& pair : obn_and_outputs_) {
+    const RematBlob& output = *pair.second;
+    op->obns.push_back(pair.first);
+    op->outputs.emplace_back(pair.second);
+    op->output_mem_cases.push_back(output.mem_case_);
+    op->output_rt_blob_descs.push_back(output.rt_blob_desc_);
+    op->output_headers.emplace_back(output.blob_->header_ptr(),
+                                    output.rt_blob_desc_->ByteSizeOfBlobHeader());
+    op->compute_cost += output.body_bytes_;
+  }
+  std::unique_lock<std::recursive_mutex> lock(rematerializer_->mutex_);
+  for (const auto& pair : obn_and_outputs_) {
+    CHECK_OR_RETURN(!pair.second->producer_);
+    pair.second->producer_ = op;
+    rematerializer_->ReindexLocked(pair.second.get());
+  }
+  for (const auto& pair : ibn_and_inputs_) {
+    auto* consumers = &pair.second->consumers_;
+    // prune released consumers before growing, so long-lived inputs do not accumulate them
+    if (consumers->size() == consumers->capacity()) {
+      consumers->erase(std::remove_if(consumers->begin(), consumers->end(),
+                                      [](const std::weak_ptr<RematOp>& consumer) {
+                                        return consumer.expired();
+                                      }),
+                       consumers->end());
+    }
+    consumers->push_back(op);
+  }
+  return Maybe<void>::Ok();
+}
+
+}  // namespace eager
+}  // namespace oneflow
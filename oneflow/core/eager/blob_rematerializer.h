@@ -0,0 +1,201 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifndef ONEFLOW_CORE_EAGER_BLOB_REMATERIALIZER_H_
+#define ONEFLOW_CORE_EAGER_BLOB_REMATERIALIZER_H_
+
+#include <atomic>
+#include <map>
+#include <mutex>
+#include <set>
+#include "oneflow/core/common/maybe.h"
+#include "oneflow/core/common/util.h"
+#include "oneflow/core/job/job_desc.h"
+#include "oneflow/core/kernel/eager_kernel.h"
+#include "oneflow/core/memory/memory_case.pb.h"
+#include "oneflow/core/register/blob.h"
+#include "oneflow/core/register/runtime_blob_desc.h"
+
+namespace oneflow {
+
+class DeviceCtx;
+
+namespace eager {
+
+class BlobObject;
+class BlobRematerializer;
+class RematBlob;
+
+// Runs the kernel of a replayable instruction on the blobs of its ibns and obns
+using RematForward =
+    std::function<Maybe<void>(DeviceCtx*, const std::function<Blob*(const std::string&)>&)>;
+
+// A replayable CallOpKernel instruction. Inputs are held strongly so that their bodies can be
+// rematerialized even after the frontend released them, outputs weakly to keep the lineage
+// acyclic.
+struct RematOp final {
+  RematForward forward;
+  std::vector<std::pair<std::string, std::shared_ptr<RematBlob>>> ibn_and_inputs;
+  std::vector<std::string> obns;
+  std::vector<std::weak_ptr<RematBlob>> outputs;
+  // used to rebuild outputs released by the frontend as scratch blobs during replay
+  std::vector<MemoryCase> output_mem_cases;
+  std::vector<std::shared_ptr<const RtBlobDesc>> output_rt_blob_descs;
+  std::vector<std::string> output_headers;
+  // bytes read and written by the kernel, a device independent proxy of the replay cost
+  int64_t compute_cost;
+};
+
+// Header and body of an EagerBlobObject in memory-budget mode. The header is always resident, the
+// body may be evicted and recomputed from producer_.
+class RematBlob final {
+ public:
+  OF_DISALLOW_COPY_AND_MOVE(RematBlob);
+  RematBlob(BlobRematerializer* rematerializer, const MemoryCase& mem_case,
+            const std::shared_ptr<const RtBlobDesc>& rt_blob_desc);
+  ~RematBlob();
+
+  const Blob& blob() const { return *blob_; }
+  Blob* mut_blob() { return blob_.get(); }
+
+ private:
+  friend class BlobRematerializer;
+  friend class RematInstructionCtx;
+
+  enum State { kNotComputed = 0, kResident, kEvicted };
+
+  BlobRematerializer* rematerializer_;
+  MemoryCase mem_case_;
+  int64_t mem_zone_id_;
+  std::shared_ptr<const RtBlobDesc> rt_blob_desc_;
+  std::unique_ptr<char, std::function<void(char*)>> header_buffer_;
+  std::unique_ptr<Blob> blob_;
+  std::unique_ptr<char, std::function<void(char*)>> body_;
+  int64_t body_bytes_;
+
+  // fields below are guarded by the mutex of rematerializer_
+  State state_;
+  // the device ctx of the stream which allocated the body. Only this stream evicts it.
+  DeviceCtx* owner_device_ctx_;
+  std::shared_ptr<RematOp> producer_;
+  std::vector<std::weak_ptr<RematOp>> consumers_;
+  bool pinned_;
+  int64_t lock_cnt_;
+  int64_t last_access_tick_;
+  // the tick the blob is filed under in the eviction index, -1 if it is not evictable
+  int64_t indexed_tick_;
+};
+
+// BlobRematerializer implements an optional memory-budget mode for eager blobs in the spirit of
+// dynamic tensor rematerialization (DTR). Once a budget is set, bodies of newly initialized eager
+// blobs are accounted per memory zone (host or one cuda device). When an allocation would exceed
+// the budget, resident bodies produced by stateless user op kernels are evicted in order of
+//   replay cost / (body bytes * staleness)
+// and recomputed by replaying their producing kernel when an instruction accesses them again.
+//
+// Only the stream that allocated a body evicts it, so reusing the freed memory is ordered by the
+// stream itself. A blob accessed from another stream or mutated in place is pinned for good.
+class BlobRematerializer final {
+ public:
+  OF_DISALLOW_COPY_AND_MOVE(BlobRematerializer);
+  BlobRematerializer();
+  ~BlobRematerializer() = default;
+
+  // A non-positive budget disables the memory-budget mode. Blobs initialized before a change
+  // keep the mode they were created with.
+  void set_budget_bytes(int64_t budget_bytes) { budget_bytes_ = budget_bytes; }
+  int64_t budget_bytes() const { return budget_bytes_; }
+  bool enabled() const { return budget_bytes_ > 0; }
+
+  std::shared_ptr<RematBlob> NewRematBlob(const MemoryCase& mem_case,
+                                          const std::shared_ptr<const RtBlobDesc>& rt_blob_desc);
+
+  std::string StatisticsDebugString() const;
+
+ private:
+  friend class RematBlob;
+  friend class RematInstructionCtx;
+
+  // methods with suffix Locked expect mutex_ to be held by the caller
+  Maybe<void> MakeResidentLocked(RematBlob* blob, DeviceCtx* device_ctx);
+  Maybe<void> RematerializeLocked(RematBlob* blob, DeviceCtx* compute_ctx, bool is_foreign);
+  // Bodies owned by evicting_ctx may be evicted to make room, nullptr evicts nothing.
+  Maybe<void> AllocateBodyLocked(RematBlob* blob, DeviceCtx* evicting_ctx);
+  Maybe<void> PrepareMutationLocked(RematBlob* blob, DeviceCtx* device_ctx);
+  void EvictUntilFitsLocked(int64_t mem_zone_id, DeviceCtx* evicting_ctx, int64_t bytes);
+  void EvictLocked(RematBlob* blob);
+  void PinLocked(RematBlob* blob);
+  double EvictionScoreLocked(const RematBlob& blob) const;
+  double StalenessLocked(const RematBlob& blob) const {
+    return static_cast<double>(access_tick_ - blob.last_access_tick_ + 1);
+  }
+  void Touch(RematBlob* blob);
+  // files the blob in evictable_blobs_ under its current tick if it is evictable
+  void ReindexLocked(RematBlob* blob);
+  void UnindexLocked(RematBlob* blob);
+  void OnRematBlobDestroyed(RematBlob* blob);
+
+  std::atomic<int64_t> budget_bytes_;
+  // recursive since destroying a blob may release its producer and in turn the producer inputs
+  mutable std::recursive_mutex mutex_;
+  int64_t access_tick_;
+  HashSet<RematBlob*> resident_blobs_;
+  // resident, unpinned bodies with a producer by mem zone and owner device ctx, stalest first
+  std::map<std::pair<int64_t, DeviceCtx*>, std::set<std::pair<int64_t, RematBlob*>>>
+      evictable_blobs_;
+  HashMap<int64_t, int64_t> mem_zone_id2resident_bytes_;
+  HashMap<int64_t, int64_t> mem_zone_id2peak_resident_bytes_;
+  int64_t evict_cnt_;
+  int64_t evict_bytes_;
+  int64_t remat_cnt_;
+  int64_t remat_bytes_;
+  int64_t pin_cnt_;
+};
+
+// Brackets the compute of one instruction in memory-budget mode: bodies accessed are made
+// resident and locked against eviction until the ctx is destroyed, and if the instruction is a
+// replayable stateless user op kernel it becomes the producer of its outputs.
+class RematInstructionCtx final {
+ public:
+  OF_DISALLOW_COPY_AND_MOVE(RematInstructionCtx);
+  RematInstructionCtx(DeviceCtx* device_ctx, bool is_replayable);
+  ~RematInstructionCtx();
+
+  Maybe<void> AccessInput(const std::string& ibn, const BlobObject& blob_object, bool is_mut);
+  // Allocates the body of an output. is_visible_to_kernel is false for outputs left out of
+  // BnInOp2Blob, like empty tmp buffers.
+  Maybe<void> AccessOutput(const std::string& obn, BlobObject* blob_object,
+                           bool is_visible_to_kernel);
+  Maybe<void> TryRecordProducer(const std::shared_ptr<const EagerKernel>& kernel,
+                                const std::shared_ptr<const JobDesc>& job_desc,
+                                const std::shared_ptr<user_op::OpKernelState>& opkernel_state);
+  // records forward, which has to be stateless, as the producer of the outputs
+  Maybe<void> TryRecordProducer(const RematForward& forward);
+
+ private:
+  void Lock(const std::shared_ptr<RematBlob>& blob);
+
+  BlobRematerializer* rematerializer_;
+  DeviceCtx* device_ctx_;
+  bool is_replayable_;
+  std::vector<std::pair<std::string, std::shared_ptr<RematBlob>>> ibn_and_inputs_;
+  std::vector<std::pair<std::string, std::shared_ptr<RematBlob>>> obn_and_outputs_;
+  std::vector<std::shared_ptr<RematBlob>> locked_blobs_;
+};
+
+}  // namespace eager
+}  // namespace oneflow
+
+#endif  // ONEFLOW_CORE_EAGER_BLOB_REMATERIALIZER_H_
@@ -0,0 +1,170 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/eager/blob_rematerializer.h"
+#include "oneflow/core/eager/eager_blob_object.h"
+#include "oneflow/core/device/device_context.h"
+#include "oneflow/core/vm/allocator.h"
+
+namespace oneflow {
+namespace eager {
+
+namespace {
+
+const int64_t kElemCnt = 1024;
+
+class TestAllocator final : public vm::Allocator {
+ public:
+  TestAllocator() = default;
+  ~TestAllocator() override = default;
+
+  void Allocate(char** mem_ptr, std::size_t size) override {
+    *mem_ptr = reinterpret_cast<char*>(std::malloc(size));
+  }
+  void Deallocate(char* mem_ptr, std::size_t size) override { std::free(mem_ptr); }
+};
+
+class TestDeviceCtx final : public DeviceCtx {
+ public:
+  OF_DISALLOW_COPY_AND_MOVE(TestDeviceCtx);
+  TestDeviceCtx() = default;
+  ~TestDeviceCtx() override = default;
+
+  void SyncDevice() override {}
+  vm::Allocator* mut_allocator() override { return &allocator_; }
+
+ private:
+  TestAllocator allocator_;
+};
+
+std::shared_ptr<EagerBlobObject> NewBlobObject() {
+  const auto& mem_case = std::make_shared<MemoryCase>();
+  mem_case->mutable_host_mem();
+  const auto& blob_object = std::make_shared<EagerBlobObject>(mem_case, DataType::kFloat);
+  blob_object->mut_blob_desc()->mut_shape() = Shape({kElemCnt});
+  CHECK_JUST(blob_object->TryInitBlob());
+  CHECK(blob_object->remat_blob());
+  return blob_object;
+}
+
+// a budget of blob_num bodies of kElemCnt floats
+void SetBudget(int64_t blob_num) {
+  Global<BlobRematerializer>::Get()->set_budget_bytes(blob_num * kElemCnt * sizeof(float));
+}
+
+bool IsResident(const EagerBlobObject& blob_object) {
+  return blob_object.blob().dptr() != nullptr;
+}
+
+// Computes output as the sum of the inputs plus value, like a stateless user op kernel
+void Compute(DeviceCtx* device_ctx, const std::vector<EagerBlobObject*>& inputs, float value,
+             EagerBlobObject* output, int64_t* forward_cnt) {
+  RematInstructionCtx remat_ctx(device_ctx, true);
+  HashMap<std::string, Blob*> bn_in_op2blob;
+  FOR_RANGE(int64_t, i, 0, inputs.size()) {
+    const std::string ibn = "in_" + std::to_string(i);
+    CHECK_JUST(remat_ctx.AccessInput(ibn, *inputs.at(i), false));
+    bn_in_op2blob[ibn] = inputs.at(i)->mut_blob();
+  }
+  CHECK_JUST(remat_ctx.AccessOutput("out", output, true));
+  bn_in_op2blob["out"] = output->mut_blob();
+  const int64_t input_num = inputs.size();
+  const RematForward forward =
+      [input_num, value, forward_cnt](
+          DeviceCtx* device_ctx,
+          const std::function<Blob*(const std::string&)>& Blob4BnInOp) -> Maybe<void> {
+    ++*forward_cnt;
+    float* out_dptr = Blob4BnInOp("out")->mut_dptr<float>();
+    FOR_RANGE(int64_t, j, 0, kElemCnt) { out_dptr[j] = value; }
+    FOR_RANGE(int64_t, i, 0, input_num) {
+      const float* in_dptr = Blob4BnInOp("in_" + std::to_string(i))->dptr<float>();
+      FOR_RANGE(int64_t, j, 0, kElemCnt) { out_dptr[j] += in_dptr[j]; }
+    }
+    return Maybe<void>::Ok();
+  };
+  CHECK_JUST(forward(device_ctx, [&](const std::string& bn) { return bn_in_op2blob.at(bn); }));
+  CHECK_JUST(remat_ctx.TryRecordProducer(forward));
+}
+
+// accesses the body like an instruction reading it
+float Read(DeviceCtx* device_ctx, const EagerBlobObject& blob_object) {
+  RematInstructionCtx remat_ctx(device_ctx, false);
+  CHECK_JUST(remat_ctx.AccessInput("in", blob_object, false));
+  return blob_object.blob().dptr<float>()[kElemCnt - 1];
+}
+
+}  // namespace
+
+TEST(BlobRematerializer, evict_by_cost_size_and_staleness) {
+  SetBudget(3);
+  TestDeviceCtx device_ctx;
+  int64_t forward_cnt = 0;
+  const auto& a = NewBlobObject();
+  const auto& b = NewBlobObject();
+  const auto& c = NewBlobObject();
+  const auto& d = NewBlobObject();
+  const auto& e = NewBlobObject();
+  const auto& f = NewBlobObject();
+  Compute(&device_ctx, {}, 1, a.get(), &forward_cnt);
+  Compute(&device_ctx, {}, 2, b.get(), &forward_cnt);
+  Compute(&device_ctx, {a.get()}, 1, c.get(), &forward_cnt);
+  // b was accessed least recently
+  Compute(&device_ctx, {}, 4, d.get(), &forward_cnt);
+  ASSERT_FALSE(IsResident(*b));
+  ASSERT_TRUE(IsResident(*a));
+  Compute(&device_ctx, {}, 5, e.get(), &forward_cnt);
+  ASSERT_FALSE(IsResident(*a));
+  // c is the stalest, but replaying it also replays a
+  Compute(&device_ctx, {}, 6, f.get(), &forward_cnt);
+  ASSERT_FALSE(IsResident(*d));
+  ASSERT_TRUE(IsResident(*c));
+  ASSERT_TRUE(IsResident(*e));
+  ASSERT_EQ(forward_cnt, 6);
+  ASSERT_EQ(Read(&device_ctx, *d), 4);
+  ASSERT_EQ(forward_cnt, 7);
+  ASSERT_FALSE(IsResident(*e));
+  SetBudget(0);
+}
+
+TEST(BlobRematerializer, recompute_evicted_inputs_on_access) {
+  SetBudget(2);
+  TestDeviceCtx device_ctx;
+  int64_t forward_cnt = 0;
+  const auto& a = NewBlobObject();
+  const auto& b = NewBlobObject();
+  const auto& c = NewBlobObject();
+  const auto& d = NewBlobObject();
+  Compute(&device_ctx, {}, 1, a.get(), &forward_cnt);
+  Compute(&device_ctx, {a.get()}, 1, b.get(), &forward_cnt);
+  Compute(&device_ctx, {b.get()}, 1, c.get(), &forward_cnt);
+  Compute(&device_ctx, {c.get()}, 1, d.get(), &forward_cnt);
+  ASSERT_FALSE(IsResident(*a));
+  ASSERT_FALSE(IsResident(*b));
+  ASSERT_EQ(forward_cnt, 4);
+  // b is replayed after a, which then makes room for c
+  ASSERT_EQ(Read(&device_ctx, *b), 2);
+  ASSERT_EQ(forward_cnt, 6);
+  ASSERT_FALSE(IsResident(*c));
+  ASSERT_FALSE(IsResident(*d));
+  ASSERT_EQ(Read(&device_ctx, *c), 3);
+  ASSERT_EQ(forward_cnt, 7);
+  ASSERT_FALSE(IsResident(*a));
+  ASSERT_EQ(Read(&device_ctx, *d), 4);
+  ASSERT_EQ(forward_cnt, 8);
+  SetBudget(0);
+}
+
+}  // namespace eager
+}  // namespace oneflow
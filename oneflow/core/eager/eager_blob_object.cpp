@@ -22,13 +22,25 @@ namespace oneflow {
 namespace eager {
 
 Maybe<void> EagerBlobObject::TryInitBlob() {
-  if (!blob_) { JUST(InitBlob()); }
+  if (!blob_ && !remat_blob_) { JUST(InitBlob(std::make_shared<const RtBlobDesc>(blob_desc_))); }
   return Maybe<void>::Ok();
 }
 
-Maybe<void> EagerBlobObject::InitBlob() {
+Maybe<void> EagerBlobObject::TryInitBlob(const std::shared_ptr<const RtBlobDesc>& rt_blob_desc) {
+  if (!blob_ && !remat_blob_) { JUST(InitBlob(rt_blob_desc)); }
+  return Maybe<void>::Ok();
+}
+
+Maybe<void> EagerBlobObject::InitBlob(const std::shared_ptr<const RtBlobDesc>& rt_blob_desc) {
   CHECK_NE_OR_RETURN(blob_desc_.data_type(), DataType::kInvalidDataType);
-  rt_blob_desc_.reset(new RtBlobDesc(blob_desc_));
+  CHECK_NOTNULL_OR_RETURN(rt_blob_desc.get());
+  rt_blob_desc_ = rt_blob_desc;
+  auto* rematerializer = Global<BlobRematerializer>::Get();
+  if (rematerializer != nullptr && rematerializer->enabled()
+      && IsPODDataType(blob_desc_.data_type()) && !blob_desc_.is_tensor_list()) {
+    remat_blob_ = rematerializer->NewRematBlob(*mem_case_, rt_blob_desc_);
+    return Maybe<void>::Ok();
+  }
   {
     header_buffer_.reset();
     int64_t header_byte_size = rt_blob_desc_->ByteSizeOfBlobHeader();
@@ -41,6 +53,7 @@ Maybe<void> EagerBlobObject::InitBlob() {
 }
 
 void EagerBlobObject::TryAllocateBlobBodyMemory(DeviceCtx* device_ctx) {
+  CHECK(!remat_blob_) << "the body of a rematerializable blob is allocated by RematInstructionCtx";
   vm::Allocator* allocator = device_ctx->mut_allocator();
   CHECK_NOTNULL(allocator);
   Blob* blob = mut_blob();
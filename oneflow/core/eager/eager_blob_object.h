@@ -18,6 +18,7 @@ limitations under the License.
 
 #include "oneflow/core/common/maybe.h"
 #include "oneflow/core/eager/blob_object.h"
+#include "oneflow/core/eager/blob_rematerializer.h"
 #include "oneflow/core/memory/memory_allocator.h"
 
 namespace oneflow {
@@ -34,23 +35,32 @@ class EagerBlobObject : public BlobObject {
 
   virtual BlobDesc* mut_blob_desc() override { return &blob_desc_; }
 
-  virtual const Blob& blob() const override { return *blob_; }
-  virtual Blob* mut_blob() override { return blob_.get(); }
+  virtual const Blob& blob() const override {
+    return remat_blob_ ? remat_blob_->blob() : *blob_;
+  }
+  virtual Blob* mut_blob() override { return remat_blob_ ? remat_blob_->mut_blob() : blob_.get(); }
   virtual Maybe<void> TryInitBlob() override;
+  // Same as TryInitBlob() but shares an RtBlobDesc built earlier for an identical blob_desc_.
+  Maybe<void> TryInitBlob(const std::shared_ptr<const RtBlobDesc>& rt_blob_desc);
+  const std::shared_ptr<const RtBlobDesc>& rt_blob_desc() const { return rt_blob_desc_; }
+  // Not null if the blob was initialized in memory-budget mode. Its body is then managed by
+  // BlobRematerializer and allocated through RematInstructionCtx.
+  const std::shared_ptr<RematBlob>& remat_blob() const { return remat_blob_; }
 
   virtual void TryAllocateBlobBodyMemory(DeviceCtx* device_ctx) override;
 
  private:
-  Maybe<void> InitBlob();
+  Maybe<void> InitBlob(const std::shared_ptr<const RtBlobDesc>& rt_blob_desc);
 
   std::unique_ptr<Blob> blob_;
   std::unique_ptr<char, std::function<void(char*)>> header_buffer_;
   std::unique_ptr<char, std::function<void(char*)>> blob_dptr_;
   std::size_t blob_body_bytes_;
   MemoryAllocator non_pod_initer_;
+  std::shared_ptr<RematBlob> remat_blob_;
 
  protected:
-  std::unique_ptr<RtBlobDesc> rt_blob_desc_;
+  std::shared_ptr<const RtBlobDesc> rt_blob_desc_;
 };
 
 }  // namespace eager
@@ -0,0 +1,90 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/eager/eager_op_infer_cache.h"
+#include "oneflow/core/operator/operator.h"
+
+namespace oneflow {
+namespace eager {
+
+namespace {
+
+void EraseLbns(::google::protobuf::Map<std::string, UserOpConf::ListString>* arg_name2lbns) {
+  for (auto& pair : *arg_name2lbns) {
+    for (std::string& lbn : *pair.second.mutable_s()) { lbn = "undefined-op-name/undefined-bn"; }
+  }
+}
+
+}  // namespace
+
+Symbol<OperatorConf> GetUserOpConfSymWithoutOpNameAndLbn(const OperatorConf& op_conf) {
+  CHECK(op_conf.has_user_conf());
+  OperatorConf op_conf_without_name(op_conf);
+  op_conf_without_name.set_name("undefined-op-name");
+  EraseLbns(op_conf_without_name.mutable_user_conf()->mutable_input());
+  EraseLbns(op_conf_without_name.mutable_user_conf()->mutable_output());
+  return SymbolOf(op_conf_without_name);
+}
+
+std::shared_ptr<const EagerOpInferCacheValue> EagerOpInferCache::Find(
+    const EagerOpInferCacheKey& key) {
+  std::shared_ptr<const EagerOpInferCacheValue> value;
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    const auto& iter = key2value_.find(key);
+    if (iter != key2value_.end()) { value = iter->second; }
+  }
+  if (value) {
+    ++hit_cnt_;
+  } else {
+    ++miss_cnt_;
+  }
+  return value;
+}
+
+void EagerOpInferCache::Insert(const EagerOpInferCacheKey& key,
+                               const std::shared_ptr<const EagerOpInferCacheValue>& value) {
+  // entries swapped out are released after the lock is dropped
+  HashMap to_release;
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (key2value_.size() >= max_size_) {
+      std::swap(key2value_, to_release);
+      ++reset_cnt_;
+    }
+    key2value_[key] = value;
+  }
+}
+
+void EagerOpInferCache::Clear() {
+  HashMap to_release;
+  std::unique_lock<std::mutex> lock(mutex_);
+  std::swap(key2value_, to_release);
+}
+
+size_t EagerOpInferCache::size() const {
+  std::unique_lock<std::mutex> lock(mutex_);
+  return key2value_.size();
+}
+
+std::string EagerOpInferCache::StatisticsDebugString() const {
+  std::stringstream ss;
+  ss << "hit_cnt: " << hit_cnt() << ", miss_cnt: " << miss_cnt() << ", size: " << size()
+     << ", reset_cnt: " << reset_cnt();
+  return ss.str();
+}
+
+}  // namespace eager
+}  // namespace oneflow
@@ -0,0 +1,136 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifndef ONEFLOW_CORE_EAGER_EAGER_OP_INFER_CACHE_H_
+#define ONEFLOW_CORE_EAGER_EAGER_OP_INFER_CACHE_H_
+
+#include "oneflow/core/common/util.h"
+#include "oneflow/core/common/shape.h"
+#include "oneflow/core/common/symbol.h"
+#include "oneflow/core/job/job_desc.h"
+#include "oneflow/core/job/parallel_desc.h"
+#include "oneflow/core/kernel/kernel.pb.h"
+#include "oneflow/core/operator/op_conf.pb.h"
+#include "oneflow/core/operator/op_node_signature_desc.h"
+#include "oneflow/core/register/blob_desc.h"
+#include "oneflow/core/register/runtime_blob_desc.h"
+
+namespace oneflow {
+namespace eager {
+
+// The symbols eager instructions refer to (job desc, op node signature, parallel desc) are
+// deduplicated by the frontend, so pointer identity is a valid and cheap equality for them. The
+// key holds shared_ptrs to make sure an address is never reused while it is still cached.
+struct EagerOpInferCacheKey final {
+  std::shared_ptr<const JobDesc> job_desc;
+  std::shared_ptr<const OpNodeSignatureDesc> op_node_signature;
+  std::shared_ptr<const ParallelDesc> parallel_desc;
+  int64_t parallel_id;
+  DeviceType device_type;
+  Symbol<OperatorConf> op_conf_sym;
+  std::vector<Symbol<Shape>> ibn_idx2shape_sym;
+  std::vector<DataType> ibn_idx2data_type;
+  std::vector<bool> ibn_idx2is_dynamic;
+};
+
+struct EagerOpInferCacheValue final {
+  std::vector<std::string> obns;
+  std::vector<std::shared_ptr<const BlobDesc>> obn_idx2blob_desc;
+  std::vector<std::shared_ptr<const RtBlobDesc>> obn_idx2rt_blob_desc;
+  // op_conf in op_attribute is the one of the op which filled this entry
+  std::shared_ptr<const KernelConf> kernel_conf;
+};
+
+inline bool operator==(const EagerOpInferCacheKey& lhs, const EagerOpInferCacheKey& rhs) {
+  return lhs.job_desc == rhs.job_desc && lhs.op_node_signature == rhs.op_node_signature
+         && lhs.parallel_desc == rhs.parallel_desc && lhs.parallel_id == rhs.parallel_id
+         && lhs.device_type == rhs.device_type && lhs.op_conf_sym == rhs.op_conf_sym
+         && lhs.ibn_idx2shape_sym == rhs.ibn_idx2shape_sym
+         && lhs.ibn_idx2data_type == rhs.ibn_idx2data_type
+         && lhs.ibn_idx2is_dynamic == rhs.ibn_idx2is_dynamic;
+}
+
+}  // namespace eager
+}  // namespace oneflow
+
+namespace std {
+
+template<>
+struct hash<oneflow::eager::EagerOpInferCacheKey> final {
+  size_t operator()(const oneflow::eager::EagerOpInferCacheKey& key) const {
+    using namespace oneflow;
+    size_t ret = std::hash<const JobDesc*>()(key.job_desc.get())
+                 ^ std::hash<const OpNodeSignatureDesc*>()(key.op_node_signature.get())
+                 ^ std::hash<const ParallelDesc*>()(key.parallel_desc.get())
+                 ^ std::hash<int64_t>()(key.parallel_id)
+                 ^ std::hash<int>()(static_cast<int>(key.device_type))
+                 ^ std::hash<Symbol<OperatorConf>>()(key.op_conf_sym);
+    FOR_RANGE(size_t, i, 0, key.ibn_idx2shape_sym.size()) {
+      // mix in the position so that permuted input shapes do not collide
+      ret ^= std::hash<Symbol<Shape>>()(key.ibn_idx2shape_sym.at(i)) + i;
+    }
+    for (DataType data_type : key.ibn_idx2data_type) {
+      ret = ret * 31 + static_cast<size_t>(data_type);
+    }
+    return ret ^ std::hash<std::vector<bool>>()(key.ibn_idx2is_dynamic);
+  }
+};
+
+}  // namespace std
+
+namespace oneflow {
+namespace eager {
+
+// Returns op_conf with op name and all lbns erased so that ops differing only in names share
+// cache entries.
+Symbol<OperatorConf> GetUserOpConfSymWithoutOpNameAndLbn(const OperatorConf& op_conf);
+
+class EagerOpInferCache final {
+ public:
+  OF_DISALLOW_COPY_AND_MOVE(EagerOpInferCache);
+  EagerOpInferCache() : EagerOpInferCache(kDefaultMaxSize) {}
+  explicit EagerOpInferCache(size_t max_size)
+      : max_size_(max_size), hit_cnt_(0), miss_cnt_(0), reset_cnt_(0) {}
+  ~EagerOpInferCache() = default;
+
+  static constexpr size_t kDefaultMaxSize = 16384;
+
+  std::shared_ptr<const EagerOpInferCacheValue> Find(const EagerOpInferCacheKey& key);
+  void Insert(const EagerOpInferCacheKey& key,
+              const std::shared_ptr<const EagerOpInferCacheValue>& value);
+  void Clear();
+
+  size_t size() const;
+  int64_t hit_cnt() const { return hit_cnt_; }
+  int64_t miss_cnt() const { return miss_cnt_; }
+  int64_t reset_cnt() const { return reset_cnt_; }
+  std::string StatisticsDebugString() const;
+
+ private:
+  using HashMap = std::unordered_map<EagerOpInferCacheKey,
+                                     std::shared_ptr<const EagerOpInferCacheValue>>;
+
+  const size_t max_size_;
+  mutable std::mutex mutex_;
+  HashMap key2value_;
+  std::atomic<int64_t> hit_cnt_;
+  std::atomic<int64_t> miss_cnt_;
+  std::atomic<int64_t> reset_cnt_;
+};
+
+}  // namespace eager
+}  // namespace oneflow
+
+#endif  // ONEFLOW_CORE_EAGER_EAGER_OP_INFER_CACHE_H_
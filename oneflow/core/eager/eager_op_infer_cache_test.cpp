@@ -0,0 +1,75 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/eager/eager_op_infer_cache.h"
+
+namespace oneflow {
+namespace eager {
+
+namespace test {
+
+namespace {
+
+EagerOpInferCacheKey MakeKey(const OperatorConf& op_conf, const Shape& in_shape) {
+  EagerOpInferCacheKey key;
+  key.parallel_id = 0;
+  key.device_type = DeviceType::kCPU;
+  key.op_conf_sym = GetUserOpConfSymWithoutOpNameAndLbn(op_conf);
+  key.ibn_idx2shape_sym.push_back(SymbolOf(in_shape));
+  key.ibn_idx2data_type.push_back(DataType::kFloat);
+  key.ibn_idx2is_dynamic.push_back(false);
+  return key;
+}
+
+OperatorConf MakeReluOpConf(const std::string& op_name, const std::string& in_lbn) {
+  OperatorConf op_conf;
+  op_conf.set_name(op_name);
+  auto* user_conf = op_conf.mutable_user_conf();
+  user_conf->set_op_type_name("relu");
+  (*user_conf->mutable_input())["in"].add_s(in_lbn);
+  (*user_conf->mutable_output())["out"].add_s(op_name + "/out_0");
+  return op_conf;
+}
+
+}  // namespace
+
+TEST(EagerOpInferCache, hit_regardless_of_op_name) {
+  EagerOpInferCache cache;
+  const auto& key0 = MakeKey(MakeReluOpConf("relu0", "a/out_0"), Shape({2, 3}));
+  ASSERT_FALSE(static_cast<bool>(cache.Find(key0)));
+  cache.Insert(key0, std::make_shared<EagerOpInferCacheValue>());
+  const auto& key1 = MakeKey(MakeReluOpConf("relu1", "b/out_0"), Shape({2, 3}));
+  ASSERT_TRUE(static_cast<bool>(cache.Find(key1)));
+  const auto& key2 = MakeKey(MakeReluOpConf("relu2", "c/out_0"), Shape({4, 3}));
+  ASSERT_FALSE(static_cast<bool>(cache.Find(key2)));
+  ASSERT_EQ(cache.hit_cnt(), 1);
+  ASSERT_EQ(cache.miss_cnt(), 2);
+}
+
+TEST(EagerOpInferCache, reset_when_full) {
+  EagerOpInferCache cache(2);
+  const auto& op_conf = MakeReluOpConf("relu", "a/out_0");
+  FOR_RANGE(int64_t, i, 1, 4) {
+    cache.Insert(MakeKey(op_conf, Shape({i})), std::make_shared<EagerOpInferCacheValue>());
+  }
+  ASSERT_EQ(cache.size(), 1);
+  ASSERT_EQ(cache.reset_cnt(), 1);
+  ASSERT_TRUE(static_cast<bool>(cache.Find(MakeKey(op_conf, Shape({3})))));
+}
+
+}  // namespace test
+
+}  // namespace eager
+}  // namespace oneflow
@@ -20,6 +20,8 @@ limitations under the License.
 #include "oneflow/core/operator/operator.h"
 #include "oneflow/core/eager/opkernel_object.h"
 #include "oneflow/core/eager/eager_blob_object.h"
+#include "oneflow/core/eager/eager_op_infer_cache.h"
+#include "oneflow/core/eager/blob_rematerializer.h"
 #include "oneflow/core/vm/object_wrapper.h"
 #include "oneflow/core/vm/string_object.h"
 #include "oneflow/core/vm/stream.msg.h"
@@ -97,6 +99,8 @@ class DeleteOpKernelObjectInstructionType final : public vm::InstructionType {
 };
 COMMAND(vm::RegisterInstructionType<DeleteOpKernelObjectInstructionType>("DeleteOpKernelObject"));
 
+COMMAND(Global<EagerOpInferCache>::SetAllocated(new EagerOpInferCache()));
+
 namespace {
 
 std::shared_ptr<MemoryCase> MakeMemCase(const DeviceType device_type, const int64_t device_id) {
@@ -315,6 +319,104 @@ Maybe<void> CheckBlobParallel(vm::Instruction* instruction, const T& args,
   return Maybe<void>::Ok();
 }
 
+template<typename T>
+Maybe<void> MakeInferCacheKey(OpKernelObject* opkernel_obj, vm::Instruction* instruction,
+                              const T& args,
+                              const std::shared_ptr<const OpNodeSignatureDesc>& op_node_signature,
+                              const ParallelContext& parallel_ctx, EagerOpInferCacheKey* key) {
+  key->job_desc = opkernel_obj->job_desc_ptr();
+  key->op_node_signature = op_node_signature;
+  key->parallel_desc = instruction->parallel_desc();
+  key->parallel_id = parallel_ctx.parallel_id();
+  key->device_type = opkernel_obj->device_type();
+  key->op_conf_sym = opkernel_obj->op_conf_sym_without_name_and_lbn();
+  const auto& AppendInput = [&](const BlobDesc& blob_desc) {
+    key->ibn_idx2shape_sym.push_back(SymbolOf(blob_desc.shape()));
+    key->ibn_idx2data_type.push_back(blob_desc.data_type());
+    key->ibn_idx2is_dynamic.push_back(blob_desc.is_dynamic());
+  };
+  JUST(ForEachConstInputBnAndBlobObject(
+      instruction, args, [&](const std::string&, const BlobObject& blob_object) -> Maybe<void> {
+        AppendInput(blob_object.blob_desc());
+        return Maybe<void>::Ok();
+      }));
+  JUST(ForEachMutInputBnAndBlobObject(
+      instruction, args, [&](const std::string&, BlobObject* blob_object) -> Maybe<void> {
+        AppendInput(blob_object->blob_desc());
+        return Maybe<void>::Ok();
+      }));
+  return Maybe<void>::Ok();
+}
+
+template<typename T>
+Maybe<void> InitOutputBlobs4InferCacheValue(vm::Instruction* instruction, const T& args,
+                                            const EagerOpInferCacheValue& value) {
+  int64_t obn_idx = 0;
+  JUST(ForEachOutputBnAndBlobObject(
+      instruction, args, [&](const std::string& obn, BlobObject* blob_object) -> Maybe<void> {
+        CHECK_LT_OR_RETURN(obn_idx, value.obns.size());
+        CHECK_EQ_OR_RETURN(obn, value.obns.at(obn_idx));
+        blob_object->mut_blob_desc()->CopyFrom(*value.obn_idx2blob_desc.at(obn_idx));
+        auto* eager_blob_object = dynamic_cast<EagerBlobObject*>(blob_object);
+        if (eager_blob_object != nullptr) {
+          JUST(eager_blob_object->TryInitBlob(value.obn_idx2rt_blob_desc.at(obn_idx)));
+        } else {
+          JUST(blob_object->TryInitBlob());
+        }
+        ++obn_idx;
+        return Maybe<void>::Ok();
+      }));
+  CHECK_EQ_OR_RETURN(obn_idx, value.obns.size());
+  return Maybe<void>::Ok();
+}
+
+// Outputs not owned by eager, e.g. mutable lazy blobs, make the infer result uncacheable.
+template<typename T>
+Maybe<void> TryMakeInferCacheValue(OpKernelObject* opkernel_obj, vm::Instruction* instruction,
+                                   const T& args,
+                                   std::shared_ptr<const EagerOpInferCacheValue>* cache_value) {
+  auto value = std::make_shared<EagerOpInferCacheValue>();
+  bool cacheable = true;
+  JUST(ForEachOutputBnAndBlobObject(
+      instruction, args, [&](const std::string& obn, BlobObject* blob_object) -> Maybe<void> {
+        auto* eager_blob_object = dynamic_cast<EagerBlobObject*>(blob_object);
+        if (eager_blob_object == nullptr || !eager_blob_object->rt_blob_desc()) {
+          cacheable = false;
+          return Maybe<void>::Ok();
+        }
+        value->obns.push_back(obn);
+        value->obn_idx2blob_desc.emplace_back(new BlobDesc(blob_object->blob_desc()));
+        value->obn_idx2rt_blob_desc.push_back(eager_blob_object->rt_blob_desc());
+        return Maybe<void>::Ok();
+      }));
+  if (!cacheable) { return Maybe<void>::Ok(); }
+  value->kernel_conf = std::make_shared<const KernelConf>(opkernel_obj->kernel().kernel_conf());
+  *cache_value = value;
+  return Maybe<void>::Ok();
+}
+
+// Makes input bodies resident and allocates output bodies for compute
+template<typename T>
+Maybe<void> AccessBlobBodies(
+    vm::Instruction* instruction, const T& args, RematInstructionCtx* remat_ctx,
+    const std::function<bool(const std::string&, const BlobObject&)>& FilterOutBlob) {
+  JUST(ForEachConstInputBnAndBlobObject(
+      instruction, args,
+      [&](const std::string& bn_in_op, const BlobObject& blob_object) -> Maybe<void> {
+        return remat_ctx->AccessInput(bn_in_op, blob_object, false);
+      }));
+  JUST(ForEachMutInputBnAndBlobObject(
+      instruction, args, [&](const std::string& bn_in_op, BlobObject* blob_object) -> Maybe<void> {
+        return remat_ctx->AccessInput(bn_in_op, *blob_object, true);
+      }));
+  JUST(ForEachOutputBnAndBlobObject(
+      instruction, args, [&](const std::string& bn_in_op, BlobObject* blob_object) -> Maybe<void> {
+        bool is_visible_to_kernel = FilterOutBlob(bn_in_op, *blob_object);
+        return remat_ctx->AccessOutput(bn_in_op, blob_object, is_visible_to_kernel);
+      }));
+  return Maybe<void>::Ok();
+}
+
 template<typename T>
 Maybe<void> OpKernelInfer(OpKernelObject* opkernel_obj, vm::Instruction* instruction, const T& args,
                           const std::shared_ptr<MemoryCase>& mem_case) {
@@ -323,25 +425,44 @@ Maybe<void> OpKernelInfer(OpKernelObject* opkernel_obj, vm::Instruction* instruc
     CHECK_NE_OR_RETURN(default_data_type, DataType::kInvalidDataType);
     InitOutputBlobObjects(instruction, args, mem_case, default_data_type);
   }
-  std::function<BlobDesc*(const std::string&)> BlobDesc4BnInOp;
-  JUST(MakeBlobDesc4BnInOp(instruction, args, &BlobDesc4BnInOp));
-  const OpNodeSignatureDesc* op_node_signature = nullptr;
+  std::shared_ptr<const OpNodeSignatureDesc> op_node_signature;
   {
     const auto* operand = instruction->operand_type(args.op_node_signature());
     const auto* op_node_signature_object =
         JUST(operand->template Get<vm::ObjectWrapper<OpNodeSignatureDesc>>());
-    op_node_signature = &op_node_signature_object->Get();
+    op_node_signature = op_node_signature_object->GetPtr();
   }
   ParallelContext parallel_ctx;
   JUST(instruction->parallel_desc()->GetParallelContext(
       &parallel_ctx, instruction->stream().machine_id(), instruction->stream().device_id()));
-  JUST(opkernel_obj->ResetOpAndKernel(*op_node_signature, &parallel_ctx, BlobDesc4BnInOp,
-                                      instruction->parallel_desc().get()));
-  JUST(CheckBlobParallel(instruction, args, op_node_signature));
-  JUST(ForEachOutputBnAndBlobObject(
-      instruction, args, [](const std::string& obn, BlobObject* blob_object) -> Maybe<void> {
-        return blob_object->TryInitBlob();
-      }));
+  auto* infer_cache = Global<EagerOpInferCache>::Get();
+  EagerOpInferCacheKey infer_cache_key;
+  JUST(MakeInferCacheKey(opkernel_obj, instruction, args, op_node_signature, parallel_ctx,
+                         &infer_cache_key));
+  const auto& infer_cache_value = infer_cache->Find(infer_cache_key);
+  if (infer_cache_value) {
+    // the output blob descs and kernel_conf only depend on the cache key, so neither op
+    // construction nor InferBlobDescs is needed
+    opkernel_obj->ResetKernel(infer_cache_value->kernel_conf);
+    JUST(CheckBlobParallel(instruction, args, op_node_signature.get()));
+    JUST(InitOutputBlobs4InferCacheValue(instruction, args, *infer_cache_value));
+  } else {
+    std::function<BlobDesc*(const std::string&)> BlobDesc4BnInOp;
+    JUST(MakeBlobDesc4BnInOp(instruction, args, &BlobDesc4BnInOp));
+    JUST(opkernel_obj->ResetOpAndKernel(*op_node_signature, &parallel_ctx, BlobDesc4BnInOp,
+                                        instruction->parallel_desc().get()));
+    JUST(CheckBlobParallel(instruction, args, op_node_signature.get()));
+    JUST(ForEachOutputBnAndBlobObject(
+        instruction, args, [](const std::string& obn, BlobObject* blob_object) -> Maybe<void> {
+          return blob_object->TryInitBlob();
+        }));
+    std::shared_ptr<const EagerOpInferCacheValue> value;
+    JUST(TryMakeInferCacheValue(opkernel_obj, instruction, args, &value));
+    if (value) {
+      opkernel_obj->set_cached_kernel_conf(value->kernel_conf);
+      infer_cache->Insert(infer_cache_key, value);
+    }
+  }
   std::function<Blob*(const std::string&)> Blob4BnInOp;
   Shape empty_shape{};
   const auto& FilterOutBlob = [&](const std::string& bn_in_op, const BlobObject& blob_object) {
@@ -389,35 +510,32 @@ template<typename T>
 Maybe<void> OpKernelCompute(OpKernelObject* opkernel_obj, vm::Instruction* instruction,
                             const T& args) {
   DeviceCtx* device_ctx = instruction->stream().device_ctx().get();
-  JUST(ForEachOutputBnAndBlobObject(
-      instruction, args, [&](const std::string&, BlobObject* blob_object) -> Maybe<void> {
-        blob_object->TryAllocateBlobBodyMemory(device_ctx);
-        return Maybe<void>::Ok();
-      }));
+  Shape empty_shape{};
+  const auto& FilterOutBlob = [&](const std::string& bn_in_op, const BlobObject& blob_object) {
+    return !(bn_in_op == "tmp_buffer_0" && blob_object.blob_desc().shape() == empty_shape);
+  };
+  RematInstructionCtx remat_ctx(device_ctx, true);
+  JUST(AccessBlobBodies(instruction, args, &remat_ctx, FilterOutBlob));
   std::shared_ptr<user_op::OpKernelState> new_state;
   {
     std::function<Blob*(const std::string&)> Blob4BnInOp;
-    Shape empty_shape{};
-    const auto& FilterOutBlob = [&](const std::string& bn_in_op, const BlobObject& blob_object) {
-      return !(bn_in_op == "tmp_buffer_0" && blob_object.blob_desc().shape() == empty_shape);
-    };
     JUST(MakeBlob4BnInOp(instruction, args, &Blob4BnInOp, FilterOutBlob));
     EagerKernel* eager_kernel = opkernel_obj->mut_kernel();
     const auto& old_state = opkernel_obj->opkernel_state();
     new_state = eager_kernel->EagerForward(old_state, device_ctx, Blob4BnInOp);
   }
   opkernel_obj->reset_opkernel_state(new_state);
+  JUST(remat_ctx.TryRecordProducer(opkernel_obj->shared_kernel(), opkernel_obj->job_desc_ptr(),
+                                   new_state));
   return Maybe<void>::Ok();
 }
 
 Maybe<void> OpKernelCompute(SystemOpKernelObject* opkernel_obj, vm::Instruction* instruction,
                             const StatelessCallOpKernelInstrOperand& args) {
   DeviceCtx* device_ctx = instruction->stream().device_ctx().get();
-  JUST(ForEachOutputBnAndBlobObject(
-      instruction, args, [&](const std::string&, BlobObject* blob_object) -> Maybe<void> {
-        blob_object->TryAllocateBlobBodyMemory(device_ctx);
-        return Maybe<void>::Ok();
-      }));
+  RematInstructionCtx remat_ctx(device_ctx, false);
+  JUST(AccessBlobBodies(instruction, args, &remat_ctx,
+                        [](const std::string&, const BlobObject&) { return true; }));
   KernelCtx kernel_ctx;
   kernel_ctx.device_ctx = device_ctx;
   std::function<Blob*(const std::string&)> Blob4BnInOp;
@@ -573,26 +691,28 @@ void SystemStatelessCallOpKernelInstructionType::Compute(vm::Instruction* instru
 }
 
 template<typename T>
-void FeedOrFetchBlob(vm::Instruction* instruction) {
+void FeedOrFetchBlob(vm::Instruction* instruction, bool is_body_accessed, bool is_feed) {
   FlatMsgView<T> args(instruction->instr_msg().operand());
   DeviceCtx* device_ctx = instruction->stream().device_ctx().get();
   auto* rw_mutext_blob = instruction->mut_operand_type(args->blob());
   auto* blob_object = rw_mutext_blob->template Mut<BlobObject>();
+  RematInstructionCtx remat_ctx(device_ctx, false);
+  if (is_body_accessed) { CHECK_JUST(remat_ctx.AccessInput("blob", *blob_object, is_feed)); }
   OfBlob of_blob(device_ctx, blob_object->mut_blob());
   int64_t of_blob_ptr = reinterpret_cast<int64_t>(&of_blob);
   Global<ForeignCallback>::Get()->OfBlobCall(args->unique_callback_id(), of_blob_ptr);
 }
 
 void FetchBlobHeaderInstructionType::Infer(vm::Instruction* instruction) const {
-  FeedOrFetchBlob<FetchBlobInstrOperand>(instruction);
+  FeedOrFetchBlob<FetchBlobInstrOperand>(instruction, false, false);
 }
 
 void FetchBlobBodyInstructionType::Compute(vm::Instruction* instruction) const {
-  FeedOrFetchBlob<FetchBlobInstrOperand>(instruction);
+  FeedOrFetchBlob<FetchBlobInstrOperand>(instruction, true, false);
 }
 
 void FeedBlobInstructionType::Compute(vm::Instruction* instruction) const {
-  FeedOrFetchBlob<FeedBlobInstrOperand>(instruction);
+  FeedOrFetchBlob<FeedBlobInstrOperand>(instruction, true, true);
 }
 
 }  // namespace eager
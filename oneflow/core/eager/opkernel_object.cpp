@@ -14,6 +14,7 @@ See the License for the specific language governing permissions and
 limitations under the License.
 */
 #include "oneflow/core/eager/opkernel_object.h"
+#include "oneflow/core/eager/eager_op_infer_cache.h"
 
 namespace oneflow {
 namespace eager {
@@ -28,9 +29,26 @@ Maybe<void> OpKernelObject::ResetOpAndKernel(
                       &op_ctx));
   NewPartialInitializedKernel(*op, BlobDesc4BnInOp, op_node_signature, parallel_ctx, op_ctx.get(),
                               parallel_desc);
+  cached_kernel_conf_.reset();
   return Maybe<void>::Ok();
 }
 
+Symbol<OperatorConf> OpKernelObject::op_conf_sym_without_name_and_lbn() {
+  if (!op_conf_sym_without_name_and_lbn_) {
+    op_conf_sym_without_name_and_lbn_ = GetUserOpConfSymWithoutOpNameAndLbn(op_conf_);
+  }
+  return op_conf_sym_without_name_and_lbn_;
+}
+
+void OpKernelObject::ResetKernel(const std::shared_ptr<const KernelConf>& cached_kernel_conf) {
+  CHECK(static_cast<bool>(cached_kernel_conf));
+  if (kernel_ && cached_kernel_conf_ == cached_kernel_conf) { return; }
+  KernelConf kernel_conf(*cached_kernel_conf);
+  *kernel_conf.mutable_op_attribute()->mutable_op_conf() = op_conf_;
+  kernel_.reset(new EagerKernel(job_desc_.get(), kernel_conf));
+  cached_kernel_conf_ = cached_kernel_conf;
+}
+
 Maybe<void> OpKernelObject::InferBlobDescs(
     const Operator& op, const std::function<BlobDesc*(const std::string&)>& BlobDesc4BnInOp,
     const SbpSignature* sbp_signature, const ParallelContext* parallel_ctx,
@@ -40,20 +40,27 @@ class OpKernelObject : public vm::Object {
         job_desc_(job_desc),
         device_type_(device_type),
         kernel_(nullptr),
-        opkernel_state_(nullptr) {
+        opkernel_state_(nullptr),
+        cached_kernel_conf_(nullptr) {
     CHECK(op_conf.has_user_conf());
   }
   ~OpKernelObject() override = default;
 
   const JobDesc& job_desc() const { return *job_desc_; }
+  const std::shared_ptr<const JobDesc>& job_desc_ptr() const { return job_desc_; }
 
   const std::string& op_name() const { return op_conf_.name(); }
+  const OperatorConf& op_conf() const { return op_conf_; }
+  Symbol<OperatorConf> op_conf_sym_without_name_and_lbn();
   UserOpConf* mut_user_op_conf() { return op_conf_.mutable_user_conf(); }
+  DeviceType device_type() const { return device_type_; }
 
   const std::shared_ptr<user_op::OpKernelState>& opkernel_state() const { return opkernel_state_; }
 
   const EagerKernel& kernel() const { return *kernel_; }
   EagerKernel* mut_kernel() { return kernel_.get(); }
+  // kept alive by replayable instructions after the kernel is reset
+  std::shared_ptr<const EagerKernel> shared_kernel() const { return kernel_; }
   void reset_opkernel_state(const std::shared_ptr<user_op::OpKernelState>& opkernel_state) {
     opkernel_state_ = opkernel_state;
   }
@@ -62,6 +69,12 @@ class OpKernelObject : public vm::Object {
                                const ParallelContext* parallel_ctx,
                                const std::function<BlobDesc*(const std::string&)>& BlobDesc4BnInOp,
                                const ParallelDesc* parallel_desc);
+  // Rebuilds kernel_ from a kernel_conf generated by an op identical to this one except for
+  // names. Nothing is done if kernel_ was already built from the same cached kernel_conf.
+  void ResetKernel(const std::shared_ptr<const KernelConf>& cached_kernel_conf);
+  void set_cached_kernel_conf(const std::shared_ptr<const KernelConf>& cached_kernel_conf) {
+    cached_kernel_conf_ = cached_kernel_conf;
+  }
 
  private:
   Maybe<void> InferBlobDescs(const Operator& op,
@@ -76,8 +89,10 @@ class OpKernelObject : public vm::Object {
   OperatorConf op_conf_;
   std::shared_ptr<const JobDesc> job_desc_;
   DeviceType device_type_;
-  std::unique_ptr<EagerKernel> kernel_;
+  std::shared_ptr<EagerKernel> kernel_;
   std::shared_ptr<user_op::OpKernelState> opkernel_state_;
+  std::shared_ptr<const KernelConf> cached_kernel_conf_;
+  Symbol<OperatorConf> op_conf_sym_without_name_and_lbn_;
 };
 
 class SystemOpKernelObject : public vm::Object {
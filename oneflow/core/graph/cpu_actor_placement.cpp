@@ -0,0 +1,175 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/graph/cpu_actor_placement.h"
+#include <numeric>
+
+namespace oneflow {
+
+namespace {
+
+using CpuTask = std::pair<const LogicalNode*, int64_t>;
+
+struct CpuTaskGroup {
+  int64_t machine_id;
+  double act_time;
+  std::vector<int64_t> task_indexes;
+};
+
+bool IsCpuLogicalNode(const LogicalNode* logical_node) {
+  return logical_node->parallel_desc()->device_type() == DeviceType::kCPU;
+}
+
+// the producer whose tasks the tasks of logical_node may share threads with
+const LogicalNode* ChainPrevLogicalNode(const LogicalNode* logical_node) {
+  if (logical_node->in_edges().size() != 1) { return nullptr; }
+  const LogicalNode* src_node = logical_node->SoleInEdge()->src_node();
+  if (!IsCpuLogicalNode(src_node) || src_node->out_edges().size() != 1) { return nullptr; }
+  if (!(*src_node->parallel_desc() == *logical_node->parallel_desc())) { return nullptr; }
+  return src_node;
+}
+
+}  // namespace
+
+CpuActorPlacement::CpuActorPlacement(const LogicalGraph& logical_graph,
+                                     const CpuActorProfile& profile, int64_t cpu_device_num) {
+  std::vector<CpuTask> tasks;
+  std::vector<CpuPlacementTask> placement_tasks;
+  HashMap<CpuTask, int64_t> task2index;
+  // tasks missing from the profile are as heavy as the average profiled task
+  std::vector<int64_t> unprofiled_indexes;
+  double profiled_act_time = 0;
+  logical_graph.TopoForEachNode([&](const LogicalNode* logical_node) {
+    if (!IsCpuLogicalNode(logical_node)) { return; }
+    const ParallelDesc& parallel_desc = *logical_node->parallel_desc();
+    const std::string& op_name = logical_node->op_vec().front()->op_name();
+    const LogicalNode* prev_logical_node = ChainPrevLogicalNode(logical_node);
+    // the same order as LogicalNode::GenSortedCompTaskNodes
+    int64_t parallel_id = 0;
+    for (int64_t machine_id : parallel_desc.sorted_machine_ids()) {
+      FOR_RANGE(size_t, i, 0, parallel_desc.sorted_dev_phy_ids(machine_id).size()) {
+        const CpuTask task(logical_node, parallel_id);
+        CpuPlacementTask placement_task;
+        placement_task.machine_id = machine_id;
+        placement_task.act_time = 0;
+        placement_task.chain_prev = prev_logical_node == nullptr
+                                        ? -1
+                                        : task2index.at(CpuTask(prev_logical_node, parallel_id));
+        const auto& task_key2act_time = profile.task_key2act_time();
+        const auto& iter = task_key2act_time.find(CpuActorProfileKey(op_name, parallel_id));
+        if (iter == task_key2act_time.end()) {
+          unprofiled_indexes.push_back(tasks.size());
+        } else {
+          placement_task.act_time = iter->second;
+          profiled_act_time += iter->second;
+        }
+        task2index[task] = tasks.size();
+        tasks.push_back(task);
+        placement_tasks.push_back(placement_task);
+        parallel_id += 1;
+      }
+    }
+  });
+  const int64_t profiled_cnt = tasks.size() - unprofiled_indexes.size();
+  const double default_act_time = profiled_cnt == 0 ? 1.0 : profiled_act_time / profiled_cnt;
+  for (int64_t index : unprofiled_indexes) {
+    placement_tasks.at(index).act_time = default_act_time;
+  }
+  const std::vector<int64_t> cpu_device_ids = PlaceCpuTasks(placement_tasks, cpu_device_num);
+  FOR_RANGE(int64_t, i, 0, tasks.size()) {
+    task2cpu_device_id_[tasks.at(i)] = cpu_device_ids.at(i);
+  }
+}
+
+int64_t CpuActorPlacement::CpuDeviceId4Task(const LogicalNode* logical_node,
+                                            int64_t parallel_id) const {
+  const auto& iter = task2cpu_device_id_.find(CpuTask(logical_node, parallel_id));
+  if (iter == task2cpu_device_id_.end()) { return -1; }
+  return iter->second;
+}
+
+std::vector<int64_t> PlaceCpuTasks(const std::vector<CpuPlacementTask>& tasks,
+                                   int64_t cpu_device_num) {
+  HashMap<int64_t, double> machine_id2fair_share;
+  for (const CpuPlacementTask& task : tasks) {
+    machine_id2fair_share[task.machine_id] += task.act_time;
+  }
+  for (auto& pair : machine_id2fair_share) { pair.second /= cpu_device_num; }
+
+  std::vector<CpuTaskGroup> groups;
+  std::vector<int64_t> task2group_id(tasks.size());
+  FOR_RANGE(int64_t, i, 0, tasks.size()) {
+    const CpuPlacementTask& task = tasks.at(i);
+    if (task.chain_prev != -1) {
+      CHECK_LT(task.chain_prev, i);
+      const int64_t group_id = task2group_id.at(task.chain_prev);
+      CpuTaskGroup* group = &groups.at(group_id);
+      if (group->act_time + task.act_time <= machine_id2fair_share.at(task.machine_id)) {
+        group->act_time += task.act_time;
+        group->task_indexes.push_back(i);
+        task2group_id.at(i) = group_id;
+        continue;
+      }
+    }
+    task2group_id.at(i) = groups.size();
+    groups.push_back(CpuTaskGroup{task.machine_id, task.act_time, {i}});
+  }
+
+  // longest processing time first onto the least loaded thread
+  std::vector<int64_t> group_ids(groups.size());
+  std::iota(group_ids.begin(), group_ids.end(), 0);
+  std::stable_sort(group_ids.begin(), group_ids.end(), [&](int64_t lhs, int64_t rhs) {
+    return groups.at(lhs).act_time > groups.at(rhs).act_time;
+  });
+  std::vector<int64_t> cpu_device_ids(tasks.size());
+  HashMap<int64_t, std::vector<double>> machine_id2thrd_loads;
+  for (int64_t group_id : group_ids) {
+    const CpuTaskGroup& group = groups.at(group_id);
+    std::vector<double>* thrd_loads = &machine_id2thrd_loads[group.machine_id];
+    if (thrd_loads->empty()) { thrd_loads->assign(cpu_device_num, 0); }
+    const int64_t cpu_device_id =
+        std::min_element(thrd_loads->begin(), thrd_loads->end()) - thrd_loads->begin();
+    thrd_loads->at(cpu_device_id) += group.act_time;
+    for (int64_t index : group.task_indexes) { cpu_device_ids.at(index) = cpu_device_id; }
+  }
+  return cpu_device_ids;
+}
+
+std::string CpuActorProfileKey(const std::string& op_name, int64_t parallel_id) {
+  return op_name + "/" + std::to_string(parallel_id);
+}
+
+void GenCpuActorProfile(const Plan& plan, const std::list<std::unique_ptr<ActEvent>>& act_events,
+                        CpuActorProfile* profile) {
+  HashMap<int64_t, std::pair<double, int64_t>> actor_id2total_act_time_and_act_cnt;
+  for (const auto& act_event : act_events) {
+    auto* total_act_time_and_act_cnt = &actor_id2total_act_time_and_act_cnt[act_event->actor_id()];
+    total_act_time_and_act_cnt->first += (act_event->stop_time() - act_event->start_time()) / 1e9;
+    total_act_time_and_act_cnt->second += 1;
+  }
+  auto* task_key2act_time = profile->mutable_task_key2act_time();
+  for (const TaskProto& task : plan.task()) {
+    if (!task.has_parallel_ctx() || task.exec_sequence().exec_node_size() == 0) { continue; }
+    const OperatorConf& op_conf =
+        task.exec_sequence().exec_node(0).kernel_conf().op_attribute().op_conf();
+    if (op_conf.device_tag() != "cpu") { continue; }
+    const auto& iter = actor_id2total_act_time_and_act_cnt.find(task.task_id());
+    if (iter == actor_id2total_act_time_and_act_cnt.end()) { continue; }
+    (*task_key2act_time)[CpuActorProfileKey(op_conf.name(), task.parallel_ctx().parallel_id())] =
+        iter->second.first / iter->second.second;
+  }
+}
+
+}  // namespace oneflow
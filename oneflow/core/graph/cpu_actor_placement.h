@@ -0,0 +1,62 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifndef ONEFLOW_CORE_GRAPH_CPU_ACTOR_PLACEMENT_H_
+#define ONEFLOW_CORE_GRAPH_CPU_ACTOR_PLACEMENT_H_
+
+#include "oneflow/core/graph/logical_graph.h"
+#include "oneflow/core/job/cpu_actor_profile.pb.h"
+#include "oneflow/core/job/plan.pb.h"
+#include "oneflow/core/actor/act_event.pb.h"
+
+namespace oneflow {
+
+// Assigns the cpu compute tasks of each machine to the cpu device threads. The act times of a
+// profile are balanced over the threads, a chain of ops with one consumer each stays on one thread
+// as long as it does not exceed the fair share of a thread.
+class CpuActorPlacement final {
+ public:
+  OF_DISALLOW_COPY_AND_MOVE(CpuActorPlacement);
+  CpuActorPlacement(const LogicalGraph& logical_graph, const CpuActorProfile& profile,
+                    int64_t cpu_device_num);
+  ~CpuActorPlacement() = default;
+
+  // -1 for tasks the placement does not know
+  int64_t CpuDeviceId4Task(const LogicalNode* logical_node, int64_t parallel_id) const;
+
+ private:
+  HashMap<std::pair<const LogicalNode*, int64_t>, int64_t> task2cpu_device_id_;
+};
+
+// A cpu compute task of CpuActorPlacement, tasks are placed in topological order
+struct CpuPlacementTask {
+  int64_t machine_id;
+  double act_time;
+  // the index of the task of the producer it may share a thread with, -1 if there is none
+  int64_t chain_prev;
+};
+
+// returns the cpu device id of each task
+std::vector<int64_t> PlaceCpuTasks(const std::vector<CpuPlacementTask>& tasks,
+                                   int64_t cpu_device_num);
+
+std::string CpuActorProfileKey(const std::string& op_name, int64_t parallel_id);
+
+void GenCpuActorProfile(const Plan& plan, const std::list<std::unique_ptr<ActEvent>>& act_events,
+                        CpuActorProfile* profile);
+
+}  // namespace oneflow
+
+#endif  // ONEFLOW_CORE_GRAPH_CPU_ACTOR_PLACEMENT_H_
@@ -0,0 +1,39 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/graph/cpu_actor_placement.h"
+
+namespace oneflow {
+
+TEST(CpuActorPlacement, keep_chain_within_fair_share) {
+  // the fair share of each of the 2 threads is 2
+  const std::vector<CpuPlacementTask> tasks = {{0, 1, -1}, {0, 1, 0}, {0, 2, -1}};
+  ASSERT_EQ(PlaceCpuTasks(tasks, 2), std::vector<int64_t>({0, 0, 1}));
+}
+
+TEST(CpuActorPlacement, split_chain_beyond_fair_share) {
+  const std::vector<CpuPlacementTask> tasks = {{0, 2, -1}, {0, 1, 0}, {0, 1, -1}};
+  ASSERT_EQ(PlaceCpuTasks(tasks, 2), std::vector<int64_t>({0, 1, 1}));
+}
+
+TEST(CpuActorPlacement, longest_processing_time_first) {
+  // the longest tasks are placed first onto the least loaded thread of their machine, the
+  // chained task joins its producer on the second machine
+  const std::vector<CpuPlacementTask> tasks = {{0, 2, -1}, {0, 3, -1}, {0, 2, -1}, {1, 1, -1},
+                                               {0, 3, -1}, {0, 2, -1}, {1, 1, 3},  {1, 2, -1}};
+  ASSERT_EQ(PlaceCpuTasks(tasks, 2), std::vector<int64_t>({0, 0, 1, 0, 1, 0, 0, 1}));
+}
+
+}  // namespace oneflow
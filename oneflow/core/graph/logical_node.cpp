@@ -129,6 +129,7 @@ void LogicalNode::GenSortedCompTaskNodes(
   for (int64_t machine_id : parallel_desc_->sorted_machine_ids()) {
     for (int64_t dev_phy_id : parallel_desc_->sorted_dev_phy_ids(machine_id)) {
       CompTaskNode* comp_task_node = NewCompTaskNode();
+      comp_task_node->set_logical_node(this);
       comp_task_node->set_machine_id(machine_id);
       comp_task_node->mut_parallel_ctx()->set_parallel_id(parallel_idx++);
       comp_task_node->mut_parallel_ctx()->set_parallel_num(parallel_num);
@@ -175,7 +176,6 @@ void LogicalNode::GenSortedCompTaskNodes(
       } else {
         UNIMPLEMENTED();
       }
-      comp_task_node->set_logical_node(this);
       Handler(comp_task_node);
     }
   }
@@ -34,6 +34,8 @@ limitations under the License.
 #include "oneflow/core/graph/boxing/to_interface_sub_task_graph_builder.h"
 #include "oneflow/core/graph/boxing/sub_task_graph_builder_util.h"
 #include "oneflow/core/graph/boxing_identity_compute_task_node.h"
+#include "oneflow/core/graph/cpu_actor_placement.h"
+#include "oneflow/core/thread/thread_manager.h"
 
 namespace oneflow {
 
@@ -177,10 +179,25 @@ TaskGraph::TaskGraph(std::unique_ptr<const LogicalGraph>&& logical_gph) {
     return &(buf_vec.at(mem_zone_id));
   };
 
+  const ResourceDesc& resource_desc = *Global<ResourceDesc, ForSession>::Get();
+  std::unique_ptr<CpuActorPlacement> cpu_actor_placement;
+  if (!resource_desc.cpu_actor_profile_path().empty()) {
+    CpuActorProfile profile;
+    ParseProtoFromTextFile(resource_desc.cpu_actor_profile_path(), &profile);
+    cpu_actor_placement.reset(
+        new CpuActorPlacement(*logical_gph_, profile, resource_desc.CpuDeviceNum()));
+  }
   std::vector<int64_t> cpu_device_offset(Global<ResourceDesc, ForSession>::Get()->TotalMachineNum(),
                                          0);
   auto AllocateCpuThrdIdEvenly = [&](const TaskNode* task_node) {
     CHECK(!task_node->IsIndependent());
+    const auto* comp_task_node = dynamic_cast<const CompTaskNode*>(task_node);
+    if (cpu_actor_placement && comp_task_node != nullptr
+        && comp_task_node->logical_node() != nullptr) {
+      const int64_t cpu_device_id = cpu_actor_placement->CpuDeviceId4Task(
+          comp_task_node->logical_node(), comp_task_node->parallel_id());
+      if (cpu_device_id != -1) { return Global<IDMgr>::Get()->GetCpuDeviceThrdId(cpu_device_id); }
+    }
     int64_t& offset = cpu_device_offset.at(task_node->machine_id());
     int64_t ret = Global<IDMgr>::Get()->GetCpuDeviceThrdId(offset);
     offset = (offset + 1) % Global<ResourceDesc, ForSession>::Get()->CpuDeviceNum();
@@ -282,6 +299,28 @@ void TaskGraph::AcyclicTopoForEachNode(const std::function<void(TaskNode* node)>
   return AcyclicTopoForEachNode([](TaskNode*) { return true; }, Handler);
 }
 
+void TaskGraph::ParallelTopoForEachNode(const std::function<void(TaskNode* node)>& Handler) const {
+  HashMap<const TaskNode*, int64_t> node2level;
+  std::vector<std::vector<TaskNode*>> levels;
+  TopoForEachNode([&](TaskNode* node) {
+    int64_t level = 0;
+    node->ForEachNodeOnInEdge(
+        [&](TaskNode* in_node) { level = std::max(level, node2level.at(in_node) + 1); });
+    node2level.emplace(node, level);
+    if (level == static_cast<int64_t>(levels.size())) { levels.emplace_back(); }
+    levels.at(level).push_back(node);
+  });
+  // nodes differ a lot in cost, so the threads pull them one by one instead of taking fixed ranges
+  constexpr int64_t kMinNodeNumPerThread = 4;
+  for (const std::vector<TaskNode*>& level : levels) {
+    std::atomic<int64_t> next(0);
+    const int64_t level_size = level.size();
+    MultiThreadLoopInRanges(level_size, kMinNodeNumPerThread, [&](int64_t, int64_t, int64_t) {
+      for (int64_t i = next++; i < level_size; i = next++) { Handler(level.at(i)); }
+    });
+  }
+}
+
 void TaskGraph::RemoveEmptyRegsts() {
   ForEachNode([&](TaskNode* node) { node->EraseZeroSizeProducedBlob(); });
   ForEachNode([&](TaskNode* node) { node->EraseZeroSizeConsumedRegst(); });
@@ -45,6 +45,9 @@ class TaskGraph final : public Graph<TaskNode, TaskEdge> {
                                    IsOpNameDataOrCtrlReachable);
 
   void AcyclicTopoForEachNode(const std::function<void(TaskNode* node)>& Handler) const;
+  // Handles the nodes level by level in topological order, the nodes of a level concurrently on
+  // the ThreadPool. Handler may only touch the node itself and read its in nodes.
+  void ParallelTopoForEachNode(const std::function<void(TaskNode* node)>& Handler) const;
 
 #define DECLARE_BLD_SUB_TASK_GRAPH_METHOD(method_name) void method_name BLD_SUB_TSK_GPH_MTHD_ARGS();
 
@@ -0,0 +1,338 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/job/act_graph_analysis.h"
+#include "oneflow/core/common/shape.h"
+
+namespace oneflow {
+
+namespace {
+
+double Ns2Ms(double ns) { return ns / 1e6; }
+
+struct RegstDescInfo {
+  int64_t producer;
+  std::string name;
+  int64_t register_num;
+};
+
+struct ActNode {
+  const ActEvent* event;
+  int64_t piece_id;
+  // pairs of pred node and edge
+  std::vector<std::pair<int64_t, int64_t>> in_edges;
+  // whether an act reads a regst of this act
+  bool is_consumed = false;
+  // the in edge whose pred stops last, -1 if there is no pred
+  int64_t binding_in_edge = -1;
+};
+
+struct EdgeStat {
+  ActDependencyEdge edge;
+  int64_t bound_act_cnt = 0;
+  double stall_ns = 0;
+  int64_t critical_piece_cnt = 0;
+  double bubble_ns = 0;
+};
+
+class ActGraph final {
+ public:
+  OF_DISALLOW_COPY_AND_MOVE(ActGraph);
+  ActGraph(const Plan& plan, const std::list<std::unique_ptr<ActEvent>>& act_events);
+  ~ActGraph() = default;
+
+  void GenReport(ActGraphReport* report);
+
+ private:
+  void InitActors(const Plan& plan);
+  void AddSerialEdges();
+  void AddRegstEdges();
+  void AddEdge(int64_t src, int64_t dst, ActDependencyType type, int64_t regst_desc_id);
+  int64_t FindNode(int64_t actor_id, int64_t act_id) const;
+  void ChargeStalls();
+  void ChargeBubbles(ActGraphReport* report);
+  void FollowCriticalPaths(ActGraphReport* report);
+  const ActNode& BindingPred(const ActNode& node) const {
+    return nodes_.at(node.in_edges.at(node.binding_in_edge).first);
+  }
+  EdgeStat* BindingEdgeStat(const ActNode& node) {
+    return &edge_stats_.at(node.in_edges.at(node.binding_in_edge).second);
+  }
+
+  HashMap<int64_t, std::string> actor_id2name_;
+  HashMap<int64_t, int64_t> actor_id2act_cnt_per_piece_;
+  HashMap<int64_t, RegstDescInfo> regst_desc_id2info_;
+  std::vector<ActNode> nodes_;
+  HashMap<std::pair<int64_t, int64_t>, int64_t> actor_act2node_;
+  std::vector<EdgeStat> edge_stats_;
+  HashMap<std::string, int64_t> edge_key2edge_;
+};
+
+ActGraph::ActGraph(const Plan& plan, const std::list<std::unique_ptr<ActEvent>>& act_events) {
+  InitActors(plan);
+  for (const auto& act_event : act_events) {
+    const auto actor_act = std::make_pair(act_event->actor_id(), act_event->act_id());
+    if (actor_id2name_.find(actor_act.first) == actor_id2name_.end()) { continue; }
+    if (!actor_act2node_.emplace(actor_act, nodes_.size()).second) { continue; }
+    nodes_.emplace_back();
+    nodes_.back().event = act_event.get();
+    nodes_.back().piece_id = act_event->act_id() / actor_id2act_cnt_per_piece_.at(actor_act.first);
+  }
+  AddSerialEdges();
+  AddRegstEdges();
+  for (ActNode& node : nodes_) {
+    double last_stop_time = -1;
+    FOR_RANGE(int64_t, i, 0, node.in_edges.size()) {
+      const double stop_time = nodes_.at(node.in_edges.at(i).first).event->stop_time();
+      if (stop_time > last_stop_time) {
+        last_stop_time = stop_time;
+        node.binding_in_edge = i;
+      }
+    }
+  }
+}
+
+void ActGraph::InitActors(const Plan& plan) {
+  for (const TaskProto& task : plan.task()) {
+    std::string name = TaskType_Name(task.task_type()) + ":";
+    if (task.has_parallel_ctx() && task.exec_sequence().exec_node_size() > 0) {
+      name += task.exec_sequence().exec_node(0).kernel_conf().op_attribute().op_conf().name() + "/"
+              + std::to_string(task.parallel_ctx().parallel_id());
+    } else {
+      name += std::to_string(task.task_id());
+    }
+    actor_id2name_.emplace(task.task_id(), name);
+    // the outermost dim of a time shape counts the pieces, the others the acts of each piece
+    int64_t act_cnt_per_piece = 1;
+    for (const auto& pair : task.produced_regst_desc()) {
+      if (!pair.second.regst_desc_type().has_data_regst_desc()) { continue; }
+      const DataRegstDesc& data_regst_desc = pair.second.regst_desc_type().data_regst_desc();
+      if (!data_regst_desc.has_time_shape()) { continue; }
+      const Shape time_shape(data_regst_desc.time_shape());
+      if (time_shape.NumAxes() == 0 || time_shape.At(0) == 0) { continue; }
+      act_cnt_per_piece = std::max(act_cnt_per_piece, time_shape.elem_cnt() / time_shape.At(0));
+    }
+    actor_id2act_cnt_per_piece_.emplace(task.task_id(), act_cnt_per_piece);
+    for (const auto& pair : task.produced_regst_desc()) {
+      RegstDescInfo info;
+      info.producer = task.task_id();
+      info.name = pair.first;
+      info.register_num = pair.second.register_num();
+      regst_desc_id2info_.emplace(pair.second.regst_desc_id(), info);
+    }
+  }
+}
+
+void ActGraph::AddSerialEdges() {
+  HashMap<int64_t, std::vector<int64_t>> actor_id2nodes;
+  FOR_RANGE(int64_t, i, 0, nodes_.size()) {
+    actor_id2nodes[nodes_.at(i).event->actor_id()].push_back(i);
+  }
+  for (auto& pair : actor_id2nodes) {
+    std::vector<int64_t>* actor_nodes = &pair.second;
+    std::sort(actor_nodes->begin(), actor_nodes->end(), [&](int64_t lhs, int64_t rhs) {
+      return nodes_.at(lhs).event->act_id() < nodes_.at(rhs).event->act_id();
+    });
+    FOR_RANGE(int64_t, i, 1, actor_nodes->size()) {
+      AddEdge(actor_nodes->at(i - 1), actor_nodes->at(i), kSerialActDependency, -1);
+    }
+  }
+}
+
+void ActGraph::AddRegstEdges() {
+  // the readers of each regst, keyed by regst desc id and the act id of its producer
+  HashMap<std::pair<int64_t, int64_t>, std::vector<int64_t>> regst2readers;
+  HashMap<int64_t, std::vector<int64_t>> regst_desc_id2act_ids;
+  FOR_RANGE(int64_t, i, 0, nodes_.size()) {
+    for (const ReadableRegstInfo& info : nodes_.at(i).event->readable_regst_infos()) {
+      const auto& info_it = regst_desc_id2info_.find(info.regst_desc_id());
+      if (info_it == regst_desc_id2info_.end()) { continue; }
+      const int64_t producer_node = FindNode(info_it->second.producer, info.act_id());
+      if (producer_node != -1) {
+        AddEdge(producer_node, i, kUpstreamRegstDependency, info.regst_desc_id());
+        nodes_.at(producer_node).is_consumed = true;
+      }
+      regst2readers[std::make_pair(info.regst_desc_id(), info.act_id())].push_back(i);
+      regst_desc_id2act_ids[info.regst_desc_id()].push_back(info.act_id());
+    }
+  }
+  // the regst of the n-th output reuses the slot of the (n - register_num)-th one
+  for (auto& pair : regst_desc_id2act_ids) {
+    const RegstDescInfo& info = regst_desc_id2info_.at(pair.first);
+    std::vector<int64_t>* act_ids = &pair.second;
+    std::sort(act_ids->begin(), act_ids->end());
+    act_ids->erase(std::unique(act_ids->begin(), act_ids->end()), act_ids->end());
+    FOR_RANGE(int64_t, n, info.register_num, act_ids->size()) {
+      const int64_t producer_node = FindNode(info.producer, act_ids->at(n));
+      if (producer_node == -1) { continue; }
+      const auto& readers =
+          regst2readers.at(std::make_pair(pair.first, act_ids->at(n - info.register_num)));
+      for (int64_t reader : readers) {
+        AddEdge(reader, producer_node, kDownstreamSlotDependency, pair.first);
+      }
+    }
+  }
+}
+
+void ActGraph::AddEdge(int64_t src, int64_t dst, ActDependencyType type, int64_t regst_desc_id) {
+  const int64_t src_actor_id = nodes_.at(src).event->actor_id();
+  const int64_t dst_actor_id = nodes_.at(dst).event->actor_id();
+  const std::string key = std::to_string(src_actor_id) + "," + std::to_string(dst_actor_id) + ","
+                          + std::to_string(type) + "," + std::to_string(regst_desc_id);
+  auto it = edge_key2edge_.find(key);
+  if (it == edge_key2edge_.end()) {
+    it = edge_key2edge_.emplace(key, edge_stats_.size()).first;
+    edge_stats_.emplace_back();
+    ActDependencyEdge* edge = &edge_stats_.back().edge;
+    edge->set_src_actor(actor_id2name_.at(src_actor_id));
+    edge->set_dst_actor(actor_id2name_.at(dst_actor_id));
+    edge->set_type(type);
+    if (regst_desc_id != -1) { edge->set_regst_name(regst_desc_id2info_.at(regst_desc_id).name); }
+  }
+  nodes_.at(dst).in_edges.emplace_back(src, it->second);
+}
+
+int64_t ActGraph::FindNode(int64_t actor_id, int64_t act_id) const {
+  const auto& it = actor_act2node_.find(std::make_pair(actor_id, act_id));
+  return it == actor_act2node_.end() ? -1 : it->second;
+}
+
+void ActGraph::ChargeStalls() {
+  for (const ActNode& node : nodes_) {
+    if (node.binding_in_edge == -1) { continue; }
+    EdgeStat* stat = BindingEdgeStat(node);
+    stat->bound_act_cnt += 1;
+    // the previous act of the actor is a pred of each act but its first
+    const ActEvent* prev = nullptr;
+    for (const auto& in_edge : node.in_edges) {
+      if (edge_stats_.at(in_edge.second).edge.type() == kSerialActDependency) {
+        prev = nodes_.at(in_edge.first).event;
+      }
+    }
+    if (prev != nullptr) {
+      stat->stall_ns += std::max(node.event->ready_time() - prev->stop_time(), 0.0);
+    }
+  }
+}
+
+void ActGraph::ChargeBubbles(ActGraphReport* report) {
+  std::map<int64_t, std::vector<const ActNode*>> stream_id2nodes;
+  for (const ActNode& node : nodes_) {
+    stream_id2nodes[node.event->work_stream_id()].push_back(&node);
+  }
+  for (auto& pair : stream_id2nodes) {
+    std::vector<const ActNode*>* stream_nodes = &pair.second;
+    std::sort(stream_nodes->begin(), stream_nodes->end(),
+              [](const ActNode* lhs, const ActNode* rhs) {
+                return lhs->event->start_time() < rhs->event->start_time();
+              });
+    double busy_ns = 0;
+    double bubble_ns = 0;
+    double last_stop_time = stream_nodes->front()->event->start_time();
+    for (const ActNode* node : *stream_nodes) {
+      const double start_time = node->event->start_time();
+      const double stop_time = node->event->stop_time();
+      if (start_time > last_stop_time) {
+        bubble_ns += start_time - last_stop_time;
+        if (node->binding_in_edge != -1) {
+          BindingEdgeStat(*node)->bubble_ns += start_time - last_stop_time;
+        }
+      }
+      busy_ns += std::max(stop_time - std::max(start_time, last_stop_time), 0.0);
+      last_stop_time = std::max(last_stop_time, stop_time);
+    }
+    StreamBubbles* stream_bubbles = report->add_stream_bubbles();
+    stream_bubbles->set_work_stream_id(pair.first);
+    stream_bubbles->set_act_cnt(stream_nodes->size());
+    stream_bubbles->set_busy_ms(Ns2Ms(busy_ns));
+    stream_bubbles->set_span_ms(Ns2Ms(last_stop_time - stream_nodes->front()->event->start_time()));
+    stream_bubbles->set_bubble_ms(Ns2Ms(bubble_ns));
+  }
+}
+
+void ActGraph::FollowCriticalPaths(ActGraphReport* report) {
+  std::map<int64_t, const ActNode*> piece_id2last_sink;
+  for (const ActNode& node : nodes_) {
+    if (node.is_consumed) { continue; }
+    const ActNode*& last_sink = piece_id2last_sink[node.piece_id];
+    if (last_sink == nullptr || node.event->stop_time() > last_sink->event->stop_time()) {
+      last_sink = &node;
+    }
+  }
+  for (const auto& pair : piece_id2last_sink) {
+    // the path stays within the acts of the piece, the first step keeps the edge from the act
+    // of an earlier piece which made it ready
+    std::vector<const ActNode*> path{pair.second};
+    HashSet<const ActNode*> visited{pair.second};
+    while (path.back()->binding_in_edge != -1) {
+      const ActNode* pred = &BindingPred(*path.back());
+      if (pred->piece_id != pair.first || !visited.insert(pred).second) { break; }
+      path.push_back(pred);
+    }
+    std::reverse(path.begin(), path.end());
+    PieceCriticalPath* critical_path = report->add_piece_critical_path();
+    critical_path->set_piece_id(pair.first);
+    critical_path->set_length_ms(
+        Ns2Ms(path.back()->event->stop_time() - path.front()->event->ready_time()));
+    for (const ActNode* node : path) {
+      const ActEvent* event = node->event;
+      CriticalPathStep* step = critical_path->add_step();
+      step->set_actor(actor_id2name_.at(event->actor_id()));
+      step->set_act_id(event->act_id());
+      step->set_act_ms(Ns2Ms(event->stop_time() - event->ready_time()));
+      if (node->binding_in_edge == -1) {
+        step->set_wait_ms(0);
+        continue;
+      }
+      step->set_wait_ms(
+          Ns2Ms(std::max(event->ready_time() - BindingPred(*node).event->stop_time(), 0.0)));
+      EdgeStat* stat = BindingEdgeStat(*node);
+      stat->critical_piece_cnt += 1;
+      *step->mutable_edge() = stat->edge;
+    }
+  }
+}
+
+void ActGraph::GenReport(ActGraphReport* report) {
+  if (nodes_.empty()) { return; }
+  ChargeStalls();
+  ChargeBubbles(report);
+  FollowCriticalPaths(report);
+  std::vector<const EdgeStat*> edge_stats;
+  for (const EdgeStat& stat : edge_stats_) { edge_stats.push_back(&stat); }
+  const auto& EdgeKey = [](const EdgeStat* stat) {
+    return std::make_tuple(stat->edge.src_actor(), stat->edge.dst_actor(),
+                           static_cast<int>(stat->edge.type()), stat->edge.regst_name());
+  };
+  std::sort(edge_stats.begin(), edge_stats.end(),
+            [&](const EdgeStat* lhs, const EdgeStat* rhs) { return EdgeKey(lhs) < EdgeKey(rhs); });
+  for (const EdgeStat* stat : edge_stats) {
+    ActEdgeStall* edge_stall = report->add_edge_stall();
+    *edge_stall->mutable_edge() = stat->edge;
+    edge_stall->set_bound_act_cnt(stat->bound_act_cnt);
+    edge_stall->set_stall_ms(Ns2Ms(stat->stall_ns));
+    edge_stall->set_critical_piece_cnt(stat->critical_piece_cnt);
+    edge_stall->set_bubble_ms(Ns2Ms(stat->bubble_ns));
+  }
+}
+
+}  // namespace
+
+void AnalyzeActGraph(const Plan& plan, const std::list<std::unique_ptr<ActEvent>>& act_events,
+                     ActGraphReport* report) {
+  ActGraph(plan, act_events).GenReport(report);
+}
+
+}  // namespace oneflow
@@ -0,0 +1,41 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifndef ONEFLOW_CORE_JOB_ACT_GRAPH_ANALYSIS_H_
+#define ONEFLOW_CORE_JOB_ACT_GRAPH_ANALYSIS_H_
+
+#include "oneflow/core/common/util.h"
+#include "oneflow/core/actor/act_event.pb.h"
+#include "oneflow/core/job/act_graph_analysis.pb.h"
+#include "oneflow/core/job/plan.pb.h"
+
+namespace oneflow {
+
+// Rebuilds the dependencies among the acts of the act events with the regst descs of the plan.
+// An act depends on the previous act of its actor, on the acts producing the regsts it reads and,
+// through the register num of the regsts it writes, on the acts releasing the regst slots it
+// reuses. The dependency that stopped last made the act ready and is charged with the idle time
+// of the actor before it.
+//
+// The acts of a piece are told by the time shapes of the regsts their actors produce: an actor
+// acting n times per piece has the acts n * piece_id to n * piece_id + n - 1 in it. The critical
+// path of a piece is followed back along the dependencies from the act of the piece which stops
+// last among the acts whose regsts no act reads, as long as the acts are in the piece.
+void AnalyzeActGraph(const Plan& plan, const std::list<std::unique_ptr<ActEvent>>& act_events,
+                     ActGraphReport* report);
+
+}  // namespace oneflow
+
+#endif  // ONEFLOW_CORE_JOB_ACT_GRAPH_ANALYSIS_H_
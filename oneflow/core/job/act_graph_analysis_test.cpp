@@ -0,0 +1,156 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/job/act_graph_analysis.h"
+
+namespace oneflow {
+
+namespace {
+
+// a task producing the regst "<name>" with its task id times 10 as regst desc id
+void AddTask(Plan* plan, int64_t task_id, const std::string& name, int64_t register_num,
+             int64_t act_cnt_per_piece) {
+  TaskProto* task = plan->add_task();
+  task->set_task_type(TaskType::kNormalForward);
+  task->set_task_id(task_id);
+  RegstDescProto* regst_desc = &(*task->mutable_produced_regst_desc())[name];
+  regst_desc->set_regst_desc_id(task_id * 10);
+  regst_desc->set_producer_task_id(task_id);
+  regst_desc->set_register_num(register_num);
+  ShapeProto* time_shape =
+      regst_desc->mutable_regst_desc_type()->mutable_data_regst_desc()->mutable_time_shape();
+  time_shape->add_dim(2);
+  time_shape->add_dim(act_cnt_per_piece);
+}
+
+// times are in ms, the reader acts read the regsts of the given acts of the actor before
+void AddActEvent(std::list<std::unique_ptr<ActEvent>>* act_events, int64_t actor_id,
+                 int64_t act_id, double ready_time, double stop_time,
+                 const std::vector<std::pair<int64_t, int64_t>>& regst_desc_id7act_ids) {
+  act_events->emplace_back(new ActEvent());
+  ActEvent* act_event = act_events->back().get();
+  act_event->set_is_experiment_phase(false);
+  act_event->set_actor_id(actor_id);
+  act_event->set_work_stream_id(actor_id);
+  act_event->set_act_id(act_id);
+  act_event->set_ready_time(ready_time * 1e6);
+  act_event->set_start_time(ready_time * 1e6);
+  act_event->set_stop_time(stop_time * 1e6);
+  for (const auto& pair : regst_desc_id7act_ids) {
+    ReadableRegstInfo* info = act_event->add_readable_regst_infos();
+    info->set_regst_desc_id(pair.first);
+    info->set_act_id(pair.second);
+  }
+}
+
+const ActEdgeStall& FindEdgeStall(const ActGraphReport& report, const std::string& src_actor,
+                                  const std::string& dst_actor, ActDependencyType type) {
+  for (const ActEdgeStall& edge_stall : report.edge_stall()) {
+    if (edge_stall.edge().src_actor() == src_actor && edge_stall.edge().dst_actor() == dst_actor
+        && edge_stall.edge().type() == type) {
+      return edge_stall;
+    }
+  }
+  UNIMPLEMENTED();
+}
+
+void CheckStep(const CriticalPathStep& step, const std::string& actor, int64_t act_id,
+               double act_ms) {
+  ASSERT_EQ(step.actor(), actor);
+  ASSERT_EQ(step.act_id(), act_id);
+  ASSERT_DOUBLE_EQ(step.act_ms(), act_ms);
+  ASSERT_DOUBLE_EQ(step.wait_ms(), 0);
+}
+
+}  // namespace
+
+TEST(ActGraphAnalysis, serial_upstream_and_slot_edges) {
+  // a acts once per piece with a single regst slot, b reads each regst of a twice and c reads each
+  // regst of b, which has two slots
+  Plan plan;
+  AddTask(&plan, 1, "a_out", 1, 1);
+  AddTask(&plan, 2, "b_out", 2, 2);
+  AddTask(&plan, 3, "c_out", 1, 2);
+  const std::string a = "kNormalForward:1";
+  const std::string b = "kNormalForward:2";
+  const std::string c = "kNormalForward:3";
+  std::list<std::unique_ptr<ActEvent>> act_events;
+  AddActEvent(&act_events, 1, 0, 0, 10, {});
+  AddActEvent(&act_events, 2, 0, 10, 20, {{10, 0}});
+  AddActEvent(&act_events, 2, 1, 20, 30, {{10, 0}});
+  AddActEvent(&act_events, 3, 0, 20, 25, {{20, 0}});
+  AddActEvent(&act_events, 3, 1, 30, 35, {{20, 1}});
+  // the slot of a is released by the last read of b
+  AddActEvent(&act_events, 1, 1, 30, 40, {});
+  AddActEvent(&act_events, 2, 2, 40, 50, {{10, 1}});
+  AddActEvent(&act_events, 3, 2, 50, 55, {{20, 2}});
+  AddActEvent(&act_events, 2, 3, 50, 60, {{10, 1}});
+  AddActEvent(&act_events, 3, 3, 60, 70, {{20, 3}});
+  // an actor out of the plan is ignored
+  AddActEvent(&act_events, 4, 0, 0, 100, {{30, 0}});
+  ActGraphReport report;
+  AnalyzeActGraph(plan, act_events, &report);
+
+  const ActEdgeStall& a_slot = FindEdgeStall(report, b, a, kDownstreamSlotDependency);
+  ASSERT_EQ(a_slot.edge().regst_name(), "a_out");
+  ASSERT_EQ(a_slot.bound_act_cnt(), 1);
+  ASSERT_DOUBLE_EQ(a_slot.stall_ms(), 20);
+  ASSERT_EQ(a_slot.critical_piece_cnt(), 1);
+  const ActEdgeStall& b_slot = FindEdgeStall(report, c, b, kDownstreamSlotDependency);
+  ASSERT_EQ(b_slot.edge().regst_name(), "b_out");
+  ASSERT_EQ(b_slot.bound_act_cnt(), 0);
+  const ActEdgeStall& b_serial = FindEdgeStall(report, b, b, kSerialActDependency);
+  ASSERT_EQ(b_serial.bound_act_cnt(), 2);
+  ASSERT_EQ(b_serial.critical_piece_cnt(), 2);
+  const ActEdgeStall& b_upstream = FindEdgeStall(report, a, b, kUpstreamRegstDependency);
+  ASSERT_EQ(b_upstream.bound_act_cnt(), 2);
+  ASSERT_DOUBLE_EQ(b_upstream.stall_ms(), 10);
+  ASSERT_EQ(FindEdgeStall(report, b, c, kUpstreamRegstDependency).bound_act_cnt(), 4);
+  ASSERT_EQ(report.edge_stall_size(), 7);
+
+  ASSERT_EQ(report.stream_bubbles_size(), 3);
+  ASSERT_EQ(report.stream_bubbles(0).work_stream_id(), 1);
+  ASSERT_DOUBLE_EQ(report.stream_bubbles(0).busy_ms(), 20);
+  ASSERT_DOUBLE_EQ(report.stream_bubbles(0).span_ms(), 40);
+  ASSERT_DOUBLE_EQ(report.stream_bubbles(0).bubble_ms(), 20);
+
+  // the acts of b and c in the second piece have the act ids 2 and 3
+  ASSERT_EQ(report.piece_critical_path_size(), 2);
+  const PieceCriticalPath& first_path = report.piece_critical_path(0);
+  ASSERT_EQ(first_path.piece_id(), 0);
+  ASSERT_DOUBLE_EQ(first_path.length_ms(), 35);
+  ASSERT_EQ(first_path.step_size(), 4);
+  CheckStep(first_path.step(0), a, 0, 10);
+  ASSERT_FALSE(first_path.step(0).has_edge());
+  CheckStep(first_path.step(1), b, 0, 10);
+  ASSERT_EQ(first_path.step(1).edge().type(), kUpstreamRegstDependency);
+  CheckStep(first_path.step(2), b, 1, 10);
+  ASSERT_EQ(first_path.step(2).edge().type(), kSerialActDependency);
+  CheckStep(first_path.step(3), c, 1, 5);
+  ASSERT_EQ(first_path.step(3).edge().type(), kUpstreamRegstDependency);
+  const PieceCriticalPath& second_path = report.piece_critical_path(1);
+  ASSERT_EQ(second_path.piece_id(), 1);
+  ASSERT_DOUBLE_EQ(second_path.length_ms(), 40);
+  ASSERT_EQ(second_path.step_size(), 4);
+  // the first step keeps the slot edge from the last act of b in the first piece
+  CheckStep(second_path.step(0), a, 1, 10);
+  ASSERT_EQ(second_path.step(0).edge().type(), kDownstreamSlotDependency);
+  ASSERT_EQ(second_path.step(0).edge().src_actor(), b);
+  CheckStep(second_path.step(1), b, 2, 10);
+  CheckStep(second_path.step(2), b, 3, 10);
+  CheckStep(second_path.step(3), c, 3, 10);
+}
+
+}  // namespace oneflow
@@ -0,0 +1,235 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/job/actor_fusion_util.h"
+#include "oneflow/core/job/job_desc.h"
+#include "oneflow/core/common/shape.h"
+
+namespace oneflow {
+
+namespace {
+
+// the tasks the compiler and the runtime find through their sole exec node by op name or type,
+// e.g. the producers of the lbis of the critical sections
+bool IsSoleOpTask(const OperatorConf& op_conf) {
+  if (IsInterfaceOpConf(op_conf)) { return true; }
+  switch (op_conf.op_type_case()) {
+    case OperatorConf::kTickConf:
+    case OperatorConf::kSourceTickConf:
+    case OperatorConf::kSinkTickConf:
+    case OperatorConf::kDeviceTickConf:
+    case OperatorConf::kAccTickConf:
+    case OperatorConf::kPartialTickConf:
+    case OperatorConf::kWaitAndSendIdsConf:
+    case OperatorConf::kReentrantLockConf:
+    case OperatorConf::kCallbackNotifyConf:
+    case OperatorConf::kForeignInputConf:
+    case OperatorConf::kForeignOutputConf:
+    case OperatorConf::kForeignWatchConf:
+    case OperatorConf::kCaseConf:
+    case OperatorConf::kEsacConf: return true;
+    default: return false;
+  }
+}
+
+bool IsFusibleTask(const TaskProto& task) {
+  if (task.task_type() != TaskType::kNormalForward) { return false; }
+  for (const ExecNodeProto& node : task.exec_sequence().exec_node()) {
+    const OperatorConf& op_conf = node.kernel_conf().op_attribute().op_conf();
+    if (IsSoleOpTask(op_conf)) { return false; }
+    // kernels which may return before their work is queued need an actor of their own
+    if (op_conf.has_collective_boxing_generic_conf() || op_conf.has_sync_dynamic_resize_conf()) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool IsCtrlRegst(const RegstDescProto& regst_desc) {
+  return regst_desc.regst_desc_type().has_ctrl_regst_desc();
+}
+
+bool IsSameTimeShape(const RegstDescProto& lhs, const RegstDescProto& rhs) {
+  return Shape(lhs.regst_desc_type().data_regst_desc().time_shape())
+         == Shape(rhs.regst_desc_type().data_regst_desc().time_shape());
+}
+
+void AddUniqueId(PbRf<int64_t>* ids, int64_t id) {
+  if (std::find(ids->begin(), ids->end(), id) == ids->end()) { ids->Add(id); }
+}
+
+class ActorFusion final {
+ public:
+  OF_DISALLOW_COPY_AND_MOVE(ActorFusion);
+  explicit ActorFusion(Plan* plan);
+  ~ActorFusion() = default;
+
+  void FuseLinearChains();
+
+ private:
+  RegstDescProto* MutRegstDesc4RegstDescId(int64_t regst_desc_id);
+  // the task task may be merged into, nullptr if none
+  TaskProto* FusibleProducer(const TaskProto& task);
+  void Fuse(TaskProto* producer, TaskProto* consumer);
+
+  Plan* plan_;
+  HashMap<int64_t, TaskProto*> task_id2task_;
+  HashMap<int64_t, int64_t> regst_desc_id2producer_task_id_;
+  HashSet<int64_t> fused_task_ids_;
+  int64_t unsent_regst_cnt_;
+};
+
+ActorFusion::ActorFusion(Plan* plan) : plan_(plan), unsent_regst_cnt_(0) {
+  for (TaskProto& task : *plan->mutable_task()) {
+    CHECK(task_id2task_.emplace(task.task_id(), &task).second);
+    for (const auto& pair : task.produced_regst_desc()) {
+      CHECK(regst_desc_id2producer_task_id_.emplace(pair.second.regst_desc_id(), task.task_id())
+                .second);
+    }
+  }
+}
+
+RegstDescProto* ActorFusion::MutRegstDesc4RegstDescId(int64_t regst_desc_id) {
+  const auto& producer_it = regst_desc_id2producer_task_id_.find(regst_desc_id);
+  if (producer_it == regst_desc_id2producer_task_id_.end()) { return nullptr; }
+  for (auto& pair : *task_id2task_.at(producer_it->second)->mutable_produced_regst_desc()) {
+    if (pair.second.regst_desc_id() == regst_desc_id) { return &pair.second; }
+  }
+  UNIMPLEMENTED();
+  return nullptr;
+}
+
+TaskProto* ActorFusion::FusibleProducer(const TaskProto& task) {
+  if (!IsFusibleTask(task)) { return nullptr; }
+  TaskProto* producer = nullptr;
+  std::vector<const RegstDescProto*> in_regst_descs;
+  for (const auto& pair : task.consumed_regst_desc_id()) {
+    for (int64_t regst_desc_id : pair.second.regst_desc_id()) {
+      const RegstDescProto* regst_desc = MutRegstDesc4RegstDescId(regst_desc_id);
+      if (regst_desc == nullptr) { return nullptr; }
+      if (IsCtrlRegst(*regst_desc)) { continue; }
+      TaskProto* cur_producer = task_id2task_.at(regst_desc->producer_task_id());
+      if (producer != nullptr && producer != cur_producer) { return nullptr; }
+      producer = cur_producer;
+      in_regst_descs.push_back(regst_desc);
+    }
+  }
+  if (producer == nullptr || !IsFusibleTask(*producer)) { return nullptr; }
+  if (producer->machine_id() != task.machine_id() || producer->thrd_id() != task.thrd_id()) {
+    return nullptr;
+  }
+  if (producer->produced_regst_desc().count("const_buf") > 0
+      && task.produced_regst_desc().count("const_buf") > 0) {
+    return nullptr;
+  }
+  // no one but task waits on the producer, so the merged task can not close a cycle
+  for (const auto& pair : producer->produced_regst_desc()) {
+    for (int64_t consumer_task_id : pair.second.consumer_task_id()) {
+      if (consumer_task_id != task.task_id()) { return nullptr; }
+    }
+  }
+  // task acts once per act of the producer and its outputs do not share memory with the inputs
+  for (const auto& pair : task.produced_regst_desc()) {
+    const RegstDescProto& regst_desc = pair.second;
+    if (regst_desc.inplace_consumed_regst_desc_id() != -1
+        || regst_desc.hint_inplace_consumed_regst_desc_id() != -1) {
+      return nullptr;
+    }
+    if (IsCtrlRegst(regst_desc)) { continue; }
+    for (const RegstDescProto* in_regst_desc : in_regst_descs) {
+      if (!IsSameTimeShape(*in_regst_desc, regst_desc)) { return nullptr; }
+    }
+  }
+  return producer;
+}
+
+void ActorFusion::Fuse(TaskProto* producer, TaskProto* consumer) {
+  // the regsts between the two are kept by the merged task for its kernels, none is sent
+  HashSet<int64_t> inner_regst_desc_ids;
+  std::vector<std::string> inner_ctrl_regst_names;
+  for (auto& pair : *producer->mutable_produced_regst_desc()) {
+    RegstDescProto* regst_desc = &pair.second;
+    inner_regst_desc_ids.insert(regst_desc->regst_desc_id());
+    if (regst_desc->consumer_task_id_size() > 0) { unsent_regst_cnt_ += 1; }
+    if (IsCtrlRegst(*regst_desc)) {
+      inner_ctrl_regst_names.push_back(pair.first);
+    } else {
+      regst_desc->clear_consumer_task_id();
+    }
+  }
+  for (const std::string& name : inner_ctrl_regst_names) {
+    CHECK_EQ(regst_desc_id2producer_task_id_.erase(
+                 producer->produced_regst_desc().at(name).regst_desc_id()),
+             1);
+    producer->mutable_produced_regst_desc()->erase(name);
+  }
+  for (const auto& pair : consumer->consumed_regst_desc_id()) {
+    for (int64_t regst_desc_id : pair.second.regst_desc_id()) {
+      if (inner_regst_desc_ids.count(regst_desc_id) > 0) { continue; }
+      auto* consumer_task_ids = MutRegstDesc4RegstDescId(regst_desc_id)->mutable_consumer_task_id();
+      consumer_task_ids->erase(
+          std::remove(consumer_task_ids->begin(), consumer_task_ids->end(), consumer->task_id()),
+          consumer_task_ids->end());
+      AddUniqueId(consumer_task_ids, producer->task_id());
+      AddUniqueId((*producer->mutable_consumed_regst_desc_id())[pair.first].mutable_regst_desc_id(),
+                  regst_desc_id);
+    }
+  }
+  for (const auto& pair : consumer->produced_regst_desc()) {
+    std::string name = pair.first;
+    if (producer->produced_regst_desc().count(name) > 0) {
+      name += "_" + std::to_string(consumer->task_id());
+    }
+    RegstDescProto* regst_desc = &(*producer->mutable_produced_regst_desc())[name];
+    *regst_desc = pair.second;
+    regst_desc->set_producer_task_id(producer->task_id());
+    regst_desc_id2producer_task_id_.at(regst_desc->regst_desc_id()) = producer->task_id();
+  }
+  for (const ExecNodeProto& node : consumer->exec_sequence().exec_node()) {
+    *producer->mutable_exec_sequence()->add_exec_node() = node;
+  }
+  CHECK(fused_task_ids_.insert(consumer->task_id()).second);
+}
+
+void ActorFusion::FuseLinearChains() {
+  bool changed = true;
+  while (changed) {
+    changed = false;
+    for (TaskProto& task : *plan_->mutable_task()) {
+      if (fused_task_ids_.count(task.task_id()) > 0) { continue; }
+      TaskProto* producer = FusibleProducer(task);
+      if (producer == nullptr) { continue; }
+      Fuse(producer, &task);
+      changed = true;
+    }
+  }
+  if (fused_task_ids_.empty()) { return; }
+  const int64_t task_num = plan_->task_size();
+  PbRpf<TaskProto> remaining_tasks;
+  for (TaskProto& task : *plan_->mutable_task()) {
+    if (fused_task_ids_.count(task.task_id()) > 0) { continue; }
+    remaining_tasks.Add()->Swap(&task);
+  }
+  plan_->mutable_task()->Swap(&remaining_tasks);
+  LOG(INFO) << "actor fusion of job " << GlobalJobDesc().job_name() << ": " << task_num
+            << " actors to " << plan_->task_size() << ", " << unsent_regst_cnt_
+            << " regsts no longer sent between actors each act";
+}
+
+}  // namespace
+
+void ActorFusionUtil::FuseLinearChains(Plan* plan) { ActorFusion(plan).FuseLinearChains(); }
+
+}  // namespace oneflow
@@ -0,0 +1,34 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifndef ONEFLOW_CORE_JOB_ACTOR_FUSION_UTIL_H_
+#define ONEFLOW_CORE_JOB_ACTOR_FUSION_UTIL_H_
+
+#include "oneflow/core/job/plan.pb.h"
+
+namespace oneflow {
+
+struct ActorFusionUtil {
+  // Merges each normal forward task into the task on the same thread that produces all its
+  // inputs, when nothing but the consumer reads the regsts of the producer. The merged task runs
+  // the kernels of both back to back in one act, the regsts between them are no longer sent.
+  // Interface, tick and control ops keep a task of their own, since they are found through the
+  // sole exec node of their task.
+  static void FuseLinearChains(Plan* plan);
+};
+
+}  // namespace oneflow
+
+#endif  // ONEFLOW_CORE_JOB_ACTOR_FUSION_UTIL_H_
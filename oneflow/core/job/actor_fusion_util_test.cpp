@@ -0,0 +1,138 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/job/actor_fusion_util.h"
+#include "oneflow/core/job/global_for.h"
+#include "oneflow/core/job/job_desc.h"
+#include "oneflow/core/job/resource_desc.h"
+
+namespace oneflow {
+
+namespace {
+
+OperatorConf ReluOpConf(const std::string& name) {
+  OperatorConf op_conf;
+  op_conf.set_name(name);
+  op_conf.mutable_user_conf()->set_op_type_name("relu");
+  return op_conf;
+}
+
+OperatorConf NewInputOpConf(const std::string& name) {
+  OperatorConf op_conf;
+  op_conf.set_name(name);
+  op_conf.mutable_input_conf();
+  return op_conf;
+}
+
+OperatorConf NewReturnOpConf(const std::string& name) {
+  OperatorConf op_conf;
+  op_conf.set_name(name);
+  op_conf.mutable_return_conf();
+  return op_conf;
+}
+
+// a task on thread 0 of machine 0 with a sole exec node of op_conf, producing the regst "out" with
+// the task id as regst desc id and consuming the regst of in_task_id, if any
+TaskProto* AddTask(Plan* plan, int64_t task_id, const OperatorConf& op_conf, int64_t in_task_id) {
+  TaskProto* task = plan->add_task();
+  task->set_task_type(TaskType::kNormalForward);
+  task->set_machine_id(0);
+  task->set_thrd_id(0);
+  task->set_task_id(task_id);
+  task->set_job_id(0);
+  KernelConf* kernel_conf = task->mutable_exec_sequence()->add_exec_node()->mutable_kernel_conf();
+  *kernel_conf->mutable_op_attribute()->mutable_op_conf() = op_conf;
+  RegstDescProto* regst_desc = &(*task->mutable_produced_regst_desc())["out"];
+  regst_desc->set_regst_desc_id(task_id);
+  regst_desc->set_producer_task_id(task_id);
+  DataRegstDesc* data_regst_desc = regst_desc->mutable_regst_desc_type()->mutable_data_regst_desc();
+  data_regst_desc->mutable_time_shape()->add_dim(1);
+  if (in_task_id != -1) {
+    (*task->mutable_consumed_regst_desc_id())["in"].add_regst_desc_id(in_task_id);
+    for (TaskProto& in_task : *plan->mutable_task()) {
+      if (in_task.task_id() != in_task_id) { continue; }
+      in_task.mutable_produced_regst_desc()->at("out").add_consumer_task_id(task_id);
+    }
+  }
+  return task;
+}
+
+const TaskProto* FindTask(const Plan& plan, int64_t task_id) {
+  for (const TaskProto& task : plan.task()) {
+    if (task.task_id() == task_id) { return &task; }
+  }
+  return nullptr;
+}
+
+void FuseLinearChains(Plan* plan) {
+  Global<ResourceDesc, ForSession>::New(Resource());
+  JobConfigProto job_conf;
+  job_conf.set_job_name("actor_fusion_test");
+  job_conf.mutable_predict_conf();
+  {
+    GlobalJobDescScope scope(job_conf, 0);
+    ActorFusionUtil::FuseLinearChains(plan);
+  }
+  Global<ResourceDesc, ForSession>::Delete();
+}
+
+}  // namespace
+
+TEST(ActorFusionUtil, fuse_chain_between_interface_ops) {
+  Plan plan;
+  AddTask(&plan, 1, NewInputOpConf("input"), -1);
+  AddTask(&plan, 2, ReluOpConf("relu0"), 1);
+  AddTask(&plan, 3, ReluOpConf("relu1"), 2);
+  AddTask(&plan, 4, ReluOpConf("relu2"), 3);
+  AddTask(&plan, 5, NewReturnOpConf("return"), 4);
+  FuseLinearChains(&plan);
+
+  ASSERT_EQ(plan.task_size(), 3);
+  // the interface ops are still found through the sole exec node of their task
+  const TaskProto* input = FindTask(plan, 1);
+  ASSERT_NE(input, nullptr);
+  ASSERT_EQ(input->exec_sequence().exec_node_size(), 1);
+  const TaskProto* ret = FindTask(plan, 5);
+  ASSERT_NE(ret, nullptr);
+  ASSERT_EQ(ret->exec_sequence().exec_node_size(), 1);
+
+  const TaskProto* fused = FindTask(plan, 2);
+  ASSERT_NE(fused, nullptr);
+  ASSERT_EQ(fused->exec_sequence().exec_node_size(), 3);
+  ASSERT_EQ(fused->exec_sequence().exec_node(2).kernel_conf().op_attribute().op_conf().name(),
+            "relu2");
+  ASSERT_EQ(input->produced_regst_desc().at("out").consumer_task_id_size(), 1);
+  ASSERT_EQ(input->produced_regst_desc().at("out").consumer_task_id(0), 2);
+  // the regst of the last fused kernel is sent to the return op, the inner ones are not sent
+  int64_t sent_regst_desc_id = -1;
+  for (const auto& pair : fused->produced_regst_desc()) {
+    if (pair.second.consumer_task_id_size() == 0) { continue; }
+    ASSERT_EQ(sent_regst_desc_id, -1);
+    ASSERT_EQ(pair.second.consumer_task_id(0), 5);
+    sent_regst_desc_id = pair.second.regst_desc_id();
+  }
+  ASSERT_EQ(sent_regst_desc_id, 4);
+  ASSERT_EQ(ret->consumed_regst_desc_id().at("in").regst_desc_id(0), 4);
+}
+
+TEST(ActorFusionUtil, keep_tasks_of_other_threads) {
+  Plan plan;
+  AddTask(&plan, 1, ReluOpConf("relu0"), -1);
+  AddTask(&plan, 2, ReluOpConf("relu1"), 1)->set_thrd_id(1);
+  FuseLinearChains(&plan);
+  ASSERT_EQ(plan.task_size(), 2);
+}
+
+}  // namespace oneflow
@@ -15,6 +15,7 @@ limitations under the License.
 */
 #include "oneflow/core/job/compiler.h"
 #include "oneflow/core/job/global_for.h"
+#include "oneflow/core/job/actor_fusion_util.h"
 #include "oneflow/core/persistence/tee_persistent_log_stream.h"
 #include "oneflow/core/graph/op_graph.h"
 #include "oneflow/core/job_rewriter/job_completer.h"
@@ -64,36 +65,62 @@ void Compiler::GenNetTopo(Plan* plan) const {
 
 void Compiler::Compile(Job* job, Plan* plan, bool need_job_complete) const {
   const JobDesc& job_desc = GlobalJobDesc();
-  if (need_job_complete) { JobCompleter().Complete(job); }
+  double phase_start = GetCurTime();
+  auto LogPhaseTime = [&](const std::string& phase) {
+    const double now = GetCurTime();
+    LOG(INFO) << "compile job " << job_desc.job_name() << ", " << phase << ": "
+              << (now - phase_start) / 1e6 << " ms";
+    phase_start = now;
+  };
+  if (need_job_complete) {
+    JobCompleter().Complete(job);
+    LogPhaseTime("complete job");
+  }
   Global<OpGraph>::New(*job);
   if (Global<ResourceDesc, ForSession>::Get()->enable_debug_mode()) {
     TeePersistentLogStream::Create(StrCat("optimized_job", job_desc.job_id()))->Write(*job);
     Global<OpGraph>::Get()->ToDotWithFilePath("optimized_dlnet_" + std::to_string(job_desc.job_id())
                                               + "_op_graph.dot");
   }
+  LogPhaseTime("build op graph");
   auto logical_gph = std::make_unique<LogicalGraph>(*job);
   auto task_gph = std::make_unique<TaskGraph>(std::move(logical_gph));
+  LogPhaseTime("build task graph");
   using std::placeholders::_1;
+  // allocates the regst desc ids, kept serial for deterministic plans
   task_gph->ForEachNode(std::bind(&TaskNode::ProduceAllRegstsAndBindEdges, _1));
   task_gph->ForEachNode(std::bind(&TaskNode::ConsumeAllRegsts, _1));
   task_gph->ForEachNode(std::bind(&TaskNode::PinConsumedRegst, _1));
-  task_gph->TopoForEachNode(&TaskNode::Build);
+  LogPhaseTime("produce and consume regsts");
+  // Build runs concurrently on the nodes of a level. It may only write the exec graph and the
+  // produced regsts of its own node and read the regsts its in nodes have locked. Besides, it may
+  // call NewNodeId and NewEdgeId for exec nodes and the thread safe IDMgr counters, which do not
+  // show up in the plan. Anything else shared, e.g. Global<OpGraph>, is only read.
+  task_gph->ParallelTopoForEachNode(&TaskNode::Build);
+  LogPhaseTime("build task nodes");
   task_gph->RemoveEmptyRegsts();
   task_gph->AddOrderingCtrlEdgeInSameChain();
   if (job_desc.enable_inplace()) {
     auto IsReachable = Global<OpGraph>::Get()->MakePredicatorIsOpNameDataOrCtrlReachable();
     task_gph->EnableInplaceMemSharing(IsReachable);
   }
-  task_gph->TopoForEachNode(&TaskNode::InferTimeShapeIfMeaningful);
+  LogPhaseTime("add ctrl edges and inplace");
+  task_gph->ParallelTopoForEachNode(&TaskNode::InferTimeShapeIfMeaningful);
+  LogPhaseTime("infer time shapes");
 
   task_gph->ForEachNode([&](TaskNode* task_node) {
     if (task_node->IsMeaningLess()) { return; }
     task_node->ToProto(plan->mutable_task()->Add());
   });
+  if (job_desc.enable_actor_fusion()) {
+    ActorFusionUtil::FuseLinearChains(plan);
+    LogPhaseTime("fuse actors");
+  }
   {
     auto* job_id2job_conf = plan->mutable_job_confs()->mutable_job_id2job_conf();
     (*job_id2job_conf)[GlobalJobDesc().job_id()] = GlobalJobDesc().job_conf();
   }
+  LogPhaseTime("to proto");
   Global<OpGraph>::Delete();
 }
 
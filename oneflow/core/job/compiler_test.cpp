@@ -0,0 +1,134 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/job/compiler.h"
+#include "oneflow/core/job/id_manager.h"
+#include "oneflow/core/job/job_builder.h"
+#include "oneflow/core/job/global_for.h"
+#include "oneflow/core/framework/user_op_conf.h"
+#include "oneflow/core/thread/thread_pool.h"
+
+namespace oneflow {
+
+namespace {
+
+constexpr int64_t kCpuDeviceNum = 16;
+
+void New() {
+  EnvProto env_proto;
+  env_proto.add_machine()->set_id(0);
+  env_proto.set_ctrl_port(9527);
+  Global<EnvDesc>::New(env_proto);
+  Resource resource;
+  resource.set_machine_num(1);
+  resource.set_cpu_device_num(kCpuDeviceNum);
+  Global<ResourceDesc, ForSession>::New(resource);
+  JobConfigProto job_conf;
+  job_conf.set_job_name("compiler_test");
+  job_conf.mutable_predict_conf();
+  Global<JobDesc>::New(job_conf, 0);
+}
+
+void Delete() {
+  Global<JobDesc>::Delete();
+  Global<ResourceDesc, ForSession>::Delete();
+  Global<EnvDesc>::Delete();
+}
+
+OperatorConf CpuUserOpConf(const user_op::UserOpConfWrapper& wrapper) {
+  OperatorConf op_conf = wrapper.op_conf();
+  op_conf.set_device_tag("cpu");
+  return op_conf;
+}
+
+// a constant feeds two element-wise branches on all cpus, their sum is gathered onto one cpu
+Job GenJob() {
+  Job job;
+  *job.mutable_job_conf() = GlobalJobDesc().job_conf();
+  JobBuilder job_builder(&job);
+  const auto constant_op = user_op::UserOpConfWrapperBuilder("constant")
+                               .Op("constant")
+                               .Attr<double>("floating_value", 1.0)
+                               .Attr<int64_t>("integer_value", 0)
+                               .Attr<bool>("is_floating_value", true)
+                               .Attr<DataType>("dtype", DataType::kFloat)
+                               .Attr<Shape>("shape", Shape({64, 32}))
+                               .Output("out")
+                               .Build();
+  const auto relu_op = user_op::UserOpConfWrapperBuilder("relu")
+                           .Op("relu")
+                           .Input("in", constant_op.output("out", 0))
+                           .Output("out")
+                           .Build();
+  const auto sigmoid_op = user_op::UserOpConfWrapperBuilder("sigmoid")
+                              .Op("sigmoid")
+                              .Input("in", constant_op.output("out", 0))
+                              .Output("out")
+                              .Build();
+  const auto add_n_op = user_op::UserOpConfWrapperBuilder("add_n")
+                            .Op("add_n")
+                            .Input("in", relu_op.output("out", 0))
+                            .Input("in", sigmoid_op.output("out", 0))
+                            .Output("out")
+                            .Build();
+  const auto gather_op = user_op::UserOpConfWrapperBuilder("gather")
+                             .Op("relu")
+                             .Input("in", add_n_op.output("out", 0))
+                             .Output("out")
+                             .Build();
+  ParallelConf all_cpus;
+  all_cpus.set_device_tag("cpu");
+  all_cpus.add_device_name("0:0-" + std::to_string(kCpuDeviceNum - 1));
+  job_builder.AddOps(all_cpus, {CpuUserOpConf(constant_op), CpuUserOpConf(relu_op),
+                                CpuUserOpConf(sigmoid_op), CpuUserOpConf(add_n_op)});
+  ParallelConf one_cpu;
+  one_cpu.set_device_tag("cpu");
+  one_cpu.add_device_name("0:0");
+  job_builder.AddOps(one_cpu, {CpuUserOpConf(gather_op)});
+  return job;
+}
+
+// ids are allocated from a fresh IDMgr, so that the plans of the same job are comparable
+Plan CompileWithNewIDMgr(const Job& job) {
+  Global<IDMgr>::New();
+  Job mut_job(job);
+  Plan plan;
+  Compiler().Compile(&mut_job, &plan, false);
+  Global<IDMgr>::Delete();
+  return plan;
+}
+
+}  // namespace
+
+TEST(Compiler, parallel_build_is_same_as_serial_build) {
+  New();
+  const Job job = GenJob();
+  // without a ThreadPool the task nodes are built one by one
+  const Plan serial_plan = CompileWithNewIDMgr(job);
+  Global<ThreadPool>::New(4);
+  const Plan parallel_plan = CompileWithNewIDMgr(job);
+  Global<ThreadPool>::Delete();
+  ASSERT_EQ(serial_plan.task_size(), parallel_plan.task_size());
+  // the ops on all cpus put one task per cpu in each level, so the levels are built concurrently
+  ASSERT_GE(serial_plan.task_size(), 4 * kCpuDeviceNum);
+  FOR_RANGE(int64_t, i, 0, serial_plan.task_size()) {
+    ASSERT_TRUE(PbMd::Equals(serial_plan.task(i), parallel_plan.task(i)))
+        << "task " << serial_plan.task(i).task_id() << " differs";
+  }
+  ASSERT_TRUE(PbMd::Equals(serial_plan, parallel_plan));
+  Delete();
+}
+
+}  // namespace oneflow
@@ -44,6 +44,7 @@ void IDMgr::UpdateBaseIndependentThrdId(int64_t val) {
 }
 
 int64_t IDMgr::NewTaskId(int64_t machine_id, int64_t thrd_id, int64_t local_work_stream_id) {
+  std::unique_lock<std::mutex> lock(mutex_);
   int64_t machine_thrd_id = GetMachineThrdId(machine_id, thrd_id);
   CHECK_LT(machine_thrd_id2num_of_tasks_[machine_thrd_id],
            (static_cast<int64_t>(1) << task_id_bit_num_) - 1);
@@ -81,6 +82,7 @@ int64_t IDMgr::ThrdId4ActorId(int64_t actor_id) const {
 }
 
 int64_t IDMgr::AllocateLocalWorkStreamId(int64_t machine_id, int64_t thrd_id) {
+  std::unique_lock<std::mutex> lock(mutex_);
   return 100 + (machine_thrd_id2stream_id_cnt_[GetMachineThrdId(machine_id, thrd_id)]++);
 }
 
@@ -108,12 +110,14 @@ int64_t IDMgr::LocalWorkStreamId4ActorId(int64_t actor_id) const {
 }
 
 int64_t IDMgr::AllocateChainId(int64_t global_work_stream_id) {
+  std::unique_lock<std::mutex> lock(mutex_);
   CHECK_LT(stream_id2chain_cnt_[global_work_stream_id],
            (static_cast<int64_t>(1) << task_id_bit_num_) - 1);
   return global_work_stream_id | (stream_id2chain_cnt_[global_work_stream_id]++);
 }
 
 int64_t IDMgr::PickCpuThrdIdEvenly(int64_t machine_id) {
+  std::unique_lock<std::mutex> lock(mutex_);
   return GetCpuDeviceThrdId(machine_id2num_cpu_thrd_id_picked_[machine_id]++ % cpu_device_num_);
 }
 
@@ -42,6 +42,8 @@ class IDMgr final {
   void UpdateBaseIndependentThrdId(int64_t val);
 
   int64_t NewTaskId(int64_t machine_id, int64_t thrd_id, int64_t local_work_stream_id);
+  // The New*Id and Allocate* functions are thread safe, the ids are only deterministic if they are
+  // allocated in a deterministic order though.
   int64_t NewRegstDescId() { return regst_desc_id_count_++; }
   int64_t NewMemBlockId() { return mem_block_id_count_++; }
   int64_t NewChunkId() { return chunk_id_count_++; }
@@ -92,9 +94,10 @@ class IDMgr final {
 
   int64_t gpu_device_num_;
   int64_t cpu_device_num_;
-  int64_t regst_desc_id_count_;
-  int64_t mem_block_id_count_;
-  int64_t chunk_id_count_;
+  std::atomic<int64_t> regst_desc_id_count_;
+  std::atomic<int64_t> mem_block_id_count_;
+  std::atomic<int64_t> chunk_id_count_;
+  std::mutex mutex_;
   HashMap<int64_t, int64_t> machine_thrd_id2num_of_tasks_;
   HashMap<int64_t, int64_t> machine_thrd_id2stream_id_cnt_;
   HashMap<int64_t, int64_t> stream_id2chain_cnt_;
@@ -23,6 +23,7 @@ limitations under the License.
 #include "oneflow/core/job/resource_desc.h"
 #include "oneflow/core/job/global_for.h"
 #include "oneflow/core/job/profiler.h"
+#include "oneflow/core/job/sbp_cost_model.h"
 #include "oneflow/core/job/global_for.h"
 #include "oneflow/core/job/parallel_desc.h"
 #include "oneflow/core/graph/plan_task_graph.h"
@@ -273,19 +274,13 @@ std::function<void(int64_t, uint64_t)> MakeSetterSetPlanRegstNum(Plan* plan) {
   };
 }
 
-std::function<const HashMap<int64_t, double>&(int64_t)> MakeGetterPathDurations4RegstDescId(
-    const ChainActGraph& graph) {
-  auto regst_desc_id2consumer_id2duration =
-      std::make_shared<HashMap<int64_t, HashMap<int64_t, double>>>();
-  graph.ForEachRegstDescConsumerPathMeanDuration(
-      [&](int64_t regst_desc_id, int64_t consumer_actor_id, double time) {
-        (*regst_desc_id2consumer_id2duration)[regst_desc_id][consumer_actor_id] = time;
-      });
+std::function<const HashMap<int64_t, double>&(int64_t)> MakeGetterConsumerId2Val4RegstDescId(
+    const std::shared_ptr<const RegstDescId2ConsumerId2Val>& regst_desc_id2consumer_id2val) {
   auto empty = std::make_shared<const HashMap<int64_t, double>>();
-  return [regst_desc_id2consumer_id2duration,
+  return [regst_desc_id2consumer_id2val,
           empty](int64_t regst_desc_id) -> const HashMap<int64_t, double>& {
-    const auto& it = regst_desc_id2consumer_id2duration->find(regst_desc_id);
-    if (it == regst_desc_id2consumer_id2duration->end()) {
+    const auto& it = regst_desc_id2consumer_id2val->find(regst_desc_id);
+    if (it == regst_desc_id2consumer_id2val->end()) {
       return *empty;
     } else {
       return it->second;
@@ -293,24 +288,24 @@ std::function<const HashMap<int64_t, double>&(int64_t)> MakeGetterPathDurations4
   };
 }
 
+std::function<const HashMap<int64_t, double>&(int64_t)> MakeGetterPathDurations4RegstDescId(
+    const ChainActGraph& graph) {
+  auto regst_desc_id2consumer_id2duration = std::make_shared<RegstDescId2ConsumerId2Val>();
+  graph.ForEachRegstDescConsumerPathMeanDuration(
+      [&](int64_t regst_desc_id, int64_t consumer_actor_id, double time) {
+        (*regst_desc_id2consumer_id2duration)[regst_desc_id][consumer_actor_id] = time;
+      });
+  return MakeGetterConsumerId2Val4RegstDescId(regst_desc_id2consumer_id2duration);
+}
+
 std::function<const HashMap<int64_t, double>&(int64_t)> MakeGetterPathIIScales4RegstDescId(
     const ChainActGraph& graph) {
-  auto regst_desc_id2consumer_id2ii_scale =
-      std::make_shared<HashMap<int64_t, HashMap<int64_t, double>>>();
+  auto regst_desc_id2consumer_id2ii_scale = std::make_shared<RegstDescId2ConsumerId2Val>();
   graph.ForEachRegstDescConsumerPathIIScale(
       [&](int64_t regst_desc_id, int64_t consumer_actor_id, double ii_scale) {
         (*regst_desc_id2consumer_id2ii_scale)[regst_desc_id][consumer_actor_id] = ii_scale;
       });
-  auto empty = std::make_shared<const HashMap<int64_t, double>>();
-  return [regst_desc_id2consumer_id2ii_scale,
-          empty](int64_t regst_desc_id) -> const HashMap<int64_t, double>& {
-    const auto& it = regst_desc_id2consumer_id2ii_scale->find(regst_desc_id);
-    if (it == regst_desc_id2consumer_id2ii_scale->end()) {
-      return *empty;
-    } else {
-      return it->second;
-    }
-  };
+  return MakeGetterConsumerId2Val4RegstDescId(regst_desc_id2consumer_id2ii_scale);
 }
 
 void TryConnectWithMemSafeGuardCtrlRegstDesc(TaskProto* src_task_proto, TaskProto* dst_task_proto) {
@@ -524,6 +519,104 @@ void GenMemBlockAndChunk4Plan(Plan* plan) {
 
 }  // namespace
 
+// The analytic counterpart of the statistics ChainActGraph takes from act events. One piece is
+// scheduled as soon as the inputs of each task are ready, a regst is held from the start of its
+// producer to the end of each consumer. Times are in nanoseconds like those of act events.
+double EstimatePipeline(const Plan& plan, const HashMap<int64_t, double>& task_id2act_time,
+                        RegstDescId2ConsumerId2Val* regst_desc_id2consumer_id2duration,
+                        RegstDescId2ConsumerId2Val* regst_desc_id2consumer_id2ii_scale) {
+  HashMap<int64_t, const TaskProto*> task_id2task;
+  HashMap<int64_t, int64_t> regst_desc_id2producer_task_id;
+  // acts per piece, the elem cnt of the time shape
+  HashMap<int64_t, int64_t> regst_desc_id2act_cnt;
+  HashMap<int64_t, int64_t> task_id2act_cnt;
+  int64_t max_act_cnt = 1;
+  for (const TaskProto& task : plan.task()) {
+    task_id2task[task.task_id()] = &task;
+    int64_t task_act_cnt = 1;
+    for (const auto& pair : task.produced_regst_desc()) {
+      regst_desc_id2producer_task_id[pair.second.regst_desc_id()] = task.task_id();
+      if (!pair.second.regst_desc_type().has_data_regst_desc()) { continue; }
+      const auto& data_regst_desc = pair.second.regst_desc_type().data_regst_desc();
+      if (!data_regst_desc.has_time_shape()) { continue; }
+      const int64_t act_cnt = Shape(data_regst_desc.time_shape()).elem_cnt();
+      regst_desc_id2act_cnt[pair.second.regst_desc_id()] = act_cnt;
+      task_act_cnt = std::max(task_act_cnt, act_cnt);
+    }
+    task_id2act_cnt[task.task_id()] = task_act_cnt;
+    max_act_cnt = std::max(max_act_cnt, task_act_cnt);
+  }
+  auto Duration4TaskId = [&](int64_t task_id) { return task_id2act_time.at(task_id) * 1e9; };
+  auto ForEachProducerTaskId = [&](const TaskProto& task,
+                                   const std::function<void(int64_t)>& Handler) {
+    for (const auto& pair : task.consumed_regst_desc_id()) {
+      for (int64_t regst_desc_id : pair.second.regst_desc_id()) {
+        const auto& iter = regst_desc_id2producer_task_id.find(regst_desc_id);
+        if (iter != regst_desc_id2producer_task_id.end()) { Handler(iter->second); }
+      }
+    }
+  };
+
+  HashMap<int64_t, int64_t> task_id2in_cnt;
+  HashMap<int64_t, std::vector<int64_t>> task_id2consumer_task_ids;
+  for (const TaskProto& task : plan.task()) {
+    ForEachProducerTaskId(task, [&](int64_t producer_task_id) {
+      task_id2in_cnt[task.task_id()] += 1;
+      task_id2consumer_task_ids[producer_task_id].push_back(task.task_id());
+    });
+  }
+  std::list<int64_t> ready_task_ids;
+  for (const TaskProto& task : plan.task()) {
+    if (task_id2in_cnt[task.task_id()] == 0) { ready_task_ids.push_back(task.task_id()); }
+  }
+  // the tasks of cycles, if any, start at 0
+  HashMap<int64_t, double> task_id2start_time;
+  while (!ready_task_ids.empty()) {
+    const int64_t task_id = ready_task_ids.front();
+    ready_task_ids.pop_front();
+    const double finish_time = task_id2start_time[task_id] + Duration4TaskId(task_id);
+    for (int64_t consumer_task_id : task_id2consumer_task_ids[task_id]) {
+      double* start_time = &task_id2start_time[consumer_task_id];
+      *start_time = std::max(*start_time, finish_time);
+      int64_t* in_cnt = &task_id2in_cnt.at(consumer_task_id);
+      *in_cnt -= 1;
+      if (*in_cnt == 0) { ready_task_ids.push_back(consumer_task_id); }
+    }
+  }
+
+  for (const TaskProto& task : plan.task()) {
+    const int64_t task_id = task.task_id();
+    for (const auto& pair : task.produced_regst_desc()) {
+      const int64_t regst_desc_id = pair.second.regst_desc_id();
+      const auto& act_cnt_iter = regst_desc_id2act_cnt.find(regst_desc_id);
+      const int64_t act_cnt = act_cnt_iter == regst_desc_id2act_cnt.end()
+                                  ? task_id2act_cnt.at(task_id)
+                                  : act_cnt_iter->second;
+      for (int64_t consumer_task_id : pair.second.consumer_task_id()) {
+        if (task_id2task.find(consumer_task_id) == task_id2task.end()) { continue; }
+        const double duration = task_id2start_time[consumer_task_id]
+                                + Duration4TaskId(consumer_task_id) - task_id2start_time[task_id];
+        (*regst_desc_id2consumer_id2duration)[regst_desc_id][consumer_task_id] =
+            std::max(duration, Duration4TaskId(task_id) + Duration4TaskId(consumer_task_id));
+        (*regst_desc_id2consumer_id2ii_scale)[regst_desc_id][consumer_task_id] =
+            1.0 * max_act_cnt / act_cnt;
+      }
+    }
+  }
+
+  HashMap<int64_t, double> stream_id2total_calc_time;
+  for (const TaskProto& task : plan.task()) {
+    const int64_t stream_id = Global<IDMgr>::Get()->GlobalWorkStreamId4TaskId(task.task_id());
+    stream_id2total_calc_time[stream_id] +=
+        Duration4TaskId(task.task_id()) * task_id2act_cnt.at(task.task_id());
+  }
+  double base_ii = 0;
+  for (const auto& pair : stream_id2total_calc_time) {
+    base_ii = std::max(base_ii, pair.second / max_act_cnt);
+  }
+  return base_ii;
+}
+
 uint64_t Improver::AvailableMemSize(int64_t machine_id, int64_t memory_zone_id) const {
   int64_t mem_size = amd_.machine_amd(machine_id).zone_size(memory_zone_id);
   const ResourceDesc* resource_desc = Global<ResourceDesc, ForSession>::Get();
@@ -561,13 +654,14 @@ Maybe<void> Improver::CheckAllZoneNotOOM(
     const MemZoneRegstDescs& mz_regst_descs,
     const std::function<const HashMap<int64_t, double>&(int64_t)>& PathDurations4RegstDescId,
     const std::function<const HashMap<int64_t, double>&(int64_t)>& PathIIScales4RegstDescId,
-    double ii) const {
+    double ii, double mem_ratio) const {
   FOR_RANGE(int64_t, machine_id, 0, mz_regst_descs.size()) {
     FOR_RANGE(int64_t, mem_zone_id, 0, mz_regst_descs[machine_id].size()) {
       const auto& regst_descs = mz_regst_descs[machine_id][mem_zone_id];
       const uint64_t calc =
           CalcMemoryConsumed(regst_descs, PathDurations4RegstDescId, PathIIScales4RegstDescId, ii);
-      const uint64_t available = AvailableMemSize(machine_id, mem_zone_id);
+      const uint64_t available =
+          static_cast<uint64_t>(AvailableMemSize(machine_id, mem_zone_id) * mem_ratio);
       if (calc >= available) {
         const auto* id_mgr = Global<IDMgr>::Get();
         const char* device_tag = JUST(DeviceTag4DeviceType(
@@ -604,7 +698,8 @@ Maybe<double> Improver::BinarySearchII(
     const MemZoneRegstDescs& mz_regst_descs) const {
   double max_duration = CalcMaxRegstDescDuration(PathDurations4RegstDescId, mz_regst_descs);
   JUST(CheckAllZoneNotOOM(mz_regst_descs, PathDurations4RegstDescId, PathIIScales4RegstDescId,
-                          max_duration));
+                          max_duration, 1));
+  // an ii the budget does not fit falls back to max_duration, which fits all the memory
   const double ii_search_threshold = 1;
   double r = max_duration;
   double l = base_ii;
@@ -612,7 +707,8 @@ Maybe<double> Improver::BinarySearchII(
   while ((r - l) > ii_search_threshold) {
     mid = (l + r) / 2;
     const auto& oom_status = TRY(CheckAllZoneNotOOM(mz_regst_descs, PathDurations4RegstDescId,
-                                                    PathIIScales4RegstDescId, mid));
+                                                    PathIIScales4RegstDescId, mid,
+                                                    mem_budget_ratio_));
 
     if (oom_status.IsOk()) {
       r = mid;
@@ -695,7 +791,7 @@ Maybe<Plan> Improver::GenAndInferMemBlockIdOnly(const AvailableMemDesc& amd,
   MakeMemZoneRegstDescs(complete_plan, &mz_regst_descs);
   HashMap<int64_t, double> zero2one{{0, 1}};
   auto Zero2One = [&](int64_t) -> const HashMap<int64_t, double>& { return zero2one; };
-  JUST(CheckAllZoneNotOOM(mz_regst_descs, Zero2One, Zero2One, 1));
+  JUST(CheckAllZoneNotOOM(mz_regst_descs, Zero2One, Zero2One, 1, 1));
   SetUniqueMemBlockId4UnreusedMemRegst(&complete_plan);
   GenMemBlockAndChunk4Plan(&complete_plan);
   return complete_plan;
@@ -707,14 +803,40 @@ Maybe<Plan> Improver::Improve(const AvailableMemDesc& amd, const Plan& naive_pla
   std::list<std::unique_ptr<ActEvent>> act_events;
   ParseActEvents(act_event_filepath, &act_events);
   ChainActGraph chain_act_graph(naive_plan, std::move(act_events));
+  return ImproveRegstNum(naive_plan, MakeGetterPathDurations4RegstDescId(chain_act_graph),
+                         MakeGetterPathIIScales4RegstDescId(chain_act_graph),
+                         chain_act_graph.CalcBaseII());
+}
 
-  auto PathDurations4RegstDescId = MakeGetterPathDurations4RegstDescId(chain_act_graph);
-  auto PathIIScales4RegstDescId = MakeGetterPathIIScales4RegstDescId(chain_act_graph);
-  double base_ii = chain_act_graph.CalcBaseII();
-
+Maybe<Plan> Improver::ImproveAnalytically(const AvailableMemDesc& amd, const Plan& naive_plan,
+                                          const SbpCostModelConf& cost_model_conf,
+                                          double mem_budget_ratio) {
+  CHECK_GT(mem_budget_ratio, 0);
+  CHECK_LE(mem_budget_ratio, 1);
+  Init(amd, naive_plan);
+  mem_budget_ratio_ = mem_budget_ratio;
+  HashMap<int64_t, double> task_id2act_time;
+  EstimateActTime4Tasks(naive_plan, cost_model_conf, &task_id2act_time);
+  auto regst_desc_id2consumer_id2duration = std::make_shared<RegstDescId2ConsumerId2Val>();
+  auto regst_desc_id2consumer_id2ii_scale = std::make_shared<RegstDescId2ConsumerId2Val>();
+  const double base_ii =
+      EstimatePipeline(naive_plan, task_id2act_time, regst_desc_id2consumer_id2duration.get(),
+                       regst_desc_id2consumer_id2ii_scale.get());
+  return ImproveRegstNum(naive_plan,
+                         MakeGetterConsumerId2Val4RegstDescId(regst_desc_id2consumer_id2duration),
+                         MakeGetterConsumerId2Val4RegstDescId(regst_desc_id2consumer_id2ii_scale),
+                         base_ii);
+}
+
+Maybe<Plan> Improver::ImproveRegstNum(
+    const Plan& naive_plan,
+    const std::function<const HashMap<int64_t, double>&(int64_t)>& PathDurations4RegstDescId,
+    const std::function<const HashMap<int64_t, double>&(int64_t)>& PathIIScales4RegstDescId,
+    double base_ii) {
   Plan mem_unlimited_plan(naive_plan);
-  ForEachImprovedRegstNum(naive_plan, false, base_ii, PathDurations4RegstDescId,
-                          PathIIScales4RegstDescId, MakeSetterSetPlanRegstNum(&mem_unlimited_plan));
+  JUST(ForEachImprovedRegstNum(naive_plan, false, base_ii, PathDurations4RegstDescId,
+                               PathIIScales4RegstDescId,
+                               MakeSetterSetPlanRegstNum(&mem_unlimited_plan)));
   Plan complete_plan = GenAndInferMemBlockId(mem_unlimited_plan);
   Plan plan(complete_plan);
   JUST(ForEachImprovedRegstNum(complete_plan, true, base_ii, PathDurations4RegstDescId,
@@ -21,20 +21,31 @@ limitations under the License.
 #include "oneflow/core/memory/memory_case.pb.h"
 #include "oneflow/core/job/available_memory_desc.pb.h"
 #include "oneflow/core/graph/chain_act_graph.h"
+#include "oneflow/core/job/sbp_cost_model.pb.h"
 
 namespace oneflow {
 
 class Improver final {
  public:
   OF_DISALLOW_COPY_AND_MOVE(Improver);
-  Improver() : start_mem_block_id_(-1) {}
+  Improver() : start_mem_block_id_(-1), mem_budget_ratio_(1) {}
   ~Improver() = default;
 
   Maybe<Plan> Improve(const AvailableMemDesc& amd, const Plan& naive_plan,
                       const std::string& act_event_filepath);
+  // sizes the regst nums by act times estimated from the cost model instead of measured in an
+  // experiment run, buffering into at most mem_budget_ratio of the available memory of each zone
+  Maybe<Plan> ImproveAnalytically(const AvailableMemDesc& amd, const Plan& naive_plan,
+                                  const SbpCostModelConf& cost_model_conf,
+                                  double mem_budget_ratio);
   Maybe<Plan> GenAndInferMemBlockIdOnly(const AvailableMemDesc& amd, const Plan& naive_plan);
 
  private:
+  Maybe<Plan> ImproveRegstNum(
+      const Plan& naive_plan,
+      const std::function<const HashMap<int64_t, double>&(int64_t)>& PathDurations4RegstDescId,
+      const std::function<const HashMap<int64_t, double>&(int64_t)>& PathIIScales4RegstDescId,
+      double base_ii);
   Plan GenAndInferMemBlockId(const Plan& naive_plan) const;
   void Init(const AvailableMemDesc& amd, const Plan& naive_plan);
   Maybe<void> ForEachImprovedRegstNum(
@@ -52,7 +63,7 @@ class Improver final {
       const MemZoneRegstDescs& mz_regst_descs,
       const std::function<const HashMap<int64_t, double>&(int64_t)>& Duration4RegstDescId,
       const std::function<const HashMap<int64_t, double>&(int64_t)>& Ratio4RegstDescId,
-      double ii) const;
+      double ii, double mem_ratio) const;
   Maybe<double> BinarySearchII(
       double base_ii,
       const std::function<const HashMap<int64_t, double>&(int64_t)>& Duration4RegstDescId,
@@ -66,9 +77,19 @@ class Improver final {
       const MemZoneRegstDescs& mz_regst_descs) const;
 
   int32_t start_mem_block_id_;
+  // the share of the available memory the ii search may fill
+  double mem_budget_ratio_;
   AvailableMemDesc amd_;
 };
 
+using RegstDescId2ConsumerId2Val = HashMap<int64_t, HashMap<int64_t, double>>;
+
+// The analytic counterpart of the statistics ChainActGraph takes from act events, for the act
+// times of the tasks in seconds. Returns the base ii.
+double EstimatePipeline(const Plan& plan, const HashMap<int64_t, double>& task_id2act_time,
+                        RegstDescId2ConsumerId2Val* regst_desc_id2consumer_id2duration,
+                        RegstDescId2ConsumerId2Val* regst_desc_id2consumer_id2ii_scale);
+
 }  // namespace oneflow
 
 #endif  // ONEFLOW_CORE_JOB_IMPROVER_H_
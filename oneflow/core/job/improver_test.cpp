@@ -0,0 +1,124 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/job/improver.h"
+#include "oneflow/core/job/id_manager.h"
+#include "oneflow/core/job/global_for.h"
+
+namespace oneflow {
+
+namespace {
+
+void New() {
+  EnvProto env_proto;
+  env_proto.add_machine()->set_id(0);
+  env_proto.set_ctrl_port(9527);
+  Global<EnvDesc>::New(env_proto);
+  Resource resource;
+  resource.set_machine_num(1);
+  resource.set_cpu_device_num(4);
+  Global<ResourceDesc, ForSession>::New(resource);
+  Global<IDMgr>::New();
+}
+
+void Delete() {
+  Global<IDMgr>::Delete();
+  Global<ResourceDesc, ForSession>::Delete();
+  Global<EnvDesc>::Delete();
+}
+
+// a task producing the regst "out" of act_cnt acts per piece, with the task id as regst desc id
+TaskProto* AddTask(Plan* plan, int64_t thrd_id, int64_t act_cnt) {
+  TaskProto* task = plan->add_task();
+  task->set_machine_id(0);
+  task->set_thrd_id(thrd_id);
+  task->set_task_id(Global<IDMgr>::Get()->NewTaskId(0, thrd_id, 0));
+  RegstDescProto* regst_desc = &(*task->mutable_produced_regst_desc())["out"];
+  regst_desc->set_regst_desc_id(task->task_id());
+  regst_desc->set_producer_task_id(task->task_id());
+  regst_desc->mutable_regst_desc_type()->mutable_data_regst_desc()->mutable_time_shape()->add_dim(
+      act_cnt);
+  return task;
+}
+
+void Connect(TaskProto* producer, TaskProto* consumer) {
+  producer->mutable_produced_regst_desc()->at("out").add_consumer_task_id(consumer->task_id());
+  (*consumer->mutable_consumed_regst_desc_id())["in"].add_regst_desc_id(producer->task_id());
+}
+
+}  // namespace
+
+TEST(Improver, estimate_pipeline_of_chain) {
+  New();
+  Plan plan;
+  // the second task acts 4 times per piece, the first and the last share a work stream
+  TaskProto* first = AddTask(&plan, 0, 1);
+  TaskProto* second = AddTask(&plan, 1, 4);
+  TaskProto* last = AddTask(&plan, 0, 4);
+  Connect(first, second);
+  Connect(second, last);
+  const HashMap<int64_t, double> task_id2act_time{
+      {first->task_id(), 1}, {second->task_id(), 2}, {last->task_id(), 3}};
+  RegstDescId2ConsumerId2Val regst_desc_id2consumer_id2duration;
+  RegstDescId2ConsumerId2Val regst_desc_id2consumer_id2ii_scale;
+  const double base_ii = EstimatePipeline(plan, task_id2act_time,
+                                          &regst_desc_id2consumer_id2duration,
+                                          &regst_desc_id2consumer_id2ii_scale);
+  // the shared stream is busy for 1 + 4 * 3 seconds per piece of 4 acts
+  ASSERT_DOUBLE_EQ(base_ii, 13e9 / 4);
+  ASSERT_EQ(regst_desc_id2consumer_id2duration.size(), 2);
+  // from the start of the producer to the end of the consumer
+  ASSERT_DOUBLE_EQ(regst_desc_id2consumer_id2duration.at(first->task_id()).at(second->task_id()),
+                   3e9);
+  ASSERT_DOUBLE_EQ(regst_desc_id2consumer_id2duration.at(second->task_id()).at(last->task_id()),
+                   5e9);
+  ASSERT_DOUBLE_EQ(regst_desc_id2consumer_id2ii_scale.at(first->task_id()).at(second->task_id()),
+                   4);
+  ASSERT_DOUBLE_EQ(regst_desc_id2consumer_id2ii_scale.at(second->task_id()).at(last->task_id()),
+                   1);
+  Delete();
+}
+
+TEST(Improver, estimate_pipeline_waits_for_slowest_input) {
+  New();
+  Plan plan;
+  TaskProto* source = AddTask(&plan, 0, 1);
+  TaskProto* fast = AddTask(&plan, 1, 1);
+  TaskProto* slow = AddTask(&plan, 2, 1);
+  TaskProto* sink = AddTask(&plan, 3, 1);
+  Connect(source, fast);
+  Connect(source, slow);
+  Connect(fast, sink);
+  Connect(slow, sink);
+  // a consumer out of the plan is ignored
+  source->mutable_produced_regst_desc()->at("out").add_consumer_task_id(-1);
+  const HashMap<int64_t, double> task_id2act_time{
+      {source->task_id(), 1}, {fast->task_id(), 1}, {slow->task_id(), 5}, {sink->task_id(), 1}};
+  RegstDescId2ConsumerId2Val regst_desc_id2consumer_id2duration;
+  RegstDescId2ConsumerId2Val regst_desc_id2consumer_id2ii_scale;
+  const double base_ii = EstimatePipeline(plan, task_id2act_time,
+                                          &regst_desc_id2consumer_id2duration,
+                                          &regst_desc_id2consumer_id2ii_scale);
+  ASSERT_DOUBLE_EQ(base_ii, 5e9);
+  ASSERT_EQ(regst_desc_id2consumer_id2duration.at(source->task_id()).size(), 2);
+  // the sink starts when the slow input is done, the regst of the fast one is held until then
+  ASSERT_DOUBLE_EQ(regst_desc_id2consumer_id2duration.at(fast->task_id()).at(sink->task_id()),
+                   6e9);
+  ASSERT_DOUBLE_EQ(regst_desc_id2consumer_id2duration.at(slow->task_id()).at(sink->task_id()),
+                   6e9);
+  Delete();
+}
+
+}  // namespace oneflow
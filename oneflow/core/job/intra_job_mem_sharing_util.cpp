@@ -20,6 +20,9 @@ limitations under the License.
 #include "oneflow/core/job/id_manager.h"
 #include "oneflow/core/register/runtime_register_desc.h"
 #include "oneflow/core/thread/thread_pool.h"
+#include "oneflow/core/persistence/tee_persistent_log_stream.h"
+#include <numeric>
+#include <random>
 
 namespace oneflow {
 
@@ -27,6 +30,7 @@ enum MemAllocAlgoType {
   kMemSizeFirstAlgo = 0,
   kMutualExclusionFirstAlgo = 1,
   kTimeLineAlgo = 2,
+  kBestFitSearchAlgo = 3,
 };
 
 }  // namespace oneflow
@@ -584,11 +588,50 @@ void MemReusedAlgorithm_TimeLineAlgo(
   result->mem_block_size = bfc_allocator.buffer_size();
 }
 
+void MemReusedAlgorithm_BestFitSearchAlgo(
+    const HashMap<RegstDescProto*, HashSet<RegstDescProto*>>& regst2mutual_exclusion_regsts,
+    int64_t lower_bound, int64_t budget, MemBlockResultInfo* result) {
+  std::vector<RegstDescProto*> regsts;
+  for (const auto& pair : regst2mutual_exclusion_regsts) { regsts.push_back(pair.first); }
+  std::sort(regsts.begin(), regsts.end(), [](RegstDescProto* lhs, RegstDescProto* rhs) {
+    return lhs->regst_desc_id() < rhs->regst_desc_id();
+  });
+  HashMap<RegstDescProto*, int64_t> regst2id;
+  for (int64_t i = 0; i < regsts.size(); ++i) { regst2id[regsts.at(i)] = i; }
+  std::vector<int64_t> sizes(regsts.size());
+  std::vector<std::vector<int64_t>> mutual_exclusions(regsts.size());
+  for (int64_t i = 0; i < regsts.size(); ++i) {
+    sizes.at(i) = RtRegstDesc(*regsts.at(i)).TotalMainByteSize4AllRegst();
+    for (RegstDescProto* mutual_regst : regst2mutual_exclusion_regsts.at(regsts.at(i))) {
+      mutual_exclusions.at(i).push_back(regst2id.at(mutual_regst));
+    }
+  }
+  std::vector<int64_t> offsets;
+  const int64_t buffer_size = IntraJobMemSharingUtil::BestFitSearch(sizes, mutual_exclusions,
+                                                                    lower_bound, budget, &offsets);
+  HashMap<RegstDescProto*, int64_t>* regst_desc2offset = &(result->regst_desc2offset);
+  for (int64_t i = 0; i < regsts.size(); ++i) {
+    CHECK(regst_desc2offset->emplace(regsts.at(i), offsets.at(i)).second);
+  }
+  result->mem_block_size = std::max<int64_t>(buffer_size, 1);
+}
+
+std::string MemAllocAlgoName(MemAllocAlgoType algo_id) {
+  switch (algo_id) {
+    case kMemSizeFirstAlgo: return "mem_size_first";
+    case kMutualExclusionFirstAlgo: return "mutual_exclusion_first";
+    case kTimeLineAlgo: return "time_line";
+    case kBestFitSearchAlgo: return "best_fit_search";
+    default: UNIMPLEMENTED();
+  }
+  return "";
+}
+
 void SelectAlgorithmGenMemBlockOffset4Regsts(
     MemAllocAlgoType algo_id, const std::vector<HashSet<RegstDescProto*>>& alloc_regsts_timeline,
     const std::vector<HashSet<RegstDescProto*>>& free_regsts_timeline,
     const HashMap<RegstDescProto*, HashSet<RegstDescProto*>>& regst2mutual_exclusion_regsts,
-    MemBlockResultInfo* result) {
+    int64_t lower_bound, int64_t best_fit_search_budget, MemBlockResultInfo* result) {
   CHECK_EQ(result->mem_block_size, 0);
   CHECK(result->regst_desc2offset.empty());
   switch (algo_id) {
@@ -601,6 +644,10 @@ void SelectAlgorithmGenMemBlockOffset4Regsts(
     case kTimeLineAlgo:
       MemReusedAlgorithm_TimeLineAlgo(alloc_regsts_timeline, free_regsts_timeline, result);
       break;
+    case kBestFitSearchAlgo:
+      MemReusedAlgorithm_BestFitSearchAlgo(regst2mutual_exclusion_regsts, lower_bound,
+                                           best_fit_search_budget, result);
+      break;
     default: UNIMPLEMENTED();
   }
   CHECK_GT(result->mem_block_size, 0);
@@ -614,6 +661,7 @@ int64_t CountMemAllocAlgoNum() {
   if (mem_alloc_algo_conf.use_mem_size_first_algo()) { ++ret; }
   if (mem_alloc_algo_conf.use_mutual_exclusion_first_algo()) { ++ret; }
   if (mem_alloc_algo_conf.use_time_line_algo()) { ++ret; }
+  if (mem_alloc_algo_conf.use_best_fit_search_algo()) { ++ret; }
   CHECK_GE(ret, 0);
   return ret;
 }
@@ -631,6 +679,9 @@ void InitAlgo2Result(HashMap<MemAllocAlgoType, MemBlockResultInfo>* algo2result)
   if (mem_alloc_algo_conf.use_time_line_algo()) {
     CHECK(algo2result->emplace(kTimeLineAlgo, MemBlockResultInfo()).second);
   }
+  if (mem_alloc_algo_conf.use_best_fit_search_algo()) {
+    CHECK(algo2result->emplace(kBestFitSearchAlgo, MemBlockResultInfo()).second);
+  }
 }
 
 }  // namespace
@@ -664,9 +715,27 @@ void IntraJobMemSharingUtil::InferMemBlockId4MemReusedRegst(Plan* plan,
         &mem_chain2consumer2inplaced_regst[pair.first]);
   }
 
+  HashMap<int64_t, int64_t> mem_chain2lower_bound;
+  auto Sizes4Timeline = [](const std::vector<HashSet<RegstDescProto*>>& regsts_timeline) {
+    std::vector<std::vector<int64_t>> sizes_timeline(regsts_timeline.size());
+    FOR_RANGE(int64_t, i, 0, regsts_timeline.size()) {
+      for (RegstDescProto* regst : regsts_timeline.at(i)) {
+        sizes_timeline.at(i).push_back(RtRegstDesc(*regst).TotalMainByteSize4AllRegst());
+      }
+    }
+    return sizes_timeline;
+  };
+  for (int64_t mem_chain_id : mem_chains) {
+    mem_chain2lower_bound[mem_chain_id] = IntraJobMemSharingUtil::MaxLiveBytes(
+        Sizes4Timeline(mem_chain2task2alloc_regsts.at(mem_chain_id)),
+        Sizes4Timeline(mem_chain2task2free_regsts.at(mem_chain_id)));
+  }
+
   // step 2: multi-thread run several algorithm for each mem chain
   HashMap<int64_t, HashMap<MemAllocAlgoType, MemBlockResultInfo>> mem_chain2algo2result;
   {
+    const int64_t best_fit_search_budget =
+        GlobalJobDesc().job_conf().memory_allocation_algorithm_conf().best_fit_search_budget();
     int64_t work_size = mem_chain2mem_reused_regsts.size() * CountMemAllocAlgoNum();
     int64_t thread_pool_size = std::min<int64_t>(work_size, std::thread::hardware_concurrency());
     BlockingCounter counter(work_size);
@@ -676,13 +745,15 @@ void IntraJobMemSharingUtil::InferMemBlockId4MemReusedRegst(Plan* plan,
       for (auto& pair : mem_chain2algo2result.at(mem_chain_id)) {
         MemAllocAlgoType algo_id = pair.first;
         MemBlockResultInfo* result = &pair.second;
+        const int64_t lower_bound = mem_chain2lower_bound.at(mem_chain_id);
         thread_pool.AddWork([algo_id, mem_chain_id, &mem_chain2task2alloc_regsts,
                              &mem_chain2task2free_regsts, &mem_chain2regst2mutual_exclusion_regsts,
-                             result, &counter]() {
+                             lower_bound, best_fit_search_budget, result, &counter]() {
           SelectAlgorithmGenMemBlockOffset4Regsts(
               algo_id, mem_chain2task2alloc_regsts.at(mem_chain_id),
               mem_chain2task2free_regsts.at(mem_chain_id),
-              mem_chain2regst2mutual_exclusion_regsts.at(mem_chain_id), result);
+              mem_chain2regst2mutual_exclusion_regsts.at(mem_chain_id), lower_bound,
+              best_fit_search_budget, result);
           counter.Decrease();
         });
       }
@@ -691,14 +762,26 @@ void IntraJobMemSharingUtil::InferMemBlockId4MemReusedRegst(Plan* plan,
   }
 
   // step 3: choose best one for each mem chain and set offset for inplace consumer regst
+  std::string report;
   for (const auto& pair : mem_chain2algo2result) {
     const MemBlockResultInfo* best_result = nullptr;
+    MemAllocAlgoType best_algo_id = kMemSizeFirstAlgo;
     for (const auto& algo_result_pair : pair.second) {
       if (!best_result || algo_result_pair.second.mem_block_size < best_result->mem_block_size) {
         best_result = &algo_result_pair.second;
+        best_algo_id = algo_result_pair.first;
       }
     }
     CHECK(best_result != nullptr);
+    const int64_t lower_bound = mem_chain2lower_bound.at(pair.first);
+    double gap = 0;
+    if (lower_bound > 0) {
+      gap = (static_cast<double>(best_result->mem_block_size) - lower_bound) * 100 / lower_bound;
+    }
+    report += "mem chain " + std::to_string(pair.first) + ": "
+              + MemAllocAlgoName(best_algo_id) + " " + std::to_string(best_result->mem_block_size)
+              + " bytes, lower bound " + std::to_string(lower_bound) + " bytes, gap "
+              + std::to_string(gap) + "%\n";
     int64_t mem_block_id = Global<IDMgr>::Get()->NewMemBlockId();
     CHECK_EQ(mem_chain2mem_reused_regsts.at(pair.first).size(),
              (best_result->regst_desc2offset.size()
@@ -720,6 +803,127 @@ void IntraJobMemSharingUtil::InferMemBlockId4MemReusedRegst(Plan* plan,
       consumer_regst_desc->set_mem_block_offset(inplaced_regst_desc->mem_block_offset());
     }
   }
+  if (Global<ResourceDesc, ForSession>::Get()->enable_debug_mode()) {
+    TeePersistentLogStream::Create("mem_sharing_report_" + GlobalJobDesc().job_name())
+        ->Write(report);
+  }
+}
+
+int64_t IntraJobMemSharingUtil::MaxLiveBytes(
+    const std::vector<std::vector<int64_t>>& alloc_sizes_timeline,
+    const std::vector<std::vector<int64_t>>& free_sizes_timeline) {
+  int64_t live_bytes = 0;
+  int64_t max_live_bytes = 0;
+  CHECK_EQ(alloc_sizes_timeline.size(), free_sizes_timeline.size());
+  for (int64_t i = 0; i < alloc_sizes_timeline.size(); ++i) {
+    for (int64_t size : alloc_sizes_timeline.at(i)) { live_bytes += size; }
+    max_live_bytes = std::max(max_live_bytes, live_bytes);
+    for (int64_t size : free_sizes_timeline.at(i)) { live_bytes -= size; }
+  }
+  CHECK_EQ(live_bytes, 0);
+  return max_live_bytes;
+}
+
+int64_t IntraJobMemSharingUtil::AllocateByOrderAndBestFit(
+    const std::vector<int64_t>& order, const std::vector<int64_t>& sizes,
+    const std::vector<std::vector<int64_t>>& mutual_exclusions, std::vector<int64_t>* offsets) {
+  offsets->assign(sizes.size(), -1);
+  int64_t buffer_size = 0;
+  std::vector<std::pair<int64_t, int64_t>> occupied;
+  for (int64_t id : order) {
+    const int64_t size = sizes.at(id);
+    occupied.clear();
+    for (int64_t mutual_id : mutual_exclusions.at(id)) {
+      const int64_t mutual_offset = offsets->at(mutual_id);
+      if (mutual_offset == -1) { continue; }
+      occupied.emplace_back(mutual_offset, mutual_offset + sizes.at(mutual_id));
+    }
+    std::sort(occupied.begin(), occupied.end());
+    int64_t best_offset = -1;
+    int64_t best_gap = std::numeric_limits<int64_t>::max();
+    int64_t end = 0;
+    auto TryGap = [&](int64_t gap_begin, int64_t gap_end) {
+      const int64_t gap = gap_end - gap_begin;
+      if (gap >= size && gap < best_gap) {
+        best_offset = gap_begin;
+        best_gap = gap;
+      }
+    };
+    for (const auto& pair : occupied) {
+      if (pair.first > end) { TryGap(end, pair.first); }
+      end = std::max(end, pair.second);
+    }
+    TryGap(end, buffer_size);
+    if (best_offset == -1) { best_offset = end; }
+    offsets->at(id) = best_offset;
+    buffer_size = std::max(buffer_size, best_offset + size);
+  }
+  return buffer_size;
+}
+
+int64_t IntraJobMemSharingUtil::BestFitSearch(
+    const std::vector<int64_t>& sizes, const std::vector<std::vector<int64_t>>& mutual_exclusions,
+    int64_t lower_bound, int64_t budget, std::vector<int64_t>* offsets) {
+  const int64_t regst_num = sizes.size();
+  // the work of one placement of all the regsts
+  int64_t allocation_cost = regst_num;
+  for (const auto& ids : mutual_exclusions) { allocation_cost += ids.size(); }
+  int64_t remaining_allocation_num = budget / std::max<int64_t>(allocation_cost, 1);
+  // the larger and the longer living first, the order of noisy sizes for restarts
+  auto SortedOrder = [&](const std::vector<double>& keys) {
+    std::vector<int64_t> order(regst_num);
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&](int64_t lhs, int64_t rhs) {
+      if (keys.at(lhs) != keys.at(rhs)) { return keys.at(lhs) > keys.at(rhs); }
+      return mutual_exclusions.at(lhs).size() > mutual_exclusions.at(rhs).size();
+    });
+    return order;
+  };
+  std::vector<double> keys(sizes.begin(), sizes.end());
+  std::vector<int64_t> order = SortedOrder(keys);
+  std::vector<int64_t> cur_offsets;
+  int64_t best_buffer_size = AllocateByOrderAndBestFit(order, sizes, mutual_exclusions, offsets);
+  auto TryAllocate = [&]() {
+    remaining_allocation_num -= 1;
+    const int64_t buffer_size =
+        AllocateByOrderAndBestFit(order, sizes, mutual_exclusions, &cur_offsets);
+    if (buffer_size < best_buffer_size) {
+      best_buffer_size = buffer_size;
+      *offsets = cur_offsets;
+    }
+    return buffer_size;
+  };
+  auto CanGoOn = [&]() { return best_buffer_size > lower_bound && remaining_allocation_num > 0; };
+  // a fixed seed and a budget of work keep the plan of a job the same on every machine
+  std::mt19937 gen(regst_num);
+  std::uniform_int_distribution<int64_t> pos_dis(0, std::max<int64_t>(regst_num - 1, 0));
+  std::uniform_real_distribution<double> noise_dis(0.7, 1.3);
+  const int64_t max_stall_cnt = std::max<int64_t>(regst_num, 64);
+  while (regst_num > 1 && CanGoOn()) {
+    // local search of swaps in the order, equal sizes are accepted to walk across plateaus
+    int64_t cur_buffer_size = TryAllocate();
+    int64_t stall_cnt = 0;
+    while (stall_cnt < max_stall_cnt && CanGoOn()) {
+      const int64_t i = pos_dis(gen);
+      const int64_t j = pos_dis(gen);
+      if (i == j) { continue; }
+      std::swap(order.at(i), order.at(j));
+      const int64_t buffer_size = TryAllocate();
+      if (buffer_size < cur_buffer_size) {
+        stall_cnt = 0;
+      } else {
+        stall_cnt += 1;
+      }
+      if (buffer_size <= cur_buffer_size) {
+        cur_buffer_size = buffer_size;
+      } else {
+        std::swap(order.at(i), order.at(j));
+      }
+    }
+    for (int64_t i = 0; i < regst_num; ++i) { keys.at(i) = sizes.at(i) * noise_dis(gen); }
+    order = SortedOrder(keys);
+  }
+  return best_buffer_size;
 }
 
 }  // namespace oneflow
@@ -23,6 +23,22 @@ namespace oneflow {
 
 struct IntraJobMemSharingUtil {
   static void InferMemBlockId4MemReusedRegst(Plan* plan, const PlanTaskGraph& plan_task_graph);
+
+  // The bytes alive at the same time at most, for the sizes of the regsts allocated and freed at
+  // each step. No assignment of offsets can do better.
+  static int64_t MaxLiveBytes(const std::vector<std::vector<int64_t>>& alloc_sizes_timeline,
+                              const std::vector<std::vector<int64_t>>& free_sizes_timeline);
+  // Places the regsts by order, each one into the smallest gap between the placed regsts it is
+  // mutually exclusive with, and returns the buffer size
+  static int64_t AllocateByOrderAndBestFit(
+      const std::vector<int64_t>& order, const std::vector<int64_t>& sizes,
+      const std::vector<std::vector<int64_t>>& mutual_exclusions, std::vector<int64_t>* offsets);
+  // Searches the orders of AllocateByOrderAndBestFit until the buffer size reaches lower_bound or
+  // the budget, counted in regsts placed and mutual exclusions visited, is spent. The result only
+  // depends on the arguments.
+  static int64_t BestFitSearch(const std::vector<int64_t>& sizes,
+                               const std::vector<std::vector<int64_t>>& mutual_exclusions,
+                               int64_t lower_bound, int64_t budget, std::vector<int64_t>* offsets);
 };
 
 }  // namespace oneflow
@@ -0,0 +1,128 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/job/intra_job_mem_sharing_util.h"
+
+namespace oneflow {
+
+namespace {
+
+// every pair of regsts is mutually exclusive
+std::vector<std::vector<int64_t>> AllMutuallyExclusive(int64_t regst_num) {
+  std::vector<std::vector<int64_t>> mutual_exclusions(regst_num);
+  FOR_RANGE(int64_t, i, 0, regst_num) {
+    FOR_RANGE(int64_t, j, 0, regst_num) {
+      if (i != j) { mutual_exclusions.at(i).push_back(j); }
+    }
+  }
+  return mutual_exclusions;
+}
+
+void CheckNoOverlap(const std::vector<int64_t>& sizes,
+                    const std::vector<std::vector<int64_t>>& mutual_exclusions,
+                    const std::vector<int64_t>& offsets, int64_t buffer_size) {
+  ASSERT_EQ(offsets.size(), sizes.size());
+  FOR_RANGE(int64_t, i, 0, sizes.size()) {
+    ASSERT_GE(offsets.at(i), 0);
+    ASSERT_LE(offsets.at(i) + sizes.at(i), buffer_size);
+    for (int64_t j : mutual_exclusions.at(i)) {
+      const bool disjoint = offsets.at(i) + sizes.at(i) <= offsets.at(j)
+                            || offsets.at(j) + sizes.at(j) <= offsets.at(i);
+      ASSERT_TRUE(disjoint);
+    }
+  }
+}
+
+}  // namespace
+
+TEST(IntraJobMemSharingUtil, max_live_bytes) {
+  // 0 lives in steps 0-1, 1 in steps 1-2 and 2 in step 2
+  const std::vector<std::vector<int64_t>> alloc_sizes_timeline = {{100}, {50}, {70}};
+  const std::vector<std::vector<int64_t>> free_sizes_timeline = {{}, {100}, {50, 70}};
+  ASSERT_EQ(IntraJobMemSharingUtil::MaxLiveBytes(alloc_sizes_timeline, free_sizes_timeline), 150);
+}
+
+TEST(IntraJobMemSharingUtil, allocate_into_smallest_gap) {
+  // 1 and 3 leave gaps of 30 and 20 to the last regst, which takes the smaller one
+  const std::vector<int64_t> sizes = {30, 10, 20, 10, 20};
+  std::vector<std::vector<int64_t>> mutual_exclusions(sizes.size());
+  auto AddMutualExclusion = [&](int64_t i, int64_t j) {
+    mutual_exclusions.at(i).push_back(j);
+    mutual_exclusions.at(j).push_back(i);
+  };
+  AddMutualExclusion(0, 1);
+  AddMutualExclusion(0, 2);
+  AddMutualExclusion(1, 2);
+  AddMutualExclusion(0, 3);
+  AddMutualExclusion(1, 3);
+  AddMutualExclusion(2, 3);
+  AddMutualExclusion(1, 4);
+  AddMutualExclusion(3, 4);
+  std::vector<int64_t> offsets;
+  const int64_t buffer_size = IntraJobMemSharingUtil::AllocateByOrderAndBestFit(
+      {0, 1, 2, 3, 4}, sizes, mutual_exclusions, &offsets);
+  ASSERT_EQ(offsets, std::vector<int64_t>({0, 30, 40, 60, 40}));
+  ASSERT_EQ(buffer_size, 70);
+  CheckNoOverlap(sizes, mutual_exclusions, offsets, buffer_size);
+}
+
+TEST(IntraJobMemSharingUtil, allocate_without_mutual_exclusion) {
+  const std::vector<int64_t> sizes = {30, 10, 20};
+  std::vector<int64_t> offsets;
+  const int64_t buffer_size = IntraJobMemSharingUtil::AllocateByOrderAndBestFit(
+      {2, 1, 0}, sizes, std::vector<std::vector<int64_t>>(sizes.size()), &offsets);
+  ASSERT_EQ(offsets, std::vector<int64_t>({0, 0, 0}));
+  ASSERT_EQ(buffer_size, 30);
+}
+
+TEST(IntraJobMemSharingUtil, best_fit_search_is_deterministic) {
+  // a chain of regsts living in overlapping windows, the search has to reorder them
+  const int64_t regst_num = 40;
+  std::vector<int64_t> sizes(regst_num);
+  std::vector<std::vector<int64_t>> mutual_exclusions(regst_num);
+  FOR_RANGE(int64_t, i, 0, regst_num) {
+    sizes.at(i) = 16 + (i * 37) % 101;
+    FOR_RANGE(int64_t, j, i + 1, std::min<int64_t>(i + 4, regst_num)) {
+      mutual_exclusions.at(i).push_back(j);
+      mutual_exclusions.at(j).push_back(i);
+    }
+  }
+  std::vector<int64_t> first_offsets;
+  const int64_t first_buffer_size =
+      IntraJobMemSharingUtil::BestFitSearch(sizes, mutual_exclusions, 0, 1 << 20, &first_offsets);
+  CheckNoOverlap(sizes, mutual_exclusions, first_offsets, first_buffer_size);
+  std::vector<int64_t> second_offsets;
+  const int64_t second_buffer_size =
+      IntraJobMemSharingUtil::BestFitSearch(sizes, mutual_exclusions, 0, 1 << 20, &second_offsets);
+  ASSERT_EQ(first_buffer_size, second_buffer_size);
+  ASSERT_EQ(first_offsets, second_offsets);
+  // the search never ends worse than the first placement of the larger regsts first
+  std::vector<int64_t> no_search_offsets;
+  ASSERT_LE(first_buffer_size,
+            IntraJobMemSharingUtil::BestFitSearch(sizes, mutual_exclusions, 0, 0,
+                                                  &no_search_offsets));
+}
+
+TEST(IntraJobMemSharingUtil, best_fit_search_stops_at_lower_bound) {
+  const std::vector<int64_t> sizes = {30, 10, 20};
+  const auto mutual_exclusions = AllMutuallyExclusive(sizes.size());
+  std::vector<int64_t> offsets;
+  const int64_t buffer_size =
+      IntraJobMemSharingUtil::BestFitSearch(sizes, mutual_exclusions, 60, 1 << 20, &offsets);
+  ASSERT_EQ(buffer_size, 60);
+  CheckNoOverlap(sizes, mutual_exclusions, offsets, buffer_size);
+}
+
+}  // namespace oneflow
@@ -63,6 +63,15 @@ class JobDesc final {
   }
   bool prune_parallel_cast_ops() const { return job_conf_.prune_parallel_cast_ops(); }
   bool prune_cast_to_static_shape_ops() const { return job_conf_.prune_cast_to_static_shape_ops(); }
+  bool enable_auto_sbp() const { return job_conf_.enable_auto_sbp(); }
+  const std::string& sbp_cost_model_path() const { return job_conf_.sbp_cost_model_path(); }
+  bool enable_analytic_regst_num_tuning() const {
+    return job_conf_.enable_analytic_regst_num_tuning();
+  }
+  double analytic_regst_num_mem_budget_ratio() const {
+    return job_conf_.analytic_regst_num_mem_budget_ratio();
+  }
+  bool enable_actor_fusion() const { return job_conf_.enable_actor_fusion(); }
   int64_t cudnn_buf_limit_mbyte() const { return job_conf_.cudnn_buf_limit_mbyte(); }
 
   bool enable_keep_header_only() const { return job_conf_.enable_keep_header_only(); }
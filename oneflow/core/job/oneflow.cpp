@@ -29,17 +29,21 @@ limitations under the License.
 #include "oneflow/core/job/available_memory_desc.pb.h"
 #include "oneflow/core/persistence/tee_persistent_log_stream.h"
 #include "oneflow/core/actor/act_event_logger.h"
+#include "oneflow/core/job/sbp_cost_model.h"
 #include "oneflow/core/job/oneflow.h"
 #include "oneflow/core/job/model_io_v2_job.h"
 #include "oneflow/core/job/model_io_job.h"
 #include "oneflow/core/job/inter_job_mem_sharing_util.h"
 #include "oneflow/core/job/plan_util.h"
+#include "oneflow/core/job/plan_cache.h"
 #include "oneflow/core/operator/interface_op_util.h"
 #include "oneflow/core/job/critical_section_desc.h"
 #include "oneflow/core/job/global_for.h"
 #include "oneflow/core/vm/oneflow_vm.h"
 #include "oneflow/core/graph/plan_task_graph.h"
 #include "oneflow/core/graph/boxing/collective_boxing_util.h"
+#include "oneflow/core/thread/thread_manager.h"
+#include <zlib.h>
 
 namespace std {
 
@@ -63,96 +67,119 @@ bool operator==(const ParallelBlobConf& lhs, const ParallelBlobConf& rhs) {
 
 namespace {
 
-std::string cluster_thrd_ids_key(const std::string& plan_name) {
-  return plan_name + "_cluster_thrd_ids";
+std::string sub_plan_key(const std::string& plan_name, int64_t machine_id) {
+  return plan_name + "_" + std::to_string(machine_id) + "_sub_plan";
 }
 
-std::string net_topo_key(const std::string& plan_name) { return plan_name + "_net_topo"; }
-
-std::string job_id2job_conf(const std::string& plan_name) { return plan_name + "_job_id2job_conf"; }
-
-std::string GetCollectiveBoxingPlanKey(const std::string& plan_name) {
-  return plan_name + "_collective_boxing_plan";
+std::string shared_plan_key(const std::string& plan_name) { return plan_name + "_shared_plan"; }
+
+// Plans are dominated by repeated op and blob names, so even the fastest zlib level shrinks them a
+// lot. The raw size is prepended to the compressed bytes.
+std::string SerializeAndCompress(const PbMessage& msg) {
+  std::string raw;
+  CHECK(msg.SerializeToString(&raw));
+  const uint64_t raw_size = raw.size();
+  uLongf compressed_size = compressBound(raw_size);
+  std::string compressed(sizeof(raw_size) + compressed_size, '\0');
+  std::memcpy(&compressed[0], &raw_size, sizeof(raw_size));
+  CHECK_EQ(compress2(reinterpret_cast<Bytef*>(&compressed[sizeof(raw_size)]), &compressed_size,
+                     reinterpret_cast<const Bytef*>(raw.data()), raw_size, Z_BEST_SPEED),
+           Z_OK);
+  compressed.resize(sizeof(raw_size) + compressed_size);
+  return compressed;
 }
 
-std::string sub_plan_key(const std::string& plan_name, int64_t machine_id, int64_t thrd_id) {
-  return plan_name + "_" + std::to_string(machine_id) + "_" + std::to_string(thrd_id);
+void DecompressAndParse(const std::string& compressed, PbMessage* msg) {
+  uint64_t raw_size = 0;
+  CHECK_GE(compressed.size(), sizeof(raw_size));
+  std::memcpy(&raw_size, compressed.data(), sizeof(raw_size));
+  std::string raw(raw_size, '\0');
+  uLongf uncompressed_size = raw_size;
+  CHECK_EQ(uncompress(reinterpret_cast<Bytef*>(&raw[0]), &uncompressed_size,
+                      reinterpret_cast<const Bytef*>(compressed.data() + sizeof(raw_size)),
+                      compressed.size() - sizeof(raw_size)),
+           Z_OK);
+  CHECK_EQ(uncompressed_size, raw_size);
+  CHECK(msg->ParseFromString(raw));
 }
 
-std::string block7chunk_key(const std::string& plan_name, int64_t machine_id) {
-  return plan_name + "_" + std::to_string(machine_id) + "_block7chunk";
+int64_t GetPlanFanOutParent(int64_t machine_id) { return (machine_id - 1) / 2; }
+
+bool HasPlanFanOutChild(int64_t machine_id, int64_t machine_num) {
+  return 2 * machine_id + 1 < machine_num;
 }
 
+// Every worker pulls its sub plan from its own ctrl server, where the master has pushed it. The
+// part shared by all machines fans out along a binary tree rooted at the master: each machine pulls
+// it from its parent's ctrl server and pushes it to its own for its children.
 void PushPlan(const std::string& plan_name, const Plan& plan) {
-  HashMap<int64_t, std::set<int64_t>> machine_id2thrd_id_set;
-  HashMap<std::pair<int64_t, int64_t>, std::vector<TaskProto>> mchn_thrd_id2task_protos;
-  HashMap<int64_t, MemBlockAndChunkList> machine_id2block7chunk;
-
-  for (const auto& task : plan.task()) {
-    machine_id2thrd_id_set[task.machine_id()].insert(task.thrd_id());
-    mchn_thrd_id2task_protos[std::make_pair(task.machine_id(), task.thrd_id())].emplace_back(task);
-  }
-
-  HashMap<int64_t, ThrdIds> machine_id2thrd_ids;
-  for (const auto& pair : machine_id2thrd_id_set) {
-    CHECK(machine_id2thrd_ids.emplace(pair.first, ThrdIds()).second);
-    std::vector<int64_t> thrd_id_vec(pair.second.begin(), pair.second.end());
-    *(machine_id2thrd_ids.at(pair.first).mutable_thrd_id()) = StdVec2PbRf(thrd_id_vec);
-  }
-
-  ClusterThrdIds cluster_thrd_ids;
-  *(cluster_thrd_ids.mutable_machine_id2thrd_ids()) = HashMap2PbMap(machine_id2thrd_ids);
-  Global<CtrlClient>::Get()->PushKV(cluster_thrd_ids_key(plan_name), cluster_thrd_ids);
-
-  for (const auto& pair : mchn_thrd_id2task_protos) {
-    SubPlan sub_plan;
-    *(sub_plan.mutable_task()) = StdVec2PbRpf(pair.second);
-    Global<CtrlClient>::Get()->PushKV(sub_plan_key(plan_name, pair.first.first, pair.first.second),
-                                      sub_plan);
-  }
-
+  const double start = GetCurTime();
+  const int64_t machine_num = Global<ResourceDesc, ForSession>::Get()->TotalMachineNum();
+  const int64_t this_machine_id = Global<MachineCtx>::Get()->this_machine_id();
+  std::vector<std::vector<const TaskProto*>> machine_id2tasks(machine_num);
+  for (const auto& task : plan.task()) { machine_id2tasks.at(task.machine_id()).push_back(&task); }
+  std::vector<std::vector<const MemBlockProto*>> machine_id2mem_blocks(machine_num);
   for (const auto& mem_block : plan.block_chunk_list().mem_block()) {
-    *machine_id2block7chunk[mem_block.machine_id()].add_mem_block() = mem_block;
+    machine_id2mem_blocks.at(mem_block.machine_id()).push_back(&mem_block);
   }
+  std::vector<std::vector<const ChunkProto*>> machine_id2chunks(machine_num);
   for (const auto& chunk : plan.block_chunk_list().chunk()) {
-    *machine_id2block7chunk[chunk.machine_id()].add_chunk() = chunk;
+    machine_id2chunks.at(chunk.machine_id()).push_back(&chunk);
   }
-  for (const auto& pair : machine_id2block7chunk) {
-    Global<CtrlClient>::Get()->PushKV(block7chunk_key(plan_name, pair.first), pair.second);
+  std::atomic<int64_t> pushed_size(0);
+  MultiThreadLoop(machine_num, [&](size_t machine_id) {
+    if (static_cast<int64_t>(machine_id) == this_machine_id) { return; }
+    SubPlan sub_plan;
+    for (const TaskProto* task : machine_id2tasks.at(machine_id)) { *sub_plan.add_task() = *task; }
+    MemBlockAndChunkList* block7chunk = sub_plan.mutable_block_chunk_list();
+    for (const MemBlockProto* mem_block : machine_id2mem_blocks.at(machine_id)) {
+      *block7chunk->add_mem_block() = *mem_block;
+    }
+    for (const ChunkProto* chunk : machine_id2chunks.at(machine_id)) {
+      *block7chunk->add_chunk() = *chunk;
+    }
+    const std::string& compressed = SerializeAndCompress(sub_plan);
+    pushed_size += compressed.size();
+    Global<CtrlClient>::Get()->PushMachineKV(machine_id, sub_plan_key(plan_name, machine_id),
+                                             compressed);
+  });
+  if (HasPlanFanOutChild(this_machine_id, machine_num)) {
+    SharedPlan shared_plan;
+    *shared_plan.mutable_net_topo() = plan.net_topo();
+    *shared_plan.mutable_job_confs() = plan.job_confs();
+    *shared_plan.mutable_collective_boxing_plan() = plan.collective_boxing_plan();
+    const std::string& compressed = SerializeAndCompress(shared_plan);
+    pushed_size += compressed.size();
+    Global<CtrlClient>::Get()->PushMachineKV(this_machine_id, shared_plan_key(plan_name),
+                                             compressed);
   }
-
-  Global<CtrlClient>::Get()->PushKV(net_topo_key(plan_name), plan.net_topo());
-  Global<CtrlClient>::Get()->PushKV(job_id2job_conf(plan_name), plan.job_confs());
-  Global<CtrlClient>::Get()->PushKV(GetCollectiveBoxingPlanKey(plan_name),
-                                    plan.collective_boxing_plan());
+  LOG(INFO) << "push " << plan_name << ": " << plan.ByteSizeLong() << " bytes, "
+            << pushed_size.load() << " bytes compressed, " << (GetCurTime() - start) / 1e6
+            << " ms";
 }
 
 void PullPlan(const std::string& plan_name, Plan* plan) {
-  ClusterThrdIds cluster_thrd_ids;
-  Global<CtrlClient>::Get()->PullKV(cluster_thrd_ids_key(plan_name), &cluster_thrd_ids);
-  PrintProtoToTextFile(cluster_thrd_ids, JoinPath(FLAGS_log_dir, cluster_thrd_ids_key(plan_name)));
-  HashMap<int64_t, ThrdIds> machine_id2thrd_ids;
-  machine_id2thrd_ids = PbMap2HashMap(cluster_thrd_ids.machine_id2thrd_ids());
-  int64_t machine_id = Global<MachineCtx>::Get()->this_machine_id();
-  auto thrd_ids_it = machine_id2thrd_ids.find(machine_id);
-  CHECK(thrd_ids_it != machine_id2thrd_ids.end());
-  std::vector<int64_t> thrd_id_vec = PbRf2StdVec(thrd_ids_it->second.thrd_id());
-  for (auto thrd_id : thrd_id_vec) {
-    SubPlan sub_plan;
-    Global<CtrlClient>::Get()->PullKV(sub_plan_key(plan_name, machine_id, thrd_id), &sub_plan);
-    plan->mutable_task()->MergeFrom(sub_plan.task());
-  }
-  NetTopo net_topo;
-  Global<CtrlClient>::Get()->PullKV(net_topo_key(plan_name), &net_topo);
-  *(plan->mutable_net_topo()) = net_topo;
-  JobConfs job_confs;
-  Global<CtrlClient>::Get()->PullKV(job_id2job_conf(plan_name), &job_confs);
-  *(plan->mutable_job_confs()) = job_confs;
-  Global<CtrlClient>::Get()->PullKV(GetCollectiveBoxingPlanKey(plan_name),
-                                    plan->mutable_collective_boxing_plan());
-  MemBlockAndChunkList block7chunk;
-  Global<CtrlClient>::Get()->PullKV(block7chunk_key(plan_name, machine_id), &block7chunk);
-  plan->mutable_block_chunk_list()->CopyFrom(block7chunk);
+  const int64_t machine_num = Global<ResourceDesc, ForSession>::Get()->TotalMachineNum();
+  const int64_t machine_id = Global<MachineCtx>::Get()->this_machine_id();
+  std::string shared_plan_str;
+  Global<CtrlClient>::Get()->PullMachineKV(GetPlanFanOutParent(machine_id),
+                                           shared_plan_key(plan_name), &shared_plan_str);
+  if (HasPlanFanOutChild(machine_id, machine_num)) {
+    Global<CtrlClient>::Get()->PushMachineKV(machine_id, shared_plan_key(plan_name),
+                                             shared_plan_str);
+  }
+  std::string sub_plan_str;
+  Global<CtrlClient>::Get()->PullMachineKV(machine_id, sub_plan_key(plan_name, machine_id),
+                                           &sub_plan_str);
+  SubPlan sub_plan;
+  DecompressAndParse(sub_plan_str, &sub_plan);
+  plan->mutable_task()->Swap(sub_plan.mutable_task());
+  plan->mutable_block_chunk_list()->Swap(sub_plan.mutable_block_chunk_list());
+  SharedPlan shared_plan;
+  DecompressAndParse(shared_plan_str, &shared_plan);
+  plan->mutable_net_topo()->Swap(shared_plan.mutable_net_topo());
+  plan->mutable_job_confs()->Swap(shared_plan.mutable_job_confs());
+  plan->mutable_collective_boxing_plan()->Swap(shared_plan.mutable_collective_boxing_plan());
 }
 
 bool IsCollectiveBoxingNode(const PlanTaskNode* node) {
@@ -327,6 +354,25 @@ Maybe<void> CompileCurJobOnMaster(Job* job, Plan* improved_plan, bool need_job_c
           JoinPath(FLAGS_log_dir, ActEventLogger::experiment_act_event_bin_filename())));
       OF_SESSION_BARRIER();
       TeePersistentLogStream::Create("improved_plan")->Write(*improved_plan);
+      if (job_desc.enable_auto_sbp()) {
+        // the calibrated cost model is picked up by sbp_cost_model_path in later sessions
+        std::list<std::unique_ptr<ActEvent>> act_events;
+        ParseActEvents(JoinPath(FLAGS_log_dir, ActEventLogger::experiment_act_event_bin_filename()),
+                       &act_events);
+        SbpCostModelConf sbp_cost_model_conf =
+            LoadSbpCostModelConf(job_desc.sbp_cost_model_path());
+        CalibrateSbpCostModelConf(naive_plan, act_events, &sbp_cost_model_conf);
+        TeePersistentLogStream::Create("sbp_cost_model_" + job_desc.job_name())
+            ->Write(sbp_cost_model_conf);
+      }
+    }
+  } else if (job_desc.enable_analytic_regst_num_tuning()) {
+    if (Global<MachineCtx>::Get()->IsThisMachineMaster()) {
+      *improved_plan = *JUST(
+          Improver().ImproveAnalytically(*Global<AvailableMemDesc>::Get(), naive_plan,
+                                         LoadSbpCostModelConf(job_desc.sbp_cost_model_path()),
+                                         job_desc.analytic_regst_num_mem_budget_ratio()));
+      LOG(INFO) << "analytic improve time: " << GetCurTime() - start;
     }
   } else {
     *improved_plan = complete_plan;
@@ -939,6 +985,18 @@ Maybe<void> CompileAndMergePlanOnMaster(const PbRpf<Job>& conf_jobs, Plan* plan)
       jobs.emplace_back(pull_job);
     }
   }
+  const bool plan_cache_enabled =
+      Global<MachineCtx>::Get()->IsThisMachineMaster() && PlanCache::IsEnabled(jobs);
+  const std::string plan_cache_compile_input =
+      plan_cache_enabled ? PlanCache::GenCompileInput(jobs) : "";
+  if (plan_cache_enabled && PlanCache::TryLoad(plan_cache_compile_input, jobs, plan)) {
+    if (Global<ResourceDesc, ForSession>::Get()->enable_debug_mode()) {
+      TeePersistentLogStream::Create("merged_plan")->Write(*plan);
+    }
+    PushPlan("merged_plan", *plan);
+    OF_SESSION_BARRIER();
+    return Maybe<void>::Ok();
+  }
   std::vector<Plan> sub_plans(jobs.size());
   FOR_RANGE(int64_t, i, 0, jobs.size()) {
     AddJobName2JobId(jobs.at(i)->job_conf().job_name(), i);
@@ -965,6 +1023,7 @@ Maybe<void> CompileAndMergePlanOnMaster(const PbRpf<Job>& conf_jobs, Plan* plan)
       TeePersistentLogStream::Create("merged_plan")->Write(*plan);
       PlanUtil::ToDotFile(*plan, "/dot/merged_plan.dot");
     }
+    if (plan_cache_enabled) { PlanCache::Save(plan_cache_compile_input, *plan); }
     PushPlan("merged_plan", *plan);
   } else {
     PullPlan("merged_plan", plan);
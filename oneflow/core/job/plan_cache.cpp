@@ -0,0 +1,189 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/job/plan_cache.h"
+#include "oneflow/core/job/plan_cache.pb.h"
+#include "oneflow/core/job/available_memory_desc.pb.h"
+#include "oneflow/core/job/cpu_actor_profile.pb.h"
+#include "oneflow/core/job/critical_section_desc.h"
+#include "oneflow/core/job/env_desc.h"
+#include "oneflow/core/job/global_for.h"
+#include "oneflow/core/job/job_desc.h"
+#include "oneflow/core/job/job_set.pb.h"
+#include "oneflow/core/job/resource_desc.h"
+#include "oneflow/core/job/sbp_cost_model.h"
+#include "oneflow/core/persistence/compile_cache.h"
+
+namespace oneflow {
+
+namespace {
+
+std::string GetEntryPath(const std::string& compile_input) {
+  return CompileCacheEntryPath(Global<ResourceDesc, ForSession>::Get()->plan_cache_dir(), "plan_",
+                               compile_input);
+}
+
+bool CheckMemoryFits(const Plan& plan) {
+  const AvailableMemDesc& amd = *Global<AvailableMemDesc>::Get();
+  const ResourceDesc& resource_desc = *Global<ResourceDesc, ForSession>::Get();
+  HashMap<std::pair<int64_t, int64_t>, int64_t> machine_zone2mem_size;
+  auto Add = [&](int64_t machine_id, const MemoryCase& mem_case, int64_t mem_size) {
+    const int64_t zone_id = mem_case.has_device_cuda_mem() ? mem_case.device_cuda_mem().device_id()
+                                                           : resource_desc.GpuDeviceNum();
+    machine_zone2mem_size[std::make_pair(machine_id, zone_id)] += mem_size;
+  };
+  for (const ChunkProto& chunk : plan.block_chunk_list().chunk()) {
+    Add(chunk.machine_id(), chunk.mem_case(), chunk.mem_size());
+  }
+  for (const MemBlockProto& mem_block : plan.block_chunk_list().mem_block()) {
+    if (mem_block.chunk_id() == -1) {
+      Add(mem_block.machine_id(), mem_block.mem_case(), mem_block.mem_size());
+    }
+  }
+  for (const auto& pair : machine_zone2mem_size) {
+    const int64_t machine_id = pair.first.first;
+    const int64_t zone_id = pair.first.second;
+    if (machine_id >= amd.machine_amd_size()) { return false; }
+    if (zone_id >= amd.machine_amd(machine_id).zone_size_size()) { return false; }
+    const int64_t reserved = zone_id == resource_desc.GpuDeviceNum()
+                                 ? resource_desc.reserved_host_mem_byte()
+                                 : resource_desc.reserved_device_mem_byte();
+    const int64_t available =
+        static_cast<int64_t>(amd.machine_amd(machine_id).zone_size(zone_id)) - reserved;
+    if (pair.second > available) {
+      LOG(WARNING) << "cached plan needs " << pair.second << " bytes in memory zone " << zone_id
+                   << " of machine " << machine_id << ", only " << available << " are available";
+      return false;
+    }
+  }
+  return true;
+}
+
+}  // namespace
+
+bool PlanCache::IsEnabled(const std::vector<std::shared_ptr<Job>>& jobs) {
+  if (!Global<ResourceDesc, ForSession>::Get()->enable_plan_cache()) { return false; }
+  if (CompileCacheVersion().empty()) {
+    LOG(WARNING) << "plan cache is disabled since oneflow was built without BUILD_GIT_VERSION";
+    return false;
+  }
+  for (const auto& job : jobs) {
+    // the improved plan depends on the act events of the experiment run
+    if (job->job_conf().exp_run_conf().enable_experiment_run()) { return false; }
+  }
+  return true;
+}
+
+std::string PlanCache::GenCompileInput(const std::vector<std::shared_ptr<Job>>& jobs) {
+  std::string compile_input = CompileCacheVersion();
+  compile_input.push_back('\0');
+  for (const auto& job : jobs) {
+    AppendDeterministicSerialization(*job, &compile_input);
+    // sbp signatures and regst nums depend on the cost model, not on where it is
+    const std::string& sbp_cost_model_path = job->job_conf().sbp_cost_model_path();
+    if (!sbp_cost_model_path.empty()) {
+      AppendDeterministicSerialization(LoadSbpCostModelConf(sbp_cost_model_path), &compile_input);
+    }
+  }
+  Resource resource = Global<ResourceDesc, ForSession>::Get()->resource();
+  resource.clear_plan_cache_dir();
+  resource.clear_enable_plan_cache();
+  resource.clear_enable_debug_mode();
+  resource.clear_pin_cpu_device_threads();
+  resource.clear_metrics_port();
+  resource.clear_metrics_path();
+  resource.clear_metrics_dump_interval_ms();
+  // the placement of cpu actors depends on the profile, not on where it is
+  resource.clear_cpu_actor_profile_path();
+  AppendDeterministicSerialization(resource, &compile_input);
+  const std::string& cpu_actor_profile_path =
+      Global<ResourceDesc, ForSession>::Get()->cpu_actor_profile_path();
+  if (!cpu_actor_profile_path.empty()) {
+    CpuActorProfile cpu_actor_profile;
+    ParseProtoFromTextFile(cpu_actor_profile_path, &cpu_actor_profile);
+    AppendDeterministicSerialization(cpu_actor_profile, &compile_input);
+  }
+  FOR_RANGE(int64_t, i, 0, Global<EnvDesc>::Get()->TotalMachineNum()) {
+    AppendDeterministicSerialization(Global<EnvDesc>::Get()->machine(i), &compile_input);
+  }
+  AppendDeterministicSerialization(*Global<const IOConf>::Get(), &compile_input);
+  if (Global<const InterJobReuseMemStrategy>::Get() != nullptr) {
+    AppendDeterministicSerialization(*Global<const InterJobReuseMemStrategy>::Get(),
+                                     &compile_input);
+  }
+  // the available memory changes from run to run and only decides whether the plan fits, which
+  // TryLoad checks against the current one
+  for (const auto& machine_amd : Global<AvailableMemDesc>::Get()->machine_amd()) {
+    compile_input += std::to_string(machine_amd.zone_size_size()) + ",";
+  }
+  return compile_input;
+}
+
+bool PlanCache::TryLoad(const std::string& compile_input,
+                        const std::vector<std::shared_ptr<Job>>& jobs, Plan* plan) {
+  const std::string path = GetEntryPath(compile_input);
+  std::string buffer;
+  if (!ReadCompileCacheEntry(path, &buffer)) { return false; }
+  PlanCacheEntry entry;
+  if (!entry.ParseFromString(buffer)) {
+    LOG(WARNING) << "ignore corrupted plan cache entry " << path;
+    return false;
+  }
+  if (entry.oneflow_version() != CompileCacheVersion() || entry.compile_input() != compile_input) {
+    LOG(INFO) << "plan cache entry " << path << " was compiled from other jobs";
+    return false;
+  }
+  if (entry.job_name_size() != static_cast<int64_t>(jobs.size()) + 1) { return false; }
+  FOR_RANGE(int64_t, i, 0, jobs.size()) {
+    if (entry.job_name(i) != jobs.at(i)->job_conf().job_name()) { return false; }
+  }
+  if (Global<CriticalSectionDesc>::Get()->CriticalSectionNum() != 0) { return false; }
+  if (!CheckMemoryFits(entry.plan())) { return false; }
+
+  FOR_RANGE(int64_t, i, 0, entry.job_name_size()) {
+    CHECK(Global<JobName2JobId>::Get()->emplace(entry.job_name(i), i).second);
+  }
+  for (const CriticalSection& critical_section : entry.critical_section()) {
+    Global<CriticalSectionDesc>::Get()->AddCriticalSection(
+        std::make_unique<CriticalSection>(critical_section));
+  }
+  Global<CriticalSectionDesc>::Get()->Done();
+  plan->Swap(entry.mutable_plan());
+  LOG(INFO) << "load plan from cache " << path;
+  return true;
+}
+
+void PlanCache::Save(const std::string& compile_input, const Plan& plan) {
+  PlanCacheEntry entry;
+  entry.set_oneflow_version(CompileCacheVersion());
+  entry.set_compile_input(compile_input);
+  const JobName2JobId& job_name2job_id = *Global<JobName2JobId>::Get();
+  std::vector<const std::string*> job_names(job_name2job_id.size());
+  for (const auto& pair : job_name2job_id) { job_names.at(pair.second) = &pair.first; }
+  for (const std::string* job_name : job_names) { entry.add_job_name(*job_name); }
+  const CriticalSectionDesc& critical_section_desc = *Global<CriticalSectionDesc>::Get();
+  FOR_RANGE(int64_t, i, 0, critical_section_desc.CriticalSectionNum()) {
+    *entry.add_critical_section() = critical_section_desc.GetCriticalSection(i);
+  }
+  *entry.mutable_plan() = plan;
+  std::string buffer;
+  CHECK(entry.SerializeToString(&buffer));
+
+  const std::string path = GetEntryPath(compile_input);
+  WriteCompileCacheEntry(path, buffer);
+  LOG(INFO) << "save plan to cache " << path;
+}
+
+}  // namespace oneflow
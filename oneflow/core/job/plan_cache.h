@@ -0,0 +1,48 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifndef ONEFLOW_CORE_JOB_PLAN_CACHE_H_
+#define ONEFLOW_CORE_JOB_PLAN_CACHE_H_
+
+#include "oneflow/core/common/util.h"
+#include "oneflow/core/job/job.pb.h"
+#include "oneflow/core/job/plan.pb.h"
+
+namespace oneflow {
+
+// PlanCache keeps the merged plan of a job set in Resource.plan_cache_dir, so that restarting a
+// session with the same jobs skips the logical/task graph construction and the memory planning.
+//
+// The compile input of an entry is the deterministic serialization of the jobs (including the
+// model io, push and pull jobs), the resource, the machines, the io conf, the inter job mem reuse
+// strategy, the number of memory zones and the oneflow git version. An entry is used only if its
+// compile input equals the current one byte for byte, its jobs and critical sections match the
+// current ones and its memory still fits into the available memory; otherwise the job set is
+// compiled as usual and the entry is replaced.
+//
+// Only the master uses the cache, the other machines pull the plan as before.
+struct PlanCache {
+  static bool IsEnabled(const std::vector<std::shared_ptr<Job>>& jobs);
+  static std::string GenCompileInput(const std::vector<std::shared_ptr<Job>>& jobs);
+  // On a hit fills plan and restores JobName2JobId and the CriticalSectionDesc the compilation
+  // would have produced.
+  static bool TryLoad(const std::string& compile_input,
+                      const std::vector<std::shared_ptr<Job>>& jobs, Plan* plan);
+  static void Save(const std::string& compile_input, const Plan& plan);
+};
+
+}  // namespace oneflow
+
+#endif  // ONEFLOW_CORE_JOB_PLAN_CACHE_H_
@@ -15,9 +15,11 @@ limitations under the License.
 */
 #include "oneflow/core/job/profiler.h"
 #include "oneflow/core/job/job_desc.h"
+#include "oneflow/core/job/act_graph_analysis.h"
 #include "oneflow/core/persistence/tee_persistent_log_stream.h"
 #include "oneflow/core/common/str_util.h"
 #include "oneflow/core/actor/act_event_logger.h"
+#include "oneflow/core/graph/cpu_actor_placement.h"
 
 namespace oneflow {
 
@@ -47,8 +49,37 @@ class ActorProfileInfo {
   double avg_act_time_;
   int64_t act_num_;
 };
+
+void AddPerfCounters(const PerfCounters& src, PerfCounters* dst) {
+  if (src.has_cycles()) { dst->set_cycles(dst->cycles() + src.cycles()); }
+  if (src.has_instructions()) { dst->set_instructions(dst->instructions() + src.instructions()); }
+  if (src.has_llc_misses()) { dst->set_llc_misses(dst->llc_misses() + src.llc_misses()); }
+  if (src.has_branch_misses()) {
+    dst->set_branch_misses(dst->branch_misses() + src.branch_misses());
+  }
+}
+
 }  // namespace
 
+std::string PerfCountersToString(const PerfCounters& perf_counters) {
+  std::string str;
+  if (perf_counters.has_cycles()) { str += " cycles:" + std::to_string(perf_counters.cycles()); }
+  if (!perf_counters.has_instructions() || perf_counters.instructions() == 0) { return str; }
+  const double kilo_instructions = perf_counters.instructions() / 1000.0;
+  if (perf_counters.has_cycles() && perf_counters.cycles() > 0) {
+    str += " ipc:"
+           + std::to_string(static_cast<double>(perf_counters.instructions())
+                            / perf_counters.cycles());
+  }
+  if (perf_counters.has_llc_misses()) {
+    str += " llc_mpki:" + std::to_string(perf_counters.llc_misses() / kilo_instructions);
+  }
+  if (perf_counters.has_branch_misses()) {
+    str += " branch_mpki:" + std::to_string(perf_counters.branch_misses() / kilo_instructions);
+  }
+  return str;
+}
+
 void Profiler::Profile(const Plan& plan, const std::string& act_event_filepath) {
   HashMap<int64_t, TaskType> task_id2task_type;
   for (const TaskProto& task : plan.task()) {
@@ -59,11 +90,15 @@ void Profiler::Profile(const Plan& plan, const std::string& act_event_filepath)
   ParseActEvents(act_event_filepath, &act_events);
 
   HashMap<int64_t, std::vector<ActTimeInfo>> actor_id2act_time_info;
+  HashMap<int64_t, PerfCounters> actor_id2perf_counters;
   for (const auto& act_event : act_events) {
     int64_t actor_id = act_event->actor_id();
     ActTimeInfo act_time_info(
         {act_event->ready_time(), act_event->start_time(), act_event->stop_time()});
     actor_id2act_time_info[actor_id].emplace_back(act_time_info);
+    if (act_event->has_perf_counters()) {
+      AddPerfCounters(act_event->perf_counters(), &actor_id2perf_counters[actor_id]);
+    }
   }
 
   using ProfileInfoPair = std::pair<int64_t, ActorProfileInfo>;
@@ -106,8 +141,20 @@ void Profiler::Profile(const Plan& plan, const std::string& act_event_filepath)
                << " avg_act_time:" << std::to_string(pair.second.avg_act_time())
                << " avg_act_interval:" << std::to_string(pair.second.avg_act_interval())
                << " bottleneck_score:" << std::to_string(pair.second.CalcBottleNeckScore())
-               << " type:" << TaskType_Name(task_id2task_type.at(pair.first)) << "\n";
+               << " type:" << TaskType_Name(task_id2task_type.at(pair.first));
+    const auto perf_counters_it = actor_id2perf_counters.find(pair.first);
+    if (perf_counters_it != actor_id2perf_counters.end()) {
+      log_stream << PerfCountersToString(perf_counters_it->second);
+    }
+    log_stream << "\n";
   }
+  // fed back through Resource.cpu_actor_profile_path to place the cpu actors of later sessions
+  CpuActorProfile cpu_actor_profile;
+  GenCpuActorProfile(plan, act_events, &cpu_actor_profile);
+  TeePersistentLogStream::Create("cpu_actor_profile")->Write(cpu_actor_profile);
+  ActGraphReport act_graph_report;
+  AnalyzeActGraph(plan, act_events, &act_graph_report);
+  TeePersistentLogStream::Create("act_graph_report")->Write(act_graph_report);
 }
 
 }  // namespace oneflow
@@ -18,6 +18,7 @@ limitations under the License.
 
 #include "oneflow/core/common/util.h"
 #include "oneflow/core/job/plan.pb.h"
+#include "oneflow/core/actor/act_event.pb.h"
 
 namespace oneflow {
 
@@ -32,6 +33,10 @@ class Profiler final {
  private:
 };
 
+// instructions per cycle and misses per kilo instructions, which tell compute bound kernels from
+// the ones bound by memory or by mispredicted branches
+std::string PerfCountersToString(const PerfCounters& perf_counters);
+
 }  // namespace oneflow
 
 #endif  // ONEFLOW_CORE_JOB_PROFILER_H_
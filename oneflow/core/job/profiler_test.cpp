@@ -0,0 +1,48 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/job/profiler.h"
+
+namespace oneflow {
+
+TEST(Profiler, perf_counters_to_string) {
+  PerfCounters perf_counters;
+  ASSERT_EQ(PerfCountersToString(perf_counters), "");
+  perf_counters.set_cycles(2000);
+  perf_counters.set_instructions(5000);
+  perf_counters.set_llc_misses(10);
+  perf_counters.set_branch_misses(25);
+  ASSERT_EQ(PerfCountersToString(perf_counters),
+            " cycles:2000 ipc:2.500000 llc_mpki:2.000000 branch_mpki:5.000000");
+  // counters the cpu does not have are left out
+  perf_counters.clear_llc_misses();
+  ASSERT_EQ(PerfCountersToString(perf_counters), " cycles:2000 ipc:2.500000 branch_mpki:5.000000");
+  perf_counters.clear_cycles();
+  ASSERT_EQ(PerfCountersToString(perf_counters), " branch_mpki:5.000000");
+  perf_counters.set_cycles(0);
+  ASSERT_EQ(PerfCountersToString(perf_counters), " cycles:0 branch_mpki:5.000000");
+}
+
+TEST(Profiler, perf_counters_to_string_without_instructions) {
+  PerfCounters perf_counters;
+  perf_counters.set_cycles(2000);
+  perf_counters.set_llc_misses(10);
+  perf_counters.set_branch_misses(25);
+  ASSERT_EQ(PerfCountersToString(perf_counters), " cycles:2000");
+  perf_counters.set_instructions(0);
+  ASSERT_EQ(PerfCountersToString(perf_counters), " cycles:2000");
+}
+
+}  // namespace oneflow
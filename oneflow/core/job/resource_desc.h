@@ -53,6 +53,12 @@ class ResourceDesc final {
   int32_t ComputeThreadPoolSize() const;
   bool enable_debug_mode() const;
   CollectiveBoxingConf collective_boxing_conf() const;
+  bool enable_plan_cache() const {
+    return resource_.enable_plan_cache() && !resource_.plan_cache_dir().empty();
+  }
+  const std::string& plan_cache_dir() const { return resource_.plan_cache_dir(); }
+  const std::string& cpu_actor_profile_path() const { return resource_.cpu_actor_profile_path(); }
+  bool pin_cpu_device_threads() const { return resource_.pin_cpu_device_threads(); }
 
   void SetMachineNum(int32_t val) { resource_.set_machine_num(val); }
   void SetCpuDeviceNum(int32_t val) { resource_.set_cpu_device_num(val); }
@@ -22,6 +22,7 @@ limitations under the License.
 #include "oneflow/core/job/resource_desc.h"
 #include "oneflow/core/job/global_for.h"
 #include "oneflow/core/job/runtime_job_descs.h"
+#include "oneflow/core/job/runtime_metrics.h"
 #include "oneflow/core/thread/thread_manager.h"
 #include "oneflow/core/actor/act_event_logger.h"
 #include "oneflow/core/graph/task_node.h"
@@ -96,6 +97,7 @@ Runtime::~Runtime() {
 
 void Runtime::NewAllGlobal(const Plan& plan, size_t total_piece_num, bool is_experiment_phase) {
   Global<RuntimeCtx>::New(total_piece_num, is_experiment_phase);
+  if (RuntimeMetrics::IsEnabled()) { Global<RuntimeMetrics>::New(); }
   if (Global<MachineCtx>::Get()->IsThisMachineMaster()
       && Global<RuntimeCtx>::Get()->NeedCollectActEvent()) {
     Global<ActEventLogger>::New(is_experiment_phase);
@@ -167,6 +169,7 @@ void Runtime::DeleteAllGlobal() {
   }
 
   Global<ActEventLogger>::Delete();
+  Global<RuntimeMetrics>::Delete();
   Global<RuntimeCtx>::Delete();
   Global<summary::EventsWriter>::Delete();
 }
@@ -0,0 +1,283 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/job/runtime_metrics.h"
+#include "oneflow/core/common/platform.h"
+#include "oneflow/core/job/global_for.h"
+#include "oneflow/core/job/machine_context.h"
+#include "oneflow/core/job/resource_desc.h"
+
+#include <cstdio>
+#include <map>
+#include <sstream>
+
+#ifdef OF_PLATFORM_POSIX
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+#endif  // OF_PLATFORM_POSIX
+
+namespace oneflow {
+
+namespace {
+
+// Each exporter wakes up this often to serve requests, dump the file and check for stop
+const int kExporterPollMs = 100;
+// A scraper which does not send its request or read the response holds the exporter this long
+const int kExporterIoTimeoutMs = 1000;
+
+int64_t NewRuntimeMetricsUid() {
+  static std::atomic<int64_t> next_uid(0);
+  return next_uid.fetch_add(1);
+}
+
+class PrometheusWriter final {
+ public:
+  explicit PrometheusWriter(int64_t machine_id) : machine_id_(machine_id) {
+    out_.precision(std::numeric_limits<double>::digits10);
+  }
+
+  void Family(const std::string& name, const std::string& type, const std::string& help) {
+    out_ << "# HELP " << name << " " << help << "\n";
+    out_ << "# TYPE " << name << " " << type << "\n";
+    name_ = name;
+  }
+  template<typename T>
+  void Sample(const std::vector<std::pair<std::string, int64_t>>& labels, T value) {
+    out_ << name_ << "{machine_id=\"" << machine_id_ << "\"";
+    for (const auto& pair : labels) { out_ << "," << pair.first << "=\"" << pair.second << "\""; }
+    out_ << "} " << value << "\n";
+  }
+  std::string str() const { return out_.str(); }
+
+ private:
+  int64_t machine_id_;
+  std::string name_;
+  std::ostringstream out_;
+};
+
+}  // namespace
+
+RuntimeMetrics::RuntimeMetrics()
+    : uid_(NewRuntimeMetricsUid()),
+      this_machine_id_(Global<MachineCtx>::Get()->this_machine_id()),
+      listen_sockfd_(-1),
+      exporter_stopped_(false) {
+  const Resource& resource = Global<ResourceDesc, ForSession>::Get()->resource();
+  if (resource.metrics_port() > 0) {
+#ifdef OF_PLATFORM_POSIX
+    listen_sockfd_ = socket(AF_INET, SOCK_STREAM, 0);
+    PCHECK(listen_sockfd_ != -1);
+    int reuse = 1;
+    PCHECK(setsockopt(listen_sockfd_, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse)) == 0);
+    sockaddr_in sa = {};
+    sa.sin_family = AF_INET;
+    sa.sin_port = htons(resource.metrics_port());
+    sa.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (bind(listen_sockfd_, reinterpret_cast<sockaddr*>(&sa), sizeof(sa)) == 0) {
+      PCHECK(listen(listen_sockfd_, 16) == 0);
+      LOG(INFO) << "runtime metrics served on http://127.0.0.1:" << resource.metrics_port()
+                << "/metrics";
+    } else {
+      PLOG(WARNING) << "runtime metrics can not be served on port " << resource.metrics_port();
+      close(listen_sockfd_);
+      listen_sockfd_ = -1;
+    }
+#else
+    LOG(WARNING) << "runtime metrics can only be served on posix platforms";
+#endif  // OF_PLATFORM_POSIX
+  }
+  exporter_ = std::thread(&RuntimeMetrics::ServeAndDump, this);
+}
+
+RuntimeMetrics::~RuntimeMetrics() {
+  exporter_stopped_ = true;
+  exporter_.join();
+#ifdef OF_PLATFORM_POSIX
+  if (listen_sockfd_ != -1) { close(listen_sockfd_); }
+#endif  // OF_PLATFORM_POSIX
+  // the totals of the whole run stay in the file
+  DumpToFile();
+}
+
+bool RuntimeMetrics::IsEnabled() {
+  const Resource& resource = Global<ResourceDesc, ForSession>::Get()->resource();
+  return resource.metrics_port() > 0 || !resource.metrics_path().empty();
+}
+
+ActorMetrics* RuntimeMetrics::NewActorMetrics(int64_t actor_id, int64_t thrd_id) {
+  std::unique_lock<std::mutex> lck(mutex_);
+  actor_metrics_.emplace_back();
+  ActorMetrics* metrics = &actor_metrics_.back();
+  metrics->actor_id = actor_id;
+  metrics->thrd_id = thrd_id;
+  return metrics;
+}
+
+RegstMetrics* RuntimeMetrics::NewRegstMetrics(int64_t regst_desc_id, int64_t producer,
+                                              int64_t regst_num) {
+  std::unique_lock<std::mutex> lck(mutex_);
+  regst_metrics_.emplace_back();
+  RegstMetrics* metrics = &regst_metrics_.back();
+  metrics->regst_desc_id = regst_desc_id;
+  metrics->producer = producer;
+  metrics->regst_num = regst_num;
+  return metrics;
+}
+
+ThreadMetrics* RuntimeMetrics::NewThreadMetrics(int64_t thrd_id) {
+  std::unique_lock<std::mutex> lck(mutex_);
+  thread_metrics_.emplace_back();
+  ThreadMetrics* metrics = &thread_metrics_.back();
+  metrics->thrd_id = thrd_id;
+  return metrics;
+}
+
+PeerMetrics* RuntimeMetrics::ThreadLocalPeerMetrics(int64_t peer_machine_id) {
+  // keyed by uid, the cells of a previous session are never reused
+  static thread_local int64_t cached_uid = -1;
+  static thread_local HashMap<int64_t, PeerMetrics*> peer2metrics;
+  if (cached_uid != uid_) {
+    cached_uid = uid_;
+    peer2metrics.clear();
+  }
+  auto it = peer2metrics.find(peer_machine_id);
+  if (it == peer2metrics.end()) {
+    std::unique_lock<std::mutex> lck(mutex_);
+    peer_metrics_.emplace_back();
+    peer_metrics_.back().first = peer_machine_id;
+    it = peer2metrics.emplace(peer_machine_id, &peer_metrics_.back().second).first;
+  }
+  return it->second;
+}
+
+std::string RuntimeMetrics::ExportPrometheusText() const {
+  PrometheusWriter writer(this_machine_id_);
+  std::unique_lock<std::mutex> lck(mutex_);
+  writer.Family("oneflow_actor_acts_total", "counter", "Acts of the actor.");
+  for (const ActorMetrics& metrics : actor_metrics_) {
+    writer.Sample({{"actor_id", metrics.actor_id}, {"thrd_id", metrics.thrd_id}},
+                  metrics.act_cnt.Get());
+  }
+  writer.Family("oneflow_actor_busy_seconds_total", "counter",
+                "Seconds the actor thread spent in the acts of the actor.");
+  for (const ActorMetrics& metrics : actor_metrics_) {
+    writer.Sample({{"actor_id", metrics.actor_id}, {"thrd_id", metrics.thrd_id}},
+                  metrics.busy_ns.Get() / 1e9);
+  }
+  writer.Family("oneflow_regst_in_use", "gauge",
+                "Produced regsts of the regst desc not acked by all consumers yet.");
+  for (const RegstMetrics& metrics : regst_metrics_) {
+    writer.Sample({{"regst_desc_id", metrics.regst_desc_id}, {"producer", metrics.producer}},
+                  metrics.in_use.Get());
+  }
+  writer.Family("oneflow_regst_num", "gauge", "Regsts of the regst desc.");
+  for (const RegstMetrics& metrics : regst_metrics_) {
+    writer.Sample({{"regst_desc_id", metrics.regst_desc_id}, {"producer", metrics.producer}},
+                  metrics.regst_num);
+  }
+  writer.Family("oneflow_thread_msgs_total", "counter", "Actor msgs handled by the thread.");
+  for (const ThreadMetrics& metrics : thread_metrics_) {
+    writer.Sample({{"thrd_id", metrics.thrd_id}}, metrics.msg_cnt.Get());
+  }
+  writer.Family("oneflow_thread_mailbox_depth", "gauge",
+                "Actor msgs received by the thread and not handled yet.");
+  for (const ThreadMetrics& metrics : thread_metrics_) {
+    writer.Sample({{"thrd_id", metrics.thrd_id}}, metrics.mailbox_depth.Get());
+  }
+  std::map<int64_t, std::pair<int64_t, int64_t>> peer2msg_cnt_and_byte_size;
+  for (const auto& pair : peer_metrics_) {
+    auto* sum = &peer2msg_cnt_and_byte_size[pair.first];
+    sum->first += pair.second.sent_msg_cnt.Get();
+    sum->second += pair.second.read_byte_size.Get();
+  }
+  writer.Family("oneflow_comm_net_sent_msgs_total", "counter", "Actor msgs sent to the peer.");
+  for (const auto& pair : peer2msg_cnt_and_byte_size) {
+    writer.Sample({{"peer_machine_id", pair.first}}, pair.second.first);
+  }
+  writer.Family("oneflow_comm_net_read_bytes_total", "counter", "Bytes read from the peer.");
+  for (const auto& pair : peer2msg_cnt_and_byte_size) {
+    writer.Sample({{"peer_machine_id", pair.first}}, pair.second.second);
+  }
+  return writer.str();
+}
+
+void RuntimeMetrics::ServeAndDump() {
+  const Resource& resource = Global<ResourceDesc, ForSession>::Get()->resource();
+  const double dump_interval_ns = resource.metrics_dump_interval_ms() * 1e6;
+  double last_dump_time = GetCurTime();
+  while (!exporter_stopped_) {
+#ifdef OF_PLATFORM_POSIX
+    pollfd fd = {listen_sockfd_, POLLIN, 0};
+    if (poll(&fd, listen_sockfd_ == -1 ? 0 : 1, kExporterPollMs) > 0) {
+      const int sockfd = accept(listen_sockfd_, nullptr, nullptr);
+      if (sockfd != -1) {
+        timeval timeout = {};
+        timeout.tv_sec = kExporterIoTimeoutMs / 1000;
+        timeout.tv_usec = (kExporterIoTimeoutMs % 1000) * 1000;
+        PCHECK(setsockopt(sockfd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout)) == 0);
+        PCHECK(setsockopt(sockfd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout)) == 0);
+        // any request gets the metrics, the request itself is not parsed
+        char request[1024];
+        if (recv(sockfd, request, sizeof(request), 0) < 0) {
+          close(sockfd);
+          continue;
+        }
+        const std::string body = ExportPrometheusText();
+        const std::string response =
+            "HTTP/1.0 200 OK\r\nContent-Type: text/plain; version=0.0.4\r\nContent-Length: "
+            + std::to_string(body.size()) + "\r\n\r\n" + body;
+        size_t sent = 0;
+        while (sent < response.size()) {
+          const ssize_t n = send(sockfd, response.data() + sent, response.size() - sent, 0);
+          if (n <= 0) { break; }
+          sent += n;
+        }
+        close(sockfd);
+      }
+    }
+#else
+    std::this_thread::sleep_for(std::chrono::milliseconds(kExporterPollMs));
+#endif  // OF_PLATFORM_POSIX
+    if (GetCurTime() - last_dump_time >= dump_interval_ns) {
+      DumpToFile();
+      last_dump_time = GetCurTime();
+    }
+  }
+}
+
+void RuntimeMetrics::DumpToFile() const {
+  const std::string& path = Global<ResourceDesc, ForSession>::Get()->resource().metrics_path();
+  if (path.empty()) { return; }
+  // written aside and renamed, so that a scraper never reads a partial file
+  const std::string tmp_path = path + ".tmp";
+  {
+    std::ofstream out(tmp_path);
+    out << ExportPrometheusText();
+  }
+  if (std::rename(tmp_path.c_str(), path.c_str()) != 0) {
+    // e.g. the directory is gone, the run goes on without the file
+    static std::once_flag warned;
+    std::call_once(warned, [&] {
+      PLOG(WARNING) << "runtime metrics can not be dumped to " << path
+                    << ", further failures are not logged";
+    });
+  }
+}
+
+}  // namespace oneflow
@@ -0,0 +1,108 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifndef ONEFLOW_CORE_JOB_RUNTIME_METRICS_H_
+#define ONEFLOW_CORE_JOB_RUNTIME_METRICS_H_
+
+#include "oneflow/core/common/util.h"
+
+namespace oneflow {
+
+// A counter or gauge written by one thread only. The writer does a relaxed load and store
+// instead of a locked add and the exporter reads it at any time.
+class MetricCell final {
+ public:
+  OF_DISALLOW_COPY_AND_MOVE(MetricCell);
+  MetricCell() : value_(0) {}
+  ~MetricCell() = default;
+
+  void Add(int64_t val) { Set(Get() + val); }
+  void Set(int64_t val) { value_.store(val, std::memory_order_relaxed); }
+  int64_t Get() const { return value_.load(std::memory_order_relaxed); }
+
+ private:
+  std::atomic<int64_t> value_;
+};
+
+struct RegstMetrics {
+  int64_t regst_desc_id;
+  int64_t producer;
+  int64_t regst_num;
+  // the produced regsts whose consumers have not acked them yet
+  MetricCell in_use;
+};
+
+struct ActorMetrics {
+  int64_t actor_id;
+  int64_t thrd_id;
+  MetricCell act_cnt;
+  MetricCell busy_ns;
+  HashMap<int64_t, RegstMetrics*> regst_desc_id2metrics;
+};
+
+struct ThreadMetrics {
+  int64_t thrd_id;
+  MetricCell msg_cnt;
+  // the msgs taken from the channel and not handled yet
+  MetricCell mailbox_depth;
+};
+
+struct PeerMetrics {
+  MetricCell sent_msg_cnt;
+  MetricCell read_byte_size;
+};
+
+// Live metrics of the runtime on this machine, exported in the Prometheus text format. It is
+// created only if Resource.metrics_port or Resource.metrics_path is set, the actors and threads
+// keep a null metrics pointer otherwise so that they pay a branch and nothing else.
+//
+// Actors and threads register their cells once and update them from their own thread. The cells
+// of the comm net peers are written by any actor thread, so each thread has its own cells and
+// the exporter sums them up.
+class RuntimeMetrics final {
+ public:
+  OF_DISALLOW_COPY_AND_MOVE(RuntimeMetrics);
+  RuntimeMetrics();
+  ~RuntimeMetrics();
+
+  static bool IsEnabled();
+
+  ActorMetrics* NewActorMetrics(int64_t actor_id, int64_t thrd_id);
+  RegstMetrics* NewRegstMetrics(int64_t regst_desc_id, int64_t producer, int64_t regst_num);
+  ThreadMetrics* NewThreadMetrics(int64_t thrd_id);
+  PeerMetrics* ThreadLocalPeerMetrics(int64_t peer_machine_id);
+
+  std::string ExportPrometheusText() const;
+
+ private:
+  void ServeAndDump();
+  void DumpToFile() const;
+
+  const int64_t uid_;
+  const int64_t this_machine_id_;
+  mutable std::mutex mutex_;
+  std::deque<ActorMetrics> actor_metrics_;
+  std::deque<RegstMetrics> regst_metrics_;
+  std::deque<ThreadMetrics> thread_metrics_;
+  std::deque<std::pair<int64_t, PeerMetrics>> peer_metrics_;
+
+  int listen_sockfd_;
+  std::atomic<bool> exporter_stopped_;
+  std::thread exporter_;
+};
+
+}  // namespace oneflow
+
+#endif  // ONEFLOW_CORE_JOB_RUNTIME_METRICS_H_
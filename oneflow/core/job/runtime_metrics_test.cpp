@@ -0,0 +1,81 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/job/runtime_metrics.h"
+#include "oneflow/core/job/global_for.h"
+#include "oneflow/core/job/machine_context.h"
+#include "oneflow/core/job/resource_desc.h"
+
+namespace oneflow {
+
+TEST(RuntimeMetrics, export_prometheus_text) {
+  // neither served nor dumped, only exported
+  Global<ResourceDesc, ForSession>::New(Resource());
+  Global<MachineCtx>::New(1);
+  {
+    RuntimeMetrics metrics;
+    ActorMetrics* actor_metrics = metrics.NewActorMetrics(7, 2);
+    actor_metrics->act_cnt.Add(3);
+    actor_metrics->busy_ns.Add(1500000000);
+    RegstMetrics* regst_metrics = metrics.NewRegstMetrics(11, 7, 4);
+    regst_metrics->in_use.Add(2);
+    regst_metrics->in_use.Add(-1);
+    ThreadMetrics* thread_metrics = metrics.NewThreadMetrics(2);
+    thread_metrics->msg_cnt.Add(9);
+    thread_metrics->mailbox_depth.Set(5);
+    // the cells of each thread are summed up per peer
+    metrics.ThreadLocalPeerMetrics(0)->sent_msg_cnt.Add(1);
+    metrics.ThreadLocalPeerMetrics(0)->read_byte_size.Add(100);
+    std::thread([&]() {
+      metrics.ThreadLocalPeerMetrics(0)->sent_msg_cnt.Add(2);
+      metrics.ThreadLocalPeerMetrics(2)->read_byte_size.Add(24);
+    }).join();
+    ASSERT_EQ(metrics.ExportPrometheusText(),
+              "# HELP oneflow_actor_acts_total Acts of the actor.\n"
+              "# TYPE oneflow_actor_acts_total counter\n"
+              "oneflow_actor_acts_total{machine_id=\"1\",actor_id=\"7\",thrd_id=\"2\"} 3\n"
+              "# HELP oneflow_actor_busy_seconds_total Seconds the actor thread spent in the "
+              "acts of the actor.\n"
+              "# TYPE oneflow_actor_busy_seconds_total counter\n"
+              "oneflow_actor_busy_seconds_total{machine_id=\"1\",actor_id=\"7\",thrd_id=\"2\"} "
+              "1.5\n"
+              "# HELP oneflow_regst_in_use Produced regsts of the regst desc not acked by all "
+              "consumers yet.\n"
+              "# TYPE oneflow_regst_in_use gauge\n"
+              "oneflow_regst_in_use{machine_id=\"1\",regst_desc_id=\"11\",producer=\"7\"} 1\n"
+              "# HELP oneflow_regst_num Regsts of the regst desc.\n"
+              "# TYPE oneflow_regst_num gauge\n"
+              "oneflow_regst_num{machine_id=\"1\",regst_desc_id=\"11\",producer=\"7\"} 4\n"
+              "# HELP oneflow_thread_msgs_total Actor msgs handled by the thread.\n"
+              "# TYPE oneflow_thread_msgs_total counter\n"
+              "oneflow_thread_msgs_total{machine_id=\"1\",thrd_id=\"2\"} 9\n"
+              "# HELP oneflow_thread_mailbox_depth Actor msgs received by the thread and not "
+              "handled yet.\n"
+              "# TYPE oneflow_thread_mailbox_depth gauge\n"
+              "oneflow_thread_mailbox_depth{machine_id=\"1\",thrd_id=\"2\"} 5\n"
+              "# HELP oneflow_comm_net_sent_msgs_total Actor msgs sent to the peer.\n"
+              "# TYPE oneflow_comm_net_sent_msgs_total counter\n"
+              "oneflow_comm_net_sent_msgs_total{machine_id=\"1\",peer_machine_id=\"0\"} 3\n"
+              "oneflow_comm_net_sent_msgs_total{machine_id=\"1\",peer_machine_id=\"2\"} 0\n"
+              "# HELP oneflow_comm_net_read_bytes_total Bytes read from the peer.\n"
+              "# TYPE oneflow_comm_net_read_bytes_total counter\n"
+              "oneflow_comm_net_read_bytes_total{machine_id=\"1\",peer_machine_id=\"0\"} 100\n"
+              "oneflow_comm_net_read_bytes_total{machine_id=\"1\",peer_machine_id=\"2\"} 24\n");
+  }
+  Global<MachineCtx>::Delete();
+  Global<ResourceDesc, ForSession>::Delete();
+}
+
+}  // namespace oneflow
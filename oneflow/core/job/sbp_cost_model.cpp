@@ -0,0 +1,215 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/job/sbp_cost_model.h"
+#include "oneflow/core/job/sbp_parallel.h"
+#include "oneflow/core/common/protobuf.h"
+#include "oneflow/core/register/runtime_register_desc.h"
+
+namespace oneflow {
+
+namespace {
+
+double LogicalByteSize(const BlobDesc& blob_desc) {
+  return static_cast<double>(blob_desc.shape().elem_cnt())
+         * GetSizeOfDataType(blob_desc.data_type());
+}
+
+double ByteSizeOnOneDevice(const BlobDesc& logical_blob_desc, const SbpParallel& sbp_parallel,
+                           int64_t parallel_num) {
+  const double logical_byte_size = LogicalByteSize(logical_blob_desc);
+  if (sbp_parallel.has_split_parallel()) { return logical_byte_size / parallel_num; }
+  return logical_byte_size;
+}
+
+HashMap<int64_t, size_t> MakeRegstDescId2ByteSize(const Plan& plan) {
+  HashMap<int64_t, size_t> regst_desc_id2byte_size;
+  for (const TaskProto& task : plan.task()) {
+    for (const auto& pair : task.produced_regst_desc()) {
+      if (!pair.second.regst_desc_type().has_data_regst_desc()) { continue; }
+      regst_desc_id2byte_size[pair.second.regst_desc_id()] =
+          RtRegstDesc(pair.second).MainByteSize4OneRegst();
+    }
+  }
+  return regst_desc_id2byte_size;
+}
+
+// bytes of one regst of each data regst the task produces or consumes
+double ByteSize4Task(const TaskProto& task,
+                     const HashMap<int64_t, size_t>& regst_desc_id2byte_size) {
+  double byte_size = 0;
+  auto Add = [&](int64_t regst_desc_id) {
+    const auto& iter = regst_desc_id2byte_size.find(regst_desc_id);
+    if (iter != regst_desc_id2byte_size.end()) { byte_size += iter->second; }
+  };
+  for (const auto& pair : task.produced_regst_desc()) { Add(pair.second.regst_desc_id()); }
+  for (const auto& pair : task.consumed_regst_desc_id()) {
+    for (int64_t regst_desc_id : pair.second.regst_desc_id()) { Add(regst_desc_id); }
+  }
+  return byte_size;
+}
+
+}  // namespace
+
+constexpr double SbpCostModel::kInfeasibleCost;
+
+double SbpCostModel::SecPerByte(const OperatorConf& op_conf) const {
+  const auto& iter = conf_.op_type2sec_per_byte().find(OpTypeKey4OpConf(op_conf));
+  if (iter != conf_.op_type2sec_per_byte().end()) { return iter->second; }
+  if (op_conf.device_tag() == "gpu") { return conf_.gpu_sec_per_byte(); }
+  return conf_.cpu_sec_per_byte();
+}
+
+double SbpCostModel::Bandwidth(const ParallelDesc& src_parallel_desc,
+                               const ParallelDesc& dst_parallel_desc) const {
+  if (src_parallel_desc.sorted_machine_ids().size() > 1
+      || src_parallel_desc.sorted_machine_ids() != dst_parallel_desc.sorted_machine_ids()) {
+    return conf_.inter_machine_bandwidth();
+  }
+  return conf_.intra_machine_bandwidth();
+}
+
+double SbpCostModel::ComputeCost(
+    const Operator& op, const ParallelDesc& parallel_desc,
+    const std::function<const BlobDesc&(const std::string&)>& LogicalBlobDesc4BnInOp,
+    const std::function<const SbpParallel&(const std::string&)>& SbpParallel4BnInOp) const {
+  const int64_t parallel_num = parallel_desc.parallel_num();
+  double byte_size = 0;
+  for (const auto& ibn : op.input_bns()) {
+    byte_size += ByteSizeOnOneDevice(LogicalBlobDesc4BnInOp(ibn), SbpParallel4BnInOp(ibn),
+                                     parallel_num);
+  }
+  for (const auto& obn : op.output_bns()) {
+    byte_size += ByteSizeOnOneDevice(LogicalBlobDesc4BnInOp(obn), SbpParallel4BnInOp(obn),
+                                     parallel_num);
+  }
+  return byte_size * SecPerByte(op.op_conf());
+}
+
+double SbpCostModel::MemoryCost(
+    const Operator& op, const ParallelDesc& parallel_desc,
+    const std::function<const BlobDesc&(const std::string&)>& LogicalBlobDesc4BnInOp,
+    const std::function<const SbpParallel&(const std::string&)>& SbpParallel4BnInOp) const {
+  if (conf_.sec_per_memory_byte() == 0) { return 0; }
+  double byte_size = 0;
+  for (const auto& obn : op.output_bns()) {
+    byte_size += ByteSizeOnOneDevice(LogicalBlobDesc4BnInOp(obn), SbpParallel4BnInOp(obn),
+                                     parallel_desc.parallel_num());
+  }
+  return byte_size * conf_.sec_per_memory_byte();
+}
+
+double SbpCostModel::BoxingCost(const BlobDesc& logical_blob_desc,
+                                const ParallelDesc& src_parallel_desc,
+                                const SbpParallel& src_sbp_parallel,
+                                const ParallelDesc& dst_parallel_desc,
+                                const SbpParallel& dst_sbp_parallel) const {
+  const double logical_byte_size = LogicalByteSize(logical_blob_desc);
+  const double bandwidth = Bandwidth(src_parallel_desc, dst_parallel_desc);
+  if (src_parallel_desc == dst_parallel_desc) {
+    const int64_t parallel_num = src_parallel_desc.parallel_num();
+    if (parallel_num == 1 || src_sbp_parallel == dst_sbp_parallel) { return 0; }
+    if (dst_sbp_parallel.has_partial_sum_parallel()) { return kInfeasibleCost; }
+    // each device sends and receives (n - 1) / n of the blob in a ring all-gather
+    const double ring_cost = logical_byte_size * (parallel_num - 1) / parallel_num / bandwidth;
+    if (src_sbp_parallel.has_broadcast_parallel()) { return 0; }
+    if (src_sbp_parallel.has_split_parallel()) {
+      // all-gather, or all-to-all between two split axes
+      if (dst_sbp_parallel.has_broadcast_parallel()) { return ring_cost; }
+      return ring_cost / parallel_num;
+    }
+    // all-reduce, or reduce-scatter
+    if (dst_sbp_parallel.has_broadcast_parallel()) { return 2 * ring_cost; }
+    return ring_cost;
+  }
+  if (dst_sbp_parallel.has_partial_sum_parallel()) { return kInfeasibleCost; }
+  // the busiest device of either side limits the copy between two placements
+  const double send_byte_size = src_sbp_parallel.has_split_parallel()
+                                    ? logical_byte_size / src_parallel_desc.parallel_num()
+                                    : logical_byte_size;
+  const double recv_byte_size = ByteSizeOnOneDevice(logical_blob_desc, dst_sbp_parallel,
+                                                    dst_parallel_desc.parallel_num());
+  return std::max(send_byte_size, recv_byte_size) / bandwidth;
+}
+
+std::string OpTypeKey4OpConf(const OperatorConf& op_conf) {
+  std::string op_type_name;
+  if (op_conf.has_user_conf()) {
+    op_type_name = op_conf.user_conf().op_type_name();
+  } else {
+    op_type_name = OperatorConf::descriptor()->FindFieldByNumber(op_conf.op_type_case())->name();
+  }
+  return op_conf.device_tag() + "/" + op_type_name;
+}
+
+SbpCostModelConf LoadSbpCostModelConf(const std::string& path) {
+  SbpCostModelConf conf;
+  if (!path.empty()) { ParseProtoFromTextFile(path, &conf); }
+  return conf;
+}
+
+void EstimateActTime4Tasks(const Plan& plan, const SbpCostModelConf& conf,
+                           HashMap<int64_t, double>* task_id2act_time) {
+  const SbpCostModel cost_model(conf);
+  const HashMap<int64_t, size_t> regst_desc_id2byte_size = MakeRegstDescId2ByteSize(plan);
+  for (const TaskProto& task : plan.task()) {
+    double act_time = conf.sec_per_act();
+    if (task.task_type() == TaskType::kCopyCommNet) {
+      // only the produced regst is counted, the consumed one holds the same bytes
+      double byte_size = 0;
+      for (const auto& pair : task.produced_regst_desc()) {
+        const auto& iter = regst_desc_id2byte_size.find(pair.second.regst_desc_id());
+        if (iter != regst_desc_id2byte_size.end()) { byte_size += iter->second; }
+      }
+      act_time += byte_size / conf.inter_machine_bandwidth();
+    } else if (task.exec_sequence().exec_node_size() > 0) {
+      const OperatorConf& op_conf =
+          task.exec_sequence().exec_node(0).kernel_conf().op_attribute().op_conf();
+      act_time += ByteSize4Task(task, regst_desc_id2byte_size) * cost_model.SecPerByte(op_conf);
+    }
+    (*task_id2act_time)[task.task_id()] = act_time;
+  }
+}
+
+void CalibrateSbpCostModelConf(const Plan& plan, const std::list<std::unique_ptr<ActEvent>>& events,
+                               SbpCostModelConf* conf) {
+  HashMap<int64_t, std::pair<double, int64_t>> actor_id2total_sec_and_act_cnt;
+  for (const auto& event : events) {
+    auto* total_sec_and_act_cnt = &actor_id2total_sec_and_act_cnt[event->actor_id()];
+    total_sec_and_act_cnt->first += (event->stop_time() - event->start_time()) / 1e9;
+    total_sec_and_act_cnt->second += 1;
+  }
+  const HashMap<int64_t, size_t> regst_desc_id2byte_size = MakeRegstDescId2ByteSize(plan);
+  HashMap<std::string, std::pair<double, double>> op_type_key2total_sec_and_byte_size;
+  for (const TaskProto& task : plan.task()) {
+    if (task.task_type() != TaskType::kNormalForward) { continue; }
+    if (task.exec_sequence().exec_node_size() != 1) { continue; }
+    const auto& iter = actor_id2total_sec_and_act_cnt.find(task.task_id());
+    if (iter == actor_id2total_sec_and_act_cnt.end()) { continue; }
+    const double byte_size = ByteSize4Task(task, regst_desc_id2byte_size);
+    if (byte_size == 0) { continue; }
+    const OperatorConf& op_conf =
+        task.exec_sequence().exec_node(0).kernel_conf().op_attribute().op_conf();
+    auto* total_sec_and_byte_size = &op_type_key2total_sec_and_byte_size[OpTypeKey4OpConf(op_conf)];
+    total_sec_and_byte_size->first += iter->second.first / iter->second.second;
+    total_sec_and_byte_size->second += byte_size;
+  }
+  auto* op_type2sec_per_byte = conf->mutable_op_type2sec_per_byte();
+  for (const auto& pair : op_type_key2total_sec_and_byte_size) {
+    (*op_type2sec_per_byte)[pair.first] = pair.second.first / pair.second.second;
+  }
+}
+
+}  // namespace oneflow
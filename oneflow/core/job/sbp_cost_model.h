@@ -0,0 +1,79 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifndef ONEFLOW_CORE_JOB_SBP_COST_MODEL_H_
+#define ONEFLOW_CORE_JOB_SBP_COST_MODEL_H_
+
+#include "oneflow/core/job/sbp_cost_model.pb.h"
+#include "oneflow/core/job/parallel_desc.h"
+#include "oneflow/core/job/plan.pb.h"
+#include "oneflow/core/operator/operator.h"
+#include "oneflow/core/register/blob_desc.h"
+#include "oneflow/core/actor/act_event.pb.h"
+
+namespace oneflow {
+
+// Estimates in seconds per piece what an sbp signature costs an op and its blobs
+class SbpCostModel final {
+ public:
+  OF_DISALLOW_COPY_AND_MOVE(SbpCostModel);
+  explicit SbpCostModel(const SbpCostModelConf& conf) : conf_(conf) {}
+  ~SbpCostModel() = default;
+
+  // time one device spends on its part of the inputs and outputs
+  double ComputeCost(
+      const Operator& op, const ParallelDesc& parallel_desc,
+      const std::function<const BlobDesc&(const std::string&)>& LogicalBlobDesc4BnInOp,
+      const std::function<const SbpParallel&(const std::string&)>& SbpParallel4BnInOp) const;
+  // price of the device memory held by the outputs
+  double MemoryCost(
+      const Operator& op, const ParallelDesc& parallel_desc,
+      const std::function<const BlobDesc&(const std::string&)>& LogicalBlobDesc4BnInOp,
+      const std::function<const SbpParallel&(const std::string&)>& SbpParallel4BnInOp) const;
+  // time of the boxing between a producer and a consumer, ring collectives within a placement
+  double BoxingCost(const BlobDesc& logical_blob_desc, const ParallelDesc& src_parallel_desc,
+                    const SbpParallel& src_sbp_parallel, const ParallelDesc& dst_parallel_desc,
+                    const SbpParallel& dst_sbp_parallel) const;
+
+  // seconds an op of op_conf takes per byte of its inputs and outputs on one device
+  double SecPerByte(const OperatorConf& op_conf) const;
+
+  // boxing to a partial consumer is never done, it is finite so that the search still compares
+  static constexpr double kInfeasibleCost = 1e6;
+
+ private:
+  double Bandwidth(const ParallelDesc& src_parallel_desc,
+                   const ParallelDesc& dst_parallel_desc) const;
+
+  SbpCostModelConf conf_;
+};
+
+// "<device tag>/<op type name>", the key of SbpCostModelConf.op_type2sec_per_byte
+std::string OpTypeKey4OpConf(const OperatorConf& op_conf);
+
+// the default conf when path is empty
+SbpCostModelConf LoadSbpCostModelConf(const std::string& path);
+
+// Estimates the seconds of one act of each task of plan, keyed by task id
+void EstimateActTime4Tasks(const Plan& plan, const SbpCostModelConf& conf,
+                           HashMap<int64_t, double>* task_id2act_time);
+
+// Fits op_type2sec_per_byte to the act events of the single op compute tasks of plan
+void CalibrateSbpCostModelConf(const Plan& plan, const std::list<std::unique_ptr<ActEvent>>& events,
+                               SbpCostModelConf* conf);
+
+}  // namespace oneflow
+
+#endif  // ONEFLOW_CORE_JOB_SBP_COST_MODEL_H_
@@ -0,0 +1,94 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/job/sbp_cost_model.h"
+#include "oneflow/core/job/global_for.h"
+#include "oneflow/core/job/resource_desc.h"
+
+namespace oneflow {
+
+namespace {
+
+ParallelDesc GpuParallelDesc(const std::string& device_name) {
+  ParallelConf parallel_conf;
+  parallel_conf.set_device_tag("gpu");
+  parallel_conf.add_device_name(device_name);
+  return ParallelDesc(parallel_conf);
+}
+
+SbpParallel Split(int64_t axis) {
+  SbpParallel sbp_parallel;
+  sbp_parallel.mutable_split_parallel()->set_axis(axis);
+  return sbp_parallel;
+}
+
+SbpParallel Broadcast() {
+  SbpParallel sbp_parallel;
+  sbp_parallel.mutable_broadcast_parallel();
+  return sbp_parallel;
+}
+
+SbpParallel PartialSum() {
+  SbpParallel sbp_parallel;
+  sbp_parallel.mutable_partial_sum_parallel();
+  return sbp_parallel;
+}
+
+}  // namespace
+
+TEST(SbpCostModel, boxing_cost) {
+  Resource resource;
+  resource.set_machine_num(2);
+  resource.set_gpu_device_num(4);
+  Global<ResourceDesc, ForSession>::New(resource);
+  {
+    SbpCostModelConf conf;
+    conf.set_intra_machine_bandwidth(1e10);
+    conf.set_inter_machine_bandwidth(1e9);
+    const SbpCostModel cost_model(conf);
+    // 4096 bytes
+    const BlobDesc blob_desc(Shape({64, 16}), DataType::kFloat);
+    const ParallelDesc four_gpus = GpuParallelDesc("0:0-3");
+    const ParallelDesc two_gpus = GpuParallelDesc("0:0-1");
+    const ParallelDesc one_gpu = GpuParallelDesc("0:0");
+    const ParallelDesc other_machine = GpuParallelDesc("1:0-1");
+    auto Cost = [&](const ParallelDesc& src_parallel_desc, const SbpParallel& src_sbp_parallel,
+                    const ParallelDesc& dst_parallel_desc, const SbpParallel& dst_sbp_parallel) {
+      return cost_model.BoxingCost(blob_desc, src_parallel_desc, src_sbp_parallel,
+                                   dst_parallel_desc, dst_sbp_parallel);
+    };
+    // each of the 4 devices sends and receives 3 / 4 of the blob in a ring
+    const double ring_cost = 4096.0 * 3 / 4 / 1e10;
+    ASSERT_DOUBLE_EQ(Cost(four_gpus, Split(0), four_gpus, Split(0)), 0);
+    ASSERT_DOUBLE_EQ(Cost(one_gpu, Split(0), one_gpu, Broadcast()), 0);
+    ASSERT_DOUBLE_EQ(Cost(four_gpus, Broadcast(), four_gpus, Split(1)), 0);
+    ASSERT_DOUBLE_EQ(Cost(four_gpus, Split(0), four_gpus, Broadcast()), ring_cost);
+    ASSERT_DOUBLE_EQ(Cost(four_gpus, Split(0), four_gpus, Split(1)), ring_cost / 4);
+    ASSERT_DOUBLE_EQ(Cost(four_gpus, PartialSum(), four_gpus, Broadcast()), 2 * ring_cost);
+    ASSERT_DOUBLE_EQ(Cost(four_gpus, PartialSum(), four_gpus, Split(0)), ring_cost);
+    ASSERT_DOUBLE_EQ(Cost(four_gpus, Split(0), four_gpus, PartialSum()),
+                     SbpCostModel::kInfeasibleCost);
+    ASSERT_DOUBLE_EQ(Cost(four_gpus, Split(0), two_gpus, PartialSum()),
+                     SbpCostModel::kInfeasibleCost);
+    // the two devices receiving the whole blob are the busiest
+    ASSERT_DOUBLE_EQ(Cost(four_gpus, Split(0), two_gpus, Broadcast()), 4096 / 1e10);
+    ASSERT_DOUBLE_EQ(Cost(two_gpus, PartialSum(), four_gpus, Split(0)), 4096 / 1e10);
+    ASSERT_DOUBLE_EQ(Cost(four_gpus, Split(0), two_gpus, Split(0)), 2048 / 1e10);
+    ASSERT_DOUBLE_EQ(Cost(two_gpus, Split(0), other_machine, Split(0)), 2048 / 1e9);
+  }
+  Global<ResourceDesc, ForSession>::Delete();
+}
+
+}  // namespace oneflow
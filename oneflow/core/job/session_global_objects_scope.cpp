@@ -58,10 +58,14 @@ void PushAvailableMemDescOfThisMachine() {
 
 AvailableMemDesc PullAvailableMemDesc() {
   AvailableMemDesc ret;
-  AvailableMemDescOfMachine machine_amd_i;
+  std::vector<std::string> keys;
   FOR_RANGE(int64_t, i, 0, (Global<ResourceDesc, ForSession>::Get()->TotalMachineNum())) {
-    Global<CtrlClient>::Get()->PullKV(GetAmdCtrlKey(i), ret.add_machine_amd());
+    keys.push_back(GetAmdCtrlKey(i));
   }
+  // one rpc per ctrl server instead of one per machine
+  std::vector<std::string> vals;
+  Global<CtrlClient>::Get()->PullKVs(keys, &vals);
+  for (const std::string& val : vals) { ret.add_machine_amd()->ParseFromString(val); }
   return ret;
 }
 
@@ -0,0 +1,229 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/job_rewriter/op_graph_pass.h"
+#include "oneflow/core/job_rewriter/sbp_candidate_graph.h"
+#include "oneflow/core/job/sbp_cost_model.h"
+#include "oneflow/core/job/sbp_parallel.h"
+#include "oneflow/core/persistence/tee_persistent_log_stream.h"
+
+namespace oneflow {
+
+namespace {
+
+struct SbpNode {
+  const OpNode* op_node;
+  // the sbp signature inferred greedily by OpGraph is always the first candidate
+  std::vector<SbpSignature> candidates;
+  std::vector<double> compute_costs;
+  std::vector<double> memory_costs;
+  // ops other than multi device user ops keep the sbp signature OpGraph inferred
+  bool is_fixed;
+};
+
+// Picks the sbp signatures of all ops together, the greedy inference of OpGraph only looks at
+// the producers of an op
+class SbpSearch final {
+ public:
+  OF_DISALLOW_COPY_AND_MOVE(SbpSearch);
+  SbpSearch(const OpGraph& op_graph, const SbpCostModel& cost_model)
+      : op_graph_(op_graph), cost_model_(cost_model) {}
+  ~SbpSearch() = default;
+
+  Maybe<void> Init(const Job& job);
+  void Run() { candidate_graph_.Search(); }
+  void GenReport(AutoSbpReport* report) const;
+  void UpdateJobParallelViewConf(JobParallelViewConf* job_parallel_view_conf) const;
+
+ private:
+  Maybe<void> InitNode(const OpNode* op_node, bool is_free, const SbpSignature& sbp_sig_conf,
+                       SbpNode* node) const;
+  void InitEdges();
+  const SbpParallel& SbpParallel4Bn(const SbpNode& node, int64_t index,
+                                    const std::string& bn) const;
+
+  const OpGraph& op_graph_;
+  const SbpCostModel& cost_model_;
+  // the node ids of candidate_graph_ are the indexes of nodes_
+  std::vector<SbpNode> nodes_;
+  HashMap<const OpNode*, int64_t> op_node2index_;
+  SbpCandidateGraph candidate_graph_;
+};
+
+Maybe<void> SbpSearch::Init(const Job& job) {
+  HashSet<std::string> op_names_with_identical_sbp;
+  for (const auto& pair : job.helper().identical_sbp_oba_pairs().pair()) {
+    op_names_with_identical_sbp.insert(pair.first().op_name());
+    op_names_with_identical_sbp.insert(pair.second().op_name());
+  }
+  const JobParallelViewConf& job_parallel_view_conf = job.job_parallel_view_conf();
+  std::vector<const OpNode*> op_nodes;
+  op_graph_.TopoForEachNode([&](const OpNode* op_node) { op_nodes.push_back(op_node); });
+  nodes_.resize(op_nodes.size());
+  FOR_RANGE(int64_t, i, 0, op_nodes.size()) {
+    const OpNode* op_node = op_nodes.at(i);
+    const std::string& op_name = op_node->op().op_name();
+    op_node2index_[op_node] = i;
+    bool is_free = op_node->op().op_conf().has_user_conf()
+                   && op_node->parallel_desc().parallel_num() > 1
+                   && op_names_with_identical_sbp.count(op_name) == 0;
+    const auto& op_name2is_mirrored = job_parallel_view_conf.op_name2is_mirrored_parallel_view();
+    const auto& mirrored_iter = op_name2is_mirrored.find(op_name);
+    if (mirrored_iter != op_name2is_mirrored.end() && mirrored_iter->second) { is_free = false; }
+    SbpSignature sbp_sig_conf;
+    const auto& op_name2sbp_sig_conf = job_parallel_view_conf.op_name2sbp_signature_conf();
+    const auto& conf_iter = op_name2sbp_sig_conf.find(op_name);
+    if (conf_iter != op_name2sbp_sig_conf.end()) { sbp_sig_conf = conf_iter->second; }
+    SbpNode* node = &nodes_.at(i);
+    JUST(InitNode(op_node, is_free, sbp_sig_conf, node));
+    std::vector<double> candidate_costs;
+    FOR_RANGE(int64_t, c, 0, node->candidates.size()) {
+      candidate_costs.push_back(node->compute_costs.at(c) + node->memory_costs.at(c));
+    }
+    CHECK_EQ_OR_RETURN(candidate_graph_.AddNode(candidate_costs, node->is_fixed), i);
+  }
+  InitEdges();
+  return Maybe<void>::Ok();
+}
+
+Maybe<void> SbpSearch::InitNode(const OpNode* op_node, bool is_free,
+                                const SbpSignature& sbp_sig_conf, SbpNode* node) const {
+  const Operator& op = op_node->op();
+  node->op_node = op_node;
+  node->is_fixed = true;
+  node->candidates.push_back(op_node->sbp_signature());
+  if (is_free) {
+    auto LogicalBlobDesc4Ibn = [&](const std::string& ibn) -> Maybe<const BlobDesc&> {
+      return op_node->LogicalBlobDesc4Lbi(op.BnInOp2Lbi(ibn));
+    };
+    SbpSignatureList sbp_sig_list;
+    JUST(op.GetSbpSignaturesIf(LogicalBlobDesc4Ibn, op_node->parallel_desc(), &sbp_sig_list));
+    SbpSignatureList filtered_sbp_sig_list;
+    FilterSbpSignatureList(sbp_sig_list, sbp_sig_conf, &filtered_sbp_sig_list);
+    for (const SbpSignature& sbp_signature : filtered_sbp_sig_list.sbp_signature()) {
+      if (sbp_signature == op_node->sbp_signature()) { continue; }
+      node->candidates.push_back(sbp_signature);
+    }
+    node->is_fixed = node->candidates.size() == 1;
+  }
+  auto LogicalBlobDesc4BnInOp = [&](const std::string& bn) -> const BlobDesc& {
+    return op_node->LogicalBlobDesc4Lbi(op.BnInOp2Lbi(bn));
+  };
+  FOR_RANGE(int64_t, i, 0, node->candidates.size()) {
+    auto SbpParallel4BnInOp = [&](const std::string& bn) -> const SbpParallel& {
+      return SbpParallel4Bn(*node, i, bn);
+    };
+    node->compute_costs.push_back(cost_model_.ComputeCost(
+        op, op_node->parallel_desc(), LogicalBlobDesc4BnInOp, SbpParallel4BnInOp));
+    node->memory_costs.push_back(cost_model_.MemoryCost(
+        op, op_node->parallel_desc(), LogicalBlobDesc4BnInOp, SbpParallel4BnInOp));
+  }
+  return Maybe<void>::Ok();
+}
+
+void SbpSearch::InitEdges() {
+  op_graph_.ForEachEdge([&](const OpEdge* edge) {
+    const int64_t src_index = op_node2index_.at(edge->src_node());
+    const int64_t dst_index = op_node2index_.at(edge->dst_node());
+    const SbpNode& src = nodes_.at(src_index);
+    const SbpNode& dst = nodes_.at(dst_index);
+    const int64_t dst_candidate_num = dst.candidates.size();
+    std::vector<double> costs(src.candidates.size() * dst_candidate_num, 0);
+    FOR_RANGE(int64_t, i, 0, src.candidates.size()) {
+      FOR_RANGE(int64_t, j, 0, dst_candidate_num) {
+        double cost = 0;
+        for (const LogicalBlobId& lbi : edge->lbis()) {
+          const std::string& obn = edge->lbi2obn().at(lbi);
+          const BlobDesc& logical_blob_desc = edge->src_node()->LogicalBlobDesc4Lbi(lbi);
+          for (const std::string& ibn : edge->lbi2ibns().at(lbi)) {
+            cost += cost_model_.BoxingCost(
+                logical_blob_desc, edge->src_node()->parallel_desc(), SbpParallel4Bn(src, i, obn),
+                edge->dst_node()->parallel_desc(), SbpParallel4Bn(dst, j, ibn));
+          }
+        }
+        costs.at(i * dst_candidate_num + j) = cost;
+      }
+    }
+    candidate_graph_.AddEdge(src_index, dst_index, costs);
+  });
+}
+
+const SbpParallel& SbpSearch::SbpParallel4Bn(const SbpNode& node, int64_t index,
+                                             const std::string& bn) const {
+  if (node.is_fixed) { return node.op_node->SbpParallel4BnInOp(bn); }
+  return node.candidates.at(index).bn_in_op2sbp_parallel().at(bn);
+}
+
+void SbpSearch::GenReport(AutoSbpReport* report) const {
+  report->set_greedy_cost(candidate_graph_.TotalCost(true));
+  report->set_chosen_cost(candidate_graph_.TotalCost(false));
+  FOR_RANGE(int64_t, node_id, 0, nodes_.size()) {
+    const SbpNode& node = nodes_.at(node_id);
+    if (node.is_fixed) { continue; }
+    AutoSbpOpReport* op_report = report->add_op();
+    op_report->set_op_name(node.op_node->op().op_name());
+    FOR_RANGE(int64_t, i, 0, node.candidates.size()) {
+      SbpCandidateCost* candidate = op_report->add_candidate();
+      *candidate->mutable_sbp_signature() = node.candidates.at(i);
+      candidate->set_compute_cost(node.compute_costs.at(i));
+      candidate->set_memory_cost(node.memory_costs.at(i));
+      candidate->set_boxing_cost(candidate_graph_.BoxingCost(node_id, i));
+    }
+    op_report->set_greedy_candidate_index(0);
+    op_report->set_chosen_candidate_index(candidate_graph_.chosen_index(node_id));
+  }
+}
+
+void SbpSearch::UpdateJobParallelViewConf(JobParallelViewConf* job_parallel_view_conf) const {
+  auto* op_name2sbp_signature_conf = job_parallel_view_conf->mutable_op_name2sbp_signature_conf();
+  // every searched op is pinned, the greedy inference would otherwise revise the unchanged ones
+  // after their producers changed
+  FOR_RANGE(int64_t, node_id, 0, nodes_.size()) {
+    const SbpNode& node = nodes_.at(node_id);
+    if (node.is_fixed) { continue; }
+    (*op_name2sbp_signature_conf)[node.op_node->op().op_name()] =
+        node.candidates.at(candidate_graph_.chosen_index(node_id));
+  }
+}
+
+class AutoSbpPass final : public OpGraphPass {
+ public:
+  OF_DISALLOW_COPY_AND_MOVE(AutoSbpPass);
+  AutoSbpPass() = default;
+  ~AutoSbpPass() override = default;
+  bool IsEnabled() const override { return GlobalJobDesc().enable_auto_sbp(); }
+  Maybe<void> Apply(const OpGraph& op_graph, Job* job) const override;
+};
+
+Maybe<void> AutoSbpPass::Apply(const OpGraph& op_graph, Job* job) const {
+  const SbpCostModel cost_model(LoadSbpCostModelConf(GlobalJobDesc().sbp_cost_model_path()));
+  SbpSearch search(op_graph, cost_model);
+  JUST(search.Init(*job));
+  search.Run();
+  AutoSbpReport report;
+  search.GenReport(&report);
+  LOG(INFO) << "auto sbp of job " << GlobalJobDesc().job_name()
+            << ", estimated cost of the greedy sbp signatures: " << report.greedy_cost()
+            << "s, of the chosen ones: " << report.chosen_cost() << "s";
+  TeePersistentLogStream::Create("auto_sbp_report_" + GlobalJobDesc().job_name())->Write(report);
+  search.UpdateJobParallelViewConf(job->mutable_job_parallel_view_conf());
+  return Maybe<void>::Ok();
+}
+
+}  // namespace
+
+REGISTER_FUNCTION_PASS("AutoSbpPass", AutoSbpPass);
+
+}  // namespace oneflow
@@ -112,8 +112,8 @@ void JobCompleter::Complete(Job* job) const {
 #ifdef OF_WITH_XRT
     WithOpGraphAndMutJob(job, &RebuildXrtCompiledJob);
 #else
-    LOG(WARNING) << "It will not use XLA or TensorRT since WITH_XLA or "
-                    "WITH_TENSORRT was not enabled when compiling the project.";
+    LOG(WARNING) << "It will not use XLA, TensorRT or the native engine since WITH_XLA, "
+                    "WITH_TENSORRT or WITH_XRT_NATIVE was not enabled when compiling the project.";
 #endif  // OF_WITH_XRT
   }
   CheckOpGraph(OpGraph(*job));
@@ -0,0 +1,151 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/job_rewriter/sbp_candidate_graph.h"
+
+namespace oneflow {
+
+int64_t SbpCandidateGraph::AddNode(const std::vector<double>& candidate_costs, bool is_fixed) {
+  CHECK(!candidate_costs.empty());
+  nodes_.emplace_back();
+  Node* node = &nodes_.back();
+  node->costs = candidate_costs;
+  node->is_fixed = is_fixed || candidate_costs.size() == 1;
+  node->chosen_index = 0;
+  return nodes_.size() - 1;
+}
+
+void SbpCandidateGraph::AddEdge(int64_t src, int64_t dst, const std::vector<double>& costs) {
+  CHECK_EQ(costs.size(), nodes_.at(src).costs.size() * nodes_.at(dst).costs.size());
+  nodes_.at(src).out_edges.push_back(edges_.size());
+  nodes_.at(dst).in_edges.push_back(edges_.size());
+  edges_.push_back(Edge{src, dst, costs});
+}
+
+void SbpCandidateGraph::InitChains() {
+  auto IsChainEdge = [&](int64_t edge) {
+    const Node& src = nodes_.at(edges_.at(edge).src);
+    const Node& dst = nodes_.at(edges_.at(edge).dst);
+    return !src.is_fixed && !dst.is_fixed && src.out_edges.size() == 1
+           && dst.in_edges.size() == 1;
+  };
+  chains_.clear();
+  FOR_RANGE(int64_t, i, 0, nodes_.size()) {
+    const Node& node = nodes_.at(i);
+    if (node.is_fixed) { continue; }
+    if (node.in_edges.size() == 1 && IsChainEdge(node.in_edges.front())) { continue; }
+    std::vector<int64_t> chain{i};
+    while (nodes_.at(chain.back()).out_edges.size() == 1
+           && IsChainEdge(nodes_.at(chain.back()).out_edges.front())) {
+      chain.push_back(edges_.at(nodes_.at(chain.back()).out_edges.front()).dst);
+    }
+    chains_.push_back(chain);
+  }
+}
+
+double SbpCandidateGraph::EdgeCost(int64_t edge, int64_t src_index, int64_t dst_index) const {
+  const Edge& e = edges_.at(edge);
+  return e.costs.at(src_index * nodes_.at(e.dst).costs.size() + dst_index);
+}
+
+double SbpCandidateGraph::BoxingCost(const Node& node, int64_t index, bool skip_in_edge,
+                                     bool skip_out_edge) const {
+  double cost = 0;
+  if (!skip_in_edge) {
+    for (int64_t edge : node.in_edges) {
+      cost += EdgeCost(edge, nodes_.at(edges_.at(edge).src).chosen_index, index);
+    }
+  }
+  if (!skip_out_edge) {
+    for (int64_t edge : node.out_edges) {
+      cost += EdgeCost(edge, index, nodes_.at(edges_.at(edge).dst).chosen_index);
+    }
+  }
+  return cost;
+}
+
+bool SbpCandidateGraph::OptimizeChain(const std::vector<int64_t>& chain) {
+  const int64_t chain_size = chain.size();
+  // min_costs[i][c] is the min cost of chain[0..i] with chain[i] choosing candidate c
+  std::vector<std::vector<double>> min_costs(chain_size);
+  std::vector<std::vector<int64_t>> prev_indexes(chain_size);
+  FOR_RANGE(int64_t, i, 0, chain_size) {
+    const Node& node = nodes_.at(chain.at(i));
+    const int64_t candidate_num = node.costs.size();
+    min_costs.at(i).resize(candidate_num);
+    prev_indexes.at(i).resize(candidate_num);
+    FOR_RANGE(int64_t, c, 0, candidate_num) {
+      // edges inside the chain are counted by the transition, the others against the current
+      // choices of the neighbours
+      const double unary_cost = node.costs.at(c) + BoxingCost(node, c, i > 0, i < chain_size - 1);
+      if (i == 0) {
+        min_costs.at(i).at(c) = unary_cost;
+        continue;
+      }
+      const Node& prev = nodes_.at(chain.at(i - 1));
+      const int64_t edge = node.in_edges.front();
+      // ties keep the current choice so that sweeps converge
+      int64_t best_prev_index = prev.chosen_index;
+      double best_cost =
+          min_costs.at(i - 1).at(best_prev_index) + EdgeCost(edge, best_prev_index, c);
+      FOR_RANGE(int64_t, p, 0, prev.costs.size()) {
+        const double cost = min_costs.at(i - 1).at(p) + EdgeCost(edge, p, c);
+        if (cost < best_cost) {
+          best_cost = cost;
+          best_prev_index = p;
+        }
+      }
+      min_costs.at(i).at(c) = best_cost + unary_cost;
+      prev_indexes.at(i).at(c) = best_prev_index;
+    }
+  }
+  const std::vector<double>& last_min_costs = min_costs.back();
+  int64_t index = nodes_.at(chain.back()).chosen_index;
+  FOR_RANGE(int64_t, c, 0, last_min_costs.size()) {
+    if (last_min_costs.at(c) < last_min_costs.at(index)) { index = c; }
+  }
+  bool changed = false;
+  for (int64_t i = chain_size - 1; i >= 0; --i) {
+    Node* node = &nodes_.at(chain.at(i));
+    if (node->chosen_index != index) {
+      node->chosen_index = index;
+      changed = true;
+    }
+    if (i > 0) { index = prev_indexes.at(i).at(index); }
+  }
+  return changed;
+}
+
+void SbpCandidateGraph::Search() {
+  InitChains();
+  const int64_t max_sweep_num = 16;
+  FOR_RANGE(int64_t, sweep, 0, max_sweep_num) {
+    bool changed = false;
+    for (const auto& chain : chains_) { changed |= OptimizeChain(chain); }
+    if (!changed) { break; }
+  }
+}
+
+double SbpCandidateGraph::TotalCost(bool is_greedy) const {
+  auto Index4Node = [&](int64_t node) { return is_greedy ? 0 : nodes_.at(node).chosen_index; };
+  double cost = 0;
+  FOR_RANGE(int64_t, i, 0, nodes_.size()) { cost += nodes_.at(i).costs.at(Index4Node(i)); }
+  FOR_RANGE(int64_t, i, 0, edges_.size()) {
+    cost += EdgeCost(i, Index4Node(edges_.at(i).src), Index4Node(edges_.at(i).dst));
+  }
+  return cost;
+}
+
+}  // namespace oneflow
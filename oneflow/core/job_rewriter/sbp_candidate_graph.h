@@ -0,0 +1,73 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifndef ONEFLOW_CORE_JOB_REWRITER_SBP_CANDIDATE_GRAPH_H_
+#define ONEFLOW_CORE_JOB_REWRITER_SBP_CANDIDATE_GRAPH_H_
+
+#include "oneflow/core/common/util.h"
+
+namespace oneflow {
+
+// The ops of a job with a cost for each of their candidate sbp signatures and the edges between
+// them with a cost for each pair of candidates of their ends. Chains of nodes are solved exactly
+// by dynamic programming, sweeps over the chains until no choice changes handle the rest of the
+// graph.
+class SbpCandidateGraph final {
+ public:
+  OF_DISALLOW_COPY_AND_MOVE(SbpCandidateGraph);
+  SbpCandidateGraph() = default;
+  ~SbpCandidateGraph() = default;
+
+  // returns the id of the node, its first candidate is the greedy one, which a fixed node keeps
+  int64_t AddNode(const std::vector<double>& candidate_costs, bool is_fixed);
+  // costs are row major, src candidates by dst candidates
+  void AddEdge(int64_t src, int64_t dst, const std::vector<double>& costs);
+  void Search();
+
+  int64_t chosen_index(int64_t node) const { return nodes_.at(node).chosen_index; }
+  double TotalCost(bool is_greedy) const;
+  // the costs of the edges of the node with the candidate against the choices of its neighbours
+  double BoxingCost(int64_t node, int64_t index) const {
+    return BoxingCost(nodes_.at(node), index, false, false);
+  }
+
+ private:
+  struct Node {
+    std::vector<double> costs;
+    bool is_fixed;
+    std::vector<int64_t> in_edges;
+    std::vector<int64_t> out_edges;
+    int64_t chosen_index;
+  };
+  struct Edge {
+    int64_t src;
+    int64_t dst;
+    std::vector<double> costs;
+  };
+
+  void InitChains();
+  double EdgeCost(int64_t edge, int64_t src_index, int64_t dst_index) const;
+  double BoxingCost(const Node& node, int64_t index, bool skip_in_edge, bool skip_out_edge) const;
+  // returns whether the chosen candidates changed
+  bool OptimizeChain(const std::vector<int64_t>& chain);
+
+  std::vector<Node> nodes_;
+  std::vector<Edge> edges_;
+  std::vector<std::vector<int64_t>> chains_;
+};
+
+}  // namespace oneflow
+
+#endif  // ONEFLOW_CORE_JOB_REWRITER_SBP_CANDIDATE_GRAPH_H_
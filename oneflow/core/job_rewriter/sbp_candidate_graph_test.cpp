@@ -0,0 +1,79 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/job_rewriter/sbp_candidate_graph.h"
+
+namespace oneflow {
+
+namespace {
+
+// the candidates of the ends of an edge of two candidates each are compatible if equal
+const std::vector<double> kSwitchCosts = {0, 10, 10, 0};
+
+}  // namespace
+
+TEST(SbpCandidateGraph, solve_chain_exactly) {
+  // choosing the second candidate only pays off if the whole chain switches to it
+  SbpCandidateGraph graph;
+  const int64_t a = graph.AddNode({1, 2}, false);
+  const int64_t b = graph.AddNode({1, 1}, false);
+  const int64_t c = graph.AddNode({5, 0}, false);
+  graph.AddEdge(a, b, kSwitchCosts);
+  graph.AddEdge(b, c, kSwitchCosts);
+  graph.Search();
+  ASSERT_EQ(graph.chosen_index(a), 1);
+  ASSERT_EQ(graph.chosen_index(b), 1);
+  ASSERT_EQ(graph.chosen_index(c), 1);
+  ASSERT_DOUBLE_EQ(graph.TotalCost(true), 7);
+  ASSERT_DOUBLE_EQ(graph.TotalCost(false), 3);
+}
+
+TEST(SbpCandidateGraph, sweep_over_chains) {
+  // the fixed source fans out to b and c, which join at d, so each free node is a chain of its
+  // own. d switches in the first sweep, b and c follow it in the second.
+  SbpCandidateGraph graph;
+  const int64_t a = graph.AddNode({1, 0}, true);
+  const int64_t b = graph.AddNode({3, 0}, false);
+  const int64_t c = graph.AddNode({3, 0}, false);
+  const int64_t d = graph.AddNode({30, 0}, false);
+  graph.AddEdge(a, b, {0, 0});
+  graph.AddEdge(a, c, {0, 0});
+  graph.AddEdge(b, d, kSwitchCosts);
+  graph.AddEdge(c, d, kSwitchCosts);
+  ASSERT_DOUBLE_EQ(graph.BoxingCost(b, 1), 10);
+  graph.Search();
+  ASSERT_EQ(graph.chosen_index(a), 0);
+  ASSERT_EQ(graph.chosen_index(b), 1);
+  ASSERT_EQ(graph.chosen_index(c), 1);
+  ASSERT_EQ(graph.chosen_index(d), 1);
+  ASSERT_DOUBLE_EQ(graph.TotalCost(true), 37);
+  ASSERT_DOUBLE_EQ(graph.TotalCost(false), 1);
+  ASSERT_DOUBLE_EQ(graph.BoxingCost(b, 0), 10);
+  ASSERT_DOUBLE_EQ(graph.BoxingCost(b, 1), 0);
+}
+
+TEST(SbpCandidateGraph, keep_greedy_candidate_on_tie) {
+  SbpCandidateGraph graph;
+  const int64_t a = graph.AddNode({2, 1, 2}, false);
+  const int64_t b = graph.AddNode({1, 1, 1}, false);
+  // any pair of candidates costs the same
+  graph.AddEdge(a, b, std::vector<double>(9, 1));
+  graph.Search();
+  ASSERT_EQ(graph.chosen_index(a), 1);
+  ASSERT_EQ(graph.chosen_index(b), 0);
+  ASSERT_DOUBLE_EQ(graph.TotalCost(false), 3);
+}
+
+}  // namespace oneflow
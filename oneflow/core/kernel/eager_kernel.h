@@ -27,6 +27,8 @@ class EagerKernel final : public Kernel {
   EagerKernel(const JobDesc* job_desc, const KernelConf& kernel_conf);
   ~EagerKernel() = default;
 
+  using Kernel::kernel_conf;
+
   void Infer(std::function<Blob*(const std::string&)> BnInOp2Blob) const;
 
   std::shared_ptr<user_op::OpKernelState> EagerForward(
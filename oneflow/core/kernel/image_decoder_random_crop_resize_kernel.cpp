@@ -19,6 +19,7 @@ limitations under the License.
 #include "oneflow/core/common/channel.h"
 #include "oneflow/core/common/blocking_counter.h"
 #include "oneflow/user/image/random_crop_generator.h"
+#include "oneflow/user/image/jpeg_decoder.h"
 #include <opencv2/opencv.hpp>
 
 #if defined(WITH_CUDA) && CUDA_VERSION >= 10020
@@ -92,6 +93,9 @@ class CpuDecodeHandle final : public DecodeHandle {
   void Synchronize() override {
     // do nothing
   }
+
+ private:
+  JpegDecoder jpeg_decoder_;
 };
 
 void CpuDecodeHandle::DecodeRandomCropResize(const unsigned char* data, size_t length,
@@ -99,13 +103,37 @@ void CpuDecodeHandle::DecodeRandomCropResize(const unsigned char* data, size_t l
                                              unsigned char* workspace, size_t workspace_size,
                                              unsigned char* dst, int target_width,
                                              int target_height) {
+  int width;
+  int height;
+  cv::Rect roi;
+  const bool is_jpeg = jpeg_decoder_.ReadHeader(data, length, &width, &height);
+  if (is_jpeg) {
+    if (crop_generator) {
+      GenerateRandomCropRoi(crop_generator, width, height, &roi.x, &roi.y, &roi.width,
+                            &roi.height);
+    } else {
+      roi = cv::Rect(0, 0, width, height);
+    }
+    // only the iMCU rows and columns covering the roi are decoded, and the crop, the resize and
+    // the BGR to RGB conversion of the opencv path below collapse into one resampling pass
+    JpegDecodedRoi decoded{};
+    if (jpeg_decoder_.DecodeRoi(roi.x, roi.y, roi.width, roi.height, target_width, target_height,
+                                JpegPixelFormat::kRGB, &decoded)) {
+      CHECK_EQ(decoded.channels, kNumChannels);
+      ResizeDecodedRoi<unsigned char>(decoded, target_width, target_height, nullptr, nullptr, dst);
+      return;
+    }
+  }
   cv::Mat image =
       cv::imdecode(cv::Mat(1, length, CV_8UC1, const_cast<unsigned char*>(data)), cv::IMREAD_COLOR);
   cv::Mat cropped;
   if (crop_generator) {
-    cv::Rect roi;
-    GenerateRandomCropRoi(crop_generator, image.cols, image.rows, &roi.x, &roi.y, &roi.width,
-                          &roi.height);
+    // keep the roi already drawn for this image so that the random sequence does not depend on
+    // which decoder succeeded
+    if (!is_jpeg) {
+      GenerateRandomCropRoi(crop_generator, image.cols, image.rows, &roi.x, &roi.y, &roi.width,
+                            &roi.height);
+    }
     image(roi).copyTo(cropped);
   } else {
     cropped = image;
@@ -43,6 +43,13 @@ void Kernel::InitBase(const JobDesc* job_desc, const KernelConf& kernel_conf) {
   kernel_conf_ = kernel_conf;
   shape_infer_helper_ =
       new RuntimeBlobShapeInferHelper(this->op_conf(), this->kernel_conf(), &this->job_desc());
+  for (const auto& pair : op_attribute().arg_signature().bn_in_op2lbi()) {
+    bn_in_op_vec_.push_back(pair.first);
+  }
+  std::sort(bn_in_op_vec_.begin(), bn_in_op_vec_.end());
+  FOR_RANGE(int32_t, i, 0, bn_in_op_vec_.size()) {
+    CHECK(bn_in_op2bn_slot_.emplace(bn_in_op_vec_.at(i), i).second);
+  }
 }
 
 void Kernel::Init(const JobDesc* job_desc, const KernelConf& kernel_conf, DeviceCtx* device_ctx) {
@@ -62,10 +69,27 @@ void Kernel::Launch(const KernelCtx& ctx,
   gdb::ForwardLeaveBreakPoint(op_attribute(), BnInOp2Blob);
 }
 
+void Kernel::Launch(const KernelCtx& ctx, const std::vector<Blob*>& bn_slot2blob) const {
+  CHECK_EQ(bn_slot2blob.size(), bn_in_op_vec_.size());
+  KernelCtx bound_ctx = ctx;
+  bound_ctx.bn_slot2blob = &bn_slot2blob;
+  Launch(bound_ctx, [&](const std::string& bn_in_op) -> Blob* {
+    const int32_t bn_slot = BnSlot4BnInOp(bn_in_op);
+    if (bn_slot == -1) { return nullptr; }
+    return bn_slot2blob.at(bn_slot);
+  });
+}
+
 const LogicalBlobId& Kernel::BnInOp2Lbi(const std::string& bn_in_op) const {
   return op_attribute().arg_signature().bn_in_op2lbi().at(bn_in_op);
 }
 
+int32_t Kernel::BnSlot4BnInOp(const std::string& bn_in_op) const {
+  const auto& it = bn_in_op2bn_slot_.find(bn_in_op);
+  if (it == bn_in_op2bn_slot_.end()) { return -1; }
+  return it->second;
+}
+
 void Kernel::CheckSameDim0ValidNum(
     const PbRpf<std::string>& bns,
     const std::function<Blob*(const std::string&)>& BnInOp2Blob) const {
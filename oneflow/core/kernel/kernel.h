@@ -45,8 +45,14 @@ class Kernel {
                             std::function<Blob*(const std::string&)> BnInOp2Blob) const;
 
   void Launch(const KernelCtx& ctx, std::function<Blob*(const std::string&)> BnInOp2Blob) const;
+  // bn_slot2blob holds the blob of each bn of bn_in_op_vec(), nullptr for the absent ones
+  void Launch(const KernelCtx& ctx, const std::vector<Blob*>& bn_slot2blob) const;
 
   const LogicalBlobId& BnInOp2Lbi(const std::string& bn_in_op) const;
+  // all bns of the kernel, sorted
+  const std::vector<std::string>& bn_in_op_vec() const { return bn_in_op_vec_; }
+  // index of bn_in_op in bn_in_op_vec(), -1 if the kernel has no such bn
+  int32_t BnSlot4BnInOp(const std::string& bn_in_op) const;
   const OperatorConf& op_conf() const { return op_attribute().op_conf(); }
   const OpAttribute& op_attribute() const { return kernel_conf().op_attribute(); }
   /*
@@ -135,6 +141,8 @@ class Kernel {
   const JobDesc* job_desc_;
   RuntimeBlobShapeInferHelper* shape_infer_helper_;
   KernelConf kernel_conf_;
+  std::vector<std::string> bn_in_op_vec_;
+  HashMap<std::string, int32_t> bn_in_op2bn_slot_;
 };
 
 template<DeviceType device_type>
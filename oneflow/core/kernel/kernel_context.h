@@ -20,11 +20,15 @@ limitations under the License.
 
 namespace oneflow {
 
+class Blob;
+
 struct KernelCtx {
-  KernelCtx() : device_ctx(nullptr), other(nullptr) {}
+  KernelCtx() : device_ctx(nullptr), other(nullptr), bn_slot2blob(nullptr) {}
 
   DeviceCtx* device_ctx;
   void* other;
+  // the blobs of Kernel::bn_in_op_vec by index while a kernel is launched with them
+  const std::vector<Blob*>* bn_slot2blob;
 };
 
 }  // namespace oneflow
@@ -348,14 +348,26 @@ class UserKernelComputeContext final : public user_op::KernelComputeContext {
   void UpdateTensorWithCorrBlob(std::function<Blob*(const std::string&)> BnInOp2Blob) {
     for (auto& pair : arg2tensor_) {
       const auto& arg_pair = pair.first;
-      std::unique_ptr<user_op::Tensor>* arg_tensor_ptr = &pair.second;
       Blob* blob = BnInOp2Blob(GenRepeatedBn(arg_pair.first, arg_pair.second));
       if (blob == nullptr) { continue; }
-      if (*arg_tensor_ptr) {
-        *(arg_tensor_ptr->get()) = std::move(user_op::Tensor(blob));
-      } else {
-        arg_tensor_ptr->reset(new user_op::Tensor(blob));
-      }
+      UpdateTensor(&pair.second, blob);
+    }
+  }
+  void BindBnSlots(const Kernel& kernel) {
+    CHECK(bn_slot_and_tensors_.empty());
+    for (auto& pair : arg2tensor_) {
+      const auto& arg_pair = pair.first;
+      const int32_t bn_slot = kernel.BnSlot4BnInOp(GenRepeatedBn(arg_pair.first, arg_pair.second));
+      if (bn_slot == -1) { continue; }
+      bn_slot_and_tensors_.emplace_back(bn_slot, &pair.second);
+    }
+  }
+  // the same as above with the blobs bound to the bn slots of the kernel
+  void UpdateTensorWithCorrBlob(const std::vector<Blob*>& bn_slot2blob) {
+    for (auto& pair : bn_slot_and_tensors_) {
+      Blob* blob = bn_slot2blob.at(pair.first);
+      if (blob == nullptr) { continue; }
+      UpdateTensor(pair.second, blob);
     }
   }
 
@@ -367,8 +379,17 @@ class UserKernelComputeContext final : public user_op::KernelComputeContext {
   const ArgVec& outputs() const override { return base_ctx_.outputs(); }
 
  private:
+  void UpdateTensor(std::unique_ptr<user_op::Tensor>* arg_tensor_ptr, Blob* blob) {
+    if (*arg_tensor_ptr) {
+      *(arg_tensor_ptr->get()) = std::move(user_op::Tensor(blob));
+    } else {
+      arg_tensor_ptr->reset(new user_op::Tensor(blob));
+    }
+  }
+
   DeviceCtx* device_ctx_;
   Arg2Tensor arg2tensor_;
+  std::vector<std::pair<int32_t, std::unique_ptr<user_op::Tensor>*>> bn_slot_and_tensors_;
   UserKernelBaseContext base_ctx_;
 };
 
@@ -401,6 +422,7 @@ class UserKernel final : public Kernel {
 
   void InitUserKernel(DeviceCtx* device_ctx) {
     ctx_.reset(new UserKernelComputeContext(device_ctx, kernel_conf(), job_desc()));
+    ctx_->BindBnSlots(*this);
     infer_ctx_.reset(new UserKernelInferContext(device_ctx, kernel_conf(), job_desc()));
     infer_cache_.reset(new user_op::OpKernelInferCache(kernel_conf(), job_desc()));
     {
@@ -432,7 +454,12 @@ class UserKernel final : public Kernel {
 
   void ForwardDataContent(const KernelCtx& ctx,
                           std::function<Blob*(const std::string&)> BnInOp2Blob) const override {
-    ForwardUserKernel(BnInOp2Blob, opkernel_state_.get());
+    if (ctx.bn_slot2blob != nullptr) {
+      ctx_->UpdateTensorWithCorrBlob(*ctx.bn_slot2blob);
+      kernel_->Compute(ctx_.get(), opkernel_state_.get());
+    } else {
+      ForwardUserKernel(BnInOp2Blob, opkernel_state_.get());
+    }
   }
 
   void ForwardShape(const KernelCtx& ctx,
@@ -15,14 +15,93 @@ limitations under the License.
 */
 #include "oneflow/core/ndarray/ndarray_apply_broadcast_binary_core.h"
 
+#include "oneflow/core/thread/thread_manager.h"
+
 namespace oneflow {
 
+namespace {
+
+// Broadcasts smaller than this run on the calling thread
+constexpr int64_t kMinElemNumPerThread = 1 << 15;
+
+// Strides of x in the index space of y, 0 along the broadcast axes
+template<int NDIMS>
+void GetBroadcastStrides(const XpuShape& x_shape, int64_t strides[NDIMS]) {
+  FOR_RANGE(int, i, 0, NDIMS) { strides[i] = x_shape.At(i) == 1 ? 0 : x_shape.DimElemNum(i); }
+}
+
+// One contiguous run along the innermost axis. Operands broadcast along it are loaded once and
+// splatted so that every branch is a plain loop the compiler vectorizes.
+template<typename T, typename Y, template<typename> class binary_func>
+void ApplyInnermost(int64_t n, Y* y, const T* a, int64_t a_step, const T* b, int64_t b_step) {
+  if (a_step != 0 && b_step != 0) {
+    for (int64_t i = 0; i < n; ++i) { y[i] = binary_func<T>::Invoke(a[i], b[i]); }
+  } else if (a_step != 0) {
+    const T b_val = *b;
+    for (int64_t i = 0; i < n; ++i) { y[i] = binary_func<T>::Invoke(a[i], b_val); }
+  } else if (b_step != 0) {
+    const T a_val = *a;
+    for (int64_t i = 0; i < n; ++i) { y[i] = binary_func<T>::Invoke(a_val, b[i]); }
+  } else {
+    const Y y_val = binary_func<T>::Invoke(*a, *b);
+    for (int64_t i = 0; i < n; ++i) { y[i] = y_val; }
+  }
+}
+
+// Computes y[begin, end). Only the coordinate of begin is derived by division, then the
+// coordinate and the offsets of a and b advance row by row with carries.
+template<typename T, typename Y, int NDIMS, template<typename> class binary_func>
+void ApplyRange(const XpuShape& y_shape, Y* y, const T* a, const int64_t a_strides[NDIMS],
+                const T* b, const int64_t b_strides[NDIMS], int64_t begin, int64_t end) {
+  const int64_t inner_dim = y_shape.At(NDIMS - 1);
+  int64_t coord[NDIMS];
+  y_shape.template Offset2Coordinate<NDIMS>(begin, coord);
+  int64_t a_offset = 0;
+  int64_t b_offset = 0;
+  FOR_RANGE(int, i, 0, NDIMS) {
+    a_offset += coord[i] * a_strides[i];
+    b_offset += coord[i] * b_strides[i];
+  }
+  int64_t offset = begin;
+  while (offset < end) {
+    const int64_t n = std::min(inner_dim - coord[NDIMS - 1], end - offset);
+    ApplyInnermost<T, Y, binary_func>(n, y + offset, a + a_offset, a_strides[NDIMS - 1],
+                                      b + b_offset, b_strides[NDIMS - 1]);
+    offset += n;
+    coord[NDIMS - 1] += n;
+    a_offset += n * a_strides[NDIMS - 1];
+    b_offset += n * b_strides[NDIMS - 1];
+    for (int i = NDIMS - 1; i > 0 && coord[i] == y_shape.At(i); --i) {
+      coord[i] = 0;
+      a_offset += a_strides[i - 1] - y_shape.At(i) * a_strides[i];
+      b_offset += b_strides[i - 1] - y_shape.At(i) * b_strides[i];
+      coord[i - 1] += 1;
+    }
+  }
+}
+
+template<typename T, typename Y, int NDIMS, template<typename> class binary_func>
+void CpuBroadcastApply(const XpuShape& y_shape, Y* y, const XpuShape& a_shape, const T* a,
+                       const XpuShape& b_shape, const T* b) {
+  int64_t a_strides[NDIMS];
+  int64_t b_strides[NDIMS];
+  GetBroadcastStrides<NDIMS>(a_shape, a_strides);
+  GetBroadcastStrides<NDIMS>(b_shape, b_strides);
+  MultiThreadLoopInRanges(
+      y_shape.ElemNum(), kMinElemNumPerThread, [&](int64_t, int64_t begin, int64_t end) {
+        ApplyRange<T, Y, NDIMS, binary_func>(y_shape, y, a, a_strides, b, b_strides, begin, end);
+      });
+}
+
+}  // namespace
+
 template<typename T, int NDIMS, template<typename> class binary_func>
 struct NdarrayApplyBroadcastBinaryCoreWrapper<DeviceType::kCPU, T, NDIMS, binary_func> final {
   static void Apply(DeviceCtx* ctx,
                     const XpuVarNdarray<typename BinaryFuncTrait<binary_func, T>::return_type>& y,
                     const XpuVarNdarray<const T>& a, const XpuVarNdarray<const T>& b) {
-    NdarrayApplyBroadcastBinaryCore<T, NDIMS, binary_func>::Apply(y, a, b);
+    CpuBroadcastApply<T, typename BinaryFuncTrait<binary_func, T>::return_type, NDIMS,
+                      binary_func>(y.shape(), y.ptr(), a.shape(), a.ptr(), b.shape(), b.ptr());
   }
 };
 
@@ -31,7 +110,8 @@ struct NdarrayApplyBroadcastInplaceBinaryCoreWrapper<DeviceType::kCPU, T, NDIMS,
     final {
   static void InplaceApply(DeviceCtx* ctx, const XpuVarNdarray<T>& y,
                            const XpuVarNdarray<const T>& x) {
-    NdarrayApplyBroadcastBinaryCore<T, NDIMS, binary_func>::InplaceApply(y, x);
+    CpuBroadcastApply<T, T, NDIMS, binary_func>(y.shape(), y.ptr(), y.shape(), y.ptr(), x.shape(),
+                                                x.ptr());
   }
 };
 
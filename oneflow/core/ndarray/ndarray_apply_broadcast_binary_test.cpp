@@ -0,0 +1,76 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/ndarray/ndarray_apply_broadcast_binary.h"
+#include "oneflow/core/thread/thread_pool.h"
+#include <gtest/gtest.h>
+
+namespace oneflow {
+
+namespace test {
+
+namespace {
+
+int64_t BroadcastOffset(const Shape& y_shape, const Shape& x_shape, int64_t y_offset) {
+  int64_t x_offset = 0;
+  for (int64_t i = 0; i < y_shape.NumAxes(); ++i) {
+    const int64_t y_stride = y_shape.Count(i + 1);
+    const int64_t coord = (y_offset / y_stride) % y_shape.At(i);
+    x_offset = x_offset * x_shape.At(i) + (x_shape.At(i) == 1 ? 0 : coord);
+  }
+  return x_offset;
+}
+
+void TestBroadcastSub(const Shape& a_shape, const Shape& b_shape) {
+  DimVector y_dim;
+  for (int64_t i = 0; i < a_shape.NumAxes(); ++i) {
+    y_dim.push_back(std::max(a_shape.At(i), b_shape.At(i)));
+  }
+  const Shape y_shape(y_dim);
+  std::vector<float> a(a_shape.elem_cnt());
+  std::vector<float> b(b_shape.elem_cnt());
+  for (size_t i = 0; i < a.size(); ++i) { a.at(i) = i; }
+  for (size_t i = 0; i < b.size(); ++i) { b.at(i) = 0.5f * i; }
+  std::vector<float> y(y_shape.elem_cnt());
+  NdarrayApplyBroadcastBinary<DeviceType::kCPU, float, BinaryFuncSub>::Apply(
+      nullptr, XpuVarNdarray<float>(y_shape, y.data()),
+      XpuVarNdarray<const float>(a_shape, a.data()), XpuVarNdarray<const float>(b_shape, b.data()));
+  for (int64_t i = 0; i < y_shape.elem_cnt(); ++i) {
+    ASSERT_EQ(y.at(i), a.at(BroadcastOffset(y_shape, a_shape, i))
+                           - b.at(BroadcastOffset(y_shape, b_shape, i)));
+  }
+}
+
+void TestAllCases() {
+  TestBroadcastSub(Shape({3, 1}), Shape({1, 5}));
+  TestBroadcastSub(Shape({2, 3, 4}), Shape({2, 1, 4}));
+  TestBroadcastSub(Shape({1, 7, 1, 9}), Shape({5, 7, 3, 1}));
+  TestBroadcastSub(Shape({64, 1, 1027}), Shape({64, 33, 1}));
+  TestBroadcastSub(Shape({1, 1}), Shape({300, 700}));
+}
+
+}  // namespace
+
+TEST(NdarrayApplyBroadcastBinary, cpu_serial) { TestAllCases(); }
+
+TEST(NdarrayApplyBroadcastBinary, cpu_parallel) {
+  Global<ThreadPool>::New(4);
+  TestAllCases();
+  Global<ThreadPool>::Delete();
+}
+
+}  // namespace test
+
+}  // namespace oneflow
@@ -17,26 +17,236 @@ limitations under the License.
 #include "oneflow/core/common/preprocessor.h"
 #include "oneflow/core/ndarray/ndarray_reduce_impl.h"
 #include "oneflow/core/ndarray/binary_func.h"
+#include "oneflow/core/thread/thread_manager.h"
 
 namespace oneflow {
 
-#define SPECIALIZE_CPU_NDARRAY_REDUCE_IMPL(struct_name)                                            \
-  template<typename T, template<typename> class binary_func>                                       \
-  struct struct_name<DeviceType::kCPU, T, binary_func> final {                                     \
-    static bool Matched(const XpuVarNdarray<T>& y, const XpuVarNdarray<const T>& x) {              \
-      return false;                                                                                \
-    }                                                                                              \
-    static void Reduce(DeviceCtx* ctx, const XpuVarNdarray<T>& y, const XpuVarNdarray<const T>& x, \
-                       const XpuVarNdarray<T>& tmp_storage) {                                      \
-      UNIMPLEMENTED();                                                                             \
-    }                                                                                              \
+namespace {
+
+// Reductions smaller than this run on the calling thread
+constexpr int64_t kMinElemNumPerThread = 1 << 15;
+// Contiguous runs up to this length are reduced by kNumLanes independent accumulators, longer runs
+// are halved recursively so that the rounding error of a sum grows with log(n) instead of n.
+constexpr int64_t kPairwiseBlockSize = 256;
+constexpr int64_t kNumLanes = 8;
+// Strided (column) reductions keep a partial row of kColBlockSize elements and fold it into the
+// result every kRowBlockSize rows.
+constexpr int64_t kColBlockSize = 512;
+constexpr int64_t kRowBlockSize = 128;
+
+int64_t CeilDiv(int64_t n, int64_t d) { return (n + d - 1) / d; }
+
+template<typename T, template<typename> class binary_func>
+T ReduceBlock(const T* x, int64_t n) {
+  T lanes[kNumLanes];
+  std::fill(lanes, lanes + kNumLanes, UnitOfBinaryFunc<T, binary_func>::Val());
+  int64_t i = 0;
+  for (; i + kNumLanes <= n; i += kNumLanes) {
+    FOR_RANGE(int64_t, j, 0, kNumLanes) { lanes[j] = binary_func<T>::Invoke(lanes[j], x[i + j]); }
+  }
+  for (; i < n; ++i) { lanes[0] = binary_func<T>::Invoke(lanes[0], x[i]); }
+  for (int64_t width = kNumLanes / 2; width > 0; width /= 2) {
+    FOR_RANGE(int64_t, j, 0, width) {
+      lanes[j] = binary_func<T>::Invoke(lanes[j], lanes[j + width]);
+    }
+  }
+  return lanes[0];
+}
+
+template<typename T, template<typename> class binary_func>
+T ReduceContiguous(const T* x, int64_t n) {
+  if (n <= kPairwiseBlockSize) { return ReduceBlock<T, binary_func>(x, n); }
+  const int64_t half = n / 2;
+  return binary_func<T>::Invoke(ReduceContiguous<T, binary_func>(x, half),
+                                ReduceContiguous<T, binary_func>(x + half, n - half));
+}
+
+// y[j] = reduce(x[i * row_stride + j] for i in [0, rows)) for j in [0, cols)
+template<typename T, template<typename> class binary_func>
+void ReduceRows(const T* x, int64_t rows, int64_t cols, int64_t row_stride, T* y) {
+  T partial[kColBlockSize];
+  T block_partial[kColBlockSize];
+  for (int64_t col = 0; col < cols; col += kColBlockSize) {
+    const int64_t n = std::min(kColBlockSize, cols - col);
+    std::fill(partial, partial + n, UnitOfBinaryFunc<T, binary_func>::Val());
+    for (int64_t row = 0; row < rows; row += kRowBlockSize) {
+      std::fill(block_partial, block_partial + n, UnitOfBinaryFunc<T, binary_func>::Val());
+      FOR_RANGE(int64_t, i, row, std::min(row + kRowBlockSize, rows)) {
+        const T* x_row = x + i * row_stride + col;
+        FOR_RANGE(int64_t, j, 0, n) {
+          block_partial[j] = binary_func<T>::Invoke(block_partial[j], x_row[j]);
+        }
+      }
+      FOR_RANGE(int64_t, j, 0, n) {
+        partial[j] = binary_func<T>::Invoke(partial[j], block_partial[j]);
+      }
+    }
+    std::copy(partial, partial + n, y + col);
+  }
+}
+
+// (X, Y, Z) -> (X, 1, Z), split over X and blocks of Z columns
+template<typename T, template<typename> class binary_func>
+void ReduceCubeY(const T* x, int64_t dim_x, int64_t dim_y, int64_t dim_z, T* y) {
+  const int64_t col_block_num = CeilDiv(dim_z, kColBlockSize);
+  const int64_t block_elem_num = dim_y * std::min(dim_z, kColBlockSize);
+  MultiThreadLoopInRanges(dim_x * col_block_num, CeilDiv(kMinElemNumPerThread, block_elem_num),
+                          [&](int64_t, int64_t begin, int64_t end) {
+                            FOR_RANGE(int64_t, i, begin, end) {
+                              const int64_t x_idx = i / col_block_num;
+                              const int64_t col = (i % col_block_num) * kColBlockSize;
+                              ReduceRows<T, binary_func>(
+                                  x + x_idx * dim_y * dim_z + col, dim_y,
+                                  std::min(kColBlockSize, dim_z - col), dim_z,
+                                  y + x_idx * dim_z + col);
+                            }
+                          });
+}
+
+}  // namespace
+
+template<typename T, template<typename> class binary_func>
+struct NdarrayScalarReduce<DeviceType::kCPU, T, binary_func> final {
+  static bool Matched(const XpuVarNdarray<T>& y, const XpuVarNdarray<const T>& x) {
+    return y.shape().ElemNum() == 1;
+  }
+
+  static void Reduce(DeviceCtx* ctx, const XpuVarNdarray<T>& y, const XpuVarNdarray<const T>& x,
+                     const XpuVarNdarray<T>& tmp_storage) {
+    CHECK(Matched(y, x));
+    const int64_t elem_num = x.shape().ElemNum();
+    std::vector<T> partials(GetMultiThreadLoopRangeNum(elem_num, kMinElemNumPerThread));
+    MultiThreadLoopInRanges(elem_num, kMinElemNumPerThread,
+                            [&](int64_t range_id, int64_t begin, int64_t end) {
+                              partials.at(range_id) =
+                                  ReduceContiguous<T, binary_func>(x.ptr() + begin, end - begin);
+                            });
+    // combined in a fixed order, the result does not depend on thread scheduling
+    T reduced = UnitOfBinaryFunc<T, binary_func>::Val();
+    for (const T& partial : partials) { reduced = binary_func<T>::Invoke(reduced, partial); }
+    *y.ptr() = reduced;
+  }
+};
+
+template<typename T, template<typename> class binary_func>
+struct NdarrayMatrixRowReduce<DeviceType::kCPU, T, binary_func> final {
+  static bool Matched(const XpuVarNdarray<T>& y, const XpuVarNdarray<const T>& x) {
+    if (x.shape().NumAxes() != 2) { return false; }
+    if (y.shape().NumAxes() != 2) { return false; }
+    return x.shape().At(0) == y.shape().At(0) && y.shape().At(1) == 1;
+  }
+
+  static void Reduce(DeviceCtx* ctx, const XpuVarNdarray<T>& y, const XpuVarNdarray<const T>& x,
+                     const XpuVarNdarray<T>& tmp_storage) {
+    CHECK(Matched(y, x));
+    const int64_t num_rows = x.shape().At(0);
+    const int64_t num_cols = x.shape().At(1);
+    MultiThreadLoopInRanges(num_rows, CeilDiv(kMinElemNumPerThread, num_cols),
+                            [&](int64_t, int64_t begin, int64_t end) {
+                              FOR_RANGE(int64_t, i, begin, end) {
+                                y.ptr()[i] = ReduceContiguous<T, binary_func>(
+                                    x.ptr() + i * num_cols, num_cols);
+                              }
+                            });
+  }
+};
+
+template<typename T, template<typename> class binary_func>
+struct NdarrayMatrixColReduce<DeviceType::kCPU, T, binary_func> final {
+  static bool Matched(const XpuVarNdarray<T>& y, const XpuVarNdarray<const T>& x) {
+    if (x.shape().NumAxes() != 2) { return false; }
+    if (y.shape().NumAxes() != 2) { return false; }
+    return y.shape().At(0) == 1 && x.shape().At(1) == y.shape().At(1);
+  }
+
+  static void Reduce(DeviceCtx* ctx, const XpuVarNdarray<T>& y, const XpuVarNdarray<const T>& x,
+                     const XpuVarNdarray<T>& tmp_storage) {
+    CHECK(Matched(y, x));
+    const int64_t num_rows = x.shape().At(0);
+    const int64_t num_cols = x.shape().At(1);
+    const int64_t min_rows_per_range = CeilDiv(kMinElemNumPerThread, num_cols);
+    const int64_t range_num = GetMultiThreadLoopRangeNum(num_rows, min_rows_per_range);
+    if (CeilDiv(num_cols, kColBlockSize) >= range_num) {
+      ReduceCubeY<T, binary_func>(x.ptr(), 1, num_rows, num_cols, y.ptr());
+      return;
+    }
+    // too few columns to keep the threads busy: every range of rows reduces into its own partial
+    // row and the partial rows are reduced in order. The partial rows are not kept in tmp_storage,
+    // callers may pass x as tmp_storage.
+    std::vector<T> partial_rows(range_num * num_cols);
+    T* partials = partial_rows.data();
+    MultiThreadLoopInRanges(num_rows, min_rows_per_range,
+                            [&](int64_t range_id, int64_t begin, int64_t end) {
+                              ReduceRows<T, binary_func>(x.ptr() + begin * num_cols, end - begin,
+                                                         num_cols, num_cols,
+                                                         partials + range_id * num_cols);
+                            });
+    ReduceRows<T, binary_func>(partials, range_num, num_cols, num_cols, y.ptr());
+  }
+};
+
+template<typename T, template<typename> class binary_func>
+struct NdarrayXYZCubeYReduce<DeviceType::kCPU, T, binary_func> final {
+  static bool Matched(const XpuVarNdarray<T>& y, const XpuVarNdarray<const T>& x) {
+    if (x.shape().NumAxes() != 3) { return false; }
+    if (y.shape().NumAxes() != 3) { return false; }
+    return x.shape().At(0) == y.shape().At(0) && y.shape().At(1) == 1
+           && x.shape().At(2) == y.shape().At(2);
   }
-SPECIALIZE_CPU_NDARRAY_REDUCE_IMPL(NdarrayScalarReduce);
-SPECIALIZE_CPU_NDARRAY_REDUCE_IMPL(NdarrayMatrixRowReduce);
-SPECIALIZE_CPU_NDARRAY_REDUCE_IMPL(NdarrayMatrixColReduce);
-SPECIALIZE_CPU_NDARRAY_REDUCE_IMPL(NdarrayXYZCubeYReduce);
-SPECIALIZE_CPU_NDARRAY_REDUCE_IMPL(NdarrayXYZCubeXZReduce);
-#undef SPECIALIZE_CPU_NDARRAY_REDUCE_IMPL
+
+  static void Reduce(DeviceCtx* ctx, const XpuVarNdarray<T>& y, const XpuVarNdarray<const T>& x,
+                     const XpuVarNdarray<T>& tmp_storage) {
+    CHECK(Matched(y, x));
+    ReduceCubeY<T, binary_func>(x.ptr(), x.shape().At(0), x.shape().At(1), x.shape().At(2),
+                                y.ptr());
+  }
+};
+
+template<typename T, template<typename> class binary_func>
+struct NdarrayXYZCubeXZReduce<DeviceType::kCPU, T, binary_func> final {
+  static bool Matched(const XpuVarNdarray<T>& y, const XpuVarNdarray<const T>& x) {
+    if (x.shape().NumAxes() != 3) { return false; }
+    if (y.shape().NumAxes() != 3) { return false; }
+    return y.shape().At(0) == 1 && x.shape().At(1) == y.shape().At(1) && y.shape().At(2) == 1;
+  }
+
+  static void Reduce(DeviceCtx* ctx, const XpuVarNdarray<T>& y, const XpuVarNdarray<const T>& x,
+                     const XpuVarNdarray<T>& tmp_storage) {
+    CHECK(Matched(y, x));
+    const int64_t dim_x = x.shape().At(0);
+    const int64_t dim_y = x.shape().At(1);
+    const int64_t dim_z = x.shape().At(2);
+    const int64_t min_x_per_range = CeilDiv(kMinElemNumPerThread, dim_y * dim_z);
+    const int64_t range_num = GetMultiThreadLoopRangeNum(dim_x, min_x_per_range);
+    // partials[j] = reduce(x[i, j, :] for i in [begin, end)) for j in [y_begin, y_end)
+    auto ReduceXRange = [&](int64_t begin, int64_t end, int64_t y_begin, int64_t y_end,
+                            T* partials) {
+      std::fill(partials + y_begin, partials + y_end, UnitOfBinaryFunc<T, binary_func>::Val());
+      FOR_RANGE(int64_t, i, begin, end) {
+        FOR_RANGE(int64_t, j, y_begin, y_end) {
+          partials[j] = binary_func<T>::Invoke(
+              partials[j],
+              ReduceContiguous<T, binary_func>(x.ptr() + (i * dim_y + j) * dim_z, dim_z));
+        }
+      }
+    };
+    if (dim_y >= range_num) {
+      MultiThreadLoopInRanges(dim_y, CeilDiv(kMinElemNumPerThread, dim_x * dim_z),
+                              [&](int64_t, int64_t begin, int64_t end) {
+                                ReduceXRange(0, dim_x, begin, end, y.ptr());
+                              });
+      return;
+    }
+    // private to this call like the partial rows of NdarrayMatrixColReduce
+    std::vector<T> partial_rows(range_num * dim_y);
+    T* partials = partial_rows.data();
+    MultiThreadLoopInRanges(dim_x, min_x_per_range,
+                            [&](int64_t range_id, int64_t begin, int64_t end) {
+                              ReduceXRange(begin, end, 0, dim_y, partials + range_id * dim_y);
+                            });
+    ReduceRows<T, binary_func>(partials, range_num, dim_y, dim_y, y.ptr());
+  }
+};
 
 #define INSTANTIATE_NDARRAY_REDUCE_IMPL(dtype, binary_func)                                       \
   template struct NdarrayScalarReduce<DeviceType::kCPU, OF_PP_PAIR_FIRST(dtype), binary_func>;    \
@@ -0,0 +1,159 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/ndarray/ndarray_reduce.h"
+#include "oneflow/core/thread/thread_pool.h"
+#include <chrono>
+#include <thread>
+#include <gtest/gtest.h>
+
+namespace oneflow {
+
+namespace test {
+
+namespace {
+
+int64_t ReducedOffset(const Shape& x_shape, const Shape& y_shape, int64_t x_offset) {
+  int64_t y_offset = 0;
+  for (int64_t i = 0; i < x_shape.NumAxes(); ++i) {
+    const int64_t coord = (x_offset / x_shape.Count(i + 1)) % x_shape.At(i);
+    y_offset = y_offset * y_shape.At(i) + (y_shape.At(i) == 1 ? 0 : coord);
+  }
+  return y_offset;
+}
+
+void ReduceSum(const Shape& x_shape, const Shape& y_shape, const std::vector<float>& x,
+               std::vector<float>* y) {
+  std::vector<float> tmp(x_shape.elem_cnt());
+  NdarrayReduce<DeviceType::kCPU, float, BinaryFuncSum>::Reduce(
+      nullptr, XpuVarNdarray<float>(y_shape, y->data()),
+      XpuVarNdarray<const float>(x_shape, x.data()), XpuVarNdarray<float>(x_shape, tmp.data()));
+}
+
+void TestReduceSum(const Shape& x_shape, const Shape& y_shape) {
+  std::vector<float> x(x_shape.elem_cnt());
+  // long sums of values in [1, 2), summed naively in float they drift past the tolerance
+  for (size_t i = 0; i < x.size(); ++i) { x.at(i) = 1.0f + (i % 1000) * 1e-3f; }
+  std::vector<double> expected(y_shape.elem_cnt(), 0);
+  for (int64_t i = 0; i < x_shape.elem_cnt(); ++i) {
+    expected.at(ReducedOffset(x_shape, y_shape, i)) += x.at(i);
+  }
+  std::vector<float> y(y_shape.elem_cnt());
+  ReduceSum(x_shape, y_shape, x, &y);
+  for (int64_t i = 0; i < y_shape.elem_cnt(); ++i) {
+    ASSERT_NEAR(y.at(i), expected.at(i), std::abs(expected.at(i)) * 1e-5);
+  }
+}
+
+void TestReduceMax(const Shape& x_shape, const Shape& y_shape) {
+  std::vector<float> x(x_shape.elem_cnt());
+  for (size_t i = 0; i < x.size(); ++i) { x.at(i) = static_cast<float>((i * 7919) % 10007); }
+  std::vector<float> expected(y_shape.elem_cnt(), GetMinVal<float>());
+  for (int64_t i = 0; i < x_shape.elem_cnt(); ++i) {
+    float* reduced = &expected.at(ReducedOffset(x_shape, y_shape, i));
+    *reduced = std::max(*reduced, x.at(i));
+  }
+  std::vector<float> y(y_shape.elem_cnt());
+  std::vector<float> tmp(x_shape.elem_cnt());
+  NdarrayReduce<DeviceType::kCPU, float, BinaryFuncMax>::Reduce(
+      nullptr, XpuVarNdarray<float>(y_shape, y.data()),
+      XpuVarNdarray<const float>(x_shape, x.data()), XpuVarNdarray<float>(x_shape, tmp.data()));
+  ASSERT_EQ(y, expected);
+}
+
+// the kernels of the broadcast grads pass one buffer as both x and tmp_storage
+void TestReduceSumWithXAsTmp(const Shape& x_shape, const Shape& y_shape) {
+  std::vector<float> x(x_shape.elem_cnt());
+  for (size_t i = 0; i < x.size(); ++i) { x.at(i) = static_cast<float>(i % 7); }
+  std::vector<float> expected(y_shape.elem_cnt(), 0);
+  for (int64_t i = 0; i < x_shape.elem_cnt(); ++i) {
+    expected.at(ReducedOffset(x_shape, y_shape, i)) += x.at(i);
+  }
+  std::vector<float> y(y_shape.elem_cnt());
+  NdarrayReduce<DeviceType::kCPU, float, BinaryFuncSum>::Reduce(
+      nullptr, XpuVarNdarray<float>(y_shape, y.data()),
+      XpuVarNdarray<const float>(x_shape, x.data()), XpuVarNdarray<float>(x_shape, x.data()));
+  ASSERT_EQ(y, expected);
+}
+
+void TestAllCases() {
+  // scalar
+  TestReduceSum(Shape({1 << 20}), Shape({1}));
+  TestReduceSum(Shape({37, 3}), Shape({1, 1}));
+  // matrix row
+  TestReduceSum(Shape({4096, 1000}), Shape({4096, 1}));
+  TestReduceSum(Shape({3, 100003}), Shape({3, 1}));
+  // matrix col, wide and narrow
+  TestReduceSum(Shape({1000, 4096}), Shape({1, 4096}));
+  TestReduceSum(Shape({100003, 3}), Shape({1, 3}));
+  // xyz cube y
+  TestReduceSum(Shape({32, 128, 64}), Shape({32, 1, 64}));
+  TestReduceSum(Shape({2, 9000, 1025}), Shape({2, 1, 1025}));
+  // xyz cube xz, per channel reductions of NCHW tensors
+  TestReduceSum(Shape({64, 256, 196}), Shape({1, 256, 1}));
+  TestReduceSum(Shape({4096, 3, 17}), Shape({1, 3, 1}));
+  // falls back to the default reduce
+  TestReduceSum(Shape({5, 6, 7, 8}), Shape({5, 1, 7, 1}));
+  TestReduceMax(Shape({1000, 4096}), Shape({1, 4096}));
+  TestReduceMax(Shape({64, 256, 196}), Shape({1, 256, 1}));
+  // narrow matrix col and xyz cube xz reduce by ranges into partials
+  TestReduceSumWithXAsTmp(Shape({100003, 3}), Shape({1, 3}));
+  TestReduceSumWithXAsTmp(Shape({4096, 3, 17}), Shape({1, 3, 1}));
+  TestReduceSumWithXAsTmp(Shape({5, 6, 7, 8}), Shape({5, 1, 7, 1}));
+}
+
+double MeasureGBPerSec(const Shape& x_shape, const Shape& y_shape) {
+  const std::vector<float> x(x_shape.elem_cnt(), 1.0f);
+  std::vector<float> y(y_shape.elem_cnt());
+  const int num_iters = 20;
+  ReduceSum(x_shape, y_shape, x, &y);
+  const auto start = std::chrono::steady_clock::now();
+  FOR_RANGE(int, i, 0, num_iters) { ReduceSum(x_shape, y_shape, x, &y); }
+  const double secs =
+      std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  return x.size() * sizeof(float) * num_iters / secs / 1e9;
+}
+
+}  // namespace
+
+TEST(NdarrayReduce, cpu_serial) { TestAllCases(); }
+
+TEST(NdarrayReduce, cpu_parallel) {
+  Global<ThreadPool>::New(4);
+  TestAllCases();
+  Global<ThreadPool>::Delete();
+}
+
+// Bandwidth of the reductions done by reduce_sum, bias_add_grad and the normalization grads
+// Run with --gtest_also_run_disabled_tests
+TEST(NdarrayReduce, DISABLED_benchmark_cpu_sum) {
+  Global<ThreadPool>::New(std::thread::hardware_concurrency());
+  const std::vector<std::pair<Shape, Shape>> cases = {
+      {Shape({1 << 24}), Shape({1})},
+      {Shape({4096, 1000}), Shape({4096, 1})},
+      {Shape({4096, 1000}), Shape({1, 1000})},
+      {Shape({32, 128, 64}), Shape({32, 1, 64})},
+      {Shape({64, 256, 3136}), Shape({1, 256, 1})},
+  };
+  for (const auto& pair : cases) {
+    LOG(INFO) << "reduce sum " << pair.first.DebugStr() << " -> " << pair.second.DebugStr() << ": "
+              << MeasureGBPerSec(pair.first, pair.second) << " GB/s";
+  }
+  Global<ThreadPool>::Delete();
+}
+
+}  // namespace test
+
+}  // namespace oneflow
@@ -0,0 +1,80 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/persistence/compile_cache.h"
+#include "oneflow/core/common/str_util.h"
+#include "oneflow/core/job/version.h"
+#include "oneflow/core/persistence/file_system.h"
+#include <google/protobuf/io/coded_stream.h>
+#include <google/protobuf/io/zero_copy_stream_impl_lite.h>
+#include <unistd.h>
+
+namespace oneflow {
+
+std::string CompileCacheVersion() {
+#ifdef WITH_GIT_VERSION
+  return GetOneFlowGitVersion();
+#else
+  return "";
+#endif  // WITH_GIT_VERSION
+}
+
+void AppendDeterministicSerialization(const PbMessage& msg, std::string* out) {
+  google::protobuf::io::StringOutputStream string_stream(out);
+  google::protobuf::io::CodedOutputStream coded_stream(&string_stream);
+  coded_stream.SetSerializationDeterministic(true);
+  CHECK(msg.SerializeToCodedStream(&coded_stream));
+}
+
+std::string GenFingerprint(const std::string& compile_input) {
+  uint64_t hash = 14695981039346656037ULL;
+  for (const char c : compile_input) {
+    hash ^= static_cast<unsigned char>(c);
+    hash *= 1099511628211ULL;
+  }
+  char hex[17];
+  snprintf(hex, sizeof(hex), "%016llx", static_cast<unsigned long long>(hash));
+  return hex;
+}
+
+std::string CompileCacheEntryPath(const std::string& dir, const std::string& prefix,
+                                  const std::string& compile_input) {
+  return JoinPath(dir, prefix + GenFingerprint(compile_input) + ".pb");
+}
+
+bool ReadCompileCacheEntry(const std::string& path, std::string* buffer) {
+  if (!LocalFS()->FileExists(path)) { return false; }
+  const uint64_t size = LocalFS()->GetFileSize(path);
+  buffer->assign(size, '\0');
+  if (size == 0) { return true; }
+  std::unique_ptr<fs::RandomAccessFile> file;
+  LocalFS()->NewRandomAccessFile(path, &file);
+  file->Read(0, size, &buffer->at(0));
+  return true;
+}
+
+void WriteCompileCacheEntry(const std::string& path, const std::string& buffer) {
+  LocalFS()->RecursivelyCreateDir(Dirname(path));
+  const std::string tmp_path = path + ".tmp" + std::to_string(getpid());
+  {
+    std::unique_ptr<fs::WritableFile> file;
+    LocalFS()->NewWritableFile(tmp_path, &file);
+    file->Append(buffer.data(), buffer.size());
+    file->Close();
+  }
+  LocalFS()->RenameFile(tmp_path, path);
+}
+
+}  // namespace oneflow
@@ -0,0 +1,49 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifndef ONEFLOW_CORE_PERSISTENCE_COMPILE_CACHE_H_
+#define ONEFLOW_CORE_PERSISTENCE_COMPILE_CACHE_H_
+
+#include "oneflow/core/common/protobuf.h"
+
+namespace oneflow {
+
+// Helpers of the caches that keep compilation results on disk across sessions, such as the plan
+// cache and the xrt compilation cache. An entry is named by the fingerprint of its compile input
+// and holds the whole compile input, which is compared on load.
+
+// The oneflow git version entries are tagged with, empty if oneflow was built without
+// BUILD_GIT_VERSION, in which case the caches are disabled
+std::string CompileCacheVersion();
+
+// protobuf maps are serialized in hash order unless asked otherwise
+void AppendDeterministicSerialization(const PbMessage& msg, std::string* out);
+
+// FNV-1a in 16 hex digits
+std::string GenFingerprint(const std::string& compile_input);
+
+// dir/<prefix><fingerprint>.pb
+std::string CompileCacheEntryPath(const std::string& dir, const std::string& prefix,
+                                  const std::string& compile_input);
+
+// Returns false if there is no entry at path
+bool ReadCompileCacheEntry(const std::string& path, std::string* buffer);
+
+// Written aside and renamed, so that concurrent sessions never read a partial entry
+void WriteCompileCacheEntry(const std::string& path, const std::string& buffer);
+
+}  // namespace oneflow
+
+#endif  // ONEFLOW_CORE_PERSISTENCE_COMPILE_CACHE_H_
@@ -0,0 +1,66 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/persistence/compile_cache.h"
+#include "oneflow/core/common/str_util.h"
+#include "oneflow/core/framework/user_op_conf.pb.h"
+#include "oneflow/core/persistence/file_system.h"
+
+#include <unistd.h>
+
+namespace oneflow {
+
+TEST(CompileCache, deterministic_serialization) {
+  UserOpConf lhs;
+  UserOpConf rhs;
+  lhs.set_op_type_name("add_n");
+  rhs.set_op_type_name("add_n");
+  // the same map inserted in another order
+  for (int i = 0; i < 16; ++i) { (*lhs.mutable_input())["in_" + std::to_string(i)].add_s("x"); }
+  for (int i = 15; i >= 0; --i) { (*rhs.mutable_input())["in_" + std::to_string(i)].add_s("x"); }
+  std::string lhs_serialized;
+  std::string rhs_serialized = "prefix";
+  AppendDeterministicSerialization(lhs, &lhs_serialized);
+  AppendDeterministicSerialization(rhs, &rhs_serialized);
+  ASSERT_EQ("prefix" + lhs_serialized, rhs_serialized);
+}
+
+TEST(CompileCache, fingerprint) {
+  ASSERT_EQ(GenFingerprint(""), "cbf29ce484222325");
+  ASSERT_EQ(GenFingerprint("a"), "af63dc4c8601ec8c");
+  ASSERT_EQ(CompileCacheEntryPath("/cache", "plan_", "a"), "/cache/plan_af63dc4c8601ec8c.pb");
+}
+
+TEST(CompileCache, write_and_read_entry) {
+  const std::string dir =
+      JoinPath(::testing::TempDir(), "compile_cache_test_" + std::to_string(getpid()));
+  const std::string path = CompileCacheEntryPath(dir, "entry_", "input");
+  std::string buffer;
+  ASSERT_FALSE(ReadCompileCacheEntry(path, &buffer));
+  WriteCompileCacheEntry(path, std::string("a\0b", 3));
+  ASSERT_TRUE(ReadCompileCacheEntry(path, &buffer));
+  ASSERT_EQ(buffer, std::string("a\0b", 3));
+  // an entry is replaced as a whole
+  WriteCompileCacheEntry(path, "c");
+  ASSERT_TRUE(ReadCompileCacheEntry(path, &buffer));
+  ASSERT_EQ(buffer, "c");
+  WriteCompileCacheEntry(path, "");
+  ASSERT_TRUE(ReadCompileCacheEntry(path, &buffer));
+  ASSERT_TRUE(buffer.empty());
+  ASSERT_EQ(LocalFS()->ListDir(dir).size(), 1);
+  LocalFS()->RecursivelyDeleteDir(dir);
+}
+
+}  // namespace oneflow
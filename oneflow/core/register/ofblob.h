@@ -40,6 +40,10 @@ class OfBlob final {
   void CopyShapeTo(int64_t* ptr, int64_t num_axis) const;
   void CopyStaticShapeTo(int64_t* ptr, int64_t num_axis) const;
   void CopyShapeFrom(const int64_t* ptr, int64_t num_axis) const;
+  bool is_body_in_host_mem() const { return blob_->mem_case().has_host_mem(); }
+  // the body memory itself, only valid until the kernel holding the blob returns
+  const void* body_dptr() const;
+  void* mut_body_dptr() const;
 
   int64_t TotalNumOfTensors() const;
   int64_t NumOfTensorListSlices() const;
@@ -93,6 +97,18 @@ inline void OfBlob::CopyStaticShapeTo(int64_t* ptr, int64_t num_axis) const {
   FOR_RANGE(int32_t, i, 0, num_axis) { ptr[i] = blob_->static_shape().At(i); }
 }
 
+inline const void* OfBlob::body_dptr() const {
+  CHECK(is_body_in_host_mem());
+  CHECK(!is_tensor_list());
+  return blob_->dptr();
+}
+
+inline void* OfBlob::mut_body_dptr() const {
+  CHECK(is_body_in_host_mem());
+  CHECK(!is_dynamic());
+  return blob_->mut_dptr();
+}
+
 inline int64_t OfBlob::TotalNumOfTensors() const { return blob_->total_num_of_tensors(); }
 
 inline int64_t OfBlob::NumOfTensorListSlices() const { return blob_->num_of_tensor_list_slices(); }
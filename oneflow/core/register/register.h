@@ -49,6 +49,10 @@ class Regst final {
   const std::vector<int64_t>& consumers_actor_id() const;
   const RtRegstDesc* regst_desc() const { return regst_desc_; }
   Blob* GetBlobByLbi(const LogicalBlobId& lbi);
+  // ordinal from RtRegstDesc::GetBlobOrdinal4Lbi
+  Blob* GetBlobByOrdinal(int64_t ordinal) {
+    return ordinal == -1 ? packed_blob_.get() : sorted_blobs_.at(ordinal);
+  }
   const Blob* GetSoleBlob() const;
   Blob* GetMutSoleBlob();
   int64_t GetBlobSize() const { return lbi2blob_.size(); }
@@ -73,6 +77,7 @@ class Regst final {
   RegstStatus status_;
   const RtRegstDesc* regst_desc_;
   HashMap<LogicalBlobId, std::unique_ptr<Blob>> lbi2blob_;
+  std::vector<Blob*> sorted_blobs_;
   std::unique_ptr<Blob> packed_blob_;
 };
 
@@ -162,6 +162,8 @@ void RegstMgr::NewBlobsInOneRegst(const std::vector<LbiBlobDescPair>& lbis, Regs
                                                       cur_body_pointer + body_offset));
           InitNonPODTypeBlobIfNeed(Global<MemoryAllocator>::Get(), blob_ptr.get());
         }
+        CHECK_EQ(rt_regst_desc->GetBlobOrdinal4Lbi(lbi.lbi()), regst->sorted_blobs_.size());
+        regst->sorted_blobs_.push_back(blob_ptr.get());
         CHECK(regst->lbi2blob_.emplace(lbi.lbi(), std::move(blob_ptr)).second);
         const int64_t regst_desc_id = rt_regst_desc->regst_desc_id();
         const auto& parallel_ctx = regst_desc_id2parallel_ctx_.at(regst_desc_id);
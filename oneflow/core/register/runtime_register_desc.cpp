@@ -27,9 +27,16 @@ RtRegstDesc::RtRegstDesc(const RegstDescProto& proto) {
   regst_desc_type_ = proto.regst_desc_type();
   if (proto.regst_desc_type().has_data_regst_desc()) {
     const DataRegstDesc& data_regst_desc = proto.regst_desc_type().data_regst_desc();
+    std::vector<LbiBlobDescPair> lbi_pairs;
     for (const LbiBlobDescPair& pair : data_regst_desc.lbi2blob_desc()) {
       auto blob_desc = std::make_unique<RtBlobDesc>(pair.blob_desc());
       CHECK(lbi2blob_desc_.emplace(pair.lbi(), std::move(blob_desc)).second);
+      lbi_pairs.push_back(pair);
+    }
+    // the order RegstMgr creates the blobs of a regst in
+    std::sort(lbi_pairs.begin(), lbi_pairs.end(), &CompareLbiBlobDescPair);
+    FOR_RANGE(int64_t, i, 0, lbi_pairs.size()) {
+      CHECK(lbi2blob_ordinal_.emplace(lbi_pairs.at(i).lbi(), i).second);
     }
     packed_blob_desc_.reset(new RtBlobDesc(data_regst_desc.packed_blob_desc()));
     CHECK(data_regst_desc.has_time_shape());
@@ -49,6 +56,16 @@ const RtBlobDesc* RtRegstDesc::GetRtBlobDescFromLbi(const LogicalBlobId& lbi) co
   }
 }
 
+int64_t RtRegstDesc::GetBlobOrdinal4Lbi(const LogicalBlobId& lbi) const {
+  auto it = lbi2blob_ordinal_.find(lbi);
+  if (it == lbi2blob_ordinal_.end()) {
+    CHECK(lbi.is_packed_id());
+    return -1;
+  } else {
+    return it->second;
+  }
+}
+
 size_t RtRegstDesc::TotalByteSize4AllRegst() const {
   return packed_blob_desc_->AlignedTotalByteSize() * register_num_;
 }
@@ -38,6 +38,8 @@ class RtRegstDesc {
   const RegstDescTypeProto& regst_desc_type() const { return regst_desc_type_; }
 
   const RtBlobDesc* GetRtBlobDescFromLbi(const LogicalBlobId& lbi) const;
+  // index of the blob of lbi in the regsts, -1 for the packed blob
+  int64_t GetBlobOrdinal4Lbi(const LogicalBlobId& lbi) const;
   const RtBlobDesc* packed_blob_desc() const { return packed_blob_desc_.get(); }
   size_t TotalByteSize4AllRegst() const;
   size_t TotalMainByteSize4AllRegst() const;
@@ -60,6 +62,7 @@ class RtRegstDesc {
   RegstDescTypeProto regst_desc_type_;
   MemoryCase mem_case_;
   HashMap<LogicalBlobId, std::unique_ptr<RtBlobDesc>> lbi2blob_desc_;
+  HashMap<LogicalBlobId, int64_t> lbi2blob_ordinal_;
   std::unique_ptr<RtBlobDesc> packed_blob_desc_;
   std::unique_ptr<Shape> data_regst_time_shape_;
 };
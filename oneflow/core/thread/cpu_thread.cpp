@@ -14,12 +14,41 @@ See the License for the specific language governing permissions and
 limitations under the License.
 */
 #include "oneflow/core/thread/cpu_thread.h"
+#include "oneflow/core/common/platform.h"
 
 namespace oneflow {
 
-CpuThread::CpuThread(int64_t thrd_id) {
+namespace {
+
+void BindCurThrdToCpu(int64_t cpu_idx) {
+#ifdef OF_PLATFORM_POSIX
+  cpu_set_t allowed_cpu_set;
+  CHECK_EQ(sched_getaffinity(0, sizeof(cpu_set_t), &allowed_cpu_set), 0);
+  std::vector<int> allowed_cpus;
+  FOR_RANGE(int, cpu, 0, CPU_SETSIZE) {
+    if (CPU_ISSET(cpu, &allowed_cpu_set)) { allowed_cpus.push_back(cpu); }
+  }
+  CHECK(!allowed_cpus.empty());
+  // cpus are numbered numa node by numa node, neighbouring threads share a node
+  cpu_set_t cpu_set;
+  CPU_ZERO(&cpu_set);
+  CPU_SET(allowed_cpus.at(cpu_idx % allowed_cpus.size()), &cpu_set);
+  CHECK_EQ(sched_setaffinity(0, sizeof(cpu_set_t), &cpu_set), 0);
+#else
+  static std::once_flag warn_once_flag;
+  std::call_once(warn_once_flag,
+                 []() { LOG(WARNING) << "cpu pinning is not supported, threads are not pinned"; });
+#endif
+}
+
+}  // namespace
+
+CpuThread::CpuThread(int64_t thrd_id) : CpuThread(thrd_id, -1) {}
+
+CpuThread::CpuThread(int64_t thrd_id, int64_t cpu_idx) {
   set_thrd_id(thrd_id);
-  mut_actor_thread() = std::thread([this]() {
+  mut_actor_thread() = std::thread([this, cpu_idx]() {
+    if (cpu_idx != -1) { BindCurThrdToCpu(cpu_idx); }
     ThreadCtx ctx;
 #ifdef WITH_CUDA
     ctx.cb_event_chan = nullptr;
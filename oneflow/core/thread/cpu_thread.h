@@ -27,6 +27,8 @@ class CpuThread final : public Thread {
   ~CpuThread() = default;
 
   CpuThread(int64_t thrd_id);
+  // bound to the cpu_idx-th, modulo their number, of the cpus the process may run on
+  CpuThread(int64_t thrd_id, int64_t cpu_idx);
 
  private:
 };
@@ -15,6 +15,7 @@ limitations under the License.
 */
 #include "oneflow/core/thread/thread.h"
 #include "oneflow/core/job/runtime_context.h"
+#include "oneflow/core/job/runtime_metrics.h"
 #include "oneflow/core/job/global_for.h"
 #include "oneflow/core/actor/actor.h"
 #include "oneflow/core/job/global_for.h"
@@ -41,13 +42,30 @@ void Thread::EnqueueActorMsg(const ActorMsg& msg) {
   }
 }
 
+void Thread::EnqueueActorMsgs(const std::vector<ActorMsg>& msgs) {
+  if (Global<ResourceDesc, ForSession>::Get()->thread_enable_local_message_queue()
+      && std::this_thread::get_id() == actor_thread_.get_id()) {
+    for (const ActorMsg& msg : msgs) { local_msg_queue_.push(msg); }
+  } else {
+    msg_channel_.SendMany(msgs);
+  }
+}
+
 void Thread::PollMsgChannel(const ThreadCtx& thread_ctx) {
+  ThreadMetrics* metrics = nullptr;
+  if (Global<RuntimeMetrics>::Get() != nullptr) {
+    metrics = Global<RuntimeMetrics>::Get()->NewThreadMetrics(thrd_id_);
+  }
   while (true) {
     if (local_msg_queue_.empty()) {
       CHECK_EQ(msg_channel_.ReceiveMany(&local_msg_queue_), kChannelStatusSuccess);
     }
     ActorMsg msg = std::move(local_msg_queue_.front());
     local_msg_queue_.pop();
+    if (metrics != nullptr) {
+      metrics->msg_cnt.Add(1);
+      metrics->mailbox_depth.Set(local_msg_queue_.size());
+    }
     if (msg.msg_type() == ActorMsgType::kCmdMsg) {
       if (msg.actor_cmd() == ActorCmd::kStopThread) {
         CHECK(id2actor_ptr_.empty());
@@ -59,17 +77,28 @@ void Thread::PollMsgChannel(const ThreadCtx& thread_ctx) {
         // do nothing
       }
     }
-    int64_t actor_id = msg.dst_actor_id();
-    auto actor_it = id2actor_ptr_.find(actor_id);
-    CHECK(actor_it != id2actor_ptr_.end());
-    int process_msg_ret = actor_it->second->ProcessMsg(msg);
-    if (process_msg_ret == 1) {
-      LOG(INFO) << "thread " << thrd_id_ << " deconstruct actor " << actor_id;
-      id2actor_ptr_.erase(actor_it);
-      Global<RuntimeCtx>::Get()->DecreaseCounter("running_actor_cnt");
-    } else {
-      CHECK_EQ(process_msg_ret, 0);
+    if (msg.msg_type() == ActorMsgType::kRegstAcksMsg) {
+      FOR_RANGE(int64_t, i, 0, msg.acked_regst_num()) {
+        ProcessActorMsg(ActorMsg::BuildRegstMsgToProducer(msg.src_actor_id(), msg.dst_actor_id(),
+                                                          msg.acked_regst(i)));
+      }
+      continue;
     }
+    ProcessActorMsg(msg);
+  }
+}
+
+void Thread::ProcessActorMsg(const ActorMsg& msg) {
+  int64_t actor_id = msg.dst_actor_id();
+  auto actor_it = id2actor_ptr_.find(actor_id);
+  CHECK(actor_it != id2actor_ptr_.end());
+  int process_msg_ret = actor_it->second->ProcessMsg(msg);
+  if (process_msg_ret == 1) {
+    LOG(INFO) << "thread " << thrd_id_ << " deconstruct actor " << actor_id;
+    id2actor_ptr_.erase(actor_it);
+    Global<RuntimeCtx>::Get()->DecreaseCounter("running_actor_cnt");
+  } else {
+    CHECK_EQ(process_msg_ret, 0);
   }
 }
 
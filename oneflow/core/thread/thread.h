@@ -34,6 +34,7 @@ class Thread {
 
   Channel<ActorMsg>* GetMsgChannelPtr() { return &msg_channel_; }
   void EnqueueActorMsg(const ActorMsg& msg);
+  void EnqueueActorMsgs(const std::vector<ActorMsg>& msgs);
 
   void JoinAllActor() { actor_thread_.join(); }
 
@@ -45,6 +46,7 @@ class Thread {
 
  private:
   void ConstructActor(int64_t actor_id, const ThreadCtx& thread_ctx);
+  void ProcessActorMsg(const ActorMsg& msg);
 
   HashMap<int64_t, TaskProto> id2task_;
   std::mutex id2task_mtx_;
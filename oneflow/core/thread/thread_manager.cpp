@@ -46,8 +46,10 @@ ThreadMgr::ThreadMgr(const Plan& plan) {
     }
   }
 #endif
+  const bool pin_cpu_device_threads =
+      Global<ResourceDesc, ForSession>::Get()->pin_cpu_device_threads();
   FOR_RANGE(int64_t, i, 0, (Global<ResourceDesc, ForSession>::Get()->CpuDeviceNum())) {
-    threads_.push_back(new CpuThread(thrd_id++));
+    threads_.push_back(new CpuThread(thrd_id++, pin_cpu_device_threads ? i : -1));
   }
   threads_.push_back(new CpuThread(thrd_id++));  // comm_net
   CreatePersistenceThrd(plan, thrd_id);
@@ -84,4 +86,23 @@ void MultiThreadLoop(size_t num, std::function<void(size_t i)> Callback) {
   bc.WaitUntilCntEqualZero();
 }
 
+int64_t GetMultiThreadLoopRangeNum(int64_t num, int64_t min_range_size) {
+  const ThreadPool* thread_pool = Global<ThreadPool>::Get();
+  if (thread_pool == nullptr || ThreadPool::IsCurrentThreadWorker()) { return 1; }
+  return std::max<int64_t>(
+      std::min<int64_t>(thread_pool->thread_num(), num / std::max<int64_t>(min_range_size, 1)), 1);
+}
+
+void MultiThreadLoopInRanges(
+    int64_t num, int64_t min_range_size,
+    const std::function<void(int64_t range_id, int64_t begin, int64_t end)>& Handler) {
+  const int64_t range_num = GetMultiThreadLoopRangeNum(num, min_range_size);
+  if (range_num == 1) {
+    Handler(0, 0, num);
+    return;
+  }
+  BalancedSplitter bs(num, range_num);
+  MultiThreadLoop(range_num, [&](size_t i) { Handler(i, bs.At(i).begin(), bs.At(i).end()); });
+}
+
 }  // namespace oneflow
@@ -45,6 +45,14 @@ class ThreadMgr final {
 void SingleThreadLoop(size_t num, std::function<void(size_t i)> Callback);
 void MultiThreadLoop(size_t num, std::function<void(size_t i)> Callback);
 
+// Splits [0, num) into balanced ranges of at least min_range_size and handles them on the
+// ThreadPool. The ranges are handled on the calling thread if there is only one, if there is no
+// ThreadPool or if the caller is a thread of the pool itself.
+int64_t GetMultiThreadLoopRangeNum(int64_t num, int64_t min_range_size);
+void MultiThreadLoopInRanges(
+    int64_t num, int64_t min_range_size,
+    const std::function<void(int64_t range_id, int64_t begin, int64_t end)>& Handler);
+
 }  // namespace oneflow
 
 #endif  // ONEFLOW_CORE_THREAD_THREAD_MANAGER_H_
@@ -31,6 +31,10 @@ class ThreadPool final {
   int32_t thread_num() const { return threads_.size(); }
   void AddWork(const std::function<void()>& work);
 
+  // Work running on a pool thread must not wait for other work of a pool, e.g. by a nested
+  // MultiThreadLoop, since all threads of the pool may end up waiting.
+  static bool IsCurrentThreadWorker();
+
  private:
   std::vector<Channel<std::function<void()>>> work_chans_;
   std::vector<std::thread> threads_;
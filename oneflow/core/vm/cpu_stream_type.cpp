@@ -19,6 +19,7 @@ limitations under the License.
 #include "oneflow/core/vm/instruction.msg.h"
 #include "oneflow/core/vm/thread_ctx.msg.h"
 #include "oneflow/core/vm/naive_instruction_status_querier.h"
+#include "oneflow/core/vm/stream_ordered_allocator.h"
 #include "oneflow/core/device/cpu_device_context.h"
 #include "oneflow/core/common/util.h"
 
@@ -26,7 +27,8 @@ namespace oneflow {
 namespace vm {
 
 void CpuStreamType::InitDeviceCtx(std::unique_ptr<DeviceCtx>* device_ctx, Stream* stream) const {
-  device_ctx->reset(new CpuDeviceCtx());
+  device_ctx->reset(new CpuDeviceCtx(std::unique_ptr<Allocator>(
+      new StreamOrderedAllocator(std::unique_ptr<Allocator>(new CpuAllocator())))));
 }
 
 void CpuStreamType::InitInstructionStatus(const Stream& stream,
@@ -21,7 +21,7 @@ limitations under the License.
 #include "oneflow/core/device/cuda_stream_handle.h"
 #include "oneflow/core/common/callback.msg.h"
 #include "oneflow/core/vm/cuda_allocator.h"
-#include "oneflow/core/vm/thread_safe_allocator.h"
+#include "oneflow/core/vm/stream_ordered_allocator.h"
 
 namespace oneflow {
 namespace vm {
@@ -38,7 +38,7 @@ class CudaStreamHandleDeviceCtx : public DeviceCtx {
       : cuda_handler_(new CudaStreamHandle(nullptr)),
         callback_msg_list_(callback_msg_list),
         cuda_allocator_(
-            new ThreadSafeAllocator(std::unique_ptr<Allocator>(new CudaAllocator(device_id)))) {}
+            new StreamOrderedAllocator(std::unique_ptr<Allocator>(new CudaAllocator(device_id)))) {}
 
   const cudaStream_t& cuda_stream() const override { return *(cuda_handler_->cuda_stream()); }
   const cublasHandle_t& cublas_pmh_handle() const override {
@@ -0,0 +1,219 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/vm/stream_ordered_allocator.h"
+
+namespace oneflow {
+namespace vm {
+
+namespace {
+
+std::mutex* MutRegistryMutex() {
+  static std::mutex mutex;
+  return &mutex;
+}
+
+HashSet<StreamOrderedAllocator*>* MutRegisteredAllocators() {
+  static HashSet<StreamOrderedAllocator*> allocators;
+  return &allocators;
+}
+
+void UpdatePeak(std::atomic<int64_t>* peak, int64_t value) {
+  int64_t cur_peak = *peak;
+  while (value > cur_peak && !peak->compare_exchange_weak(cur_peak, value)) {}
+}
+
+}  // namespace
+
+StreamOrderedAllocator::StreamOrderedAllocator(std::unique_ptr<Allocator>&& backend_allocator,
+                                               size_t max_cached_bytes)
+    : Allocator(),
+      backend_allocator_(std::move(backend_allocator)),
+      max_cached_bytes_(max_cached_bytes),
+      owner_thread_id_inited_(false),
+      has_pending_free_blocks_(false),
+      allocate_cnt_(0),
+      free_list_hit_cnt_(0),
+      backend_allocate_cnt_(0),
+      in_use_bytes_(0),
+      peak_in_use_bytes_(0),
+      cached_bytes_(0),
+      backend_bytes_(0),
+      peak_backend_bytes_(0) {
+  std::unique_lock<std::mutex> lock(*MutRegistryMutex());
+  CHECK(MutRegisteredAllocators()->insert(this).second);
+}
+
+StreamOrderedAllocator::~StreamOrderedAllocator() {
+  {
+    std::unique_lock<std::mutex> lock(*MutRegistryMutex());
+    CHECK_EQ(MutRegisteredAllocators()->erase(this), 1);
+  }
+  {
+    std::unique_lock<std::mutex> lock(pending_mutex_);
+    for (const auto& pair : pending_free_blocks_) { BackendDeallocate(pair.first, pair.second); }
+    pending_free_blocks_.clear();
+  }
+  ReleaseFreeListToBackend();
+}
+
+bool StreamOrderedAllocator::IsOwnerThread() {
+  if (!owner_thread_id_inited_) {
+    std::unique_lock<std::mutex> lock(owner_thread_id_mutex_);
+    if (!owner_thread_id_inited_) {
+      owner_thread_id_ = std::this_thread::get_id();
+      owner_thread_id_inited_ = true;
+    }
+  }
+  return owner_thread_id_ == std::this_thread::get_id();
+}
+
+void StreamOrderedAllocator::Allocate(char** mem_ptr, std::size_t size) {
+  if (size == 0) {
+    *mem_ptr = nullptr;
+    return;
+  }
+  ++allocate_cnt_;
+  if (IsOwnerThread()) {
+    if (has_pending_free_blocks_) { DrainPendingFreeBlocks(); }
+    if (TryAllocateFromFreeList(mem_ptr, size)) {
+      ++free_list_hit_cnt_;
+      IncreaseInUseBytes(size);
+      return;
+    }
+    // Idle cached blocks are handed back so that the backend can coalesce them into a block
+    // large enough for this request instead of growing.
+    if (cached_bytes_ >= static_cast<int64_t>(size)) { ReleaseFreeListToBackend(); }
+  }
+  BackendAllocate(mem_ptr, size);
+  IncreaseInUseBytes(size);
+}
+
+void StreamOrderedAllocator::Deallocate(char* mem_ptr, std::size_t size) {
+  if (mem_ptr == nullptr) { return; }
+  in_use_bytes_ -= size;
+  if (IsOwnerThread()) {
+    PushFreeBlock(mem_ptr, size);
+  } else {
+    std::unique_lock<std::mutex> lock(pending_mutex_);
+    pending_free_blocks_.emplace_back(mem_ptr, size);
+    has_pending_free_blocks_ = true;
+  }
+}
+
+void StreamOrderedAllocator::DrainPendingFreeBlocks() {
+  std::vector<std::pair<char*, std::size_t>> pending_free_blocks;
+  {
+    std::unique_lock<std::mutex> lock(pending_mutex_);
+    pending_free_blocks.swap(pending_free_blocks_);
+    has_pending_free_blocks_ = false;
+  }
+  for (const auto& pair : pending_free_blocks) { PushFreeBlock(pair.first, pair.second); }
+}
+
+bool StreamOrderedAllocator::TryAllocateFromFreeList(char** mem_ptr, std::size_t size) {
+  auto iter = size2free_blocks_.find(size);
+  if (iter == size2free_blocks_.end() || iter->second.empty()) { return false; }
+  *mem_ptr = iter->second.back();
+  iter->second.pop_back();
+  cached_bytes_ -= size;
+  return true;
+}
+
+void StreamOrderedAllocator::PushFreeBlock(char* mem_ptr, std::size_t size) {
+  if (cached_bytes_ + static_cast<int64_t>(size) > static_cast<int64_t>(max_cached_bytes_)) {
+    BackendDeallocate(mem_ptr, size);
+    return;
+  }
+  size2free_blocks_[size].push_back(mem_ptr);
+  cached_bytes_ += size;
+}
+
+void StreamOrderedAllocator::ReleaseFreeListToBackend() {
+  for (auto& pair : size2free_blocks_) {
+    for (char* mem_ptr : pair.second) {
+      BackendDeallocate(mem_ptr, pair.first);
+      cached_bytes_ -= pair.first;
+    }
+  }
+  size2free_blocks_.clear();
+}
+
+void StreamOrderedAllocator::BackendAllocate(char** mem_ptr, std::size_t size) {
+  {
+    std::unique_lock<std::mutex> lock(backend_mutex_);
+    backend_allocator_->Allocate(mem_ptr, size);
+  }
+  ++backend_allocate_cnt_;
+  UpdatePeak(&peak_backend_bytes_, backend_bytes_ += size);
+}
+
+void StreamOrderedAllocator::BackendDeallocate(char* mem_ptr, std::size_t size) {
+  {
+    std::unique_lock<std::mutex> lock(backend_mutex_);
+    backend_allocator_->Deallocate(mem_ptr, size);
+  }
+  backend_bytes_ -= size;
+}
+
+void StreamOrderedAllocator::IncreaseInUseBytes(int64_t bytes) {
+  UpdatePeak(&peak_in_use_bytes_, in_use_bytes_ += bytes);
+}
+
+StreamOrderedAllocatorStat StreamOrderedAllocator::GetStat() const {
+  StreamOrderedAllocatorStat stat;
+  stat.allocate_cnt = allocate_cnt_;
+  stat.free_list_hit_cnt = free_list_hit_cnt_;
+  stat.backend_allocate_cnt = backend_allocate_cnt_;
+  stat.in_use_bytes = in_use_bytes_;
+  stat.peak_in_use_bytes = peak_in_use_bytes_;
+  stat.cached_bytes = cached_bytes_;
+  stat.backend_bytes = backend_bytes_;
+  stat.peak_backend_bytes = peak_backend_bytes_;
+  return stat;
+}
+
+void StreamOrderedAllocator::ResetPeakStat() {
+  peak_in_use_bytes_ = static_cast<int64_t>(in_use_bytes_);
+  peak_backend_bytes_ = static_cast<int64_t>(backend_bytes_);
+}
+
+StreamOrderedAllocatorStat StreamOrderedAllocator::GetGlobalStat() {
+  StreamOrderedAllocatorStat global_stat;
+  std::unique_lock<std::mutex> lock(*MutRegistryMutex());
+  for (const StreamOrderedAllocator* allocator : *MutRegisteredAllocators()) {
+    const StreamOrderedAllocatorStat& stat = allocator->GetStat();
+    global_stat.allocate_cnt += stat.allocate_cnt;
+    global_stat.free_list_hit_cnt += stat.free_list_hit_cnt;
+    global_stat.backend_allocate_cnt += stat.backend_allocate_cnt;
+    global_stat.in_use_bytes += stat.in_use_bytes;
+    // peaks of different streams are not simultaneous, so their sum is an upper bound
+    global_stat.peak_in_use_bytes += stat.peak_in_use_bytes;
+    global_stat.cached_bytes += stat.cached_bytes;
+    global_stat.backend_bytes += stat.backend_bytes;
+    global_stat.peak_backend_bytes += stat.peak_backend_bytes;
+  }
+  return global_stat;
+}
+
+void StreamOrderedAllocator::ResetGlobalPeakStat() {
+  std::unique_lock<std::mutex> lock(*MutRegistryMutex());
+  for (StreamOrderedAllocator* allocator : *MutRegisteredAllocators()) {
+    allocator->ResetPeakStat();
+  }
+}
+
+}  // namespace vm
+}  // namespace oneflow
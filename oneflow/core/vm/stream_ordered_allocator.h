@@ -0,0 +1,108 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifndef ONEFLOW_CORE_VM_STREAM_ORDERED_ALLOCATOR_H_
+#define ONEFLOW_CORE_VM_STREAM_ORDERED_ALLOCATOR_H_
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "oneflow/core/vm/allocator.h"
+#include "oneflow/core/common/util.h"
+
+namespace oneflow {
+namespace vm {
+
+struct StreamOrderedAllocatorStat final {
+  int64_t allocate_cnt = 0;
+  int64_t free_list_hit_cnt = 0;
+  int64_t backend_allocate_cnt = 0;
+  int64_t in_use_bytes = 0;
+  int64_t peak_in_use_bytes = 0;
+  int64_t cached_bytes = 0;
+  int64_t backend_bytes = 0;
+  int64_t peak_backend_bytes = 0;
+};
+
+// StreamOrderedAllocator is owned by the DeviceCtx of one vm stream and caches freed blocks
+// in a per-stream free list keyed by size.
+//
+// Instructions on one stream are launched in order, so a block freed by the stream's own thread
+// can be handed to the next instruction of the same stream right away without any
+// synchronization. A block freed by another thread (e.g. TryClearObject on the device helper
+// stream) is only released after the vm has observed the completion of every instruction
+// accessing it. Such blocks are parked in a pending list and moved into the free list by the
+// owner thread on its next Allocate().
+class StreamOrderedAllocator final : public Allocator {
+ public:
+  OF_DISALLOW_COPY_AND_MOVE(StreamOrderedAllocator);
+  explicit StreamOrderedAllocator(std::unique_ptr<Allocator>&& backend_allocator)
+      : StreamOrderedAllocator(std::move(backend_allocator), kDefaultMaxCachedBytes) {}
+  StreamOrderedAllocator(std::unique_ptr<Allocator>&& backend_allocator, size_t max_cached_bytes);
+  ~StreamOrderedAllocator() override;
+
+  static constexpr size_t kDefaultMaxCachedBytes = 1024LL * 1024 * 1024;
+
+  void Allocate(char** mem_ptr, std::size_t size) override;
+  void Deallocate(char* mem_ptr, std::size_t size) override;
+
+  StreamOrderedAllocatorStat GetStat() const;
+  void ResetPeakStat();
+
+  // Sums up the stats of all living StreamOrderedAllocators in this process
+  static StreamOrderedAllocatorStat GetGlobalStat();
+  static void ResetGlobalPeakStat();
+
+ private:
+  bool IsOwnerThread();
+  void DrainPendingFreeBlocks();
+  bool TryAllocateFromFreeList(char** mem_ptr, std::size_t size);
+  void PushFreeBlock(char* mem_ptr, std::size_t size);
+  void ReleaseFreeListToBackend();
+  void BackendAllocate(char** mem_ptr, std::size_t size);
+  void BackendDeallocate(char* mem_ptr, std::size_t size);
+  void IncreaseInUseBytes(int64_t bytes);
+
+  std::unique_ptr<Allocator> backend_allocator_;
+  std::mutex backend_mutex_;
+  const size_t max_cached_bytes_;
+
+  std::atomic<bool> owner_thread_id_inited_;
+  std::thread::id owner_thread_id_;
+  std::mutex owner_thread_id_mutex_;
+
+  // only accessed by the owner thread
+  HashMap<std::size_t, std::vector<char*>> size2free_blocks_;
+
+  std::mutex pending_mutex_;
+  std::vector<std::pair<char*, std::size_t>> pending_free_blocks_;
+  std::atomic<bool> has_pending_free_blocks_;
+
+  std::atomic<int64_t> allocate_cnt_;
+  std::atomic<int64_t> free_list_hit_cnt_;
+  std::atomic<int64_t> backend_allocate_cnt_;
+  std::atomic<int64_t> in_use_bytes_;
+  std::atomic<int64_t> peak_in_use_bytes_;
+  std::atomic<int64_t> cached_bytes_;
+  std::atomic<int64_t> backend_bytes_;
+  std::atomic<int64_t> peak_backend_bytes_;
+};
+
+}  // namespace vm
+}  // namespace oneflow
+
+#endif  // ONEFLOW_CORE_VM_STREAM_ORDERED_ALLOCATOR_H_
@@ -0,0 +1,59 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/vm/stream_ordered_allocator.h"
+#include "oneflow/core/vm/cpu_allocator.h"
+
+namespace oneflow {
+namespace vm {
+
+namespace test {
+
+TEST(StreamOrderedAllocator, reuse_on_owner_thread) {
+  StreamOrderedAllocator allocator(std::unique_ptr<Allocator>(new CpuAllocator()));
+  char* ptr0 = nullptr;
+  allocator.Allocate(&ptr0, 1024);
+  ASSERT_TRUE(ptr0 != nullptr);
+  allocator.Deallocate(ptr0, 1024);
+  char* ptr1 = nullptr;
+  allocator.Allocate(&ptr1, 1024);
+  ASSERT_EQ(ptr0, ptr1);
+  const StreamOrderedAllocatorStat& stat = allocator.GetStat();
+  ASSERT_EQ(stat.allocate_cnt, 2);
+  ASSERT_EQ(stat.free_list_hit_cnt, 1);
+  ASSERT_EQ(stat.backend_allocate_cnt, 1);
+  ASSERT_EQ(stat.in_use_bytes, 1024);
+  ASSERT_EQ(stat.peak_in_use_bytes, 1024);
+  allocator.Deallocate(ptr1, 1024);
+}
+
+TEST(StreamOrderedAllocator, defer_free_from_other_thread) {
+  StreamOrderedAllocator allocator(std::unique_ptr<Allocator>(new CpuAllocator()));
+  char* ptr0 = nullptr;
+  allocator.Allocate(&ptr0, 256);
+  std::thread([&]() { allocator.Deallocate(ptr0, 256); }).join();
+  ASSERT_EQ(allocator.GetStat().cached_bytes, 0);
+  char* ptr1 = nullptr;
+  allocator.Allocate(&ptr1, 256);
+  ASSERT_EQ(ptr0, ptr1);
+  ASSERT_EQ(allocator.GetStat().free_list_hit_cnt, 1);
+  allocator.Deallocate(ptr1, 256);
+  ASSERT_EQ(allocator.GetStat().cached_bytes, 256);
+}
+
+}  // namespace test
+
+}  // namespace vm
+}  // namespace oneflow
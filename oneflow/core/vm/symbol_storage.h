@@ -16,8 +16,8 @@ limitations under the License.
 #ifndef ONEFLOW_CORE_VM_STORAGE_H_
 #define ONEFLOW_CORE_VM_STORAGE_H_
 
-#include <mutex>
 #include "oneflow/core/common/util.h"
+#include "oneflow/core/common/left_right.h"
 #include "oneflow/core/common/maybe.h"
 
 namespace oneflow {
@@ -50,8 +50,9 @@ class SymbolStorage final {
   ~SymbolStorage() = default;
 
   bool Has(int64_t logical_object_id) const {
-    std::unique_lock<std::mutex> lock(mutex_);
-    return logical_object_id2data_.find(logical_object_id) != logical_object_id2data_.end();
+    return logical_object_id2data_.Read([&](const Id2Data& id2data) {
+      return id2data.find(logical_object_id) != id2data.end();
+    });
   }
 
   Maybe<const T&> MaybeGet(int64_t logical_object_id) const {
@@ -61,38 +62,45 @@ class SymbolStorage final {
   const T& Get(int64_t logical_object_id) const { return *GetPtr(logical_object_id); }
 
   Maybe<T> MaybeGetPtr(int64_t logical_object_id) const {
-    std::unique_lock<std::mutex> lock(mutex_);
-    const auto& iter = logical_object_id2data_.find(logical_object_id);
-    CHECK_OR_RETURN(iter != logical_object_id2data_.end())
-        << "logical_object_id: " << logical_object_id;
-    return iter->second;
+    std::shared_ptr<T> ptr = FindPtr(logical_object_id);
+    CHECK_OR_RETURN(ptr) << "logical_object_id: " << logical_object_id;
+    return ptr;
   }
 
-  const std::shared_ptr<T>& GetPtr(int64_t logical_object_id) const {
-    std::unique_lock<std::mutex> lock(mutex_);
-    const auto& iter = logical_object_id2data_.find(logical_object_id);
-    CHECK(iter != logical_object_id2data_.end());
-    return iter->second;
+  std::shared_ptr<T> GetPtr(int64_t logical_object_id) const {
+    std::shared_ptr<T> ptr = FindPtr(logical_object_id);
+    CHECK(ptr);
+    return ptr;
   }
 
   void Add(int64_t logical_object_id, const typename ConstructArgType4Symbol<T>::type& data) {
     CHECK_GT(logical_object_id, 0);
     const auto& ptr = std::make_shared<T>(data);
-    std::unique_lock<std::mutex> lock(mutex_);
-    CHECK(logical_object_id2data_.emplace(logical_object_id, ptr).second);
+    logical_object_id2data_.Write([&](Id2Data* id2data) {
+      CHECK(id2data->emplace(logical_object_id, ptr).second);
+    });
   }
   void Clear(int64_t logical_object_id) {
-    std::unique_lock<std::mutex> lock(mutex_);
-    logical_object_id2data_.erase(logical_object_id);
+    logical_object_id2data_.Write([&](Id2Data* id2data) { id2data->erase(logical_object_id); });
   }
   void ClearAll() {
-    std::unique_lock<std::mutex> lock(mutex_);
-    logical_object_id2data_.clear();
+    logical_object_id2data_.Write([](Id2Data* id2data) { id2data->clear(); });
   }
 
  private:
-  mutable std::mutex mutex_;
-  HashMap<int64_t, std::shared_ptr<T>> logical_object_id2data_;
+  using Id2Data = HashMap<int64_t, std::shared_ptr<T>>;
+
+  // Copied under the read guard, a concurrent Clear may erase the node right after it
+  std::shared_ptr<T> FindPtr(int64_t logical_object_id) const {
+    return logical_object_id2data_.Read([&](const Id2Data& id2data) -> std::shared_ptr<T> {
+      const auto& iter = id2data.find(logical_object_id);
+      if (iter == id2data.end()) { return nullptr; }
+      return iter->second;
+    });
+  }
+
+  // Symbols are looked up by every eager instruction and added once, readers do not lock
+  LeftRight<Id2Data> logical_object_id2data_;
 };
 
 }  // namespace vm
@@ -289,6 +289,130 @@ def enable_debug_mode(val):
     sess.config_proto.resource.enable_debug_mode = val
 
 
+@oneflow_export("config.plan_cache_dir")
+def api_plan_cache_dir(val: str) -> None:
+    r"""Set the directory compiled plans are cached in. A later session compiling the same jobs
+    on the same resource loads the plan from it instead of compiling again.
+
+    Args:
+        val (str): directory path, an empty string disables the cache
+    """
+    return enable_if.unique([plan_cache_dir, do_nothing])(val)
+
+
+@enable_if.condition(hob.in_normal_mode & ~hob.session_initialized)
+def plan_cache_dir(val):
+    sess = session_ctx.GetDefaultSession()
+    assert type(val) is str
+    sess.config_proto.resource.plan_cache_dir = val
+
+
+@oneflow_export("config.enable_plan_cache")
+def api_enable_plan_cache(val: bool = True) -> None:
+    r"""Whether to use the plan cache set by config.plan_cache_dir or not.
+
+    Args:
+        val (bool, optional): True or False. Defaults to True.
+    """
+    return enable_if.unique([enable_plan_cache, do_nothing])(val)
+
+
+@enable_if.condition(hob.in_normal_mode & ~hob.session_initialized)
+def enable_plan_cache(val):
+    sess = session_ctx.GetDefaultSession()
+    assert type(val) is bool
+    sess.config_proto.resource.enable_plan_cache = val
+
+
+@oneflow_export("config.cpu_actor_profile_path")
+def api_cpu_actor_profile_path(val: str) -> None:
+    r"""Set the path of a cpu actor profile, e.g. the cpu_actor_profile dumped to the log dir when
+    the profiler collects act events. Cpu compute tasks are then spread over the cpu threads by
+    their measured act times instead of round robin.
+
+    Args:
+        val (str): file path, an empty string spreads the tasks round robin
+    """
+    return enable_if.unique([cpu_actor_profile_path, do_nothing])(val)
+
+
+@enable_if.condition(hob.in_normal_mode & ~hob.session_initialized)
+def cpu_actor_profile_path(val):
+    sess = session_ctx.GetDefaultSession()
+    assert type(val) is str
+    sess.config_proto.resource.cpu_actor_profile_path = val
+
+
+@oneflow_export("config.pin_cpu_device_threads")
+def api_pin_cpu_device_threads(val: bool = True) -> None:
+    r"""Whether to bind each cpu compute thread to one cpu or not.
+
+    Args:
+        val (bool, optional): True or False. Defaults to True.
+    """
+    return enable_if.unique([pin_cpu_device_threads, do_nothing])(val)
+
+
+@enable_if.condition(hob.in_normal_mode & ~hob.session_initialized)
+def pin_cpu_device_threads(val):
+    sess = session_ctx.GetDefaultSession()
+    assert type(val) is bool
+    sess.config_proto.resource.pin_cpu_device_threads = val
+
+
+@oneflow_export("config.metrics_port")
+def api_metrics_port(val: int) -> None:
+    r"""Serve the live runtime metrics of the actors, regsts, threads and comm net peers in the
+    Prometheus text format on http://127.0.0.1:<val>/metrics.
+
+    Args:
+        val (int): port number, 0 does not serve them
+    """
+    return enable_if.unique([metrics_port, do_nothing])(val)
+
+
+@enable_if.condition(hob.in_normal_mode & ~hob.session_initialized)
+def metrics_port(val):
+    sess = session_ctx.GetDefaultSession()
+    assert type(val) is int
+    sess.config_proto.resource.metrics_port = val
+
+
+@oneflow_export("config.metrics_path")
+def api_metrics_path(val: str) -> None:
+    r"""Rewrite the live runtime metrics in the Prometheus text format to a file periodically,
+    e.g. for the textfile collector of the node exporter.
+
+    Args:
+        val (str): file path, an empty string does not write them
+    """
+    return enable_if.unique([metrics_path, do_nothing])(val)
+
+
+@enable_if.condition(hob.in_normal_mode & ~hob.session_initialized)
+def metrics_path(val):
+    sess = session_ctx.GetDefaultSession()
+    assert type(val) is str
+    sess.config_proto.resource.metrics_path = val
+
+
+@oneflow_export("config.metrics_dump_interval_ms")
+def api_metrics_dump_interval_ms(val: int) -> None:
+    r"""Set the interval the file set by config.metrics_path is rewritten at.
+
+    Args:
+        val (int): interval in milliseconds
+    """
+    return enable_if.unique([metrics_dump_interval_ms, do_nothing])(val)
+
+
+@enable_if.condition(hob.in_normal_mode & ~hob.session_initialized)
+def metrics_dump_interval_ms(val):
+    sess = session_ctx.GetDefaultSession()
+    assert type(val) is int
+    sess.config_proto.resource.metrics_dump_interval_ms = val
+
+
 @oneflow_export("config.save_downloaded_file_to_local_fs")
 def api_save_downloaded_file_to_local_fs(val: bool = True) -> None:
     r"""Whether or not save downloaded file to local file system.
@@ -353,8 +477,26 @@ def api_collect_act_event(val: bool = True) -> None:
 @enable_if.condition(hob.in_normal_mode & ~hob.session_initialized)
 def collect_act_event(val=True):
     sess = session_ctx.GetDefaultSession()
-    assert type(val) is int
-    sess.config_proto.profile_conf.collect_act_event = val
+    assert type(val) is bool
+    sess.config_proto.profiler_conf.collect_act_event = val
+
+
+@oneflow_export("config.collect_perf_counters")
+def api_collect_perf_counters(val: bool = True) -> None:
+    r"""Whether or not collect hardware perf counters of the cpu acts along with the act events.
+    They need linux and a kernel.perf_event_paranoid not above 2.
+
+    Args:
+        val (bool, optional): True or False. Defaults to True.
+    """
+    return enable_if.unique([collect_perf_counters, do_nothing])(val=val)
+
+
+@enable_if.condition(hob.in_normal_mode & ~hob.session_initialized)
+def collect_perf_counters(val=True):
+    sess = session_ctx.GetDefaultSession()
+    assert type(val) is bool
+    sess.config_proto.profiler_conf.collect_perf_counters = val
 
 
 @oneflow_export("config.collective_boxing.enable_fusion")
@@ -152,6 +152,22 @@ def data_port(val):
     default_env_proto.data_port = val
 
 
+@oneflow_export("env.ctrl_server_thread_num")
+def api_ctrl_server_thread_num(val: int) -> None:
+    r"""Set the number of threads handling the control rpcs of each machine. Same on every machine.
+
+    Args:
+        val: number of threads
+    """
+    return enable_if.unique([ctrl_server_thread_num, do_nothing])(val)
+
+
+@enable_if.condition(hob.in_normal_mode & ~hob.env_initialized)
+def ctrl_server_thread_num(val):
+    assert type(val) is int
+    default_env_proto.ctrl_server_thread_num = val
+
+
 @oneflow_export("env.grpc_use_no_signal")
 @oneflow_deprecate()
 def api_grpc_use_no_signal(val: bool = True) -> None:
@@ -342,10 +342,36 @@ def policy_time_line(func_desc):
     return "use_time_line_algo"
 
 
+@oneflow_function_config("static_mem_alloc_policy_white_list.policy_best_fit_search")
+def policy_best_fit_search(func_desc):
+    r"""A static memory allocation policy called: best_fit_search
+
+    Args:
+        func_desc ([type]): [description]
+
+    Returns:
+        [type]: [description]
+    """
+    return "use_best_fit_search_algo"
+
+
+@oneflow_function_config("static_mem_alloc_best_fit_search_budget")
+def set_static_mem_alloc_best_fit_search_budget(func_desc, value):
+    r"""Set the work the best_fit_search policy may spend on each memory chain
+
+    Args:
+        func_desc ([type]): [description]
+        value ([type]): regsts placed plus mutual exclusions visited
+    """
+    conf = func_desc.job_config_proto.memory_allocation_algorithm_conf
+    conf.best_fit_search_budget = value
+
+
 @oneflow_function_config("static_mem_alloc_algo_white_list.show")
 def show_static_mem_alloc_algo_white_list(func_desc):
     r"""Show configuration of  static memory allocation policy,
-          including: "use_mem_size_first_algo", "use_mutual_exclusion_first_algo", "use_time_line_algo"
+          including: "use_mem_size_first_algo", "use_mutual_exclusion_first_algo", "use_time_line_algo",
+          "use_best_fit_search_algo"
 
     Args:
         func_desc ([type]): [description]
@@ -357,6 +383,7 @@ def show_static_mem_alloc_algo_white_list(func_desc):
         "use_mem_size_first_algo",
         "use_mutual_exclusion_first_algo",
         "use_time_line_algo",
+        "use_best_fit_search_algo",
     ]
 
 
@@ -568,6 +595,64 @@ def set_enable_non_distributed_optimizer(func_desc, value=True):
     func_desc.job_config_proto.enable_non_distributed_optimizer = value
 
 
+@oneflow_function_config("enable_auto_sbp")
+def set_enable_auto_sbp(func_desc, value=True):
+    r"""Whether choose the sbp signatures of ops by a cost model over the whole job or not
+
+    Args:
+        func_desc ([type]): [description]
+        value (bool, optional): [description]. Defaults to True.
+    """
+    func_desc.job_config_proto.enable_auto_sbp = value
+
+
+@oneflow_function_config("sbp_cost_model_path")
+def set_sbp_cost_model_path(func_desc, value):
+    r"""Set the path of the text format SbpCostModelConf used by enable_auto_sbp,
+    e.g. the sbp_cost_model calibrated by an experiment run
+
+    Args:
+        func_desc ([type]): [description]
+        value ([type]): [description]
+    """
+    func_desc.job_config_proto.sbp_cost_model_path = value
+
+
+@oneflow_function_config("enable_analytic_regst_num_tuning")
+def set_enable_analytic_regst_num_tuning(func_desc, value=True):
+    r"""Whether size the register nums by act times estimated from the cost model of
+    sbp_cost_model_path when there is no experiment run or not
+
+    Args:
+        func_desc ([type]): [description]
+        value (bool, optional): [description]. Defaults to True.
+    """
+    func_desc.job_config_proto.enable_analytic_regst_num_tuning = value
+
+
+@oneflow_function_config("analytic_regst_num_mem_budget_ratio")
+def set_analytic_regst_num_mem_budget_ratio(func_desc, value):
+    r"""Set the share of the available memory of each zone the analytic register num tuning
+    may buffer into
+
+    Args:
+        func_desc ([type]): [description]
+        value ([type]): [description]
+    """
+    func_desc.job_config_proto.analytic_regst_num_mem_budget_ratio = value
+
+
+@oneflow_function_config("enable_actor_fusion")
+def set_enable_actor_fusion(func_desc, value=True):
+    r"""Whether merge chains of actors on the same thread into one actor or not
+
+    Args:
+        func_desc ([type]): [description]
+        value (bool, optional): [description]. Defaults to True.
+    """
+    func_desc.job_config_proto.enable_actor_fusion = value
+
+
 @oneflow_function_config("disable_all_reduce_sequence")
 def set_disable_all_reduce_sequence(func_desc, value=True):
     print(
@@ -800,6 +885,17 @@ def set_use_tensorrt(func_desc, value=True):
     func_desc.job_config_proto.xrt_config.use_tensorrt = value
 
 
+@oneflow_function_config("use_xrt_native_engine")
+def set_use_xrt_native_engine(func_desc, value=True):
+    r"""Whether fuse elementwise and reduce cpu ops with the native xrt engine or not
+
+    Args:
+        func_desc ([type]): [description]
+        value (bool, optional): [description]. Defaults to True.
+    """
+    func_desc.job_config_proto.xrt_config.use_native_engine = value
+
+
 @oneflow_function_config("tensorrt.use_fp16")
 def set_tensorrt_use_fp16(func_desc, value=True):
     r"""Whether use tensorrt fp16  or not
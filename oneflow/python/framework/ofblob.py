@@ -16,6 +16,7 @@ limitations under the License.
 from __future__ import absolute_import
 
 import collections
+import ctypes
 from functools import reduce
 
 import numpy as np
@@ -85,17 +86,38 @@ class OfBlob(object):
     def is_tensor_list(self):
         return oneflow_api.OfBlob_IsTensorList(self.of_blob_ptr_)
 
+    @property
+    def is_body_in_host_mem(self):
+        return oneflow_api.OfBlob_IsBodyInHostMem(self.of_blob_ptr_)
+
+    # the views below share memory with the regst, they must not be used after the
+    # callback receiving this OfBlob returns because the regst is released then
+    def BodyNdarrayView(self):
+        assert self.is_body_in_host_mem
+        assert not self.is_tensor_list
+        dptr_addr = oneflow_api.OfBlob_BodyDptrAddr(self.of_blob_ptr_)
+        return _MakeNdarrayView(dptr_addr, self.shape, self.dtype, writable=False)
+
+    def MutBodyNdarrayView(self):
+        assert self.is_body_in_host_mem
+        assert not self.is_dynamic
+        dptr_addr = oneflow_api.OfBlob_MutBodyDptrAddr(self.of_blob_ptr_)
+        return _MakeNdarrayView(dptr_addr, self.static_shape, self.dtype, writable=True)
+
     def CopyToNdarray(self):
-        ndarray_lists = self._CopyToNdarrayLists()
+        ndarray_lists = self.CopyToNdarrayLists()
         assert len(ndarray_lists) == 1
         assert len(ndarray_lists[0]) == 1
         return ndarray_lists[0][0]
 
     def CopyToNdarrayLists(self):
+        if self.is_body_in_host_mem and not self.is_tensor_list:
+            # fetched ndarrays outlive the regst, so the view is copied once
+            return [[np.array(self.BodyNdarrayView())]]
         return self._CopyToNdarrayLists()
 
     def CopyToFlatNdarrayList(self):
-        ndarray_lists = self._CopyToNdarrayLists()
+        ndarray_lists = self.CopyToNdarrayLists()
         ret_ndarray_list = []
         for ndarray_list in ndarray_lists:
             for ndarray in ndarray_list:
@@ -110,6 +132,12 @@ class OfBlob(object):
 
     def _CopyBodyFromNdarray(self, src_ndarray):
         assert not self.is_dynamic
+        if self.is_body_in_host_mem:
+            # src_ndarray may be a strided slice, it is gathered into the regst directly
+            dst_ndarray = self.MutBodyNdarrayView()
+            assert src_ndarray.shape == dst_ndarray.shape
+            np.copyto(dst_ndarray, src_ndarray, casting="no")
+            return
         method_name = oneflow_api.Dtype_GetOfBlobStaticTensorCopyFromBufferFuncName(
             self.dtype.oneflow_proto_dtype
         )
@@ -207,3 +235,16 @@ class OfBlob(object):
         )
         num_slices = reduce(lambda a, b: a + b, is_new_slice_start_mask, 0)
         assert num_slices == oneflow_api.OfBlob_NumOfTensorListSlices(self.of_blob_ptr_)
+
+
+def _MakeNdarrayView(dptr_addr, shape, dtype, writable):
+    np_dtype = np.dtype(flow.convert_oneflow_dtype_to_numpy_dtype(dtype))
+    byte_size = reduce(lambda x, y: x * y, shape, 1) * np_dtype.itemsize
+    if byte_size == 0:
+        # an empty body has nothing to share and its dptr may be null
+        ndarray = np.empty(shape, dtype=np_dtype)
+    else:
+        buf = (ctypes.c_char * byte_size).from_address(dptr_addr)
+        ndarray = np.frombuffer(buf, dtype=np_dtype).reshape(shape)
+    ndarray.flags.writeable = writable
+    return ndarray
@@ -185,6 +185,10 @@ class FeedContext(object):
         self.rank_ = rank
 
     def GetFixedTensor(self, logical_shape):
+        return self._AsContiguousNdArray(self.GetFixedTensorView(logical_shape))
+
+    # the part of the arg of this rank, possibly a strided view of the arg
+    def GetFixedTensorView(self, logical_shape):
         assert isinstance(self.arg_ndarray_, numpy.ndarray)
         assert self.arg_ndarray_.shape == logical_shape, "%s v.s. %s" % (
             self.arg_ndarray_.shape,
@@ -193,14 +197,13 @@ class FeedContext(object):
         sbp_parallel = self.op_arg_parallel_attr_.sbp_parallel
         parallel_num = self.op_arg_parallel_attr_.parallel_desc_symbol.parallel_num
         if sbp_parallel.HasField("broadcast_parallel") or parallel_num == 1:
-            return self._AsContiguousNdArray(self.arg_ndarray_)
+            return self.arg_ndarray_
         elif sbp_parallel.HasField("split_parallel"):
             axis = sbp_parallel.split_parallel.axis
             start, end = self._GetBalancedRanges(logical_shape[axis])[self.rank_]
             slc = [slice(None)] * len(logical_shape)
             slc[axis] = slice(start, end)
-            ndarray = self.arg_ndarray_[tuple(slc)]
-            return self._AsContiguousNdArray(ndarray)
+            return self.arg_ndarray_[tuple(slc)]
         else:
             raise NotImplementedError
 
@@ -265,7 +268,11 @@ def _MakeFeedBlobCallback(feed_ctx, blob_def, blob_object):
     if isinstance(blob_def, input_blob_def.FixedTensorDef):
 
         def FeedBlob(ofblob):
-            ndarray = feed_ctx.GetFixedTensor(blob_def.shape)
+            if ofblob.is_body_in_host_mem and not ofblob.is_dynamic:
+                # copied into the regst without making the slice contiguous first
+                ndarray = feed_ctx.GetFixedTensorView(blob_def.shape)
+            else:
+                ndarray = feed_ctx.GetFixedTensor(blob_def.shape)
             dtype = dtype_util.convert_oneflow_dtype_to_numpy_dtype(ofblob.dtype)
             assert ndarray.dtype == dtype, "%s v.s. %s" % (ndarray.dtype, dtype)
             assert ndarray.shape == ofblob.static_shape, "%s v.s. %s" % (
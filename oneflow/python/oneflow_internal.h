@@ -151,6 +151,29 @@ void RunPhysicalInstruction(const std::string& vm_instruction_list,
       .GetDataAndSerializedErrorProto(error_str);
 }
 
+std::string GetEagerOpInferCacheStatistics(std::string* error_str) {
+  return oneflow::GetEagerOpInferCacheStatistics().GetDataAndSerializedErrorProto(
+      error_str, std::string(""));
+}
+
+std::string GetEagerMemoryStatistics(std::string* error_str) {
+  return oneflow::GetEagerMemoryStatistics().GetDataAndSerializedErrorProto(error_str,
+                                                                            std::string(""));
+}
+
+void ResetEagerMemoryPeakStatistics(std::string* error_str) {
+  return oneflow::ResetEagerMemoryPeakStatistics().GetDataAndSerializedErrorProto(error_str);
+}
+
+void SetEagerMemoryBudgetMByte(int64_t budget_mbyte, std::string* error_str) {
+  return oneflow::SetEagerMemoryBudgetMByte(budget_mbyte).GetDataAndSerializedErrorProto(error_str);
+}
+
+std::string GetEagerRematerializationStatistics(std::string* error_str) {
+  return oneflow::GetEagerRematerializationStatistics().GetDataAndSerializedErrorProto(
+      error_str, std::string(""));
+}
+
 long CurrentMachineId(std::string* error_str) {
   return oneflow::CurrentMachineId().GetDataAndSerializedErrorProto(error_str, 0LL);
 }
@@ -195,6 +218,24 @@ void OfBlob_CopyShapeToNumpy(uint64_t of_blob_ptr, long* array, int size) {
   return of_blob->CopyShapeTo(array, size);
 }
 
+bool OfBlob_IsBodyInHostMem(uint64_t of_blob_ptr) {
+  using namespace oneflow;
+  auto* of_blob = reinterpret_cast<OfBlob*>(of_blob_ptr);
+  return of_blob->is_body_in_host_mem();
+}
+
+uint64_t OfBlob_BodyDptrAddr(uint64_t of_blob_ptr) {
+  using namespace oneflow;
+  auto* of_blob = reinterpret_cast<OfBlob*>(of_blob_ptr);
+  return reinterpret_cast<uint64_t>(of_blob->body_dptr());
+}
+
+uint64_t OfBlob_MutBodyDptrAddr(uint64_t of_blob_ptr) {
+  using namespace oneflow;
+  auto* of_blob = reinterpret_cast<OfBlob*>(of_blob_ptr);
+  return reinterpret_cast<uint64_t>(of_blob->mut_body_dptr());
+}
+
 bool OfBlob_IsDynamic(uint64_t of_blob_ptr) {
   using namespace oneflow;
   auto* of_blob = reinterpret_cast<OfBlob*>(of_blob_ptr);
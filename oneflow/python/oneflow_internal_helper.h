@@ -46,6 +46,9 @@ limitations under the License.
 #include "oneflow/core/vm/id_util.h"
 #include "oneflow/core/eager/eager_oneflow.h"
 #include "oneflow/core/eager/eager_symbol_storage.h"
+#include "oneflow/core/eager/eager_op_infer_cache.h"
+#include "oneflow/core/eager/blob_rematerializer.h"
+#include "oneflow/core/vm/stream_ordered_allocator.h"
 
 #ifdef WITH_TENSORRT
 #include "oneflow/xrt/api.h"
@@ -283,6 +286,36 @@ Maybe<void> RunPhysicalInstruction(const std::string& instruction_list_str,
                                                                     eager_symbol_list_str);
 }
 
+Maybe<std::string> GetEagerOpInferCacheStatistics() {
+  return JUST(GlobalMaybe<eager::EagerOpInferCache>())->StatisticsDebugString();
+}
+
+Maybe<std::string> GetEagerMemoryStatistics() {
+  const vm::StreamOrderedAllocatorStat& stat = vm::StreamOrderedAllocator::GetGlobalStat();
+  std::stringstream ss;
+  ss << "allocate_cnt: " << stat.allocate_cnt << ", free_list_hit_cnt: " << stat.free_list_hit_cnt
+     << ", backend_allocate_cnt: " << stat.backend_allocate_cnt
+     << ", in_use_bytes: " << stat.in_use_bytes
+     << ", peak_in_use_bytes: " << stat.peak_in_use_bytes
+     << ", cached_bytes: " << stat.cached_bytes << ", backend_bytes: " << stat.backend_bytes
+     << ", peak_backend_bytes: " << stat.peak_backend_bytes;
+  return ss.str();
+}
+
+Maybe<void> ResetEagerMemoryPeakStatistics() {
+  vm::StreamOrderedAllocator::ResetGlobalPeakStat();
+  return Maybe<void>::Ok();
+}
+
+Maybe<void> SetEagerMemoryBudgetMByte(int64_t budget_mbyte) {
+  JUST(GlobalMaybe<eager::BlobRematerializer>())->set_budget_bytes(budget_mbyte * 1024 * 1024);
+  return Maybe<void>::Ok();
+}
+
+Maybe<std::string> GetEagerRematerializationStatistics() {
+  return JUST(GlobalMaybe<eager::BlobRematerializer>())->StatisticsDebugString();
+}
+
 Maybe<long long> CurrentMachineId() {
   CHECK_NOTNULL_OR_RETURN(Global<MachineCtx>::Get());
   return Global<MachineCtx>::Get()->this_machine_id();
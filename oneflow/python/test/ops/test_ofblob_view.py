@@ -0,0 +1,87 @@
+"""
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+"""
+import unittest
+from unittest import mock
+
+import numpy as np
+import oneflow as flow
+import oneflow.python.framework.ofblob as ofblob_util
+
+
+class FakeOfBlobApi(object):
+    # a static host blob whose body is the memory of `body`
+    def __init__(self, body):
+        self.body_ = body
+
+    def Ofblob_GetDataType(self, of_blob_ptr):
+        return flow.float32.oneflow_proto_dtype
+
+    def OfBlob_NumAxes(self, of_blob_ptr):
+        return self.body_.ndim
+
+    def OfBlob_CopyStaticShapeTo(self, of_blob_ptr, dst_ndarray):
+        dst_ndarray[:] = self.body_.shape
+
+    def OfBlob_CopyShapeToNumpy(self, of_blob_ptr, dst_ndarray):
+        dst_ndarray[:] = self.body_.shape
+
+    def OfBlob_IsBodyInHostMem(self, of_blob_ptr):
+        return True
+
+    def OfBlob_IsDynamic(self, of_blob_ptr):
+        return False
+
+    def OfBlob_IsTensorList(self, of_blob_ptr):
+        return False
+
+    def OfBlob_BodyDptrAddr(self, of_blob_ptr):
+        return self.body_.ctypes.data
+
+    def OfBlob_MutBodyDptrAddr(self, of_blob_ptr):
+        return self.body_.ctypes.data
+
+
+@flow.unittest.skip_unless_1n1d()
+class TestOfBlobView(flow.unittest.TestCase):
+    def test_feed_in_place(test_case):
+        body = np.zeros((4, 3), dtype=np.float32)
+        with mock.patch.object(ofblob_util, "oneflow_api", FakeOfBlobApi(body)):
+            ofblob = ofblob_util.OfBlob(0)
+            view = ofblob.MutBodyNdarrayView()
+            test_case.assertTrue(np.shares_memory(view, body))
+            # a strided slice of the feed arg is gathered straight into the body
+            arg = np.arange(24, dtype=np.float32).reshape(4, 6)
+            ofblob.CopyFromNdarray(arg[:, ::2])
+            test_case.assertTrue(np.array_equal(body, arg[:, ::2]))
+            # fetched ndarrays do not share the body, which is released after the callback
+            fetched = ofblob.CopyToNdarray()
+            test_case.assertTrue(np.array_equal(fetched, body))
+            test_case.assertFalse(np.shares_memory(fetched, body))
+            test_case.assertFalse(ofblob.BodyNdarrayView().flags.writeable)
+
+    def test_zero_element_view(test_case):
+        for dptr_addr in [0, np.zeros(1, dtype=np.float32).ctypes.data]:
+            view = ofblob_util._MakeNdarrayView(dptr_addr, (0, 3), flow.float32, True)
+            test_case.assertEqual(view.shape, (0, 3))
+            test_case.assertEqual(view.dtype, np.float32)
+            test_case.assertTrue(view.flags.writeable)
+        view = ofblob_util._MakeNdarrayView(0, (2, 0), flow.float32, False)
+        test_case.assertEqual(view.shape, (2, 0))
+        test_case.assertFalse(view.flags.writeable)
+
+
+if __name__ == "__main__":
+    unittest.main()
@@ -0,0 +1,78 @@
+"""
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+"""
+import unittest
+
+import numpy as np
+import oneflow as flow
+
+config = flow.function_config()
+
+
+def make_job(x_shape, b_shape, use_native_engine, dtype=flow.float32):
+    config.use_xla_jit(False)
+    config.use_tensorrt(False)
+    config.use_xrt_native_engine(use_native_engine)
+
+    @flow.global_function(config)
+    def fused_job(
+        x=flow.FixedTensorDef(x_shape, dtype=dtype),
+        bias=flow.FixedTensorDef(b_shape, dtype=dtype),
+    ):
+        with flow.scope.placement("cpu", "0:0"):
+            y = flow.math.gelu(flow.nn.bias_add(x, bias))
+            z = flow.math.multiply(y, flow.math.sigmoid(x)) + 1.0
+            return flow.math.reduce_sum(z, axis=[1], keepdims=False), y
+
+    return fused_job
+
+
+class TestNativeFusion(unittest.TestCase):
+    def _test_body(self, x, bias, dtype=np.float32):
+        f1 = make_job(x.shape, bias.shape, False, dtype=flow.float32)
+        a = f1(x, bias).get()
+        flow.clear_default_session()
+
+        f2 = make_job(x.shape, bias.shape, True, dtype=flow.float32)
+        b = f2(x, bias).get()
+        print("without native engine: ", a[0])
+        print("with native engine: ", b[0])
+        for lhs, rhs in zip(a, b):
+            self.assertTrue(
+                np.allclose(lhs.numpy(), rhs.numpy(), rtol=1e-03, atol=1e-05)
+            )
+        flow.clear_default_session()
+
+    def _test_ones_body(self, x_shape, b_shape, dtype=np.float32):
+        x = np.ones(x_shape, dtype=dtype)
+        bias = np.ones(b_shape, dtype=dtype)
+        self._test_body(x, bias, dtype=dtype)
+
+    def _test_random_body(self, x_shape, b_shape, dtype=np.float32):
+        x = np.random.random(x_shape).astype(dtype)
+        bias = np.random.random(b_shape).astype(dtype)
+        self._test_body(x, bias, dtype=dtype)
+
+    def test_ones_input(self):
+        self._test_ones_body((1, 10), (10,))
+        self._test_ones_body((2, 10, 2), (10,))
+
+    def test_random_input(self):
+        self._test_random_body((1, 10), (10,))
+        self._test_random_body((13, 300, 7), (300,))
+
+
+if __name__ == "__main__":
+    unittest.main()
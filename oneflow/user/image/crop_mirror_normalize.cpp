@@ -0,0 +1,130 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/user/image/crop_mirror_normalize.h"
+
+namespace oneflow {
+
+namespace {
+
+template<typename T>
+inline T CastFromFloat(float value);
+
+template<>
+inline float CastFromFloat<float>(float value) {
+  return value;
+}
+
+template<>
+inline float16 CastFromFloat<float16>(float value) {
+  return static_cast<float16>(value);
+}
+
+// Crops, mirrors and normalizes one H, W, C uint8 image in a single pass over the cropped input
+// rows. The normalization is folded into one multiply-add and the channel count is a compile
+// time constant, so the inner loops run with unit stride writes the compiler vectorizes.
+template<typename T, TensorLayout output_layout, bool mirror, int C>
+void CMN1SampleImpl(int64_t in_H, int64_t in_W, int64_t out_H, int64_t out_W, float crop_pos_y,
+                    float crop_pos_x, const uint8_t* __restrict__ in_dptr, T* __restrict__ out_dptr,
+                    const std::vector<float>& mean_vec, const std::vector<float>& inv_std_vec) {
+  CHECK_LE(out_H, in_H);
+  CHECK_LE(out_W, in_W);
+  const int64_t in_y0 = static_cast<int64_t>((in_H - out_H) * crop_pos_y);
+  const int64_t in_x0 = static_cast<int64_t>((in_W - out_W) * crop_pos_x);
+  float scale[C];
+  float bias[C];
+  for (int c = 0; c < C; ++c) {
+    scale[c] = inv_std_vec.at(c);
+    bias[c] = -mean_vec.at(c) * inv_std_vec.at(c);
+  }
+  const int64_t out_plane_size = out_H * out_W;
+  for (int64_t out_h = 0; out_h < out_H; ++out_h) {
+    const uint8_t* __restrict__ in_row = in_dptr + ((in_y0 + out_h) * in_W + in_x0) * C;
+    if (output_layout == TensorLayout::kNCHW) {
+      for (int c = 0; c < C; ++c) {
+        T* __restrict__ out_row = out_dptr + c * out_plane_size + out_h * out_W;
+        for (int64_t out_w = 0; out_w < out_W; ++out_w) {
+          const int64_t in_w = mirror ? out_W - 1 - out_w : out_w;
+          out_row[out_w] = CastFromFloat<T>(in_row[in_w * C + c] * scale[c] + bias[c]);
+        }
+      }
+    } else {
+      T* __restrict__ out_row = out_dptr + out_h * out_W * C;
+      for (int64_t out_w = 0; out_w < out_W; ++out_w) {
+        const int64_t in_w = mirror ? out_W - 1 - out_w : out_w;
+        for (int c = 0; c < C; ++c) {
+          out_row[out_w * C + c] = CastFromFloat<T>(in_row[in_w * C + c] * scale[c] + bias[c]);
+        }
+      }
+    }
+  }
+}
+
+template<typename T, TensorLayout output_layout, bool mirror>
+void CMN1SampleWithLayoutAndMirror(int64_t C, int64_t in_H, int64_t in_W, int64_t out_H,
+                                   int64_t out_W, float crop_pos_y, float crop_pos_x,
+                                   const uint8_t* in_dptr, T* out_dptr,
+                                   const std::vector<float>& mean_vec,
+                                   const std::vector<float>& inv_std_vec) {
+  if (C == 3) {
+    CMN1SampleImpl<T, output_layout, mirror, 3>(in_H, in_W, out_H, out_W, crop_pos_y, crop_pos_x,
+                                                in_dptr, out_dptr, mean_vec, inv_std_vec);
+  } else if (C == 1) {
+    CMN1SampleImpl<T, output_layout, mirror, 1>(in_H, in_W, out_H, out_W, crop_pos_y, crop_pos_x,
+                                                in_dptr, out_dptr, mean_vec, inv_std_vec);
+  } else {
+    UNIMPLEMENTED();
+  }
+}
+
+}  // namespace
+
+template<typename T>
+void CMN1Sample(TensorLayout output_layout, bool mirror, int64_t C, int64_t in_H, int64_t in_W,
+                int64_t out_H, int64_t out_W, float crop_pos_y, float crop_pos_x,
+                const uint8_t* in_dptr, T* out_dptr, const std::vector<float>& mean_vec,
+                const std::vector<float>& inv_std_vec) {
+#define CMN_1_SAMPLE(layout, is_mirror)                                                       \
+  CMN1SampleWithLayoutAndMirror<T, layout, is_mirror>(C, in_H, in_W, out_H, out_W, crop_pos_y, \
+                                                      crop_pos_x, in_dptr, out_dptr, mean_vec, \
+                                                      inv_std_vec)
+  if (output_layout == TensorLayout::kNCHW) {
+    if (mirror) {
+      CMN_1_SAMPLE(TensorLayout::kNCHW, true);
+    } else {
+      CMN_1_SAMPLE(TensorLayout::kNCHW, false);
+    }
+  } else {
+    if (mirror) {
+      CMN_1_SAMPLE(TensorLayout::kNHWC, true);
+    } else {
+      CMN_1_SAMPLE(TensorLayout::kNHWC, false);
+    }
+  }
+#undef CMN_1_SAMPLE
+}
+
+template void CMN1Sample<float>(TensorLayout output_layout, bool mirror, int64_t C, int64_t in_H,
+                               int64_t in_W, int64_t out_H, int64_t out_W, float crop_pos_y,
+                               float crop_pos_x, const uint8_t* in_dptr, float* out_dptr,
+                               const std::vector<float>& mean_vec,
+                               const std::vector<float>& inv_std_vec);
+template void CMN1Sample<float16>(TensorLayout output_layout, bool mirror, int64_t C, int64_t in_H,
+                                 int64_t in_W, int64_t out_H, int64_t out_W, float crop_pos_y,
+                                 float crop_pos_x, const uint8_t* in_dptr, float16* out_dptr,
+                                 const std::vector<float>& mean_vec,
+                                 const std::vector<float>& inv_std_vec);
+
+}  // namespace oneflow
@@ -0,0 +1,39 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifndef ONEFLOW_USER_IMAGE_CROP_MIRROR_NORMALIZE_H_
+#define ONEFLOW_USER_IMAGE_CROP_MIRROR_NORMALIZE_H_
+
+#include "oneflow/core/common/data_type.h"
+
+namespace oneflow {
+
+enum TensorLayout {
+  kNCHW = 0,
+  kNHWC = 1,
+};
+
+// Crops the out_H x out_W window at the relative position crop_pos_y, crop_pos_x of one H, W, C
+// uint8 image, mirrors it horizontally if mirror is set and writes (in - mean) / std per channel to
+// out_dptr in output_layout. C is 1 or 3. T is float or float16.
+template<typename T>
+void CMN1Sample(TensorLayout output_layout, bool mirror, int64_t C, int64_t in_H, int64_t in_W,
+                int64_t out_H, int64_t out_W, float crop_pos_y, float crop_pos_x,
+                const uint8_t* in_dptr, T* out_dptr, const std::vector<float>& mean_vec,
+                const std::vector<float>& inv_std_vec);
+
+}  // namespace oneflow
+
+#endif  // ONEFLOW_USER_IMAGE_CROP_MIRROR_NORMALIZE_H_
@@ -0,0 +1,89 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/user/image/crop_mirror_normalize.h"
+
+namespace oneflow {
+
+namespace test {
+
+namespace {
+
+// the element of the output at n, h, w, c, one division per element
+float ReferenceCMN(const std::vector<uint8_t>& image, int64_t C, int64_t in_H, int64_t in_W,
+                   int64_t out_H, int64_t out_W, float crop_pos_y, float crop_pos_x, bool mirror,
+                   const std::vector<float>& mean_vec, const std::vector<float>& std_vec,
+                   int64_t h, int64_t w, int64_t c) {
+  const int64_t in_y = static_cast<int64_t>((in_H - out_H) * crop_pos_y) + h;
+  const int64_t in_x =
+      static_cast<int64_t>((in_W - out_W) * crop_pos_x) + (mirror ? out_W - 1 - w : w);
+  return (static_cast<float>(image.at((in_y * in_W + in_x) * C + c)) - mean_vec.at(c))
+         / std_vec.at(c);
+}
+
+template<typename T>
+void TestCMN(TensorLayout output_layout, bool mirror, int64_t C, float tolerance) {
+  const int64_t in_H = 13;
+  const int64_t in_W = 17;
+  const int64_t out_H = 8;
+  const int64_t out_W = 11;
+  const float crop_pos_y = 0.5;
+  const float crop_pos_x = 0.3;
+  std::vector<uint8_t> image(in_H * in_W * C);
+  FOR_RANGE(int64_t, i, 0, image.size()) { image.at(i) = (i * 37 + 11) % 256; }
+  const std::vector<float> mean_vec = {123.68, 116.78, 103.94};
+  const std::vector<float> std_vec = {58.393, 57.12, 57.375};
+  std::vector<float> inv_std_vec;
+  for (float std : std_vec) { inv_std_vec.push_back(1.0f / std); }
+  std::vector<T> out(out_H * out_W * C);
+  CMN1Sample<T>(output_layout, mirror, C, in_H, in_W, out_H, out_W, crop_pos_y, crop_pos_x,
+                image.data(), out.data(), mean_vec, inv_std_vec);
+  FOR_RANGE(int64_t, h, 0, out_H) {
+    FOR_RANGE(int64_t, w, 0, out_W) {
+      FOR_RANGE(int64_t, c, 0, C) {
+        const int64_t out_idx = output_layout == TensorLayout::kNCHW
+                                    ? (c * out_H + h) * out_W + w
+                                    : (h * out_W + w) * C + c;
+        const float expected = ReferenceCMN(image, C, in_H, in_W, out_H, out_W, crop_pos_y,
+                                            crop_pos_x, mirror, mean_vec, std_vec, h, w, c);
+        ASSERT_NEAR(static_cast<float>(out.at(out_idx)), expected,
+                    tolerance * std::max(std::abs(expected), 1.0f));
+      }
+    }
+  }
+}
+
+}  // namespace
+
+TEST(CropMirrorNormalize, float_matches_reference) {
+  for (TensorLayout output_layout : {TensorLayout::kNCHW, TensorLayout::kNHWC}) {
+    for (bool mirror : {false, true}) {
+      for (int64_t C : {1, 3}) { TestCMN<float>(output_layout, mirror, C, 1e-6); }
+    }
+  }
+}
+
+TEST(CropMirrorNormalize, float16_matches_reference) {
+  // float16 has 10 explicit mantissa bits
+  for (TensorLayout output_layout : {TensorLayout::kNCHW, TensorLayout::kNHWC}) {
+    for (bool mirror : {false, true}) {
+      for (int64_t C : {1, 3}) { TestCMN<float16>(output_layout, mirror, C, 1.0f / 1024); }
+    }
+  }
+}
+
+}  // namespace test
+
+}  // namespace oneflow
@@ -0,0 +1,286 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/user/image/jpeg_decoder.h"
+#include <csetjmp>
+#include <cstdio>
+#include <cstring>
+#include <jpeglib.h>
+
+namespace oneflow {
+
+namespace {
+
+constexpr int kExifOrientationTag = 0x0112;
+constexpr int kMaxScaleDenom = 8;
+
+struct ErrorManager final {
+  jpeg_error_mgr pub;
+  std::jmp_buf setjmp_buffer;
+};
+
+void ErrorExit(j_common_ptr cinfo) {
+  ErrorManager* err = reinterpret_cast<ErrorManager*>(cinfo->err);
+  std::longjmp(err->setjmp_buffer, 1);
+}
+
+void OutputMessage(j_common_ptr cinfo) {
+  // corrupted images are reported by the fallback decoder, keep libjpeg quiet
+}
+
+uint32_t ReadExifUInt(const unsigned char* ptr, int num_bytes, bool is_little_endian) {
+  uint32_t value = 0;
+  FOR_RANGE(int, i, 0, num_bytes) {
+    const int shift = is_little_endian ? 8 * i : 8 * (num_bytes - 1 - i);
+    value |= static_cast<uint32_t>(ptr[i]) << shift;
+  }
+  return value;
+}
+
+// Returns the orientation tag in IFD0 of the exif segment, 1 (identity) if there is none
+int GetExifOrientation(const jpeg_decompress_struct& cinfo) {
+  for (jpeg_saved_marker_ptr marker = cinfo.marker_list; marker != nullptr;
+       marker = marker->next) {
+    if (marker->marker != JPEG_APP0 + 1 || marker->data_length < 14) { continue; }
+    const unsigned char* exif = marker->data;
+    if (std::memcmp(exif, "Exif\0\0", 6) != 0) { continue; }
+    const unsigned char* tiff = exif + 6;
+    const size_t tiff_length = marker->data_length - 6;
+    bool is_little_endian;
+    if (tiff[0] == 'I' && tiff[1] == 'I') {
+      is_little_endian = true;
+    } else if (tiff[0] == 'M' && tiff[1] == 'M') {
+      is_little_endian = false;
+    } else {
+      continue;
+    }
+    const size_t ifd_offset = ReadExifUInt(tiff + 4, 4, is_little_endian);
+    if (ifd_offset + 2 > tiff_length) { continue; }
+    const int num_entries = ReadExifUInt(tiff + ifd_offset, 2, is_little_endian);
+    FOR_RANGE(int, i, 0, num_entries) {
+      const size_t entry_offset = ifd_offset + 2 + i * 12;
+      if (entry_offset + 12 > tiff_length) { break; }
+      const unsigned char* entry = tiff + entry_offset;
+      if (ReadExifUInt(entry, 2, is_little_endian) == kExifOrientationTag) {
+        return ReadExifUInt(entry + 8, 2, is_little_endian);
+      }
+    }
+  }
+  return 1;
+}
+
+template<typename T>
+T CastPixel(float value);
+
+template<>
+unsigned char CastPixel<unsigned char>(float value) {
+  return static_cast<unsigned char>(std::min(std::max(value + 0.5f, 0.f), 255.f));
+}
+
+template<>
+float CastPixel<float>(float value) {
+  return value;
+}
+
+// Source taps of bilinear interpolation along one axis, clamped to [lo, hi]
+void ComputeInterpolationTaps(float src_begin, float scale, int dst_size, int lo, int hi,
+                              std::vector<int>* index0, std::vector<int>* index1,
+                              std::vector<float>* weight1) {
+  index0->resize(dst_size);
+  index1->resize(dst_size);
+  weight1->resize(dst_size);
+  FOR_RANGE(int, i, 0, dst_size) {
+    const float src = std::min(std::max(src_begin + (i + 0.5f) * scale - 0.5f,
+                                        static_cast<float>(lo)),
+                               static_cast<float>(hi));
+    const int i0 = std::min(static_cast<int>(src), hi);
+    index0->at(i) = i0;
+    index1->at(i) = std::min(i0 + 1, hi);
+    weight1->at(i) = src - i0;
+  }
+}
+
+}  // namespace
+
+struct JpegDecoder::Impl final {
+  jpeg_decompress_struct cinfo;
+  ErrorManager err;
+  bool header_read;
+};
+
+JpegDecoder::JpegDecoder() : impl_(new Impl()) {
+  impl_->cinfo.err = jpeg_std_error(&impl_->err.pub);
+  impl_->err.pub.error_exit = &ErrorExit;
+  impl_->err.pub.output_message = &OutputMessage;
+  jpeg_create_decompress(&impl_->cinfo);
+  jpeg_save_markers(&impl_->cinfo, JPEG_APP0 + 1, 0xffff);
+  impl_->header_read = false;
+}
+
+JpegDecoder::~JpegDecoder() { jpeg_destroy_decompress(&impl_->cinfo); }
+
+// No object with a non-trivial destructor may live in the scope of setjmp below since
+// libjpeg errors longjmp back to it.
+bool JpegDecoder::ReadHeader(const unsigned char* data, size_t length, int* width, int* height) {
+  jpeg_decompress_struct* cinfo = &impl_->cinfo;
+  jpeg_abort_decompress(cinfo);
+  impl_->header_read = false;
+  if (length < 2 || data[0] != 0xff || data[1] != 0xd8) { return false; }
+  if (setjmp(impl_->err.setjmp_buffer)) {
+    jpeg_abort_decompress(cinfo);
+    return false;
+  }
+  jpeg_mem_src(cinfo, const_cast<unsigned char*>(data), length);
+  if (jpeg_read_header(cinfo, TRUE) != JPEG_HEADER_OK) {
+    jpeg_abort_decompress(cinfo);
+    return false;
+  }
+  if ((cinfo->jpeg_color_space != JCS_GRAYSCALE && cinfo->jpeg_color_space != JCS_YCbCr
+       && cinfo->jpeg_color_space != JCS_RGB)
+      || GetExifOrientation(*cinfo) != 1) {
+    jpeg_abort_decompress(cinfo);
+    return false;
+  }
+  *width = static_cast<int>(cinfo->image_width);
+  *height = static_cast<int>(cinfo->image_height);
+  impl_->header_read = true;
+  return true;
+}
+
+bool JpegDecoder::DecodeRoi(int roi_x, int roi_y, int roi_width, int roi_height, int min_width,
+                            int min_height, JpegPixelFormat format, JpegDecodedRoi* decoded) {
+  jpeg_decompress_struct* cinfo = &impl_->cinfo;
+  CHECK(impl_->header_read);
+  impl_->header_read = false;
+  CHECK_GE(roi_x, 0);
+  CHECK_GE(roi_y, 0);
+  CHECK_GT(roi_width, 0);
+  CHECK_GT(roi_height, 0);
+  CHECK_LE(roi_x + roi_width, static_cast<int>(cinfo->image_width));
+  CHECK_LE(roi_y + roi_height, static_cast<int>(cinfo->image_height));
+  if (setjmp(impl_->err.setjmp_buffer)) {
+    jpeg_abort_decompress(cinfo);
+    return false;
+  }
+  if (format == JpegPixelFormat::kRGB) {
+    cinfo->out_color_space = JCS_RGB;
+  } else if (format == JpegPixelFormat::kBGR) {
+    cinfo->out_color_space = JCS_EXT_BGR;
+  } else if (format == JpegPixelFormat::kGray) {
+    cinfo->out_color_space = JCS_GRAYSCALE;
+  } else {
+    UNIMPLEMENTED();
+  }
+  // the largest DCT domain downscaling keeping the roi at least min_width x min_height
+  int scale_num = kMaxScaleDenom;
+  for (int num = 1; num < kMaxScaleDenom; num *= 2) {
+    if (roi_width * num >= min_width * kMaxScaleDenom
+        && roi_height * num >= min_height * kMaxScaleDenom) {
+      scale_num = num;
+      break;
+    }
+  }
+  cinfo->scale_num = scale_num;
+  cinfo->scale_denom = kMaxScaleDenom;
+  jpeg_start_decompress(cinfo);
+  const float scale = static_cast<float>(scale_num) / kMaxScaleDenom;
+  const JDIMENSION col_begin = static_cast<JDIMENSION>(std::floor(roi_x * scale));
+  const JDIMENSION col_end = std::min(
+      cinfo->output_width, static_cast<JDIMENSION>(std::ceil((roi_x + roi_width) * scale)));
+  const JDIMENSION row_begin = static_cast<JDIMENSION>(std::floor(roi_y * scale));
+  const JDIMENSION row_end = std::min(
+      cinfo->output_height, static_cast<JDIMENSION>(std::ceil((roi_y + roi_height) * scale)));
+  // jpeg_crop_scanline widens the span to iMCU boundaries and updates output_width
+  JDIMENSION crop_x = col_begin;
+  JDIMENSION crop_width = col_end - col_begin;
+  if (crop_width < cinfo->output_width) { jpeg_crop_scanline(cinfo, &crop_x, &crop_width); }
+  if (row_begin > 0 && jpeg_skip_scanlines(cinfo, row_begin) != row_begin) {
+    jpeg_abort_decompress(cinfo);
+    return false;
+  }
+  const int64_t row_stride = static_cast<int64_t>(cinfo->output_width) * cinfo->output_components;
+  buffer_.resize(row_stride * (row_end - row_begin));
+  while (cinfo->output_scanline < row_end) {
+    JSAMPROW row = buffer_.data() + (cinfo->output_scanline - row_begin) * row_stride;
+    if (jpeg_read_scanlines(cinfo, &row, 1) != 1) {
+      jpeg_abort_decompress(cinfo);
+      return false;
+    }
+  }
+  decoded->data = buffer_.data();
+  decoded->row_stride = row_stride;
+  decoded->rows = static_cast<int>(row_end - row_begin);
+  decoded->cols = static_cast<int>(cinfo->output_width);
+  decoded->channels = cinfo->output_components;
+  decoded->x = roi_x * scale - crop_x;
+  decoded->y = roi_y * scale - row_begin;
+  decoded->width = roi_width * scale;
+  decoded->height = roi_height * scale;
+  // scanlines below the roi are never decoded
+  jpeg_abort_decompress(cinfo);
+  return true;
+}
+
+template<typename T>
+void ResizeDecodedRoi(const JpegDecodedRoi& decoded, int dst_width, int dst_height,
+                      const float* mean, const float* inv_std, T* dst) {
+  CHECK_GT(dst_width, 0);
+  CHECK_GT(dst_height, 0);
+  const int channels = decoded.channels;
+  const int x_lo = std::max(static_cast<int>(decoded.x), 0);
+  const int x_hi =
+      std::min(static_cast<int>(std::ceil(decoded.x + decoded.width)), decoded.cols) - 1;
+  const int y_lo = std::max(static_cast<int>(decoded.y), 0);
+  const int y_hi =
+      std::min(static_cast<int>(std::ceil(decoded.y + decoded.height)), decoded.rows) - 1;
+  std::vector<int> x0;
+  std::vector<int> x1;
+  std::vector<float> alpha;
+  ComputeInterpolationTaps(decoded.x, decoded.width / dst_width, dst_width, x_lo, x_hi, &x0, &x1,
+                           &alpha);
+  std::vector<int> y0;
+  std::vector<int> y1;
+  std::vector<float> beta;
+  ComputeInterpolationTaps(decoded.y, decoded.height / dst_height, dst_height, y_lo, y_hi, &y0,
+                           &y1, &beta);
+  FOR_RANGE(int, dy, 0, dst_height) {
+    const unsigned char* row0 = decoded.data + y0.at(dy) * decoded.row_stride;
+    const unsigned char* row1 = decoded.data + y1.at(dy) * decoded.row_stride;
+    const float b = beta.at(dy);
+    T* dst_row = dst + static_cast<int64_t>(dy) * dst_width * channels;
+    FOR_RANGE(int, dx, 0, dst_width) {
+      const int c0 = x0.at(dx) * channels;
+      const int c1 = x1.at(dx) * channels;
+      const float a = alpha.at(dx);
+      FOR_RANGE(int, c, 0, channels) {
+        const float top = row0[c0 + c] + (row0[c1 + c] - row0[c0 + c]) * a;
+        const float bottom = row1[c0 + c] + (row1[c1 + c] - row1[c0 + c]) * a;
+        float value = top + (bottom - top) * b;
+        if (mean != nullptr) { value -= mean[c]; }
+        if (inv_std != nullptr) { value *= inv_std[c]; }
+        dst_row[dx * channels + c] = CastPixel<T>(value);
+      }
+    }
+  }
+}
+
+template void ResizeDecodedRoi<unsigned char>(const JpegDecodedRoi& decoded, int dst_width,
+                                              int dst_height, const float* mean,
+                                              const float* inv_std, unsigned char* dst);
+template void ResizeDecodedRoi<float>(const JpegDecodedRoi& decoded, int dst_width,
+                                      int dst_height, const float* mean, const float* inv_std,
+                                      float* dst);
+
+}  // namespace oneflow
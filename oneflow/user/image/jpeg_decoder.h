@@ -0,0 +1,82 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifndef ONEFLOW_USER_IMAGE_JPEG_DECODER_H_
+#define ONEFLOW_USER_IMAGE_JPEG_DECODER_H_
+
+#include "oneflow/core/common/util.h"
+
+namespace oneflow {
+
+enum class JpegPixelFormat { kRGB = 0, kBGR, kGray };
+
+// Pixels of a decoded region. Rows hold the whole iMCU aligned span libjpeg-turbo had to decode,
+// the requested roi is the window [x, x + width) x [y, y + height) of it, in the coordinates of
+// the DCT scaled image and therefore possibly fractional.
+struct JpegDecodedRoi final {
+  const unsigned char* data;
+  int64_t row_stride;
+  int rows;
+  int cols;
+  int channels;
+  float x;
+  float y;
+  float width;
+  float height;
+};
+
+// JpegDecoder decodes JPEG images on the cpu with libjpeg-turbo and only does the work needed for
+// a region of interest:
+//   - scanlines above the roi are skipped and the ones below are never decoded,
+//   - columns are cropped to the iMCUs covering the roi,
+//   - the image is downscaled in the DCT domain by 1/2, 1/4 or 1/8 as long as the scaled roi is
+//     still at least as large as the size the caller resizes it to.
+//
+// Images libjpeg-turbo can not convert to the requested pixel format (CMYK, 12 bit), images with
+// a non-identity exif orientation and corrupted data are rejected so that the caller falls back
+// to cv::imdecode, which keeps the results of both paths consistent.
+//
+// A JpegDecoder is not thread safe, each worker thread should own one.
+class JpegDecoder final {
+ public:
+  OF_DISALLOW_COPY_AND_MOVE(JpegDecoder);
+  JpegDecoder();
+  ~JpegDecoder();
+
+  // Returns false if data is not a JPEG image this decoder supports.
+  bool ReadHeader(const unsigned char* data, size_t length, int* width, int* height);
+  // Decodes the roi of the image whose header was read by the last ReadHeader. min_width and
+  // min_height bound the DCT scaling, pass the roi size to decode at full resolution. The pixels
+  // in decoded stay valid until the next call of ReadHeader.
+  bool DecodeRoi(int roi_x, int roi_y, int roi_width, int roi_height, int min_width,
+                 int min_height, JpegPixelFormat format, JpegDecodedRoi* decoded);
+
+ private:
+  struct Impl;
+  std::unique_ptr<Impl> impl_;
+  std::vector<unsigned char> buffer_;
+};
+
+// Resizes the roi window of decoded with bilinear interpolation (same pixel center convention as
+// cv::INTER_LINEAR) and writes dst_height x dst_width x channels interleaved pixels into dst. The
+// crop, the resize and an optional per channel normalization (v - mean[c]) * inv_std[c] are done
+// in one pass, mean and inv_std may be nullptr.
+template<typename T>
+void ResizeDecodedRoi(const JpegDecodedRoi& decoded, int dst_width, int dst_height,
+                      const float* mean, const float* inv_std, T* dst);
+
+}  // namespace oneflow
+
+#endif  // ONEFLOW_USER_IMAGE_JPEG_DECODER_H_
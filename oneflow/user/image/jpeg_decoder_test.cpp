@@ -0,0 +1,109 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/user/image/jpeg_decoder.h"
+#include <chrono>
+#include <opencv2/opencv.hpp>
+
+namespace oneflow {
+
+namespace test {
+
+namespace {
+
+std::vector<unsigned char> EncodeTestImage(int width, int height, const std::string& ext) {
+  cv::Mat image(height, width, CV_8UC3);
+  FOR_RANGE(int, y, 0, height) {
+    FOR_RANGE(int, x, 0, width) {
+      image.at<cv::Vec3b>(y, x) = cv::Vec3b(x * 255 / width, y * 255 / height, (x + y) * 7 % 256);
+    }
+  }
+  std::vector<unsigned char> data;
+  CHECK(cv::imencode(ext, image, data, {}));
+  return data;
+}
+
+cv::Mat DecodeRoiAndResize(JpegDecoder* decoder, const std::vector<unsigned char>& data,
+                           const cv::Rect& roi, int dst_width, int dst_height) {
+  int width;
+  int height;
+  CHECK(decoder->ReadHeader(data.data(), data.size(), &width, &height));
+  JpegDecodedRoi decoded{};
+  CHECK(decoder->DecodeRoi(roi.x, roi.y, roi.width, roi.height, dst_width, dst_height,
+                           JpegPixelFormat::kBGR, &decoded));
+  cv::Mat dst(dst_height, dst_width, CV_8UC3);
+  ResizeDecodedRoi<unsigned char>(decoded, dst_width, dst_height, nullptr, nullptr, dst.data);
+  return dst;
+}
+
+}  // namespace
+
+TEST(JpegDecoder, roi_at_full_scale) {
+  const std::vector<unsigned char>& data = EncodeTestImage(641, 479, ".jpg");
+  const cv::Mat& full = cv::imdecode(data, cv::IMREAD_COLOR);
+  JpegDecoder decoder;
+  const cv::Rect roi(101, 57, 300, 200);
+  const cv::Mat& dst = DecodeRoiAndResize(&decoder, data, roi, roi.width, roi.height);
+  // libjpeg builds may differ in the last bit of idct and upsampling
+  ASSERT_LE(cv::norm(dst, full(roi), cv::NORM_INF), 2);
+}
+
+TEST(JpegDecoder, roi_dct_scaled) {
+  const std::vector<unsigned char>& data = EncodeTestImage(1024, 768, ".jpg");
+  const cv::Mat& full = cv::imdecode(data, cv::IMREAD_COLOR);
+  JpegDecoder decoder;
+  const cv::Rect roi(300, 200, 640, 480);
+  const cv::Mat& dst = DecodeRoiAndResize(&decoder, data, roi, 160, 120);
+  cv::Mat expected;
+  cv::resize(full(roi), expected, cv::Size(160, 120), 0, 0, cv::INTER_AREA);
+  ASSERT_LE(cv::norm(dst, expected, cv::NORM_L1) / dst.total() / dst.channels(), 8);
+}
+
+TEST(JpegDecoder, reject_non_jpeg) {
+  const std::vector<unsigned char>& data = EncodeTestImage(64, 64, ".png");
+  JpegDecoder decoder;
+  int width;
+  int height;
+  ASSERT_FALSE(decoder.ReadHeader(data.data(), data.size(), &width, &height));
+}
+
+// Images/sec of the random crop resize of an ImageNet sized image, compared to decoding the full
+// image with opencv before cropping.
+// Run with --gtest_also_run_disabled_tests
+TEST(JpegDecoder, DISABLED_benchmark_crop_resize) {
+  const std::vector<unsigned char>& data = EncodeTestImage(500, 375, ".jpg");
+  const cv::Rect roi(50, 40, 320, 240);
+  const int num_iters = 200;
+  JpegDecoder decoder;
+  auto start = std::chrono::steady_clock::now();
+  FOR_RANGE(int, i, 0, num_iters) { DecodeRoiAndResize(&decoder, data, roi, 224, 224); }
+  const double jpeg_decoder_secs =
+      std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  start = std::chrono::steady_clock::now();
+  FOR_RANGE(int, i, 0, num_iters) {
+    cv::Mat image = cv::imdecode(data, cv::IMREAD_COLOR);
+    cv::Mat resized;
+    cv::resize(image(roi), resized, cv::Size(224, 224), 0, 0, cv::INTER_LINEAR);
+    cv::cvtColor(resized, resized, cv::COLOR_BGR2RGB);
+  }
+  const double opencv_secs =
+      std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  LOG(INFO) << "crop resize images/sec, jpeg decoder: " << num_iters / jpeg_decoder_secs
+            << ", opencv: " << num_iters / opencv_secs;
+}
+
+}  // namespace test
+
+}  // namespace oneflow
@@ -16,17 +16,57 @@ limitations under the License.
 #include "oneflow/core/framework/framework.h"
 #include "oneflow/core/thread/thread_manager.h"
 #include "oneflow/user/image/image_util.h"
+#include "oneflow/user/image/jpeg_decoder.h"
 #include <opencv2/opencv.hpp>
 
 namespace oneflow {
 
 namespace {
 
+// Decodes JPEG images straight into the requested color space with libjpeg-turbo, saving the
+// color conversion pass of the opencv path. Returns false for anything else.
+bool TryDecodeJpegImage(const TensorBuffer& raw_bytes, TensorBuffer* image_buffer,
+                        const std::string& color_space, DataType data_type) {
+  if (data_type != DataType::kUInt8 && data_type != DataType::kFloat) { return false; }
+  JpegPixelFormat format;
+  if (!ImageUtil::IsColor(color_space)) {
+    format = JpegPixelFormat::kGray;
+  } else if (color_space == "RGB") {
+    format = JpegPixelFormat::kRGB;
+  } else if (color_space == "BGR") {
+    format = JpegPixelFormat::kBGR;
+  } else {
+    return false;
+  }
+  // kernels are called from the threads of MultiThreadLoop, keep one decoder per thread
+  static thread_local JpegDecoder jpeg_decoder;
+  int width;
+  int height;
+  const auto* data = reinterpret_cast<const unsigned char*>(raw_bytes.data<char>());
+  if (!jpeg_decoder.ReadHeader(data, raw_bytes.elem_cnt(), &width, &height)) { return false; }
+  JpegDecodedRoi decoded{};
+  if (!jpeg_decoder.DecodeRoi(0, 0, width, height, width, height, format, &decoded)) {
+    return false;
+  }
+  CHECK_EQ(decoded.rows, height);
+  CHECK_EQ(decoded.cols, width);
+  const int64_t elem_cnt = decoded.row_stride * height;
+  image_buffer->Resize(Shape({height, width, decoded.channels}), data_type);
+  if (data_type == DataType::kUInt8) {
+    memcpy(image_buffer->mut_data<unsigned char>(), decoded.data, elem_cnt);
+  } else {
+    float* image_ptr = image_buffer->mut_data<float>();
+    FOR_RANGE(int64_t, i, 0, elem_cnt) { image_ptr[i] = decoded.data[i]; }
+  }
+  return true;
+}
+
 void DecodeImage(const TensorBuffer& raw_bytes, TensorBuffer* image_buffer,
                  const std::string& color_space, DataType data_type) {
   // should only support kChar, but numpy ndarray maybe cannot convert to char*
   CHECK(raw_bytes.data_type() == DataType::kChar || raw_bytes.data_type() == DataType::kInt8
         || raw_bytes.data_type() == DataType::kUInt8);
+  if (TryDecodeJpegImage(raw_bytes, image_buffer, color_space, data_type)) { return; }
   cv::_InputArray raw_bytes_arr(raw_bytes.data<char>(), raw_bytes.elem_cnt());
   cv::Mat image_mat = cv::imdecode(
       raw_bytes_arr, (ImageUtil::IsColor(color_space) ? cv::IMREAD_COLOR : cv::IMREAD_GRAYSCALE)
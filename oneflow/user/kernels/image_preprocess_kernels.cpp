@@ -19,6 +19,7 @@ limitations under the License.
 #include "oneflow/core/common/tensor_buffer.h"
 #include "oneflow/core/kernel/new_kernel_util.h"
 #include "oneflow/core/thread/thread_manager.h"
+#include "oneflow/user/image/crop_mirror_normalize.h"
 #include "oneflow/user/image/image_util.h"
 #include "oneflow/user/kernels/random_crop_kernel_state.h"
 #include "oneflow/user/kernels/random_seed_util.h"
@@ -27,60 +28,6 @@ namespace oneflow {
 
 namespace {
 
-enum TensorLayout {
-  kNCHW = 0,
-  kNHWC = 1,
-};
-
-template<TensorLayout layout>
-inline int64_t GetOffset(int64_t h, int64_t w, int64_t c, int64_t H, int64_t W, int64_t C);
-
-template<>
-inline int64_t GetOffset<TensorLayout::kNCHW>(int64_t h, int64_t w, int64_t c, int64_t H, int64_t W,
-                                              int64_t C) {
-  return c * H * W + h * W + w;  // C, H, W
-}
-
-template<>
-inline int64_t GetOffset<TensorLayout::kNHWC>(int64_t h, int64_t w, int64_t c, int64_t H, int64_t W,
-                                              int64_t C) {
-  return h * W * C + w * C + c;  // H, W, C
-}
-
-template<bool mirror>
-inline int64_t GetInputW(int64_t out_w, int64_t out_W, int64_t in_W, float crop_pos_x);
-
-template<>
-inline int64_t GetInputW<true>(int64_t out_w, int64_t out_W, int64_t in_W, float crop_pos_x) {
-  return (in_W - out_W) * crop_pos_x + (out_W - 1 - out_w);
-}
-
-template<>
-inline int64_t GetInputW<false>(int64_t out_w, int64_t out_W, int64_t in_W, float crop_pos_x) {
-  return (in_W - out_W) * crop_pos_x + out_w;
-}
-
-template<TensorLayout output_layout, bool mirror>
-void CMN1Sample(int64_t C, int64_t in_H, int64_t in_W, int64_t out_H, int64_t out_W,
-                float crop_pos_y, float crop_pos_x, const uint8_t* in_dptr, float* out_dptr,
-                const std::vector<float>& mean_vec, const std::vector<float>& inv_std_vec) {
-  CHECK_LE(out_H, in_H);
-  CHECK_LE(out_W, in_W);
-  for (int64_t c = 0; c < C; ++c) {
-    float mean = mean_vec.at(c);
-    float inv_std = inv_std_vec.at(c);
-    for (int64_t out_h = 0; out_h < out_H; ++out_h) {
-      int64_t in_h = (in_H - out_H) * crop_pos_y + out_h;
-      for (int64_t out_w = 0; out_w < out_W; ++out_w) {
-        int64_t in_w = GetInputW<mirror>(out_w, out_W, in_W, crop_pos_x);
-        int64_t in_offset = GetOffset<TensorLayout::kNHWC>(in_h, in_w, c, in_H, in_W, C);
-        int64_t out_offset = GetOffset<output_layout>(out_h, out_w, c, out_H, out_W, C);
-        out_dptr[out_offset] = (static_cast<float>(in_dptr[in_offset]) - mean) * inv_std;
-      }
-    }
-  }
-}
-
 std::vector<int8_t> GetMirrorVec(user_op::KernelComputeContext* ctx) {
   std::vector<int8_t> mirror;
   user_op::Tensor* in_blob = ctx->Tensor4ArgNameAndIndex("in", 0);
@@ -119,6 +66,31 @@ class CMNAttr final : public user_op::OpKernelState {
   std::vector<float> inv_std_vec_;
 };
 
+TensorLayout GetOutputLayout(user_op::KernelComputeContext* ctx) {
+  const std::string& output_layout = ctx->Attr<std::string>("output_layout");
+  if (output_layout == "NCHW") {
+    return TensorLayout::kNCHW;
+  } else if (output_layout == "NHWC") {
+    return TensorLayout::kNHWC;
+  } else {
+    UNIMPLEMENTED();
+    return TensorLayout::kNCHW;
+  }
+}
+
+void GetOutputHW(const ShapeView& out_shape, TensorLayout output_layout, int64_t C,
+                 int64_t* out_H, int64_t* out_W) {
+  if (output_layout == TensorLayout::kNCHW) {
+    CHECK_EQ(out_shape.At(1), C);
+    *out_H = out_shape.At(2);
+    *out_W = out_shape.At(3);
+  } else {
+    CHECK_EQ(out_shape.At(3), C);
+    *out_H = out_shape.At(1);
+    *out_W = out_shape.At(2);
+  }
+}
+
 }  // namespace
 
 class CropMirrorNormalizeFromStaticShapeToFloatKernel final : public user_op::OpKernel {
@@ -144,7 +116,6 @@ class CropMirrorNormalizeFromStaticShapeToFloatKernel final : public user_op::Op
     int64_t C = ImageUtil::IsColor(color_space) ? 3 : 1;
     float crop_pos_y = ctx->Attr<float>("crop_pos_y");
     float crop_pos_x = ctx->Attr<float>("crop_pos_x");
-    const std::string& output_layout = ctx->Attr<std::string>("output_layout");
     float* out_dptr = out_blob->mut_dptr<float>();
 
     const uint8_t* in_dptr = in_blob->dptr<uint8_t>();
@@ -157,41 +128,16 @@ class CropMirrorNormalizeFromStaticShapeToFloatKernel final : public user_op::Op
     const ShapeView& out_shape = out_blob->shape();
     CHECK_EQ(out_shape.NumAxes(), 4);
     CHECK_EQ(out_shape.At(0), N);
-    if (output_layout == "NCHW") {
-      CHECK_EQ(out_shape.At(1), C);
-      int64_t out_H = out_shape.At(2);
-      int64_t out_W = out_shape.At(3);
-      int64_t out_image_elem_cnt = C * out_H * out_W;
-      MultiThreadLoop(record_num, [&](size_t i) {
-        if (mirror.at(i)) {
-          CMN1Sample<TensorLayout::kNCHW, true>(
-              C, in_H, in_W, out_H, out_W, crop_pos_y, crop_pos_x, in_dptr + in_image_elem_cnt * i,
-              out_dptr + out_image_elem_cnt * i, mean_vec, inv_std_vec);
-        } else {
-          CMN1Sample<TensorLayout::kNCHW, false>(
-              C, in_H, in_W, out_H, out_W, crop_pos_y, crop_pos_x, in_dptr + in_image_elem_cnt * i,
-              out_dptr + out_image_elem_cnt * i, mean_vec, inv_std_vec);
-        }
-      });
-    } else if (output_layout == "NHWC") {
-      CHECK_EQ(out_shape.At(3), C);
-      int64_t out_H = out_shape.At(1);
-      int64_t out_W = out_shape.At(2);
-      int64_t out_image_elem_cnt = C * out_H * out_W;
-      MultiThreadLoop(record_num, [&](size_t i) {
-        if (mirror.at(i)) {
-          CMN1Sample<TensorLayout::kNHWC, true>(
-              C, in_H, in_W, out_H, out_W, crop_pos_y, crop_pos_x, in_dptr + in_image_elem_cnt * i,
-              out_dptr + out_image_elem_cnt * i, mean_vec, inv_std_vec);
-        } else {
-          CMN1Sample<TensorLayout::kNHWC, false>(
-              C, in_H, in_W, out_H, out_W, crop_pos_y, crop_pos_x, in_dptr + in_image_elem_cnt * i,
-              out_dptr + out_image_elem_cnt * i, mean_vec, inv_std_vec);
-        }
-      });
-    } else {
-      UNIMPLEMENTED();
-    }
+    const TensorLayout output_layout = GetOutputLayout(ctx);
+    int64_t out_H = 0;
+    int64_t out_W = 0;
+    GetOutputHW(out_shape, output_layout, C, &out_H, &out_W);
+    int64_t out_image_elem_cnt = C * out_H * out_W;
+    MultiThreadLoop(record_num, [&](size_t i) {
+      CMN1Sample<float>(output_layout, mirror.at(i), C, in_H, in_W, out_H, out_W, crop_pos_y,
+                        crop_pos_x, in_dptr + in_image_elem_cnt * i,
+                        out_dptr + out_image_elem_cnt * i, mean_vec, inv_std_vec);
+    });
   }
   bool AlwaysComputeWhenAllOutputsEmpty() const override { return false; }
 };
@@ -202,10 +148,11 @@ REGISTER_USER_KERNEL("crop_mirror_normalize_from_uint8")
                      & (user_op::HobDataType("in", 0) == DataType::kUInt8)
                      & (user_op::HobDataType("out", 0) == DataType::kFloat));
 
-class CropMirrorNormalizeFromTensorBufferToFloatKernel final : public user_op::OpKernel {
+template<typename T>
+class CropMirrorNormalizeFromTensorBufferKernel final : public user_op::OpKernel {
  public:
-  CropMirrorNormalizeFromTensorBufferToFloatKernel() = default;
-  ~CropMirrorNormalizeFromTensorBufferToFloatKernel() override = default;
+  CropMirrorNormalizeFromTensorBufferKernel() = default;
+  ~CropMirrorNormalizeFromTensorBufferKernel() override = default;
 
   std::shared_ptr<user_op::OpKernelState> CreateOpKernelState(
       user_op::KernelInitContext* ctx) const override {
@@ -225,8 +172,7 @@ class CropMirrorNormalizeFromTensorBufferToFloatKernel final : public user_op::O
     int64_t C = ImageUtil::IsColor(color_space) ? 3 : 1;
     float crop_pos_y = ctx->Attr<float>("crop_pos_y");
     float crop_pos_x = ctx->Attr<float>("crop_pos_x");
-    const std::string& output_layout = ctx->Attr<std::string>("output_layout");
-    float* out_dptr = out_blob->mut_dptr<float>();
+    T* out_dptr = out_blob->mut_dptr<T>();
 
     const TensorBuffer* in_buffers = in_blob->dptr<TensorBuffer>();
     const ShapeView& in_shape = in_blob->shape();
@@ -235,62 +181,35 @@ class CropMirrorNormalizeFromTensorBufferToFloatKernel final : public user_op::O
     const ShapeView& out_shape = out_blob->shape();
     CHECK_EQ(out_shape.NumAxes(), 4);
     CHECK_EQ(out_shape.At(0), N);
-    if (output_layout == "NCHW") {
-      CHECK_EQ(out_shape.At(1), C);
-      int64_t out_H = out_shape.At(2);
-      int64_t out_W = out_shape.At(3);
-      int64_t out_image_elem_cnt = C * out_H * out_W;
-      MultiThreadLoop(record_num, [&](size_t i) {
-        const TensorBuffer* in_buffer = in_buffers + i;
-        const Shape& in_shape = in_buffer->shape();
-        CHECK_EQ(in_shape.NumAxes(), 3);  // H, W, C
-        int64_t in_H = in_shape.At(0);
-        int64_t in_W = in_shape.At(1);
-        CHECK_EQ(C, in_shape.At(2));
-        if (mirror.at(i)) {
-          CMN1Sample<TensorLayout::kNCHW, true>(
-              C, in_H, in_W, out_H, out_W, crop_pos_y, crop_pos_x, in_buffer->data<uint8_t>(),
-              out_dptr + out_image_elem_cnt * i, mean_vec, inv_std_vec);
-        } else {
-          CMN1Sample<TensorLayout::kNCHW, false>(
-              C, in_H, in_W, out_H, out_W, crop_pos_y, crop_pos_x, in_buffer->data<uint8_t>(),
-              out_dptr + out_image_elem_cnt * i, mean_vec, inv_std_vec);
-        }
-      });
-    } else if (output_layout == "NHWC") {
-      CHECK_EQ(out_shape.At(3), C);
-      int64_t out_H = out_shape.At(1);
-      int64_t out_W = out_shape.At(2);
-      int64_t out_image_elem_cnt = C * out_H * out_W;
-      MultiThreadLoop(record_num, [&](size_t i) {
-        const TensorBuffer* in_buffer = in_buffers + i;
-        const Shape& in_shape = in_buffer->shape();
-        CHECK_EQ(in_shape.NumAxes(), 3);  // H, W, C
-        int64_t in_H = in_shape.At(0);
-        int64_t in_W = in_shape.At(1);
-        CHECK_EQ(C, in_shape.At(2));
-        if (mirror.at(i)) {
-          CMN1Sample<TensorLayout::kNHWC, true>(
-              C, in_H, in_W, out_H, out_W, crop_pos_y, crop_pos_x, in_buffer->data<uint8_t>(),
-              out_dptr + out_image_elem_cnt * i, mean_vec, inv_std_vec);
-        } else {
-          CMN1Sample<TensorLayout::kNHWC, false>(
-              C, in_H, in_W, out_H, out_W, crop_pos_y, crop_pos_x, in_buffer->data<uint8_t>(),
-              out_dptr + out_image_elem_cnt * i, mean_vec, inv_std_vec);
-        }
-      });
-    } else {
-      UNIMPLEMENTED();
-    }
+    const TensorLayout output_layout = GetOutputLayout(ctx);
+    int64_t out_H = 0;
+    int64_t out_W = 0;
+    GetOutputHW(out_shape, output_layout, C, &out_H, &out_W);
+    int64_t out_image_elem_cnt = C * out_H * out_W;
+    MultiThreadLoop(record_num, [&](size_t i) {
+      const TensorBuffer* in_buffer = in_buffers + i;
+      const Shape& in_shape = in_buffer->shape();
+      CHECK_EQ(in_shape.NumAxes(), 3);  // H, W, C
+      int64_t in_H = in_shape.At(0);
+      int64_t in_W = in_shape.At(1);
+      CHECK_EQ(C, in_shape.At(2));
+      CMN1Sample<T>(output_layout, mirror.at(i), C, in_H, in_W, out_H, out_W, crop_pos_y,
+                    crop_pos_x, in_buffer->data<uint8_t>(), out_dptr + out_image_elem_cnt * i,
+                    mean_vec, inv_std_vec);
+    });
   }
   bool AlwaysComputeWhenAllOutputsEmpty() const override { return false; }
 };
 
-REGISTER_USER_KERNEL("crop_mirror_normalize_from_tensorbuffer")
-    .SetCreateFn<CropMirrorNormalizeFromTensorBufferToFloatKernel>()
-    .SetIsMatchedHob((user_op::HobDeviceTag() == "cpu")
-                     & (user_op::HobDataType("in", 0) == DataType::kTensorBuffer)
-                     & (user_op::HobDataType("out", 0) == DataType::kFloat));
+#define REGISTER_CROP_MIRROR_NORMALIZE_FROM_TENSOR_BUFFER_KERNEL(dtype)                 \
+  REGISTER_USER_KERNEL("crop_mirror_normalize_from_tensorbuffer")                       \
+      .SetCreateFn<CropMirrorNormalizeFromTensorBufferKernel<dtype>>()                  \
+      .SetIsMatchedHob((user_op::HobDeviceTag() == "cpu")                               \
+                       & (user_op::HobDataType("in", 0) == DataType::kTensorBuffer)     \
+                       & (user_op::HobDataType("out", 0) == GetDataType<dtype>::value));
+
+REGISTER_CROP_MIRROR_NORMALIZE_FROM_TENSOR_BUFFER_KERNEL(float)
+REGISTER_CROP_MIRROR_NORMALIZE_FROM_TENSOR_BUFFER_KERNEL(float16)
 
 namespace {
 
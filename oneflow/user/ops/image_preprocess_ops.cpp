@@ -60,8 +60,8 @@ REGISTER_CPU_ONLY_USER_OP("crop_mirror_normalize_from_tensorbuffer")
                << "output_layout: " << output_layout << " is not supported";
       }
       DataType output_dtype = ctx->Attr<DataType>("output_dtype");
-      CHECK_EQ_OR_RETURN(output_dtype,
-                         DataType::kFloat);  // only support float now; for float16 in future
+      CHECK_OR_RETURN(output_dtype == DataType::kFloat || output_dtype == DataType::kFloat16)
+          << "output_dtype: " << output_dtype << " is not supported";
       *out_tensor->mut_data_type() = output_dtype;
       return Maybe<void>::Ok();
     })
@@ -41,6 +41,8 @@ DEFINE_bool(strict_clustering, EnvToBool(FLAGS_strict_clustering, true),
 //               "valid, Default means using no engine.");
 DEFINE_bool(use_xla_jit, EnvToBool(FLAGS_use_xla_jit, false), "It's optional to use xla jit.");
 DEFINE_bool(use_tensorrt, EnvToBool(FLAGS_use_tensorrt, false), "It's optional to use tensorrt.");
+DEFINE_bool(use_xrt_native, EnvToBool(FLAGS_use_xrt_native, false),
+            "It's optional to use the native cpu engine.");
 
 DEFINE_bool(tensorrt_fp16, EnvToBool(FLAGS_tensorrt_fp16, false),
             "Enable fp16 precision for TENSORRT engine.");
@@ -75,6 +77,9 @@ static std::unordered_map<std::string, std::string> user_op_type_name2string_map
     {"broadcast_add", "BcastAdd"},
     {"broadcast_mul", "BcastMul"},
     {"broadcast_div", "BcastDiv"},
+    {"broadcast_sub", "BcastSub"},
+    {"broadcast_maximum", "BcastMax"},
+    {"broadcast_minimum", "BcastMin"},
     {"cast", "Cast"},
     {"concat", "Concat"},
     {"conv2d", "Conv2D"},
@@ -85,6 +90,7 @@ static std::unordered_map<std::string, std::string> user_op_type_name2string_map
     {"avg_pool_2d", "AveragePooling2D"},
     {"reduce_sum", "ReduceSum"},
     {"reduce_mean", "ReduceMean"},
+    {"reduce_max", "ReduceMax"},
     {"reshape", "Reshape"},
     {"reshape_like", "ReshapeLike"},
     {"softmax", "Softmax"},
@@ -99,6 +105,9 @@ static std::unordered_map<std::string, std::string> user_op_type_name2string_map
     {"scalar_add", "ScalarAdd"},
     {"scalar_mul", "ScalarMul"},
     {"leaky_relu", "LeakyRelu"},
+    {"exp", "Exp"},
+    {"negative", "Negative"},
+    {"square", "Square"},
     {"adam_update", "AdamOptimizer"},
 };
 
@@ -154,6 +163,8 @@ XrtEngine StringToXrtEngine(const std::string &engine) {
     return xrt::XrtEngine::XLA;
   } else if (engine == "TENSORRT") {
     return xrt::XrtEngine::TENSORRT;
+  } else if (engine == "NATIVE") {
+    return xrt::XrtEngine::NATIVE;
   } else {
     LOG(FATAL) << "Unknown engine: " << engine;
   }
@@ -187,6 +198,7 @@ std::shared_ptr<XrtGraph> BuildXrtGraph(const XrtLaunchOpConf::Function &functio
 void InitXrtConfigurations(const XrtConfig &config) {
   if (config.has_use_xla_jit()) { FLAGS_use_xla_jit = config.use_xla_jit(); }
   if (config.has_use_tensorrt()) { FLAGS_use_tensorrt = config.use_tensorrt(); }
+  if (config.has_use_native_engine()) { FLAGS_use_xrt_native = config.use_native_engine(); }
   // Set xla configurations.
   if (config.has_tensorrt_config()) {
     const XrtConfig::TensorRTConfig &trt_config = config.tensorrt_config();
@@ -200,7 +212,9 @@ void InitXrtConfigurations(const XrtConfig &config) {
   }
 }
 
-bool XrtCompilationEnabled() { return FLAGS_use_xla_jit || FLAGS_use_tensorrt; }
+bool XrtCompilationEnabled() {
+  return FLAGS_use_xla_jit || FLAGS_use_tensorrt || FLAGS_use_xrt_native;
+}
 
 XrtPassOptions CreateDefaultXrtPassOptions(bool train_phase) {
   ClusteringOptions options;
@@ -213,6 +227,7 @@ XrtPassOptions CreateDefaultXrtPassOptions(bool train_phase) {
   options.engine = (1U << XrtEngineOptionBit::kUseDefault);
   if (FLAGS_use_xla_jit) { options.engine |= (1U << XrtEngineOptionBit::kUseXlaJit); }
   if (FLAGS_use_tensorrt) { options.engine |= (1U << XrtEngineOptionBit::kUseTensorRT); }
+  if (FLAGS_use_xrt_native) { options.engine |= (1U << XrtEngineOptionBit::kUseNative); }
 
   XrtPassOptions xrt_options;
   xrt_options.clustering_options = options;
@@ -14,10 +14,53 @@ See the License for the specific language governing permissions and
 limitations under the License.
 */
 #include "oneflow/xrt/compilation_cache.h"
+#include "oneflow/core/persistence/compile_cache.h"
+#include "oneflow/xrt/utility/env.h"
+
+#include <algorithm>
+#include <chrono>
+#include <sstream>
+#include <unordered_set>
+
+#include "glog/logging.h"
+
+DEFINE_int64(max_compilation_cache_size, EnvToInt64(FLAGS_max_compilation_cache_size, -1),
+             "Maximum executables cached by each launch kernel, unbounded if it is not positive.");
+DEFINE_string(xrt_shape_buckets, EnvToString(FLAGS_xrt_shape_buckets, ""),
+              "Comma separated sizes that the batch axis of launch parameters is padded to, "
+              "such as \"8,16,32,64\". Only the launches of clusters of element-wise ops "
+              "are bucketed. Default is empty, and this means shapes are not bucketed.");
+DEFINE_string(xrt_compilation_cache_dir, EnvToString(FLAGS_xrt_compilation_cache_dir, ""),
+              "Directory that compiled executables are serialized to and loaded from. "
+              "Default is empty, and this means executables are not persisted.");
 
 namespace oneflow {
 namespace xrt {
 
+namespace {
+
+int64_t NowTicks() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+// Hits of the same record from many threads would otherwise write its cache line on each launch
+constexpr int64_t kTouchInterval = 1000000;
+
+void TouchLastUse(std::atomic<int64_t> *last_use) {
+  const int64_t now = NowTicks();
+  if (now - last_use->load(std::memory_order_relaxed) > kTouchInterval) {
+    last_use->store(now, std::memory_order_relaxed);
+  }
+}
+
+std::string GetEntryPath(const std::string &compile_input) {
+  return CompileCacheEntryPath(FLAGS_xrt_compilation_cache_dir, "executable_", compile_input);
+}
+
+}  // namespace
+
 bool operator==(const Signature &lhs, const Signature &rhs) {
   return lhs.builder_name == rhs.builder_name && lhs.device_ordinal == rhs.device_ordinal
          && lhs.entry_shapes == rhs.entry_shapes;
@@ -42,25 +85,178 @@ Signature ComputeSignature(const std::string &name, const int device_ordinal,
   return std::move(signature);
 }
 
-Executable *CompilationCache::GetRecord(const Signature &signature) const {
-  Executable *record = nullptr;
-  // std::shared_lock<std::shared_mutex> lock(mutex_);
-  std::lock_guard<std::mutex> lock(mutex_);
-  const auto &it = records_.find(signature);
-  if (it != records_.end()) { record = it->second.get(); }
-  return record;
+int64_t FindShapeBucket(const std::vector<int64_t> &buckets, int64_t size) {
+  const auto it = std::lower_bound(buckets.begin(), buckets.end(), size);
+  return it == buckets.end() ? -1 : *it;
+}
+
+std::vector<int64_t> ParseShapeBuckets(const std::string &buckets_str) {
+  std::vector<int64_t> buckets;
+  std::stringstream ss(buckets_str);
+  std::string bucket;
+  while (std::getline(ss, bucket, ',')) {
+    if (bucket.empty()) { continue; }
+    buckets.push_back(std::stoll(bucket));
+    CHECK_GT(buckets.back(), 0) << "Invalid shape bucket " << bucket;
+  }
+  std::sort(buckets.begin(), buckets.end());
+  return buckets;
+}
+
+bool IsRowWiseFunction(const XrtLaunchOpConf::Function &function,
+                       std::unordered_set<std::string> *non_batch_major_inputs) {
+  static const std::unordered_set<std::string> row_wise_user_op_types = {
+      "tanh",       "gelu",       "sigmoid",    "relu", "cast",     "multiply", "add_n",
+      "scalar_add", "scalar_mul", "leaky_relu", "exp",  "negative", "square"};
+  std::unordered_set<std::string> batch_major_blobs;
+  for (const OperatorConf &node : function.node()) {
+    if (node.has_identity_conf()) {
+      batch_major_blobs.insert(node.identity_conf().in());
+      continue;
+    }
+    if (!node.has_user_conf()) { return false; }
+    const std::string &op_type_name = node.user_conf().op_type_name();
+    for (const auto &pair : node.user_conf().input()) {
+      const bool is_bias = op_type_name == "bias_add" && pair.first == "b";
+      for (const std::string &blob : pair.second.s()) {
+        (is_bias ? non_batch_major_inputs : &batch_major_blobs)->insert(blob);
+      }
+    }
+    if (op_type_name == "bias_add") {
+      // the bias is added along a non batch axis
+      const auto &attr = node.user_conf().attr();
+      const auto &it = attr.find("axis");
+      if (it == attr.end() || it->second.at_int32() < 1) { return false; }
+      continue;
+    }
+    if (row_wise_user_op_types.count(op_type_name) == 0) { return false; }
+  }
+  // a bias computed in the function, or also read as rows of the batch, can not be told apart
+  std::unordered_set<std::string> arguments;
+  for (const auto &argument : function.argument()) { arguments.insert(argument.value()); }
+  for (const std::string &blob : *non_batch_major_inputs) {
+    if (batch_major_blobs.count(blob) > 0 || arguments.count(blob) == 0) { return false; }
+  }
+  return true;
+}
+
+int64_t FindBatchBucket(const std::vector<Shape> &shapes, const std::vector<bool> &is_batch_major) {
+  static const std::vector<int64_t> buckets = ParseShapeBuckets(FLAGS_xrt_shape_buckets);
+  return FindBatchBucket(buckets, shapes, is_batch_major);
+}
+
+int64_t FindBatchBucket(const std::vector<int64_t> &buckets, const std::vector<Shape> &shapes,
+                        const std::vector<bool> &is_batch_major) {
+  CHECK_EQ(shapes.size(), is_batch_major.size());
+  int64_t batch_size = -1;
+  for (int i = 0; i < shapes.size(); ++i) {
+    if (!is_batch_major[i]) { continue; }
+    if (shapes[i].NumAxes() == 0) { return -1; }
+    if (batch_size == -1) { batch_size = shapes[i].At(0); }
+    if (shapes[i].At(0) != batch_size) { return -1; }
+  }
+  if (batch_size == -1) { return -1; }
+  const int64_t bucket = FindShapeBucket(buckets, batch_size);
+  return bucket > batch_size ? bucket : -1;
+}
+
+CompilationCache::CompilationCache() : capacity_(FLAGS_max_compilation_cache_size) {}
+
+std::shared_ptr<Executable> CompilationCache::GetRecord(const Signature &signature) const {
+  return records_.Read([&](const RecordMap &records) -> std::shared_ptr<Executable> {
+    const auto &it = records.find(signature);
+    if (it == records.end()) { return nullptr; }
+    if (capacity_ > 0) { TouchLastUse(&it->second->last_use); }
+    return it->second->executable;
+  });
 }
 
 void CompilationCache::Record(const Signature &signature,
                               const std::shared_ptr<Executable> &result) {
-  // std::unique_lock<std::shared_mutex> lock(mutex_);
-  std::lock_guard<std::mutex> lock(mutex_);
-  records_.emplace(signature, result);
+  std::lock_guard<std::mutex> lock(record_mutex_);
+  std::vector<Signature> evicted;
+  const bool recorded = records_.Read([&](const RecordMap &records) {
+    if (records.count(signature) > 0) { return true; }
+    if (capacity_ <= 0) { return false; }
+    std::vector<std::pair<int64_t, const Signature *>> last_use2signature;
+    for (const auto &pair : records) {
+      last_use2signature.emplace_back(pair.second->last_use.load(std::memory_order_relaxed),
+                                      &pair.first);
+    }
+    const int64_t num_evicted = static_cast<int64_t>(records.size()) + 1 - capacity_;
+    if (num_evicted <= 0) { return false; }
+    std::partial_sort(last_use2signature.begin(), last_use2signature.begin() + num_evicted,
+                      last_use2signature.end());
+    for (int64_t i = 0; i < num_evicted; ++i) {
+      evicted.push_back(*last_use2signature.at(i).second);
+    }
+    return false;
+  });
+  if (recorded) { return; }
+  auto record = std::make_shared<CacheRecord>();
+  record->executable = result;
+  record->last_use.store(NowTicks());
+  records_.Write([&](RecordMap *records) {
+    for (const Signature &evicted_signature : evicted) { records->erase(evicted_signature); }
+    records->emplace(signature, record);
+  });
+  for (const Signature &evicted_signature : evicted) {
+    VLOG(2) << "Evict executable of " << evicted_signature.builder_name;
+  }
 }
 
 void CompilationCache::Release() {
-  util::Map<Signature, std::shared_ptr<Executable>, SignatureHash> empty_records;
-  records_.swap(empty_records);
+  std::lock_guard<std::mutex> lock(record_mutex_);
+  records_.Write([](RecordMap *records) { records->clear(); });
+}
+
+bool PersistentCompilationCache::IsEnabled() {
+  static const bool enabled = []() {
+    if (FLAGS_xrt_compilation_cache_dir.empty()) { return false; }
+    if (CompileCacheVersion().empty()) {
+      LOG(WARNING) << "xrt compilation cache is disabled since oneflow was built without "
+                      "BUILD_GIT_VERSION";
+      return false;
+    }
+    return true;
+  }();
+  return enabled;
+}
+
+std::shared_ptr<Executable> PersistentCompilationCache::TryLoad(
+    const std::string &name, const std::string &compile_input) {
+  const std::string path = GetEntryPath(compile_input);
+  std::string buffer;
+  if (!ReadCompileCacheEntry(path, &buffer)) { return nullptr; }
+  ExecutableCacheEntry entry;
+  if (!entry.ParseFromString(buffer)) {
+    LOG(WARNING) << "Ignore corrupted executable cache entry " << path;
+    return nullptr;
+  }
+  if (entry.oneflow_version() != CompileCacheVersion() || entry.compile_input() != compile_input) {
+    VLOG(2) << "Executable cache entry " << path << " was compiled from another function";
+    return nullptr;
+  }
+  if (!Executable::DeserializerRegistry()->IsRegistered(entry.engine())) { return nullptr; }
+  std::shared_ptr<Executable> executable(
+      Executable::DeserializerRegistry()->Lookup(entry.engine())(name, entry.executable()));
+  if (executable) { VLOG(2) << "Load executable of " << name << " from " << path; }
+  return executable;
+}
+
+void PersistentCompilationCache::Save(const std::string &compile_input,
+                                      const Executable &executable) {
+  ExecutableCacheEntry entry;
+  if (!executable.Serialize(entry.mutable_executable())) { return; }
+  entry.set_oneflow_version(CompileCacheVersion());
+  entry.set_compile_input(compile_input);
+  entry.set_engine(executable.engine());
+  std::string buffer;
+  CHECK(entry.SerializeToString(&buffer));
+
+  const std::string path = GetEntryPath(compile_input);
+  WriteCompileCacheEntry(path, buffer);
+  VLOG(2) << "Save executable of " << executable.name() << " to " << path;
 }
 
 }  // namespace xrt
@@ -16,13 +16,17 @@ limitations under the License.
 #ifndef ONEFLOW_XRT_COMPILATION_CACHE_H_
 #define ONEFLOW_XRT_COMPILATION_CACHE_H_
 
+#include <atomic>
 #include <memory>
 #include <mutex>
 #include <string>
+#include <unordered_set>
 #include <vector>
 
 //#include "oneflow/core/common/data_type.pb.h"
+#include "oneflow/core/common/left_right.h"
 #include "oneflow/core/common/shape.h"
+#include "oneflow/core/operator/op_conf.pb.h"
 #include "oneflow/xrt/executable.h"
 #include "oneflow/xrt/parameter.h"
 #include "oneflow/xrt/utility/stl.h"
@@ -49,18 +53,62 @@ struct SignatureHash {
 Signature ComputeSignature(const std::string &name, const int device_ordinal,
                            const std::vector<xrt::Parameter> &entry_params);
 
+// Returns the smallest shape bucket not less than `size`, or -1 if there is no bucket or `size`
+// exceeds the largest one.
+int64_t FindShapeBucket(const std::vector<int64_t> &buckets, int64_t size);
+// Parses comma separated sizes into ascending shape buckets.
+std::vector<int64_t> ParseShapeBuckets(const std::string &buckets_str);
+
+// Whether each output row of the function depends on nothing but the same input row, which is
+// known for a few element-wise ops only. Padding the batch axis is wrong for any other function,
+// e.g. one reducing over the batch. The inputs without a batch axis, the biases of bias_add, are
+// put in non_batch_major_inputs by their names in the function, the others are batch-major.
+bool IsRowWiseFunction(const XrtLaunchOpConf::Function &function,
+                       std::unordered_set<std::string> *non_batch_major_inputs);
+
+// Returns the bucket (of FLAGS_xrt_shape_buckets by default) that axis 0 of the batch-major shapes
+// is padded to, or -1 if they are not bucketed since they disagree on the batch size or no bucket
+// is larger.
+int64_t FindBatchBucket(const std::vector<Shape> &shapes, const std::vector<bool> &is_batch_major);
+int64_t FindBatchBucket(const std::vector<int64_t> &buckets, const std::vector<Shape> &shapes,
+                        const std::vector<bool> &is_batch_major);
+
+// Keeps at most FLAGS_max_compilation_cache_size executables (unbounded if it is not positive),
+// the least recently used one is evicted first. GetRecord is called by every launch and does not
+// lock, hits only refresh the last use time of the record which is at most 1ms stale.
 class CompilationCache {
  public:
-  Executable *GetRecord(const Signature &signature) const;
+  CompilationCache();
+
+  std::shared_ptr<Executable> GetRecord(const Signature &signature) const;
 
   void Record(const Signature &signature, const std::shared_ptr<Executable> &result);
 
   void Release();
 
  private:
-  // static std::shared_mutex mutex_;
-  mutable std::mutex mutex_;
-  util::Map<Signature, std::shared_ptr<Executable>, SignatureHash> records_;
+  struct CacheRecord {
+    std::shared_ptr<Executable> executable;
+    // steady clock ticks of the last hit
+    std::atomic<int64_t> last_use;
+  };
+  using RecordMap = util::Map<Signature, std::shared_ptr<CacheRecord>, SignatureHash>;
+
+  int64_t capacity_;
+  // serializes Record and Release, which read the records before writing them
+  std::mutex record_mutex_;
+  LeftRight<RecordMap> records_;
+};
+
+// Executables are also serialized to FLAGS_xrt_compilation_cache_dir if it is set, so that a
+// restarted session skips their compilation. An entry is named by the fingerprint of its compile
+// input and used only if the whole compile input and the oneflow version match. The executables
+// of engines which can not serialize them are compiled in each session as before.
+struct PersistentCompilationCache {
+  static bool IsEnabled();
+  static std::shared_ptr<Executable> TryLoad(const std::string &name,
+                                             const std::string &compile_input);
+  static void Save(const std::string &compile_input, const Executable &executable);
 };
 
 }  // namespace xrt
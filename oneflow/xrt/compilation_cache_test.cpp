@@ -0,0 +1,202 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/xrt/compilation_cache.h"
+#include "oneflow/core/common/str_util.h"
+#include "oneflow/core/persistence/file_system.h"
+
+#include <unistd.h>
+#include <chrono>
+#include <thread>
+
+DECLARE_int64(max_compilation_cache_size);
+DECLARE_string(xrt_compilation_cache_dir);
+
+namespace oneflow {
+namespace xrt {
+
+namespace {
+
+// an engine no real executable is registered for
+constexpr XrtEngine kFakeEngine = XrtEngine::TVM;
+
+class FakeExecutable : public Executable {
+ public:
+  FakeExecutable(const std::string &name, const std::string &program)
+      : Executable(name, kFakeEngine), program_(program) {}
+
+  bool Run(const std::vector<Parameter> &inputs, const ExecutableRunOptions &run_options,
+           bool block_until_done = true) override {
+    return true;
+  }
+
+  bool Serialize(std::string *serialized) const override {
+    *serialized = program_;
+    return true;
+  }
+
+  const std::string &program() const { return program_; }
+
+ private:
+  std::string program_;
+};
+
+Signature BatchSignature(int64_t batch_size) {
+  Signature signature;
+  signature.builder_name = "launch";
+  signature.device_ordinal = 0;
+  signature.entry_shapes.push_back(Shape({batch_size, 16}));
+  return signature;
+}
+
+// the last use of a record is refreshed at most once per millisecond
+void WaitTouchInterval() { std::this_thread::sleep_for(std::chrono::milliseconds(5)); }
+
+OperatorConf UserOpConf(const std::string &op_type_name) {
+  OperatorConf op_conf;
+  op_conf.set_name(op_type_name);
+  op_conf.mutable_user_conf()->set_op_type_name(op_type_name);
+  return op_conf;
+}
+
+void AddInput(OperatorConf *op_conf, const std::string &arg_name, const std::string &blob) {
+  (*op_conf->mutable_user_conf()->mutable_input())[arg_name].add_s(blob);
+}
+
+}  // namespace
+
+TEST(CompilationCache, evict_least_recently_used) {
+  FLAGS_max_compilation_cache_size = 2;
+  CompilationCache cache;
+  auto first = std::make_shared<FakeExecutable>("first", "");
+  cache.Record(BatchSignature(1), first);
+  WaitTouchInterval();
+  cache.Record(BatchSignature(2), std::make_shared<FakeExecutable>("second", ""));
+  WaitTouchInterval();
+  ASSERT_EQ(cache.GetRecord(BatchSignature(1)), first);
+  WaitTouchInterval();
+  cache.Record(BatchSignature(4), std::make_shared<FakeExecutable>("third", ""));
+  ASSERT_EQ(cache.GetRecord(BatchSignature(1)), first);
+  ASSERT_EQ(cache.GetRecord(BatchSignature(2)), nullptr);
+  ASSERT_NE(cache.GetRecord(BatchSignature(4)), nullptr);
+  // an evicted executable lives on with its users
+  std::shared_ptr<Executable> third = cache.GetRecord(BatchSignature(4));
+  WaitTouchInterval();
+  cache.GetRecord(BatchSignature(1));
+  WaitTouchInterval();
+  cache.Record(BatchSignature(8), std::make_shared<FakeExecutable>("fourth", ""));
+  ASSERT_EQ(cache.GetRecord(BatchSignature(4)), nullptr);
+  ASSERT_EQ(third->name(), "third");
+  cache.Release();
+  ASSERT_EQ(cache.GetRecord(BatchSignature(1)), nullptr);
+}
+
+TEST(CompilationCache, unbounded_without_capacity) {
+  FLAGS_max_compilation_cache_size = -1;
+  CompilationCache cache;
+  for (int64_t i = 1; i <= 64; ++i) {
+    cache.Record(BatchSignature(i), std::make_shared<FakeExecutable>("launch", ""));
+  }
+  for (int64_t i = 1; i <= 64; ++i) { ASSERT_NE(cache.GetRecord(BatchSignature(i)), nullptr); }
+}
+
+TEST(CompilationCache, find_shape_bucket) {
+  const std::vector<int64_t> buckets = ParseShapeBuckets("16,4,,8");
+  ASSERT_EQ(buckets, std::vector<int64_t>({4, 8, 16}));
+  ASSERT_EQ(FindShapeBucket(buckets, 1), 4);
+  ASSERT_EQ(FindShapeBucket(buckets, 8), 8);
+  ASSERT_EQ(FindShapeBucket(buckets, 9), 16);
+  ASSERT_EQ(FindShapeBucket(buckets, 17), -1);
+  ASSERT_EQ(FindShapeBucket(ParseShapeBuckets(""), 1), -1);
+}
+
+TEST(CompilationCache, only_bucket_row_wise_functions) {
+  XrtLaunchOpConf::Function function;
+  function.add_argument()->set_value("x/out");
+  function.add_argument()->set_value("bias/out");
+  OperatorConf relu = UserOpConf("relu");
+  AddInput(&relu, "in", "x/out");
+  *function.add_node() = relu;
+  OperatorConf bias_add = UserOpConf("bias_add");
+  AddInput(&bias_add, "a", "relu/y_0");
+  AddInput(&bias_add, "b", "bias/out");
+  (*bias_add.mutable_user_conf()->mutable_attr())["axis"].set_at_int32(1);
+  *function.add_node() = bias_add;
+  function.add_node()->mutable_identity_conf()->set_in("bias_add/out_0");
+  std::unordered_set<std::string> non_batch_major_inputs;
+  ASSERT_TRUE(IsRowWiseFunction(function, &non_batch_major_inputs));
+  ASSERT_EQ(non_batch_major_inputs, std::unordered_set<std::string>({"bias/out"}));
+
+  XrtLaunchOpConf::Function batch_bias_function;
+  (*bias_add.mutable_user_conf()->mutable_attr())["axis"].set_at_int32(0);
+  *batch_bias_function.add_node() = bias_add;
+  ASSERT_FALSE(IsRowWiseFunction(batch_bias_function, &non_batch_major_inputs));
+
+  XrtLaunchOpConf::Function reduce_function = function;
+  *reduce_function.add_node() = UserOpConf("reduce_sum");
+  ASSERT_FALSE(IsRowWiseFunction(reduce_function, &non_batch_major_inputs));
+  XrtLaunchOpConf::Function matmul_function = function;
+  *matmul_function.add_node() = UserOpConf("matmul");
+  ASSERT_FALSE(IsRowWiseFunction(matmul_function, &non_batch_major_inputs));
+  // the bias is also read as rows of the batch
+  XrtLaunchOpConf::Function bias_as_rows_function = function;
+  OperatorConf square = UserOpConf("square");
+  AddInput(&square, "x", "bias/out");
+  *bias_as_rows_function.add_node() = square;
+  ASSERT_FALSE(IsRowWiseFunction(bias_as_rows_function, &non_batch_major_inputs));
+}
+
+TEST(CompilationCache, only_bucket_batch_major_shapes) {
+  const std::vector<int64_t> buckets = {8, 16};
+  // x:(4, 4) plus bias:(4), the batch size equals the size of the bias
+  ASSERT_EQ(FindBatchBucket(buckets, {Shape({4, 4}), Shape({4}), Shape({4, 4})},
+                            {true, false, true}),
+            8);
+  // the bias would not share the batch size if it was batch-major
+  ASSERT_EQ(FindBatchBucket(buckets, {Shape({5, 3}), Shape({3}), Shape({5, 3})},
+                            {true, false, true}),
+            8);
+  ASSERT_EQ(FindBatchBucket(buckets, {Shape({5, 3}), Shape({3}), Shape({5, 3})},
+                            {true, true, true}),
+            -1);
+  ASSERT_EQ(FindBatchBucket(buckets, {Shape({8, 3}), Shape({8, 3})}, {true, true}), -1);
+  ASSERT_EQ(FindBatchBucket(buckets, {Shape({17, 3}), Shape({17, 3})}, {true, true}), -1);
+  ASSERT_EQ(FindBatchBucket(buckets, {Shape({3})}, {false}), -1);
+}
+
+TEST(PersistentCompilationCache, save_and_load) {
+  if (!Executable::DeserializerRegistry()->IsRegistered(kFakeEngine)) {
+    Executable::DeserializerRegistry()->Register(
+        kFakeEngine, [](const std::string &name, const std::string &serialized) -> Executable * {
+          return new FakeExecutable(name, serialized);
+        });
+  }
+  FLAGS_xrt_compilation_cache_dir =
+      JoinPath(::testing::TempDir(), "xrt_compilation_cache_test_" + std::to_string(getpid()));
+  PersistentCompilationCache::Save("relu(1,16)", FakeExecutable("launch", "relu program"));
+  PersistentCompilationCache::Save("relu(2,16)", FakeExecutable("launch", "other program"));
+
+  std::shared_ptr<Executable> loaded = PersistentCompilationCache::TryLoad("load", "relu(1,16)");
+  ASSERT_NE(loaded, nullptr);
+  ASSERT_EQ(loaded->name(), "load");
+  ASSERT_EQ(loaded->engine(), kFakeEngine);
+  ASSERT_EQ(dynamic_cast<FakeExecutable *>(loaded.get())->program(), "relu program");
+  ASSERT_EQ(PersistentCompilationCache::TryLoad("load", "relu(4,16)"), nullptr);
+  LocalFS()->RecursivelyDeleteDir(FLAGS_xrt_compilation_cache_dir);
+  ASSERT_EQ(PersistentCompilationCache::TryLoad("load", "relu(1,16)"), nullptr);
+}
+
+}  // namespace xrt
+}  // namespace oneflow
@@ -16,9 +16,12 @@ limitations under the License.
 #ifndef ONEFLOW_XRT_EXECUTABLE_H_
 #define ONEFLOW_XRT_EXECUTABLE_H_
 
+#include <functional>
 #include <vector>
 
 #include "oneflow/xrt/parameter.h"
+#include "oneflow/xrt/types.h"
+#include "oneflow/xrt/utility/registry.h"
 #include "oneflow/xrt/xrt.pb.h"
 
 namespace oneflow {
@@ -78,6 +81,16 @@ class Executable {
 
   const std::vector<Parameter> &Results() const { return results_; }
 
+  // Serializes the executable for the deserializer registered for its engine, returns false if
+  // the engine can not restore an executable in another process.
+  virtual bool Serialize(std::string *serialized) const { return false; }
+
+  using Deserializer =
+      std::function<Executable *(const std::string &name, const std::string &serialized)>;
+  static auto DeserializerRegistry() -> util::Registry<XrtEngine, Deserializer> * {
+    return util::Registry<XrtEngine, Deserializer>::Global();
+  }
+
  protected:
   // Executable name.
   std::string name_;
@@ -86,6 +99,16 @@ class Executable {
   std::vector<Parameter> results_;
 };
 
+#define REGISTER_EXECUTABLE_DESERIALIZER(Engine, Deserialize)                              \
+  namespace {                                                                              \
+  struct _XrtExecutableDeserializer {                                                      \
+    _XrtExecutableDeserializer() {                                                         \
+      Executable::DeserializerRegistry()->Register(Engine, Deserialize);                   \
+    }                                                                                      \
+  };                                                                                       \
+  static _XrtExecutableDeserializer _xrt_executable_deserializer_ __attribute__((unused)); \
+  }  // namespace
+
 }  // namespace xrt
 }  // namespace oneflow
 
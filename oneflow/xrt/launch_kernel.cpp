@@ -14,6 +14,9 @@ See the License for the specific language governing permissions and
 limitations under the License.
 */
 #include "oneflow/xrt/launch_kernel.h"
+#include "oneflow/core/kernel/new_kernel_util.h"
+#include "oneflow/core/memory/memory_allocator.h"
+#include "oneflow/core/persistence/compile_cache.h"
 #include "oneflow/xrt/api.h"
 #include "oneflow/xrt/compilation_cache.h"
 #include "oneflow/xrt/executable.h"
@@ -62,18 +65,32 @@ void BlobDescGetter<device_type>::DumpEntryBlobDescTo(
 }
 
 template<DeviceType device_type>
-xrt::Executable *XrtLaunchKernel<device_type>::BuildExecutable(
+XrtLaunchKernel<device_type>::~XrtLaunchKernel() {
+  for (const BucketBuffer &buffer : bucket_buffers_) {
+    if (buffer.ptr) { MemoryAllocatorImpl::Deallocate(buffer.ptr, buffer.mem_case); }
+  }
+}
+
+template<DeviceType device_type>
+std::shared_ptr<xrt::Executable> XrtLaunchKernel<device_type>::BuildExecutable(
     const std::vector<xrt::Parameter> &entry_params,
     const std::vector<xrt::Parameter> &return_params,
     const std::vector<xrt::InputOutputAlias> &aliases, const int device_ordinal) const {
   if (!compilation_cache_) { compilation_cache_.reset(new xrt::CompilationCache); }
 
-  xrt::Executable *executable = nullptr;
+  std::shared_ptr<xrt::Executable> executable;
   xrt::Signature signature =
       xrt::ComputeSignature(this->op_conf().name(), device_ordinal, entry_params);
   bool force_compile = false;
   if (!force_compile) { executable = compilation_cache_->GetRecord(signature); }
 
+  std::string compile_input;
+  if (!executable && xrt::PersistentCompilationCache::IsEnabled()) {
+    compile_input = GenCompileInput(entry_params, return_params, device_ordinal);
+    executable = xrt::PersistentCompilationCache::TryLoad(this->op_conf().name(), compile_input);
+    if (executable) { compilation_cache_->Record(signature, executable); }
+  }
+
   if (!executable) {
     VLOG(2) << "Build executable for launch op " << this->op_conf().name();
     const auto &launch_conf = this->op_conf().xrt_launch_conf();
@@ -85,6 +102,10 @@ xrt::Executable *XrtLaunchKernel<device_type>::BuildExecutable(
 
       std::unordered_map<std::string, BlobDesc> entry_blob_descs;
       desc_getter_.DumpEntryBlobDescTo(&entry_blob_descs);
+      // The entry parameters are padded if the shapes are bucketed
+      for (const xrt::Parameter &param : entry_params) {
+        entry_blob_descs.at(param.name()).mut_shape() = param.shape();
+      }
       auto options = xrt::CreateDefaultXrtPassOptions();
       xrt::RunXrtPass("InferShape", graph.get(), options, &this->job_desc(), &parallel_ctx,
                       &sbp_signatures, &entry_blob_descs);
@@ -95,14 +116,86 @@ xrt::Executable *XrtLaunchKernel<device_type>::BuildExecutable(
     xrt::XrtEngine engine = xrt::StringToXrtEngine(launch_conf.engine());
     xrt::XrtDevice device = xrt::DeviceTypeToXrtDevice(device_type);
     xrt::GraphCompiler compiler(this->op_conf().name(), engine, device, device_ordinal);
-    auto result = compiler.Compile(graph.get(), entry_params, return_params, aliases);
+    executable = compiler.Compile(graph.get(), entry_params, return_params, aliases);
     // Record new compilation result
-    compilation_cache_->Record(signature, result);
-    // Get compilation result from cache
-    executable = compilation_cache_->GetRecord(signature);
+    compilation_cache_->Record(signature, executable);
+    if (!compile_input.empty()) {
+      xrt::PersistentCompilationCache::Save(compile_input, *executable);
+    }
   }
 
-  return std::move(executable);
+  return executable;
+}
+
+template<DeviceType device_type>
+std::string XrtLaunchKernel<device_type>::GenCompileInput(
+    const std::vector<xrt::Parameter> &entry_params,
+    const std::vector<xrt::Parameter> &return_params, const int device_ordinal) const {
+  std::string compile_input;
+  AppendDeterministicSerialization(this->op_conf().xrt_launch_conf(), &compile_input);
+  AppendDeterministicSerialization(this->kernel_conf().xrt_launch_conf(), &compile_input);
+  AppendDeterministicSerialization(this->job_desc().job_conf(), &compile_input);
+  compile_input += std::to_string(device_type) + ":" + std::to_string(device_ordinal) + ";";
+  for (const auto *params : {&entry_params, &return_params}) {
+    for (const xrt::Parameter &param : *params) {
+      compile_input += param.name() + param.shape().ToString()
+                       + std::to_string(param.data_type()) + ";";
+    }
+  }
+  return compile_input;
+}
+
+template<DeviceType device_type>
+bool XrtLaunchKernel<device_type>::PadToShapeBucket(
+    const KernelCtx &ctx, std::function<Blob *(const std::string &)> BnInOp2Blob,
+    const std::unordered_set<std::string> &non_batch_major_inputs,
+    std::vector<xrt::Parameter> *entry_params, std::vector<xrt::Parameter> *return_params) const {
+  const auto &io_mapping = this->op_conf().xrt_launch_conf().input_output_mapping();
+  std::vector<xrt::Parameter *> params;
+  std::vector<const Blob *> blobs;
+  std::vector<Shape> shapes;
+  std::vector<bool> is_batch_major;
+  for (int i = 0; i < entry_params->size(); ++i) {
+    params.push_back(&entry_params->at(i));
+    blobs.push_back(BnInOp2Blob(this->op_attribute().input_bns(i)));
+    is_batch_major.push_back(non_batch_major_inputs.count(io_mapping.at(params.back()->name()))
+                             == 0);
+  }
+  for (int i = 0; i < return_params->size(); ++i) {
+    params.push_back(&return_params->at(i));
+    blobs.push_back(BnInOp2Blob(this->op_attribute().output_bns(i)));
+    is_batch_major.push_back(true);
+  }
+  for (const xrt::Parameter *param : params) { shapes.push_back(param->shape()); }
+  const int64_t bucket = xrt::FindBatchBucket(shapes, is_batch_major);
+  if (bucket == -1) { return false; }
+
+  if (bucket_buffers_.size() < params.size()) { bucket_buffers_.resize(params.size()); }
+  for (int i = 0; i < params.size(); ++i) {
+    // the biases are passed as they are
+    if (!is_batch_major[i]) { continue; }
+    xrt::Parameter *param = params[i];
+    DimVector dims = param->shape().dim_vec();
+    dims[0] = bucket;
+    const Shape padded_shape(dims);
+    const size_t byte_size = padded_shape.elem_cnt() * xrt::SizeOf(param->data_type());
+    BucketBuffer *buffer = &bucket_buffers_[i];
+    if (buffer->capacity < byte_size) {
+      if (buffer->ptr) { MemoryAllocatorImpl::Deallocate(buffer->ptr, buffer->mem_case); }
+      buffer->mem_case = blobs[i]->mem_case();
+      buffer->ptr = MemoryAllocatorImpl::Allocate(buffer->mem_case, byte_size);
+      buffer->capacity = byte_size;
+    }
+    if (i < entry_params->size()) {
+      // The padding rows are zeros, the rows of the batch are contiguous since it is axis 0
+      char *dst = reinterpret_cast<char *>(buffer->ptr);
+      Memcpy<device_type>(ctx.device_ctx, dst, param->data(), param->byte_size());
+      Memset<device_type>(ctx.device_ctx, dst + param->byte_size(), 0,
+                          byte_size - param->byte_size());
+    }
+    *param = xrt::Parameter(param->name(), buffer->ptr, padded_shape, param->data_type());
+  }
+  return true;
 }
 
 template<DeviceType device_type>
@@ -160,6 +253,16 @@ void XrtLaunchKernel<device_type>::ForwardDataContent(
 
   xrt::XrtDevice device = xrt::DeviceTypeToXrtDevice(device_type);
   int device_ordinal = xrt::platform::GetDeviceId(device);
+  // The outputs are sliced from the padded return parameters after running
+  const std::vector<xrt::Parameter> unpadded_return_params = return_params;
+  bool padded = false;
+  const auto &launch_conf = this->op_conf().xrt_launch_conf();
+  std::unordered_set<std::string> non_batch_major_inputs;
+  if (launch_conf.input_mutability().empty()
+      && xrt::IsRowWiseFunction(launch_conf.function(), &non_batch_major_inputs)) {
+    padded = PadToShapeBucket(ctx, BnInOp2Blob, non_batch_major_inputs, &entry_params,
+                              &return_params);
+  }
   std::vector<xrt::InputOutputAlias> aliases;
   MakeInputOutputAlias(entry_params, &return_params, &aliases);
   // Mapping parameter names to function input and output names.
@@ -190,6 +293,13 @@ void XrtLaunchKernel<device_type>::ForwardDataContent(
   const std::vector<xrt::Parameter> &results = executable->Results();
   CHECK_EQ(results.size(), return_params.size());
   for (int i = 0; i < results.size(); ++i) { CHECK_EQ(results[i].data(), return_params[i].data()); }
+  if (padded) {
+    for (int i = 0; i < unpadded_return_params.size(); ++i) {
+      const xrt::Parameter &output = unpadded_return_params[i];
+      Memcpy<device_type>(ctx.device_ctx, output.data(), return_params[i].data(),
+                          output.byte_size());
+    }
+  }
 }
 
 // ADD_DEFAULT_KERNEL_CREATOR(OperatorConf::kXrtLaunchConf, XrtLaunchKernel,
@@ -19,6 +19,7 @@ limitations under the License.
 #include <unordered_map>
 
 #include "oneflow/core/kernel/kernel.h"
+#include "oneflow/core/memory/memory_case.pb.h"
 #include "oneflow/xrt/compilation_cache.h"
 #include "oneflow/xrt/executable.h"
 #include "oneflow/xrt/graph_compiler.h"
@@ -46,16 +47,30 @@ template<DeviceType device_type>
 class XrtLaunchKernel : public KernelIf<device_type> {
  public:
   XrtLaunchKernel() = default;
-  virtual ~XrtLaunchKernel() {}
+  virtual ~XrtLaunchKernel();
 
  private:
   void ForwardDataContent(const KernelCtx &ctx,
                           std::function<Blob *(const std::string &)> BnInOp2Blob) const override;
 
-  xrt::Executable *BuildExecutable(const std::vector<xrt::Parameter> &entry_params,
-                                   const std::vector<xrt::Parameter> &return_params,
-                                   const std::vector<xrt::InputOutputAlias> &aliases,
-                                   const int device_ordinal) const;
+  std::shared_ptr<xrt::Executable> BuildExecutable(
+      const std::vector<xrt::Parameter> &entry_params,
+      const std::vector<xrt::Parameter> &return_params,
+      const std::vector<xrt::InputOutputAlias> &aliases, const int device_ordinal) const;
+
+  std::string GenCompileInput(const std::vector<xrt::Parameter> &entry_params,
+                              const std::vector<xrt::Parameter> &return_params,
+                              const int device_ordinal) const;
+
+  // Pads the batch axis of the parameters to its shape bucket, so that batch sizes of the same
+  // bucket share one executable. The entry parameters of non_batch_major_inputs, named in the
+  // function, are not padded. Returns false if the batch-major parameters do not share the batch
+  // size or it has no bucket.
+  bool PadToShapeBucket(const KernelCtx &ctx,
+                        std::function<Blob *(const std::string &)> BnInOp2Blob,
+                        const std::unordered_set<std::string> &non_batch_major_inputs,
+                        std::vector<xrt::Parameter> *entry_params,
+                        std::vector<xrt::Parameter> *return_params) const;
 
   void MakeInputOutputAlias(                            // NOLINT
       const std::vector<xrt::Parameter> &entry_params,  // NOLINT
@@ -68,8 +83,16 @@ class XrtLaunchKernel : public KernelIf<device_type> {
   bool IsStateless() const override { return false; }
 
  private:
+  struct BucketBuffer {
+    void *ptr = nullptr;
+    size_t capacity = 0;
+    MemoryCase mem_case;
+  };
+
   mutable BlobDescGetter<device_type> desc_getter_;
   mutable std::shared_ptr<xrt::CompilationCache> compilation_cache_;
+  // Padded storage of the entry parameters followed by the return parameters
+  mutable std::vector<BucketBuffer> bucket_buffers_;
 };
 
 }  // namespace oneflow
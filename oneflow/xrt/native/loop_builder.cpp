@@ -0,0 +1,286 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/xrt/native/loop_builder.h"
+#include "oneflow/core/common/data_type.h"
+
+namespace oneflow {
+namespace xrt {
+namespace native {
+
+namespace {
+
+// a longer chain is split into several stages to bound the tiles a stage keeps
+constexpr int64_t kMaxFusedExprNum = 64;
+constexpr int64_t kTempBufferAlignment = 64;
+
+Shape BroadcastShape(const Shape &lhs, const Shape &rhs) {
+  const int64_t num_axes = std::max(lhs.NumAxes(), rhs.NumAxes());
+  DimVector dim_vec(num_axes);
+  FOR_RANGE(int64_t, i, 0, num_axes) {
+    const int64_t lhs_axis = lhs.NumAxes() - num_axes + i;
+    const int64_t rhs_axis = rhs.NumAxes() - num_axes + i;
+    const int64_t lhs_dim = lhs_axis < 0 ? 1 : lhs.At(lhs_axis);
+    const int64_t rhs_dim = rhs_axis < 0 ? 1 : rhs.At(rhs_axis);
+    CHECK(lhs_dim == rhs_dim || lhs_dim == 1 || rhs_dim == 1)
+        << "Shapes " << lhs.ToString() << " and " << rhs.ToString() << " can not broadcast.";
+    dim_vec[i] = std::max(lhs_dim, rhs_dim);
+  }
+  return Shape(dim_vec);
+}
+
+int64_t ByteSize(const Shape &shape, const DataType &data_type) {
+  return shape.elem_cnt() * GetSizeOfDataType(data_type);
+}
+
+}  // namespace
+
+int64_t LoopBuilder::AddExpr(const LoopExpr &expr) {
+  exprs_.push_back(expr);
+  return exprs_.size() - 1;
+}
+
+int64_t LoopBuilder::AddBuffer(LoopBuffer::Kind kind, int64_t index, int64_t byte_size) {
+  LoopBuffer buffer;
+  buffer.kind = kind;
+  buffer.index = index;
+  buffer.byte_size = byte_size;
+  program_.buffers.push_back(buffer);
+  return program_.buffers.size() - 1;
+}
+
+LoopValue LoopBuilder::Load(int64_t buffer_id, const Shape &shape, const DataType &data_type) {
+  LoopExpr expr;
+  expr.type = LoopExpr::kLoad;
+  expr.buffer_id = buffer_id;
+  expr.shape = shape;
+  LoopValue value;
+  value.expr_id = AddExpr(expr);
+  value.shape = shape;
+  value.data_type = data_type;
+  value.expr_num = 1;
+  return value;
+}
+
+bool LoopBuilder::IsLoad(const LoopValue &x) const {
+  return exprs_.at(x.expr_id).type == LoopExpr::kLoad;
+}
+
+bool LoopBuilder::IsDense(const LoopValue &x) const {
+  util::Set<int64_t> visited;
+  std::vector<int64_t> stack{x.expr_id};
+  while (!stack.empty()) {
+    const int64_t expr_id = stack.back();
+    stack.pop_back();
+    if (!visited.insert(expr_id).second) { continue; }
+    const LoopExpr &expr = exprs_.at(expr_id);
+    if (expr.type == LoopExpr::kLoad) {
+      if (expr.shape.elem_cnt() != x.shape.elem_cnt()) { return false; }
+      continue;
+    }
+    stack.push_back(expr.lhs);
+    if (expr.type == LoopExpr::kBinary) { stack.push_back(expr.rhs); }
+  }
+  return true;
+}
+
+LoopValue LoopBuilder::EntryParameter(int64_t entry_index, const Shape &shape,
+                                      const DataType &data_type) {
+  CHECK(data_type == DataType::kFloat || data_type == DataType::kDouble
+        || data_type == DataType::kInt32 || data_type == DataType::kInt64)
+      << "The native engine does not support data type " << data_type;
+  const int64_t buffer_id = AddBuffer(LoopBuffer::kEntry, entry_index, ByteSize(shape, data_type));
+  return Load(buffer_id, shape, data_type);
+}
+
+LoopValue LoopBuilder::Unary(UnaryOpCode op_code, const LoopValue &x, double attr) {
+  const LoopValue in = x.expr_num < kMaxFusedExprNum ? x : Materialize(x);
+  LoopExpr expr;
+  expr.type = LoopExpr::kUnary;
+  expr.op_code = static_cast<int32_t>(op_code);
+  expr.attr = attr;
+  expr.lhs = in.expr_id;
+  LoopValue value;
+  value.expr_id = AddExpr(expr);
+  value.shape = in.shape;
+  value.data_type = in.data_type;
+  value.expr_num = in.expr_num + 1;
+  return value;
+}
+
+LoopValue LoopBuilder::Binary(BinaryOpCode op_code, const LoopValue &x, const LoopValue &y) {
+  CHECK_EQ(x.data_type, y.data_type);
+  const bool fusible = x.expr_num + y.expr_num < kMaxFusedExprNum;
+  const LoopValue lhs = fusible ? x : Materialize(x);
+  const LoopValue rhs = fusible ? y : Materialize(y);
+  LoopExpr expr;
+  expr.type = LoopExpr::kBinary;
+  expr.op_code = static_cast<int32_t>(op_code);
+  expr.lhs = lhs.expr_id;
+  expr.rhs = rhs.expr_id;
+  LoopValue value;
+  value.expr_id = AddExpr(expr);
+  value.shape = BroadcastShape(lhs.shape, rhs.shape);
+  value.data_type = lhs.data_type;
+  value.expr_num = lhs.expr_num + rhs.expr_num + 1;
+  return value;
+}
+
+int64_t LoopBuilder::ReshapeDenseExpr(int64_t expr_id, const Shape &shape,
+                                      util::Map<int64_t, int64_t> *reshaped_expr_ids) {
+  const auto it = reshaped_expr_ids->find(expr_id);
+  if (it != reshaped_expr_ids->end()) { return it->second; }
+  LoopExpr expr = exprs_.at(expr_id);
+  if (expr.type == LoopExpr::kLoad) {
+    expr.shape = shape;
+  } else {
+    expr.lhs = ReshapeDenseExpr(expr.lhs, shape, reshaped_expr_ids);
+    if (expr.type == LoopExpr::kBinary) {
+      expr.rhs = ReshapeDenseExpr(expr.rhs, shape, reshaped_expr_ids);
+    }
+  }
+  const int64_t reshaped_expr_id = AddExpr(expr);
+  reshaped_expr_ids->emplace(expr_id, reshaped_expr_id);
+  return reshaped_expr_id;
+}
+
+LoopValue LoopBuilder::Reshape(const LoopValue &x, const Shape &shape) {
+  CHECK_EQ(x.shape.elem_cnt(), shape.elem_cnt());
+  const LoopValue in = IsDense(x) ? x : Materialize(x);
+  util::Map<int64_t, int64_t> reshaped_expr_ids;
+  LoopValue value = in;
+  value.expr_id = ReshapeDenseExpr(in.expr_id, shape, &reshaped_expr_ids);
+  value.shape = shape;
+  return value;
+}
+
+LoopValue LoopBuilder::Reduce(ReduceOpCode op_code, const LoopValue &x,
+                              const std::vector<int32_t> &axes) {
+  const int64_t num_axes = x.shape.NumAxes();
+  DimVector out_dim_vec = x.shape.dim_vec();
+  for (int32_t axis : axes) {
+    const int64_t reduced_axis = axis < 0 ? axis + num_axes : axis;
+    CHECK(reduced_axis >= 0 && reduced_axis < num_axes);
+    out_dim_vec[reduced_axis] = 1;
+  }
+  const Shape out_shape(out_dim_vec);
+  const int64_t out_buffer_id =
+      AddBuffer(LoopBuffer::kTemp, -1, ByteSize(out_shape, x.data_type));
+
+  LoopStage stage;
+  stage.type = LoopStage::kReduce;
+  stage.data_type = x.data_type;
+  stage.loop_shape = x.shape;
+  stage.out_buffer_id = out_buffer_id;
+  stage.reduce_op_code = op_code;
+  stage.out_elem_cnt = out_shape.elem_cnt();
+  stage.out_strides.resize(num_axes);
+  int64_t stride = 1;
+  for (int64_t i = num_axes - 1; i >= 0; --i) {
+    stage.out_strides[i] = out_dim_vec[i] == x.shape.At(i) ? stride : 0;
+    stride *= out_dim_vec[i];
+  }
+  AddStage(x, &stage);
+  return Load(out_buffer_id, out_shape, x.data_type);
+}
+
+void LoopBuilder::CollectStageExprs(int64_t expr_id,
+                                    util::Map<int64_t, int64_t> *expr_id2stage_expr_id,
+                                    std::vector<LoopExpr> *stage_exprs) const {
+  if (expr_id2stage_expr_id->count(expr_id) > 0) { return; }
+  LoopExpr expr = exprs_.at(expr_id);
+  if (expr.type != LoopExpr::kLoad) {
+    CollectStageExprs(expr.lhs, expr_id2stage_expr_id, stage_exprs);
+    expr.lhs = expr_id2stage_expr_id->at(expr.lhs);
+    if (expr.type == LoopExpr::kBinary) {
+      CollectStageExprs(expr.rhs, expr_id2stage_expr_id, stage_exprs);
+      expr.rhs = expr_id2stage_expr_id->at(expr.rhs);
+    }
+  }
+  stage_exprs->push_back(expr);
+  expr_id2stage_expr_id->emplace(expr_id, stage_exprs->size() - 1);
+}
+
+void LoopBuilder::AddStage(const LoopValue &x, LoopStage *stage) {
+  CHECK_LE(stage->loop_shape.NumAxes(), kMaxLoopAxes);
+  util::Map<int64_t, int64_t> expr_id2stage_expr_id;
+  CollectStageExprs(x.expr_id, &expr_id2stage_expr_id, &stage->exprs);
+  const int64_t num_axes = stage->loop_shape.NumAxes();
+  for (LoopExpr &expr : stage->exprs) {
+    if (expr.type != LoopExpr::kLoad) { continue; }
+    expr.strides.assign(num_axes, 0);
+    int64_t stride = 1;
+    for (int64_t i = expr.shape.NumAxes() - 1; i >= 0; --i) {
+      const int64_t loop_axis = num_axes - expr.shape.NumAxes() + i;
+      CHECK_GE(loop_axis, 0);
+      if (expr.shape.At(i) != 1) {
+        CHECK_EQ(expr.shape.At(i), stage->loop_shape.At(loop_axis));
+        expr.strides[loop_axis] = stride;
+      }
+      stride *= expr.shape.At(i);
+    }
+  }
+  program_.stages.push_back(std::move(*stage));
+}
+
+void LoopBuilder::EmitElementwiseStage(const LoopValue &x, int64_t out_buffer_id) {
+  LoopStage stage;
+  stage.type = LoopStage::kElementwise;
+  stage.data_type = x.data_type;
+  stage.loop_shape = x.shape;
+  stage.out_buffer_id = out_buffer_id;
+  stage.out_elem_cnt = x.shape.elem_cnt();
+  AddStage(x, &stage);
+}
+
+LoopValue LoopBuilder::Materialize(const LoopValue &x) {
+  if (IsLoad(x)) { return x; }
+  const int64_t buffer_id = AddBuffer(LoopBuffer::kTemp, -1, ByteSize(x.shape, x.data_type));
+  EmitElementwiseStage(x, buffer_id);
+  return Load(buffer_id, x.shape, x.data_type);
+}
+
+LoopValue LoopBuilder::MaterializeToReturn(const LoopValue &x, int64_t return_index) {
+  CHECK_EQ(return_index2buffer_id_.count(return_index), 0);
+  if (IsLoad(x)) {
+    const int64_t buffer_id = exprs_.at(x.expr_id).buffer_id;
+    LoopBuffer *buffer = &program_.buffers.at(buffer_id);
+    if (buffer->kind == LoopBuffer::kTemp) {
+      buffer->kind = LoopBuffer::kReturn;
+      buffer->index = return_index;
+      return_index2buffer_id_.emplace(return_index, buffer_id);
+      return x;
+    }
+  }
+  const int64_t buffer_id =
+      AddBuffer(LoopBuffer::kReturn, return_index, ByteSize(x.shape, x.data_type));
+  return_index2buffer_id_.emplace(return_index, buffer_id);
+  EmitElementwiseStage(x, buffer_id);
+  return Load(buffer_id, x.shape, x.data_type);
+}
+
+LoopProgram LoopBuilder::Build() {
+  program_.temp_byte_size = 0;
+  for (LoopBuffer &buffer : program_.buffers) {
+    if (buffer.kind != LoopBuffer::kTemp) { continue; }
+    buffer.index = program_.temp_byte_size;
+    program_.temp_byte_size += RoundUp(buffer.byte_size, kTempBufferAlignment);
+  }
+  return program_;
+}
+
+}  // namespace native
+}  // namespace xrt
+}  // namespace oneflow
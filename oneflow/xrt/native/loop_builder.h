@@ -0,0 +1,84 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifndef ONEFLOW_XRT_NATIVE_LOOP_BUILDER_H_
+#define ONEFLOW_XRT_NATIVE_LOOP_BUILDER_H_
+
+#include "oneflow/xrt/native/loop_program.h"
+#include "oneflow/xrt/utility/stl.h"
+
+namespace oneflow {
+namespace xrt {
+namespace native {
+
+// An expression of the builder, it is only stored to memory when it is materialized
+struct LoopValue {
+  int64_t expr_id = -1;
+  Shape shape;
+  DataType data_type = DataType::kInvalidDataType;
+  // number of exprs of the tree, an upper bound if the tree shares nodes
+  int64_t expr_num = 0;
+};
+
+// Builds a LoopProgram. Elementwise and broadcast ops only grow the expression of a value, a
+// stage is emitted when a value is materialized or reduced, so a chain of elementwise ops runs
+// in one loop nest and its intermediate values never leave the tiles of the stage.
+class LoopBuilder {
+ public:
+  LoopBuilder() = default;
+  virtual ~LoopBuilder() = default;
+
+  LoopValue EntryParameter(int64_t entry_index, const Shape &shape, const DataType &data_type);
+
+  LoopValue Unary(UnaryOpCode op_code, const LoopValue &x, double attr = 0);
+  // numpy style broadcasting, the shapes are aligned at the last axis
+  LoopValue Binary(BinaryOpCode op_code, const LoopValue &x, const LoopValue &y);
+  LoopValue Reshape(const LoopValue &x, const Shape &shape);
+  // the reduced axes are kept with dim 1
+  LoopValue Reduce(ReduceOpCode op_code, const LoopValue &x, const std::vector<int32_t> &axes);
+
+  // Stores x to a temp buffer unless it is a load already
+  LoopValue Materialize(const LoopValue &x);
+  // Stores x to the return parameter `return_index`, the temp buffer of x becomes the return
+  // buffer if x is a load of a temp buffer, the stage writing it then writes the return buffer
+  LoopValue MaterializeToReturn(const LoopValue &x, int64_t return_index);
+
+  // Assigns the temp buffers their storage
+  LoopProgram Build();
+
+ private:
+  int64_t AddExpr(const LoopExpr &expr);
+  int64_t AddBuffer(LoopBuffer::Kind kind, int64_t index, int64_t byte_size);
+  LoopValue Load(int64_t buffer_id, const Shape &shape, const DataType &data_type);
+  bool IsLoad(const LoopValue &x) const;
+  // all loads of x have as many elements as x, so the exprs of x are layout agnostic
+  bool IsDense(const LoopValue &x) const;
+  int64_t ReshapeDenseExpr(int64_t expr_id, const Shape &shape,
+                           util::Map<int64_t, int64_t> *reshaped_expr_ids);
+  void EmitElementwiseStage(const LoopValue &x, int64_t out_buffer_id);
+  void CollectStageExprs(int64_t expr_id, util::Map<int64_t, int64_t> *expr_id2stage_expr_id,
+                         std::vector<LoopExpr> *stage_exprs) const;
+  void AddStage(const LoopValue &x, LoopStage *stage);
+
+  std::vector<LoopExpr> exprs_;
+  LoopProgram program_;
+  util::Map<int64_t, int64_t> return_index2buffer_id_;
+};
+
+}  // namespace native
+}  // namespace xrt
+}  // namespace oneflow
+
+#endif  // ONEFLOW_XRT_NATIVE_LOOP_BUILDER_H_
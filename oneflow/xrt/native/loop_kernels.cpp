@@ -0,0 +1,245 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/xrt/native/loop_kernels.h"
+#include "oneflow/core/common/util.h"
+
+namespace oneflow {
+namespace xrt {
+namespace native {
+
+namespace {
+
+// Calls Handler(k, run, offset, stride) for each run of the loop indices [begin, begin + n) along
+// the innermost axis, `offset` is the offset of the first index of the run given `strides`
+template<typename Handler>
+void ForEachInnerRun(const Shape &loop_shape, const std::vector<int64_t> &strides, int64_t begin,
+                     int64_t n, const Handler &handler) {
+  const int64_t num_axes = loop_shape.NumAxes();
+  if (num_axes == 0) {
+    handler(0, n, 0, 0);
+    return;
+  }
+  int64_t index[kMaxLoopAxes];
+  int64_t offset = 0;
+  int64_t remainder = begin;
+  for (int64_t i = num_axes - 1; i >= 0; --i) {
+    index[i] = remainder % loop_shape.At(i);
+    remainder /= loop_shape.At(i);
+    offset += index[i] * strides[i];
+  }
+  const int64_t last = num_axes - 1;
+  int64_t k = 0;
+  while (k < n) {
+    const int64_t run = std::min(n - k, loop_shape.At(last) - index[last]);
+    handler(k, run, offset, strides[last]);
+    k += run;
+    index[last] += run;
+    offset += run * strides[last];
+    for (int64_t i = last; i > 0 && index[i] == loop_shape.At(i); --i) {
+      index[i] = 0;
+      offset -= loop_shape.At(i) * strides[i];
+      index[i - 1] += 1;
+      offset += strides[i - 1];
+    }
+  }
+}
+
+template<typename T>
+void LoadTile(const T *x, const Shape &loop_shape, const std::vector<int64_t> &strides,
+              int64_t begin, int64_t n, T *y) {
+  ForEachInnerRun(loop_shape, strides, begin, n,
+                  [&](int64_t k, int64_t run, int64_t offset, int64_t stride) {
+                    if (stride == 0) {
+                      std::fill(y + k, y + k + run, x[offset]);
+                    } else if (stride == 1) {
+                      std::copy(x + offset, x + offset + run, y + k);
+                    } else {
+                      for (int64_t i = 0; i < run; ++i) { y[k + i] = x[offset + i * stride]; }
+                    }
+                  });
+}
+
+template<typename T, ReduceOpCode op_code>
+struct ReduceFunctor {
+  static inline T Init() { return static_cast<T>(0); }
+  static inline T Invoke(const T acc, const T x) { return acc + x; }
+};
+
+template<typename T>
+struct ReduceFunctor<T, ReduceOpCode::kMax> {
+  static inline T Init() { return std::numeric_limits<T>::lowest(); }
+  static inline T Invoke(const T acc, const T x) { return acc > x ? acc : x; }
+};
+
+template<typename T, ReduceOpCode op_code>
+void ReduceTile(const T *x, const LoopStage &stage, int64_t begin, int64_t n, T *y) {
+  ForEachInnerRun(stage.loop_shape, stage.out_strides, begin, n,
+                  [&](int64_t k, int64_t run, int64_t offset, int64_t stride) {
+                    if (stride == 0) {
+                      T acc = y[offset];
+                      for (int64_t i = 0; i < run; ++i) {
+                        acc = ReduceFunctor<T, op_code>::Invoke(acc, x[k + i]);
+                      }
+                      y[offset] = acc;
+                    } else {
+                      for (int64_t i = 0; i < run; ++i) {
+                        T *acc = y + offset + i * stride;
+                        *acc = ReduceFunctor<T, op_code>::Invoke(*acc, x[k + i]);
+                      }
+                    }
+                  });
+}
+
+#define UNARY_TILE_CASE(op_code)                                   \
+  case UnaryOpCode::op_code:                                       \
+    UnaryTile<T, UnaryOpCode::op_code>(x, static_cast<T>(attr), n, y); \
+    break;
+
+template<typename T>
+void DispatchUnaryTile(UnaryOpCode op_code, const T *x, double attr, int64_t n, T *y) {
+  switch (op_code) {
+    UNARY_TILE_CASE(kIdentity)
+    UNARY_TILE_CASE(kRelu)
+    UNARY_TILE_CASE(kLeakyRelu)
+    UNARY_TILE_CASE(kSigmoid)
+    UNARY_TILE_CASE(kTanh)
+    UNARY_TILE_CASE(kGelu)
+    UNARY_TILE_CASE(kExp)
+    UNARY_TILE_CASE(kNegative)
+    UNARY_TILE_CASE(kSquare)
+    UNARY_TILE_CASE(kScalarAdd)
+    UNARY_TILE_CASE(kScalarMul)
+    default: UNIMPLEMENTED();
+  }
+}
+
+#undef UNARY_TILE_CASE
+
+#define BINARY_TILE_CASE(op_code)                      \
+  case BinaryOpCode::op_code:                          \
+    BinaryTile<T, BinaryOpCode::op_code>(x, y, n, z); \
+    break;
+
+template<typename T>
+void DispatchBinaryTile(BinaryOpCode op_code, const T *x, const T *y, int64_t n, T *z) {
+  switch (op_code) {
+    BINARY_TILE_CASE(kAdd)
+    BINARY_TILE_CASE(kSub)
+    BINARY_TILE_CASE(kMul)
+    BINARY_TILE_CASE(kDiv)
+    BINARY_TILE_CASE(kMax)
+    BINARY_TILE_CASE(kMin)
+    default: UNIMPLEMENTED();
+  }
+}
+
+#undef BINARY_TILE_CASE
+
+// Evaluates the exprs of the stage on loop indices [begin, begin + n), the root is written to
+// `root_dst` and the returned pointer holds its values
+template<typename T>
+const T *EvalTile(const LoopStage &stage, const std::vector<char *> &buffer_ptrs, int64_t begin,
+                  int64_t n, T *tiles, T *root_dst, std::vector<const T *> *values) {
+  const int64_t loop_elem_cnt = stage.loop_shape.elem_cnt();
+  const int64_t root = stage.exprs.size() - 1;
+  FOR_RANGE(int64_t, i, 0, stage.exprs.size()) {
+    const LoopExpr &expr = stage.exprs.at(i);
+    T *dst = (i == root && root_dst != nullptr) ? root_dst : tiles + i * kLoopTileSize;
+    if (expr.type == LoopExpr::kLoad) {
+      const T *x = reinterpret_cast<const T *>(buffer_ptrs.at(expr.buffer_id));
+      if (expr.shape.elem_cnt() == loop_elem_cnt) {
+        // the loop visits the buffer in its memory order, the tile is read in place
+        if (dst == root_dst) {
+          std::copy(x + begin, x + begin + n, dst);
+        } else {
+          dst = const_cast<T *>(x + begin);
+        }
+      } else if (expr.shape.elem_cnt() == 1) {
+        std::fill(dst, dst + n, x[0]);
+      } else {
+        LoadTile(x, stage.loop_shape, expr.strides, begin, n, dst);
+      }
+    } else if (expr.type == LoopExpr::kUnary) {
+      DispatchUnaryTile(static_cast<UnaryOpCode>(expr.op_code), values->at(expr.lhs), expr.attr,
+                        n, dst);
+    } else {
+      DispatchBinaryTile(static_cast<BinaryOpCode>(expr.op_code), values->at(expr.lhs),
+                         values->at(expr.rhs), n, dst);
+    }
+    values->at(i) = dst;
+  }
+  return values->at(root);
+}
+
+template<typename T, ReduceOpCode op_code>
+void RunReduceStage(const LoopStage &stage, const std::vector<char *> &buffer_ptrs, T *tiles) {
+  T *out = reinterpret_cast<T *>(buffer_ptrs.at(stage.out_buffer_id));
+  std::fill(out, out + stage.out_elem_cnt, ReduceFunctor<T, op_code>::Init());
+  const int64_t elem_cnt = stage.loop_shape.elem_cnt();
+  std::vector<const T *> values(stage.exprs.size());
+  for (int64_t begin = 0; begin < elem_cnt; begin += kLoopTileSize) {
+    const int64_t n = std::min(kLoopTileSize, elem_cnt - begin);
+    const T *x = EvalTile<T>(stage, buffer_ptrs, begin, n, tiles, nullptr, &values);
+    ReduceTile<T, op_code>(x, stage, begin, n, out);
+  }
+}
+
+}  // namespace
+
+template<typename T>
+void RunLoopStage(const LoopStage &stage, const std::vector<char *> &buffer_ptrs, T *tiles) {
+  if (stage.type == LoopStage::kElementwise) {
+    T *out = reinterpret_cast<T *>(buffer_ptrs.at(stage.out_buffer_id));
+    const int64_t elem_cnt = stage.loop_shape.elem_cnt();
+    std::vector<const T *> values(stage.exprs.size());
+    for (int64_t begin = 0; begin < elem_cnt; begin += kLoopTileSize) {
+      const int64_t n = std::min(kLoopTileSize, elem_cnt - begin);
+      EvalTile<T>(stage, buffer_ptrs, begin, n, tiles, out + begin, &values);
+    }
+    return;
+  }
+  switch (stage.reduce_op_code) {
+    case ReduceOpCode::kSum:
+      RunReduceStage<T, ReduceOpCode::kSum>(stage, buffer_ptrs, tiles);
+      break;
+    case ReduceOpCode::kMax:
+      RunReduceStage<T, ReduceOpCode::kMax>(stage, buffer_ptrs, tiles);
+      break;
+    case ReduceOpCode::kMean: {
+      RunReduceStage<T, ReduceOpCode::kSum>(stage, buffer_ptrs, tiles);
+      if (stage.out_elem_cnt == 0) { break; }
+      T *out = reinterpret_cast<T *>(buffer_ptrs.at(stage.out_buffer_id));
+      const T count = static_cast<T>(stage.loop_shape.elem_cnt() / stage.out_elem_cnt);
+      if (count == static_cast<T>(0)) { break; }
+      for (int64_t i = 0; i < stage.out_elem_cnt; ++i) { out[i] /= count; }
+      break;
+    }
+    default: UNIMPLEMENTED();
+  }
+}
+
+template void RunLoopStage<float>(const LoopStage &stage, const std::vector<char *> &buffer_ptrs,
+                                  float *tiles);
+template void RunLoopStage<double>(const LoopStage &stage, const std::vector<char *> &buffer_ptrs,
+                                   double *tiles);
+template void RunLoopStage<int32_t>(const LoopStage &stage, const std::vector<char *> &buffer_ptrs,
+                                    int32_t *tiles);
+template void RunLoopStage<int64_t>(const LoopStage &stage, const std::vector<char *> &buffer_ptrs,
+                                    int64_t *tiles);
+
+}  // namespace native
+}  // namespace xrt
+}  // namespace oneflow
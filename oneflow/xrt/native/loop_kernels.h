@@ -0,0 +1,89 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifndef ONEFLOW_XRT_NATIVE_LOOP_KERNELS_H_
+#define ONEFLOW_XRT_NATIVE_LOOP_KERNELS_H_
+
+#include <cmath>
+#include <limits>
+
+#include "oneflow/xrt/native/loop_program.h"
+
+namespace oneflow {
+namespace xrt {
+namespace native {
+
+template<typename T, UnaryOpCode op_code>
+struct UnaryFunctor;
+
+#define SPECIALIZE_UNARY_FUNCTOR(op_code, expr)                      \
+  template<typename T>                                               \
+  struct UnaryFunctor<T, UnaryOpCode::op_code> {                     \
+    static inline T Invoke(const T x, const T attr) { return expr; } \
+  };
+
+SPECIALIZE_UNARY_FUNCTOR(kIdentity, x)
+SPECIALIZE_UNARY_FUNCTOR(kRelu, x > static_cast<T>(0) ? x : static_cast<T>(0))
+SPECIALIZE_UNARY_FUNCTOR(kLeakyRelu, x > static_cast<T>(0) ? x : x * attr)
+SPECIALIZE_UNARY_FUNCTOR(kSigmoid, static_cast<T>(1) / (static_cast<T>(1) + std::exp(-x)))
+SPECIALIZE_UNARY_FUNCTOR(kTanh, std::tanh(x))
+SPECIALIZE_UNARY_FUNCTOR(kGelu, static_cast<T>(0.5) * x * std::erfc(-x * static_cast<T>(M_SQRT1_2)))
+SPECIALIZE_UNARY_FUNCTOR(kExp, std::exp(x))
+SPECIALIZE_UNARY_FUNCTOR(kNegative, -x)
+SPECIALIZE_UNARY_FUNCTOR(kSquare, x * x)
+SPECIALIZE_UNARY_FUNCTOR(kScalarAdd, x + attr)
+SPECIALIZE_UNARY_FUNCTOR(kScalarMul, x * attr)
+
+#undef SPECIALIZE_UNARY_FUNCTOR
+
+template<typename T, BinaryOpCode op_code>
+struct BinaryFunctor;
+
+#define SPECIALIZE_BINARY_FUNCTOR(op_code, expr)                  \
+  template<typename T>                                            \
+  struct BinaryFunctor<T, BinaryOpCode::op_code> {                \
+    static inline T Invoke(const T x, const T y) { return expr; } \
+  };
+
+SPECIALIZE_BINARY_FUNCTOR(kAdd, x + y)
+SPECIALIZE_BINARY_FUNCTOR(kSub, x - y)
+SPECIALIZE_BINARY_FUNCTOR(kMul, x * y)
+SPECIALIZE_BINARY_FUNCTOR(kDiv, x / y)
+SPECIALIZE_BINARY_FUNCTOR(kMax, x > y ? x : y)
+SPECIALIZE_BINARY_FUNCTOR(kMin, x < y ? x : y)
+
+#undef SPECIALIZE_BINARY_FUNCTOR
+
+// The tile kernels are plain loops over contiguous memory so that the compiler vectorizes them
+template<typename T, UnaryOpCode op_code>
+void UnaryTile(const T *x, const T attr, int64_t n, T *y) {
+  for (int64_t i = 0; i < n; ++i) { y[i] = UnaryFunctor<T, op_code>::Invoke(x[i], attr); }
+}
+
+template<typename T, BinaryOpCode op_code>
+void BinaryTile(const T *x, const T *y, int64_t n, T *z) {
+  for (int64_t i = 0; i < n; ++i) { z[i] = BinaryFunctor<T, op_code>::Invoke(x[i], y[i]); }
+}
+
+// Runs one stage of a program. `buffer_ptrs` is indexed by buffer id, `tiles` holds
+// kLoopTileSize elements for each expr of the stage.
+template<typename T>
+void RunLoopStage(const LoopStage &stage, const std::vector<char *> &buffer_ptrs, T *tiles);
+
+}  // namespace native
+}  // namespace xrt
+}  // namespace oneflow
+
+#endif  // ONEFLOW_XRT_NATIVE_LOOP_KERNELS_H_
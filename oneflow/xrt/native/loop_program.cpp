@@ -0,0 +1,92 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/xrt/native/loop_program.h"
+#include "oneflow/core/common/protobuf.h"
+
+namespace oneflow {
+namespace xrt {
+namespace native {
+
+void LoopProgramToProto(const LoopProgram &program, LoopProgramProto *proto) {
+  for (const LoopBuffer &buffer : program.buffers) {
+    LoopBufferProto *buffer_proto = proto->add_buffers();
+    buffer_proto->set_kind(buffer.kind);
+    buffer_proto->set_index(buffer.index);
+    buffer_proto->set_byte_size(buffer.byte_size);
+  }
+  for (const LoopStage &stage : program.stages) {
+    LoopStageProto *stage_proto = proto->add_stages();
+    stage_proto->set_type(stage.type);
+    stage_proto->set_data_type(stage.data_type);
+    stage.loop_shape.ToProto(stage_proto->mutable_loop_shape());
+    for (const LoopExpr &expr : stage.exprs) {
+      LoopExprProto *expr_proto = stage_proto->add_exprs();
+      expr_proto->set_type(expr.type);
+      expr_proto->set_op_code(expr.op_code);
+      expr_proto->set_attr(expr.attr);
+      expr_proto->set_buffer_id(expr.buffer_id);
+      expr.shape.ToProto(expr_proto->mutable_shape());
+      *expr_proto->mutable_strides() = StdVec2PbRf(expr.strides);
+      expr_proto->set_lhs(expr.lhs);
+      expr_proto->set_rhs(expr.rhs);
+    }
+    stage_proto->set_out_buffer_id(stage.out_buffer_id);
+    stage_proto->set_reduce_op_code(static_cast<int32_t>(stage.reduce_op_code));
+    *stage_proto->mutable_out_strides() = StdVec2PbRf(stage.out_strides);
+    stage_proto->set_out_elem_cnt(stage.out_elem_cnt);
+  }
+  proto->set_temp_byte_size(program.temp_byte_size);
+}
+
+LoopProgram LoopProgramFromProto(const LoopProgramProto &proto) {
+  LoopProgram program;
+  for (const LoopBufferProto &buffer_proto : proto.buffers()) {
+    LoopBuffer buffer;
+    buffer.kind = static_cast<LoopBuffer::Kind>(buffer_proto.kind());
+    buffer.index = buffer_proto.index();
+    buffer.byte_size = buffer_proto.byte_size();
+    program.buffers.push_back(buffer);
+  }
+  for (const LoopStageProto &stage_proto : proto.stages()) {
+    LoopStage stage;
+    stage.type = static_cast<LoopStage::Type>(stage_proto.type());
+    stage.data_type = stage_proto.data_type();
+    stage.loop_shape = Shape(stage_proto.loop_shape());
+    for (const LoopExprProto &expr_proto : stage_proto.exprs()) {
+      LoopExpr expr;
+      expr.type = static_cast<LoopExpr::Type>(expr_proto.type());
+      expr.op_code = expr_proto.op_code();
+      expr.attr = expr_proto.attr();
+      expr.buffer_id = expr_proto.buffer_id();
+      expr.shape = Shape(expr_proto.shape());
+      expr.strides = PbRf2StdVec(expr_proto.strides());
+      expr.lhs = expr_proto.lhs();
+      expr.rhs = expr_proto.rhs();
+      stage.exprs.push_back(expr);
+    }
+    stage.out_buffer_id = stage_proto.out_buffer_id();
+    stage.reduce_op_code = static_cast<ReduceOpCode>(stage_proto.reduce_op_code());
+    stage.out_strides = PbRf2StdVec(stage_proto.out_strides());
+    stage.out_elem_cnt = stage_proto.out_elem_cnt();
+    program.stages.push_back(stage);
+  }
+  program.temp_byte_size = proto.temp_byte_size();
+  return program;
+}
+
+}  // namespace native
+}  // namespace xrt
+}  // namespace oneflow
@@ -0,0 +1,115 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifndef ONEFLOW_XRT_NATIVE_LOOP_PROGRAM_H_
+#define ONEFLOW_XRT_NATIVE_LOOP_PROGRAM_H_
+
+#include <vector>
+
+#include "oneflow/core/common/data_type.pb.h"
+#include "oneflow/core/common/shape.h"
+#include "oneflow/xrt/native/loop_program.pb.h"
+
+namespace oneflow {
+namespace xrt {
+namespace native {
+
+constexpr int64_t kMaxLoopAxes = 8;
+// elements of the loop a stage evaluates at once, the tiles of a stage stay in the L1 cache
+constexpr int64_t kLoopTileSize = 256;
+
+enum class UnaryOpCode : int32_t {
+  kIdentity = 0,
+  kRelu,
+  kLeakyRelu,  // attr is alpha
+  kSigmoid,
+  kTanh,
+  kGelu,
+  kExp,
+  kNegative,
+  kSquare,
+  kScalarAdd,  // attr is the scalar
+  kScalarMul,  // attr is the scalar
+};
+
+enum class BinaryOpCode : int32_t {
+  kAdd = 0,
+  kSub,
+  kMul,
+  kDiv,
+  kMax,
+  kMin,
+};
+
+enum class ReduceOpCode : int32_t {
+  kSum = 0,
+  kMean,
+  kMax,
+};
+
+// Where the memory of a buffer comes from when the program runs
+struct LoopBuffer {
+  enum Kind { kEntry = 0, kReturn, kTemp };
+  Kind kind;
+  // index of the entry or return parameter, byte offset in the temp storage
+  int64_t index;
+  int64_t byte_size;
+};
+
+// One node of an elementwise expression. A load reads buffer `buffer_id` viewed as `shape`,
+// which is broadcast to the loop shape of the stage evaluating the expression.
+struct LoopExpr {
+  enum Type { kLoad = 0, kUnary, kBinary };
+  Type type;
+  int32_t op_code = 0;
+  double attr = 0;
+  int64_t buffer_id = -1;
+  Shape shape;
+  // strides of a load over the loop axes of its stage, 0 on the broadcast axes
+  std::vector<int64_t> strides;
+  // operand expr ids, always smaller than the id of this expr
+  int64_t lhs = -1;
+  int64_t rhs = -1;
+};
+
+// A loop nest over `loop_shape` evaluating `exprs` tile by tile, the last expr is the root.
+// An elementwise stage stores the root to `out_buffer_id`, a reduce stage accumulates it into
+// the buffer whose strides over the loop axes are `out_strides`, 0 on the reduced axes.
+struct LoopStage {
+  enum Type { kElementwise = 0, kReduce };
+  Type type;
+  DataType data_type;
+  Shape loop_shape;
+  std::vector<LoopExpr> exprs;
+  int64_t out_buffer_id;
+  ReduceOpCode reduce_op_code = ReduceOpCode::kSum;
+  std::vector<int64_t> out_strides;
+  int64_t out_elem_cnt = 0;
+};
+
+struct LoopProgram {
+  std::vector<LoopBuffer> buffers;
+  std::vector<LoopStage> stages;
+  int64_t temp_byte_size = 0;
+};
+
+void LoopProgramToProto(const LoopProgram &program, LoopProgramProto *proto);
+LoopProgram LoopProgramFromProto(const LoopProgramProto &proto);
+
+}  // namespace native
+}  // namespace xrt
+}  // namespace oneflow
+
+#endif  // ONEFLOW_XRT_NATIVE_LOOP_PROGRAM_H_
@@ -0,0 +1,82 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/xrt/native/native_executable.h"
+#include "oneflow/core/common/data_type.h"
+
+namespace oneflow {
+namespace xrt {
+namespace native {
+
+NativeExecutable::NativeExecutable(const std::string &name, const LoopProgram &program)
+    : Executable(name, XrtEngine::NATIVE), program_(program) {
+  temp_storage_.resize(program_.temp_byte_size);
+  size_t tile_byte_size = 0;
+  for (const LoopStage &stage : program_.stages) {
+    tile_byte_size = std::max(tile_byte_size, stage.exprs.size() * kLoopTileSize
+                                                  * GetSizeOfDataType(stage.data_type));
+  }
+  tile_storage_.resize(tile_byte_size);
+  buffer_ptrs_.resize(program_.buffers.size(), nullptr);
+  FOR_RANGE(int64_t, i, 0, program_.buffers.size()) {
+    const LoopBuffer &buffer = program_.buffers.at(i);
+    if (buffer.kind == LoopBuffer::kTemp) { buffer_ptrs_[i] = temp_storage_.data() + buffer.index; }
+  }
+}
+
+bool NativeExecutable::Run(const std::vector<Parameter> &inputs,
+                           const ExecutableRunOptions &run_options, bool block_until_done) {
+  const std::vector<Parameter> &return_params = run_options.return_params;
+  FOR_RANGE(int64_t, i, 0, program_.buffers.size()) {
+    const LoopBuffer &buffer = program_.buffers.at(i);
+    if (buffer.kind == LoopBuffer::kEntry) {
+      CHECK_EQ(inputs.at(buffer.index).byte_size(), buffer.byte_size);
+      buffer_ptrs_[i] = inputs.at(buffer.index).data<char>();
+    } else if (buffer.kind == LoopBuffer::kReturn) {
+      CHECK_EQ(return_params.at(buffer.index).byte_size(), buffer.byte_size);
+      buffer_ptrs_[i] = return_params.at(buffer.index).data<char>();
+    }
+  }
+  for (const LoopStage &stage : program_.stages) {
+    switch (stage.data_type) {
+      case DataType::kFloat: RunStage<float>(stage); break;
+      case DataType::kDouble: RunStage<double>(stage); break;
+      case DataType::kInt32: RunStage<int32_t>(stage); break;
+      case DataType::kInt64: RunStage<int64_t>(stage); break;
+      default: LOG(FATAL) << "Unsupported data type " << stage.data_type << " of " << name_;
+    }
+  }
+  // The stages run synchronously on the host, `block_until_done` makes no difference
+  results_ = return_params;
+  return true;
+}
+
+bool NativeExecutable::Serialize(std::string *serialized) const {
+  LoopProgramProto proto;
+  LoopProgramToProto(program_, &proto);
+  return proto.SerializeToString(serialized);
+}
+
+REGISTER_EXECUTABLE_DESERIALIZER(XrtEngine::NATIVE,
+                                 [](const std::string &name,
+                                    const std::string &serialized) -> Executable * {
+                                   LoopProgramProto proto;
+                                   if (!proto.ParseFromString(serialized)) { return nullptr; }
+                                   return new NativeExecutable(name, LoopProgramFromProto(proto));
+                                 });
+
+}  // namespace native
+}  // namespace xrt
+}  // namespace oneflow
@@ -0,0 +1,55 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifndef ONEFLOW_XRT_NATIVE_NATIVE_EXECUTABLE_H_
+#define ONEFLOW_XRT_NATIVE_NATIVE_EXECUTABLE_H_
+
+#include "oneflow/xrt/executable.h"
+#include "oneflow/xrt/native/loop_kernels.h"
+#include "oneflow/xrt/native/loop_program.h"
+
+namespace oneflow {
+namespace xrt {
+namespace native {
+
+// Runs the stages of a LoopProgram one by one on the calling thread. The temp storage and the
+// tiles are owned by the executable, so an executable must not run concurrently.
+class NativeExecutable : public Executable {
+ public:
+  NativeExecutable(const std::string &name, const LoopProgram &program);
+  virtual ~NativeExecutable() = default;
+
+  bool Run(const std::vector<Parameter> &inputs, const ExecutableRunOptions &run_options,
+           bool block_until_done = true) override;
+
+  bool Serialize(std::string *serialized) const override;
+
+ private:
+  template<typename T>
+  void RunStage(const LoopStage &stage) {
+    RunLoopStage<T>(stage, buffer_ptrs_, reinterpret_cast<T *>(tile_storage_.data()));
+  }
+
+  LoopProgram program_;
+  std::vector<char> temp_storage_;
+  std::vector<char> tile_storage_;
+  std::vector<char *> buffer_ptrs_;
+};
+
+}  // namespace native
+}  // namespace xrt
+}  // namespace oneflow
+
+#endif  // ONEFLOW_XRT_NATIVE_NATIVE_EXECUTABLE_H_
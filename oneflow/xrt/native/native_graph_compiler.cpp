@@ -0,0 +1,113 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/xrt/native/native_graph_compiler.h"
+#include "oneflow/xrt/native/ops/op_kernel.h"
+#include "oneflow/xrt/node_util.h"
+
+namespace oneflow {
+namespace xrt {
+namespace native {
+
+void NativeGraphCompiler::PopulateEntryParams(const std::vector<Parameter> &entry_params) {
+  for (int i = 0; i < entry_params.size(); ++i) {
+    const Parameter &param = entry_params[i];
+    operands_[ArgFromParameter(param)] =
+        builder_.EntryParameter(i, param.shape(), param.data_type());
+  }
+}
+
+Argument NativeGraphCompiler::ArgFromParameter(const Parameter &param) {
+  return Argument(param.name(), param.shape(), param.data_type());
+}
+
+void NativeGraphCompiler::SetupKernelContextParam(const XrtNode *node,
+                                                  NativeOpContext::Param *context_param) {
+  util::Map<Argument, LoopValue> input_ops;
+  util::Map<std::string /* produce/consume key */, Argument> input_output_args;
+  std::vector<std::string> output_names;
+  for (const XrtEdge *edge : node->in_edges()) {
+    if (!edge->IsControlEdge()) {
+      const Argument &arg = edge->argument();
+      CHECK_GT(operands_.count(arg), 0);
+      input_ops.emplace(arg, operands_.at(arg));
+      input_output_args.emplace(arg.meta_data().consume_key, arg);
+    }
+  }
+  for (const XrtEdge *edge : node->out_edges()) {
+    if (!edge->IsControlEdge()) {
+      const Argument &arg = edge->argument();
+      const std::string &k = arg.meta_data().produce_key;
+      if (input_output_args.emplace(k, arg).second) { output_names.push_back(k); }
+    }
+  }
+
+  context_param->op_name = node->name();
+  context_param->builder = &builder_;
+  context_param->message = OpMessage(node);
+  context_param->num_outputs = input_output_args.size() - input_ops.size();
+  context_param->arguments = std::move(input_output_args);
+  context_param->inputs = std::move(input_ops);
+  context_param->output_names = std::move(output_names);
+}
+
+std::shared_ptr<Executable> NativeGraphCompiler::Compile(
+    const XrtGraph *graph, const std::vector<Parameter> &entry_params,
+    const std::vector<Parameter> &return_params, const std::vector<InputOutputAlias> &aliases) {
+  PopulateEntryParams(entry_params);
+  util::Map<Argument, int64_t> return_indices;
+  for (int i = 0; i < return_params.size(); ++i) {
+    return_indices.emplace(ArgFromParameter(return_params[i]), i);
+  }
+
+  algorithm::TopologyVisit(*graph, [&](const XrtNode *node) {
+    if (node->IsArgumentNode()) { return; }
+    NativeOpContext::Param param;
+    SetupKernelContextParam(node, &param);
+    NativeOpContext op_context(param);
+    auto op_kernel = BuildOpKernel(node->type());
+    op_kernel->Compile(&op_context);
+
+    util::Map<Argument, int64_t> consumer_num;
+    for (const XrtEdge *edge : node->out_edges()) {
+      if (!edge->IsControlEdge()) { ++consumer_num[edge->argument()]; }
+    }
+    for (const auto &pair : op_context.outputs()) {
+      const auto it = return_indices.find(pair.first);
+      if (it != return_indices.end()) {
+        operands_[pair.first] = builder_.MaterializeToReturn(pair.second, it->second);
+        return_indices.erase(it);
+      } else if (consumer_num[pair.first] > 1) {
+        // Computing the value once is cheaper than recomputing it in each consumer
+        operands_[pair.first] = builder_.Materialize(pair.second);
+      } else {
+        operands_[pair.first] = pair.second;
+      }
+    }
+  });
+
+  // Entry parameters passed through to returns are copied to the return parameters
+  for (const auto &pair : return_indices) {
+    CHECK_GT(operands_.count(pair.first), 0) << "Return " << pair.first.name() << " is not built";
+    builder_.MaterializeToReturn(operands_.at(pair.first), pair.second);
+  }
+  return std::make_shared<NativeExecutable>(name_, builder_.Build());
+}
+
+REGISTER_GRAPH_COMPILER(XrtEngine::NATIVE, NativeGraphCompiler);
+
+}  // namespace native
+}  // namespace xrt
+}  // namespace oneflow
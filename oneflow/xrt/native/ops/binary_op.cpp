@@ -0,0 +1,103 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/xrt/native/ops/op_context.h"
+#include "oneflow/xrt/native/ops/op_kernel.h"
+
+namespace oneflow {
+namespace xrt {
+namespace native {
+
+template<BinaryOpCode op_code>
+class BcastBinaryOp : public NativeOpKernel {
+ public:
+  void Compile(NativeOpContext *ctx) override {
+    LoopBuilder *builder = ctx->builder();
+    ctx->SetOutput("z_0", builder->Binary(op_code, ctx->Input("x_0"), ctx->Input("y_0")));
+  }
+};
+
+REGISTER_NATIVE_OP_KERNEL(BcastAdd, BcastBinaryOp<BinaryOpCode::kAdd>)
+    .EnableTrainPhase()
+    .Finalize();
+REGISTER_NATIVE_OP_KERNEL(BcastSub, BcastBinaryOp<BinaryOpCode::kSub>)
+    .EnableTrainPhase()
+    .Finalize();
+REGISTER_NATIVE_OP_KERNEL(BcastMul, BcastBinaryOp<BinaryOpCode::kMul>)
+    .EnableTrainPhase()
+    .Finalize();
+REGISTER_NATIVE_OP_KERNEL(BcastDiv, BcastBinaryOp<BinaryOpCode::kDiv>)
+    .EnableTrainPhase()
+    .Finalize();
+REGISTER_NATIVE_OP_KERNEL(BcastMax, BcastBinaryOp<BinaryOpCode::kMax>)
+    .EnableTrainPhase()
+    .Finalize();
+REGISTER_NATIVE_OP_KERNEL(BcastMin, BcastBinaryOp<BinaryOpCode::kMin>)
+    .EnableTrainPhase()
+    .Finalize();
+
+class MultiplyOp : public NativeOpKernel {
+ public:
+  void Compile(NativeOpContext *ctx) override {
+    CHECK_EQ(ctx->InputShape("x_0"), ctx->InputShape("y_0"));
+    LoopBuilder *builder = ctx->builder();
+    ctx->SetSoleOutput(builder->Binary(BinaryOpCode::kMul, ctx->Input("x_0"), ctx->Input("y_0")));
+  }
+};
+
+REGISTER_NATIVE_OP_KERNEL(Multiply, MultiplyOp).EnableTrainPhase().Finalize();
+
+class AddOp : public NativeOpKernel {
+ public:
+  void Compile(NativeOpContext *ctx) override {
+    const int num_inputs = ctx->num_inputs();
+    CHECK_GE(num_inputs, 2) << "AddOp needs 2 inputs at least.";
+    const Shape in_shape = ctx->InputShape("in_0");
+    LoopValue sum = ctx->Input("in_0");
+    for (int i = 1; i < num_inputs; ++i) {
+      const std::string name = "in_" + std::to_string(i);
+      CHECK_EQ(in_shape, ctx->InputShape(name));
+      sum = ctx->builder()->Binary(BinaryOpCode::kAdd, sum, ctx->Input(name));
+    }
+    ctx->SetSoleOutput(sum);
+  }
+};
+
+REGISTER_NATIVE_OP_KERNEL(Add, AddOp).EnableTrainPhase().Finalize();
+
+class BiasAddOp : public NativeOpKernel {
+ public:
+  void Compile(NativeOpContext *ctx) override {
+    const Shape in_shape = ctx->InputShape("a_0");
+    const Shape bias_shape = ctx->InputShape("b_0");
+    CHECK_GE(in_shape.NumAxes(), 2);
+    CHECK_EQ(bias_shape.NumAxes(), 1);
+
+    DimVector dims(in_shape.NumAxes(), 1);
+    int32_t axis = ctx->Attr<int32_t>("axis");
+    if (axis < 0) { axis += in_shape.NumAxes(); }
+    dims[axis] = bias_shape.At(0);
+
+    LoopBuilder *builder = ctx->builder();
+    LoopValue bias = builder->Reshape(ctx->Input("b_0"), Shape(dims));
+    ctx->SetOutput("out_0", builder->Binary(BinaryOpCode::kAdd, ctx->Input("a_0"), bias));
+  }
+};
+
+REGISTER_NATIVE_OP_KERNEL(BiasAdd, BiasAddOp).EnableTrainPhase().Finalize();
+
+}  // namespace native
+}  // namespace xrt
+}  // namespace oneflow
@@ -0,0 +1,96 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifndef ONEFLOW_XRT_NATIVE_OPS_OP_CONTEXT_H_
+#define ONEFLOW_XRT_NATIVE_OPS_OP_CONTEXT_H_
+
+#include "oneflow/core/common/data_type.h"
+#include "oneflow/core/common/protobuf.h"
+#include "oneflow/core/common/shape.h"
+#include "oneflow/xrt/argument.h"
+#include "oneflow/xrt/kernel/op_context.h"
+#include "oneflow/xrt/native/loop_builder.h"
+#include "oneflow/xrt/types.h"
+#include "oneflow/xrt/utility/stl.h"
+#include "oneflow/xrt/xrt.pb.h"
+
+namespace oneflow {
+namespace xrt {
+namespace native {
+
+class NativeOpContext : public OpContext {
+ public:
+  struct Param {
+    std::string op_name;
+
+    LoopBuilder *builder;
+    // Config proto related to the operator
+    const PbMessage *message;
+    // Input operands
+    util::Map<Argument, LoopValue> inputs;
+    std::vector<std::string> output_names;
+    int num_outputs;
+
+    util::Map<std::string, Argument> arguments;
+  };
+
+  explicit NativeOpContext(const Param &param) : OpContext(*param.message), param_(param) {}
+
+  virtual ~NativeOpContext() = default;
+
+  const Param &param() const { return param_; }
+
+  LoopBuilder *builder() const { return param_.builder; }
+
+  const std::string &op_name() const { return param_.op_name; }
+
+  const std::string &SoleOutputName() const;
+
+  // Return input named `name` as loop value
+  const LoopValue &Input(const std::string &name) const;
+  const LoopValue &SoleInput() const;
+
+  int num_inputs() const { return param_.inputs.size(); }
+  int num_outputs() const { return param_.num_outputs; }
+  // Return output as loop values
+  const util::Map<Argument, LoopValue> &outputs() const { return outputs_; }
+
+  // Setup the output `name` with a loop value, it is reshaped to the shape of the output
+  void SetOutput(const std::string &name, const LoopValue &value);
+  void SetSoleOutput(const LoopValue &value);
+
+  // Return input `name` shape as Shape
+  Shape InputShape(const std::string &name) const;
+  Shape SoleInputShape() const;
+  // Return output `name` shape as Shape
+  Shape OutputShape(const std::string &name) const;
+  Shape SoleOutputShape() const;
+
+  bool HasInput(const std::string &name) const;
+
+ private:
+  NativeOpContext() = delete;
+  Argument ArgumentFromKey(const std::string &key) const;
+
+  Param param_;
+  // Output operands
+  util::Map<Argument, LoopValue> outputs_;
+};
+
+}  // namespace native
+}  // namespace xrt
+}  // namespace oneflow
+
+#endif  // ONEFLOW_XRT_NATIVE_OPS_OP_CONTEXT_H_
@@ -0,0 +1,43 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/xrt/native/ops/op_context.h"
+#include "oneflow/xrt/native/ops/op_kernel.h"
+
+namespace oneflow {
+namespace xrt {
+namespace native {
+
+template<ReduceOpCode op_code>
+class ReduceOp : public NativeOpKernel {
+ public:
+  void Compile(NativeOpContext *ctx) override {
+    const int64_t num_axes = ctx->SoleInputShape().NumAxes();
+    std::vector<int32_t> axis = ctx->Attr<std::vector<int32_t>>("axis");
+    for (int32_t &a : axis) {
+      if (a < 0) { a += num_axes; }
+    }
+    // The reduced value keeps the reduced axes, SetSoleOutput reshapes it if `keepdims` is false
+    ctx->SetSoleOutput(ctx->builder()->Reduce(op_code, ctx->SoleInput(), axis));
+  }
+};
+
+REGISTER_NATIVE_OP_KERNEL(ReduceSum, ReduceOp<ReduceOpCode::kSum>).EnableTrainPhase().Finalize();
+REGISTER_NATIVE_OP_KERNEL(ReduceMean, ReduceOp<ReduceOpCode::kMean>).EnableTrainPhase().Finalize();
+REGISTER_NATIVE_OP_KERNEL(ReduceMax, ReduceOp<ReduceOpCode::kMax>).EnableTrainPhase().Finalize();
+
+}  // namespace native
+}  // namespace xrt
+}  // namespace oneflow
@@ -0,0 +1,75 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/xrt/native/ops/op_context.h"
+#include "oneflow/xrt/native/ops/op_kernel.h"
+
+namespace oneflow {
+namespace xrt {
+namespace native {
+
+template<UnaryOpCode op_code>
+class UnaryOp : public NativeOpKernel {
+ public:
+  void Compile(NativeOpContext *ctx) override {
+    ctx->SetSoleOutput(ctx->builder()->Unary(op_code, ctx->SoleInput()));
+  }
+};
+
+REGISTER_NATIVE_OP_KERNEL(Identity, UnaryOp<UnaryOpCode::kIdentity>).EnableTrainPhase().Finalize();
+REGISTER_NATIVE_OP_KERNEL(Relu, UnaryOp<UnaryOpCode::kRelu>).EnableTrainPhase().Finalize();
+REGISTER_NATIVE_OP_KERNEL(Sigmoid, UnaryOp<UnaryOpCode::kSigmoid>).EnableTrainPhase().Finalize();
+REGISTER_NATIVE_OP_KERNEL(Tanh, UnaryOp<UnaryOpCode::kTanh>).EnableTrainPhase().Finalize();
+REGISTER_NATIVE_OP_KERNEL(Gelu, UnaryOp<UnaryOpCode::kGelu>).EnableTrainPhase().Finalize();
+REGISTER_NATIVE_OP_KERNEL(Exp, UnaryOp<UnaryOpCode::kExp>).EnableTrainPhase().Finalize();
+REGISTER_NATIVE_OP_KERNEL(Negative, UnaryOp<UnaryOpCode::kNegative>).EnableTrainPhase().Finalize();
+REGISTER_NATIVE_OP_KERNEL(Square, UnaryOp<UnaryOpCode::kSquare>).EnableTrainPhase().Finalize();
+
+class LeakyReluOp : public NativeOpKernel {
+ public:
+  void Compile(NativeOpContext *ctx) override {
+    const double alpha = ctx->Attr<float>("alpha");
+    ctx->SetSoleOutput(ctx->builder()->Unary(UnaryOpCode::kLeakyRelu, ctx->SoleInput(), alpha));
+  }
+};
+
+REGISTER_NATIVE_OP_KERNEL(LeakyRelu, LeakyReluOp).EnableTrainPhase().Finalize();
+
+template<UnaryOpCode op_code>
+class ScalarBinaryOp : public NativeOpKernel {
+ public:
+  void Compile(NativeOpContext *ctx) override {
+    double scalar = 0;
+    if (ctx->Attr<bool>("has_int_operand")) {
+      scalar = static_cast<double>(ctx->Attr<int64_t>("int_operand"));
+    } else if (ctx->Attr<bool>("has_float_operand")) {
+      scalar = ctx->Attr<double>("float_operand");
+    } else {
+      LOG(FATAL) << "Scalar operand of " << ctx->op_name() << " is not set";
+    }
+    ctx->SetSoleOutput(ctx->builder()->Unary(op_code, ctx->SoleInput(), scalar));
+  }
+};
+
+REGISTER_NATIVE_OP_KERNEL(ScalarAdd, ScalarBinaryOp<UnaryOpCode::kScalarAdd>)
+    .EnableTrainPhase()
+    .Finalize();
+REGISTER_NATIVE_OP_KERNEL(ScalarMul, ScalarBinaryOp<UnaryOpCode::kScalarMul>)
+    .EnableTrainPhase()
+    .Finalize();
+
+}  // namespace native
+}  // namespace xrt
+}  // namespace oneflow
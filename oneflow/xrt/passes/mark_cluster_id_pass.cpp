@@ -203,6 +203,8 @@ void MarkClusterIdPass::Run(XrtGraph *graph, const XrtPassOptions &options) {
     ClusteringSubgraphs(clustering_options, XrtEngine::TENSORRT);
     ClusteringSubgraphs(clustering_options, XrtEngine::XLA);
   }
+  // The native engine only takes the cpu nodes left by the third party engines
+  ClusteringSubgraphs(clustering_options, XrtEngine::NATIVE);
 
   RemoveInvalidClusterNodes(clustering_options);
   RerankClusterIds();
@@ -238,6 +238,7 @@ void FoldSubgraphBuilder::BuildXrtLaunchOps() {
       switch (engine) {
         case XrtEngine::XLA: return "XLA";
         case XrtEngine::TENSORRT: return "TENSORRT";
+        case XrtEngine::NATIVE: return "NATIVE";
         default: LOG(FATAL) << "Not supported engine " << engine; return "";
       }
     }());